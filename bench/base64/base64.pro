@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Benchmark of base64 implementations
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+TARGET = bench_base64
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../../src
+
+SOURCES += tst_base64.cpp \
+    ../../src/base64.cpp
+
+HEADERS += ../../src/base64.h
@@ -0,0 +1,245 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Сравнение производительности реализаций base64 на изображениях размером с обложку и иллюстрации.
+ *
+ * @~english
+ * @brief Performance comparison of base64 implementations on cover and illustration sized images.
+ */
+
+#include "base64.h"
+
+#include <QtTest>
+#include <QByteArray>
+
+class BenchBase64 : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray makeImage(int size);
+    void addSizes();
+    void addTexts();
+
+private slots:
+    void initTestCase();
+    void verify();
+    void decodeQt_data();
+    void decodeQt();
+    void decodeTable_data();
+    void decodeTable();
+    void decodeAccelerated_data();
+    void decodeAccelerated();
+    void encodeQt_data();
+    void encodeQt();
+    void encodeTable_data();
+    void encodeTable();
+    void encodeAccelerated_data();
+    void encodeAccelerated();
+};
+
+/*
+ * Pseudo-random bytes are similar to compressed image data.
+ */
+QByteArray BenchBase64::makeImage(int size)
+{
+    QByteArray image;
+    image.resize(size);
+    quint32 seed = 12345;
+
+    for (int i = 0; i < size; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        image[i] = static_cast<char>(seed >> 16);
+    }
+
+    return image;
+}
+
+void BenchBase64::addSizes()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("16 KB") << makeImage(16 * 1024);
+    QTest::newRow("256 KB") << makeImage(256 * 1024);
+    QTest::newRow("4 MB") << makeImage(4 * 1024 * 1024);
+}
+
+/*
+ * FB2 editors wrap binary sections in lines of 76 characters.
+ */
+void BenchBase64::addTexts()
+{
+    QTest::addColumn<QByteArray>("text");
+
+    QTest::newRow("16 KB") << Base64::encodeTable(makeImage(16 * 1024).constData(), 16 * 1024, 76);
+    QTest::newRow("256 KB") << Base64::encodeTable(makeImage(256 * 1024).constData(), 256 * 1024, 76);
+    QTest::newRow("4 MB") << Base64::encodeTable(makeImage(4 * 1024 * 1024).constData(), 4 * 1024 * 1024, 76);
+}
+
+void BenchBase64::initTestCase()
+{
+    qDebug("Instruction set: %s", Base64::getInstructionSet());
+}
+
+void BenchBase64::verify()
+{
+    QByteArray image = makeImage(4096 + 13);
+
+    // All tails and line lengths, the text of Qt is the reference
+    for (int size = 0; size < 300; ++size)
+    {
+        QByteArray data = image.left(size);
+        QByteArray expected = data.toBase64();
+        QByteArray decoded;
+
+        QCOMPARE(Base64::encode(data), expected);
+        QCOMPARE(Base64::encodeTable(data.constData(), data.size()), expected);
+
+        QByteArray wrapped = Base64::encode(data, 76);
+        QCOMPARE(wrapped, Base64::encodeTable(data.constData(), data.size(), 76));
+        QCOMPARE(QByteArray(wrapped).replace('\n', ""), expected);
+
+        QVERIFY(Base64::decode(wrapped, decoded));
+        QCOMPARE(decoded, data);
+        QVERIFY(Base64::decodeTable(wrapped.constData(), wrapped.size(), decoded));
+        QCOMPARE(decoded, data);
+    }
+
+    // Indented lines with CR LF, as in files saved on Windows
+    QByteArray text = Base64::encode(image, 64).replace("\n", "\r\n    ");
+    QByteArray decoded;
+    QVERIFY(Base64::decode(text, decoded));
+    QCOMPARE(decoded, image);
+
+    // Invalid characters in every position of the vector blocks
+    QByteArray valid = Base64::encode(image.left(120));
+
+    for (int i = 0; i < valid.size(); ++i)
+    {
+        QByteArray invalid = valid;
+        invalid[i] = '*';
+        QVERIFY(!Base64::decode(invalid, decoded));
+        QVERIFY(!Base64::decodeTable(invalid.constData(), invalid.size(), decoded));
+    }
+}
+
+void BenchBase64::decodeQt_data()
+{
+    addTexts();
+}
+
+void BenchBase64::decodeQt()
+{
+    QFETCH(QByteArray, text);
+    QByteArray result;
+
+    QBENCHMARK
+    {
+        result = QByteArray::fromBase64(text);
+    }
+}
+
+void BenchBase64::decodeTable_data()
+{
+    addTexts();
+}
+
+void BenchBase64::decodeTable()
+{
+    QFETCH(QByteArray, text);
+    QByteArray result;
+
+    QBENCHMARK
+    {
+        Base64::decodeTable(text.constData(), text.size(), result);
+    }
+}
+
+void BenchBase64::decodeAccelerated_data()
+{
+    addTexts();
+}
+
+void BenchBase64::decodeAccelerated()
+{
+    QFETCH(QByteArray, text);
+    QByteArray result;
+
+    QBENCHMARK
+    {
+        Base64::decode(text, result);
+    }
+}
+
+void BenchBase64::encodeQt_data()
+{
+    addSizes();
+}
+
+void BenchBase64::encodeQt()
+{
+    QFETCH(QByteArray, data);
+    QByteArray result;
+
+    QBENCHMARK
+    {
+        result = data.toBase64();
+    }
+}
+
+void BenchBase64::encodeTable_data()
+{
+    addSizes();
+}
+
+void BenchBase64::encodeTable()
+{
+    QFETCH(QByteArray, data);
+    QByteArray result;
+
+    QBENCHMARK
+    {
+        result = Base64::encodeTable(data.constData(), data.size(), 76);
+    }
+}
+
+void BenchBase64::encodeAccelerated_data()
+{
+    addSizes();
+}
+
+void BenchBase64::encodeAccelerated()
+{
+    QFETCH(QByteArray, data);
+    QByteArray result;
+
+    QBENCHMARK
+    {
+        result = Base64::encode(data, 76);
+    }
+}
+
+QTEST_APPLESS_MAIN(BenchBase64)
+
+#include "tst_base64.moc"
@@ -0,0 +1,13 @@
+#-------------------------------------------------
+#
+# Micro-benchmarks of fb2me components
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    crc32 \
+    scan \
+    rename \
+    base64
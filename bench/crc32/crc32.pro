@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Benchmark of CRC32 implementations
+#
+#-------------------------------------------------
+
+QT       += core testlib
+QT       -= gui
+
+TARGET = bench_crc32
+CONFIG += console testcase
+CONFIG -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ../../src ../..
+
+# MINIZ_EXTERNAL_CRC32 is not defined, so mz_crc32() is the original implementation of miniz
+SOURCES += tst_crc32.cpp \
+    ../../src/crc32.cpp \
+    ../../3rdparty/miniz.c
+
+HEADERS += ../../src/crc32.h
@@ -0,0 +1,184 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Сравнение производительности реализаций CRC32 на буферах размером с книгу.
+ *
+ * @~english
+ * @brief Performance comparison of CRC32 implementations on book-sized buffers.
+ */
+
+#include "crc32.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QtTest>
+#include <QByteArray>
+
+class BenchCrc32 : public QObject
+{
+    Q_OBJECT
+
+private:
+    QByteArray makeBook(int size);
+    void addSizes();
+
+private slots:
+    void initTestCase();
+    void verify();
+    void miniz_data();
+    void miniz();
+    void table_data();
+    void table();
+    void accelerated_data();
+    void accelerated();
+};
+
+/*
+ * Text similar to a book: cyrillic words in UTF-8 separated with paragraph tags.
+ */
+QByteArray BenchCrc32::makeBook(int size)
+{
+    QByteArray book;
+    book.reserve(size);
+    quint32 seed = 12345;
+
+    while (book.size() < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        int length = 2 + (seed >> 16) % 10;
+
+        for (int i = 0; i < length; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            QChar letter(0x0430 + (seed >> 16) % 32);
+            book.append(QString(letter).toUtf8());
+        }
+
+        book.append((seed & 0x700) ? " " : "</p><p>");
+    }
+
+    book.resize(size);
+    return book;
+}
+
+void BenchCrc32::addSizes()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    QTest::newRow("64 KB") << makeBook(64 * 1024);
+    QTest::newRow("1 MB") << makeBook(1024 * 1024);
+    QTest::newRow("4 MB") << makeBook(4 * 1024 * 1024);
+    QTest::newRow("16 MB") << makeBook(16 * 1024 * 1024);
+}
+
+void BenchCrc32::initTestCase()
+{
+    qDebug("PCLMULQDQ: %s", Crc32::isAccelerated() ? "yes" : "no");
+}
+
+void BenchCrc32::verify()
+{
+    QByteArray book = makeBook(1024 * 1024 + 13);
+
+    // Unaligned starts and lengths around the folding block boundaries
+    for (int offset = 0; offset < 16; ++offset)
+    {
+        for (int size = 0; size < 300; size += 7)
+        {
+            const uchar *data = reinterpret_cast<const uchar *>(book.constData()) + offset;
+            quint32 expected = (quint32)mz_crc32(MZ_CRC32_INIT, data, size);
+
+            QCOMPARE(Crc32::update(MZ_CRC32_INIT, data, size), expected);
+            QCOMPARE(Crc32::updateTable(MZ_CRC32_INIT, data, size), expected);
+        }
+    }
+
+    const uchar *data = reinterpret_cast<const uchar *>(book.constData());
+    quint32 expected = (quint32)mz_crc32(MZ_CRC32_INIT, data, book.size());
+    int half = book.size() / 2;
+
+    QCOMPARE(Crc32::update(MZ_CRC32_INIT, data, book.size()), expected);
+    QCOMPARE(Crc32::update(Crc32::update(MZ_CRC32_INIT, data, half), data + half, book.size() - half), expected);
+    QCOMPARE(Crc32::combine(Crc32::update(MZ_CRC32_INIT, data, half),
+                            Crc32::update(MZ_CRC32_INIT, data + half, book.size() - half), book.size() - half), expected);
+}
+
+void BenchCrc32::miniz_data()
+{
+    addSizes();
+}
+
+void BenchCrc32::miniz()
+{
+    QFETCH(QByteArray, data);
+    quint32 crc = 0;
+
+    QBENCHMARK
+    {
+        crc = (quint32)mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const uchar *>(data.constData()), data.size());
+    }
+
+    Q_UNUSED(crc)
+}
+
+void BenchCrc32::table_data()
+{
+    addSizes();
+}
+
+void BenchCrc32::table()
+{
+    QFETCH(QByteArray, data);
+    quint32 crc = 0;
+
+    QBENCHMARK
+    {
+        crc = Crc32::updateTable(MZ_CRC32_INIT, reinterpret_cast<const uchar *>(data.constData()), data.size());
+    }
+
+    Q_UNUSED(crc)
+}
+
+void BenchCrc32::accelerated_data()
+{
+    addSizes();
+}
+
+void BenchCrc32::accelerated()
+{
+    QFETCH(QByteArray, data);
+    quint32 crc = 0;
+
+    QBENCHMARK
+    {
+        crc = Crc32::update(MZ_CRC32_INIT, reinterpret_cast<const uchar *>(data.constData()), data.size());
+    }
+
+    Q_UNUSED(crc)
+}
+
+QTEST_APPLESS_MAIN(BenchCrc32)
+
+#include "tst_crc32.moc"
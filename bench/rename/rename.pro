@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Benchmark of template expansion and rename planning
+#
+#-------------------------------------------------
+
+QT       += core gui xml concurrent testlib
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = bench_rename
+CONFIG += console testcase c++14
+CONFIG -= app_bundle
+TEMPLATE = app
+
+include(../../src/core.pri)
+
+SOURCES += tst_rename.cpp
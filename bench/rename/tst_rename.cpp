@@ -0,0 +1,254 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Производительность подстановки шаблонов переименования и подбора свободного имени файла.
+ *
+ * @~english
+ * @brief Performance of rename template expansion and choosing a free file name.
+ */
+
+#include "tablemodel.h"
+#include "filerecord.h"
+#include "authorindex.h"
+#include "person.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+
+class BenchRename : public QObject
+{
+    Q_OBJECT
+
+private:
+    QVector<FileRecord> records;
+    AuthorIndex index;
+    quint32 seed;
+
+    int random(int bound);
+    QString word(int minLength, int maxLength);
+
+private slots:
+    void initTestCase();
+    void expansion_data();
+    void expansion();
+    void removeOptional_data();
+    void removeOptional();
+    void newName_data();
+    void newName();
+};
+
+int BenchRename::random(int bound)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % bound;
+}
+
+QString BenchRename::word(int minLength, int maxLength)
+{
+    int length = minLength + random(maxLength - minLength + 1);
+    QString text(QChar(0x0410 + random(32)));
+
+    for (int i = 1; i < length; ++i)
+    {
+        text.append(QChar(0x0430 + random(32)));
+    }
+
+    return text;
+}
+
+/*
+ * A thousand records of a typical bulk rename: a few hundred authors, some written in several ways,
+ * often without middle name or sequence.
+ */
+void BenchRename::initTestCase()
+{
+    seed = 12345;
+    QVector<Person> authors;
+
+    for (int i = 0; i < 300; ++i)
+    {
+        Person author(word(3, 8), word(4, 12));
+
+        if (random(3) != 0)
+        {
+            author.setMiddleName(word(6, 12));
+        }
+
+        authors.append(author);
+    }
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        FileRecord record;
+        Person author = authors.at(random(authors.count()));
+
+        // Variants of the same author differ by the initial or missing middle name
+        switch (random(4))
+        {
+        case 0:
+            author.setFirstName(author.getFirstName().left(1) + ".");
+            break;
+        case 1:
+            author.setMiddleName("");
+            break;
+        }
+
+        record.addAuthor(author);
+        record.setBookTitle(word(3, 12) + " " + word(2, 10));
+        record.setIsArchive(random(2) != 0);
+
+        if (random(5) < 3)
+        {
+            record.addSequence(word(4, 12), random(10));
+        }
+
+        records.append(record);
+    }
+
+    index.build(records);
+}
+
+void BenchRename::expansion_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("canonical");
+
+    QTest::newRow("flat") << QString("%L %F - %B") << false;
+    QTest::newRow("folders") << QString("%A/%L %F/%B") << false;
+    QTest::newRow("optional") << QString("%A/%L %F{ %M}/{%S/}{%N. }%B") << false;
+    QTest::newRow("nested optional") << QString("%A/%L{ %F{ %M}}/{%S{ - %N}/}%B") << false;
+    QTest::newRow("optional, canonical authors") << QString("%A/%L %F{ %M}/{%S/}{%N. }%B") << true;
+}
+
+/*
+ * One iteration expands the template for all 1000 records.
+ */
+void BenchRename::expansion()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, canonical);
+
+    AuthorIndex empty;
+    const AuthorIndex &authors = canonical ? index : empty;
+    int length = 0;
+
+    QBENCHMARK
+    {
+        QVector<FileRecord>::const_iterator it;
+
+        for (it = records.constBegin(); it != records.constEnd(); ++it)
+        {
+            length += TableModel::fromTemplateToPath(pattern, *it, authors).length();
+        }
+    }
+
+    QVERIFY(length > 0);
+}
+
+void BenchRename::removeOptional_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<QString>("params");
+
+    QTest::newRow("missing middle name") << QString("%A/%L %F{ %M}/{%S/}{%N. }%B") << QString("%M");
+    QTest::newRow("missing sequence") << QString("%A/%L %F{ %M}/{%S/}{%N. }%B") << QString("%S %N");
+    QTest::newRow("missing nested") << QString("%A/%L{ %F{ %M}}/{%S{ - %N}/}%B") << QString("%F %M %S %N");
+    QTest::newRow("repeated groups") << QString("{%S/}{%S - }{%N. }{[%S %N] }%B{ (%S)}{ #%N}") << QString("%S %N");
+}
+
+/*
+ * One iteration removes the missing parameters from 1000 template copies.
+ */
+void BenchRename::removeOptional()
+{
+    QFETCH(QString, pattern);
+    QFETCH(QString, params);
+
+    QStringList missing = params.split(' ');
+    int length = 0;
+
+    QBENCHMARK
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            QString path = pattern;
+            QStringList::const_iterator it;
+
+            for (it = missing.constBegin(); it != missing.constEnd(); ++it)
+            {
+                TableModel::fromPathRemoveOptional(path, *it, "");
+            }
+
+            length += path.length();
+        }
+    }
+
+    QVERIFY(length > 0);
+}
+
+void BenchRename::newName_data()
+{
+    QTest::addColumn<int>("collisions");
+
+    QTest::newRow("free") << 0;
+    QTest::newRow("10 copies") << 10;
+    QTest::newRow("100 copies") << 100;
+    QTest::newRow("1000 copies") << 1000;
+}
+
+/*
+ * Target folder already holds the book and its numbered copies, as after repeated copying of one selection.
+ */
+void BenchRename::newName()
+{
+    QFETCH(int, collisions);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    QString fileName = QDir(dir.path()).filePath("book.fb2.zip");
+
+    for (int i = 0; i < collisions; ++i)
+    {
+        QString copy = (i == 0) ? fileName : QDir(dir.path()).filePath(QString("book(%1).fb2.zip").arg(i));
+        QFile file(copy);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    QString result;
+
+    QBENCHMARK
+    {
+        result = FileRecord::getNewName(fileName);
+    }
+
+    QCOMPARE(QFileInfo(result).fileName(),
+             (collisions == 0) ? QString("book.fb2.zip") : QString("book(%1).fb2.zip").arg(collisions));
+}
+
+QTEST_GUILESS_MAIN(BenchRename)
+
+#include "tst_rename.moc"
@@ -0,0 +1,17 @@
+#-------------------------------------------------
+#
+# Benchmark of the scan pipeline on a synthetic corpus
+#
+#-------------------------------------------------
+
+QT       += core gui xml concurrent testlib
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = bench_scan
+CONFIG += console testcase c++14
+CONFIG -= app_bundle
+TEMPLATE = app
+
+include(../../src/core.pri)
+
+SOURCES += tst_scan.cpp
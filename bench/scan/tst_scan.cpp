@@ -0,0 +1,514 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Производительность этапов сканирования на синтетическом наборе книг.
+ *
+ * Количество книг задается переменной окружения FB2ME_BENCH_BOOKS (по умолчанию 200).
+ *
+ * @~english
+ * @brief Performance of the scan stages on a synthetic set of books.
+ *
+ * The number of books is set by FB2ME_BENCH_BOOKS environment variable (200 by default).
+ */
+
+#include "filereader.h"
+#include "filerecord.h"
+#include "tablemodel.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QTextCodec>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+
+/*
+ * Parameters of one generated book.
+ */
+struct BookInfo
+{
+    QString fileName;
+    QByteArray encoding;
+    bool archive;
+    qint64 size;
+};
+
+/*
+ * Deterministic generator of FB2 books: the same seed always gives the same corpus.
+ */
+class CorpusGenerator
+{
+public:
+    explicit CorpusGenerator(quint32 seed);
+
+    QVector<BookInfo> generate(const QString &dir, int count);
+
+private:
+    quint32 seed;
+
+    int random(int bound);
+    QString word(int minLength, int maxLength);
+    QString sentence(int words);
+    QString makeBook(const QByteArray &encoding, int authors, int paragraphs, int bodySize);
+    bool writeArchive(const QString &fileName, const QByteArray &data);
+};
+
+CorpusGenerator::CorpusGenerator(quint32 seed) :
+    seed(seed)
+{
+}
+
+int CorpusGenerator::random(int bound)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % bound;
+}
+
+QString CorpusGenerator::word(int minLength, int maxLength)
+{
+    int length = minLength + random(maxLength - minLength + 1);
+    QString text;
+    text.reserve(length);
+
+    for (int i = 0; i < length; ++i)
+    {
+        text.append(QChar(0x0430 + random(32)));
+    }
+
+    return text;
+}
+
+QString CorpusGenerator::sentence(int words)
+{
+    QString text = word(2, 10);
+    text[0] = text[0].toUpper();
+
+    for (int i = 1; i < words; ++i)
+    {
+        text.append(' ');
+        text.append(word(1, 10));
+    }
+
+    text.append('.');
+    return text;
+}
+
+QString CorpusGenerator::makeBook(const QByteArray &encoding, int authors, int paragraphs, int bodySize)
+{
+    static const char *genres[] = {"sf", "sf_fantasy", "det_classic", "prose_classic", "love_contemporary",
+                                   "adv_history", "child_tale", "nonf_biography", "xyz_unknown"};
+
+    QString book = QString("<?xml version=\"1.0\" encoding=\"%1\"?>\n").arg(QString::fromLatin1(encoding));
+    book.append("<FictionBook xmlns=\"http://www.gribuser.ru/xml/fictionbook/2.0\" "
+                "xmlns:l=\"http://www.w3.org/1999/xlink\">\n<description>\n<title-info>\n");
+
+    int genreCount = 1 + random(3);
+
+    for (int i = 0; i < genreCount; ++i)
+    {
+        book.append(QString("<genre>%1</genre>\n").arg(genres[random(sizeof(genres) / sizeof(genres[0]))]));
+    }
+
+    for (int i = 0; i < authors; ++i)
+    {
+        QString first = word(3, 8);
+        QString last = word(4, 12);
+        first[0] = first[0].toUpper();
+        last[0] = last[0].toUpper();
+        book.append(QString("<author><first-name>%1</first-name><last-name>%2</last-name></author>\n")
+                    .arg(first, last));
+    }
+
+    book.append(QString("<book-title>%1</book-title>\n").arg(sentence(1 + random(6))));
+
+    if (paragraphs > 0)
+    {
+        book.append("<annotation>");
+
+        for (int i = 0; i < paragraphs; ++i)
+        {
+            book.append(QString("<p>%1</p>").arg(sentence(10 + random(40))));
+        }
+
+        book.append("</annotation>\n");
+    }
+
+    book.append("<lang>ru</lang>\n");
+
+    if (random(2) != 0)
+    {
+        book.append(QString("<sequence name=\"%1\" number=\"%2\"/>\n").arg(sentence(2)).arg(1 + random(20)));
+    }
+
+    book.append("</title-info>\n<document-info><program-used>bench</program-used></document-info>\n"
+                "</description>\n<body>\n<section>\n");
+
+    while (book.size() < bodySize)
+    {
+        book.append("<p>");
+        book.append(sentence(5 + random(60)));
+        book.append("</p>\n");
+    }
+
+    book.append("</section>\n</body>\n</FictionBook>\n");
+    return book;
+}
+
+bool CorpusGenerator::writeArchive(const QString &fileName, const QByteArray &data)
+{
+    mz_zip_archive zip;
+    memset(&zip, 0, sizeof(zip));
+
+    QByteArray path = QFile::encodeName(fileName);
+    QByteArray entry = QFile::encodeName(QFileInfo(fileName).completeBaseName());
+
+    if (!mz_zip_writer_init_file(&zip, path.constData(), 0))
+        return false;
+
+    bool ok = mz_zip_writer_add_mem(&zip, entry.constData(), data.constData(), data.size(), MZ_DEFAULT_LEVEL)
+              && mz_zip_writer_finalize_archive(&zip);
+    mz_zip_writer_end(&zip);
+    return ok;
+}
+
+QVector<BookInfo> CorpusGenerator::generate(const QString &dir, int count)
+{
+    static const char *encodings[] = {"utf-8", "utf-8", "utf-8", "windows-1251", "windows-1251", "koi8-r"};
+
+    QVector<BookInfo> books;
+    books.reserve(count);
+
+    for (int i = 0; i < count; ++i)
+    {
+        // Books are spread over shelves, so enumeration walks nested folders
+        QString shelf = QString("%1/shelf%2").arg(dir).arg(i / 50, 3, 10, QChar('0'));
+        QDir().mkpath(shelf);
+
+        BookInfo info;
+        info.encoding = encodings[random(sizeof(encodings) / sizeof(encodings[0]))];
+        info.archive = random(2) != 0;
+
+        int authors = 1 + random(4);
+        int paragraphs = random(3) ? random(8) : random(80);
+        // Mostly novels of a few hundred kilobytes, sometimes short stories or large volumes
+        int bodySize = (random(8) ? 64 + random(448) : 4 + random(2048)) * 1024;
+
+        QString text = makeBook(info.encoding, authors, paragraphs, bodySize);
+        QByteArray data = QTextCodec::codecForName(info.encoding)->fromUnicode(text);
+
+        info.fileName = QString("%1/book%2.fb2").arg(shelf).arg(i, 5, 10, QChar('0'));
+
+        if (info.archive)
+        {
+            info.fileName.append(".zip");
+
+            if (!writeArchive(info.fileName, data))
+                return QVector<BookInfo>();
+        }
+        else
+        {
+            QFile file(info.fileName);
+
+            if ((!file.open(QIODevice::WriteOnly)) || (file.write(data) != data.size()))
+                return QVector<BookInfo>();
+        }
+
+        info.size = QFileInfo(info.fileName).size();
+        books.append(info);
+    }
+
+    return books;
+}
+
+/*
+ * Access to the stages of the reading thread.
+ */
+class BenchReader : public FileReader
+{
+public:
+    explicit BenchReader(const QString &dir) :
+        FileReader(dir, true)
+    {
+    }
+
+    using FileReader::listFiles;
+    using FileReader::readHead;
+    using FileReader::unzipHead;
+    using FileReader::tableDecoding;
+
+    int getCount() const
+    {
+        return filenames.count();
+    }
+};
+
+/*
+ * Accumulated time of benchmark iterations, reported as files/s and MB/s.
+ */
+class Throughput
+{
+public:
+    Throughput() :
+        files(0),
+        bytes(0),
+        nsecs(0)
+    {
+    }
+
+    void start()
+    {
+        timer.start();
+    }
+
+    void stop(int count, qint64 size)
+    {
+        nsecs += timer.nsecsElapsed();
+        files += count;
+        bytes += size;
+    }
+
+    void report(const char *stage) const
+    {
+        if (nsecs == 0)
+            return;
+
+        double seconds = nsecs / 1e9;
+        qDebug("%s: %.0f files/s, %.1f MB/s", stage, files / seconds, bytes / 1048576.0 / seconds);
+    }
+
+private:
+    QElapsedTimer timer;
+    qint64 files;
+    qint64 bytes;
+    qint64 nsecs;
+};
+
+class BenchScan : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir dir;
+    QVector<BookInfo> books;
+    QVector<FileRecord> records;
+
+private slots:
+    void initTestCase();
+    void enumeration();
+    void headerParsing_data();
+    void headerParsing();
+    void inflate();
+    void modelInsertion();
+};
+
+void BenchScan::initTestCase()
+{
+    QVERIFY(dir.isValid());
+
+    int count = qEnvironmentVariableIsSet("FB2ME_BENCH_BOOKS") ? qgetenv("FB2ME_BENCH_BOOKS").toInt() : 200;
+    QVERIFY(count > 0);
+
+    books = CorpusGenerator(12345).generate(dir.path(), count);
+    QCOMPARE(books.count(), count);
+
+    // Records for the model are parsed once, the model stage measures only insertion
+    BenchReader reader(dir.path());
+    QVector<BookInfo>::const_iterator it;
+    qint64 total = 0;
+
+    for (it = books.constBegin(); it != books.constEnd(); ++it)
+    {
+        FileRecord record;
+        QString fileName = it->fileName;
+        record.setSize(it->size);
+        record.setFileName(fileName);
+        record.setIsArchive(it->archive);
+        reader.parseFile(fileName, record);
+        QCOMPARE(record.getEncoding().toLower(), QString::fromLatin1(it->encoding));
+        records.append(record);
+        total += it->size;
+    }
+
+    qDebug("Corpus: %d books, %.1f MB", count, total / 1048576.0);
+}
+
+void BenchScan::enumeration()
+{
+    qint64 bytes = 0;
+    QVector<BookInfo>::const_iterator it;
+
+    for (it = books.constBegin(); it != books.constEnd(); ++it)
+    {
+        bytes += it->size;
+    }
+
+    Throughput throughput;
+
+    QBENCHMARK
+    {
+        throughput.start();
+        BenchReader reader(dir.path());
+        reader.listFiles();
+        throughput.stop(reader.getCount(), bytes);
+        QCOMPARE(reader.getCount(), books.count());
+    }
+
+    throughput.report("enumeration");
+}
+
+void BenchScan::headerParsing_data()
+{
+    QTest::addColumn<QByteArray>("encoding");
+    QTest::addColumn<bool>("table");
+
+    // Legacy encodings are measured with the table decoder and with the codec of QXmlStreamReader
+    QTest::newRow("utf-8") << QByteArray("utf-8") << true;
+    QTest::newRow("windows-1251 table") << QByteArray("windows-1251") << true;
+    QTest::newRow("windows-1251 codec") << QByteArray("windows-1251") << false;
+    QTest::newRow("koi8-r table") << QByteArray("koi8-r") << true;
+    QTest::newRow("koi8-r codec") << QByteArray("koi8-r") << false;
+}
+
+void BenchScan::headerParsing()
+{
+    QFETCH(QByteArray, encoding);
+    QFETCH(bool, table);
+
+    // Uncompressed books only, so the stage does not include inflate
+    BenchReader reader(dir.path());
+    reader.tableDecoding = table;
+    QStringList files;
+    qint64 bytes = 0;
+    QVector<BookInfo>::const_iterator it;
+
+    for (it = books.constBegin(); it != books.constEnd(); ++it)
+    {
+        if ((!it->archive) && (it->encoding == encoding))
+        {
+            QByteArray head;
+            QVERIFY(reader.readHead(it->fileName, head) == 0);
+            files.append(it->fileName);
+            bytes += head.size();
+        }
+    }
+
+    if (files.isEmpty())
+        QSKIP("No uncompressed books in this encoding");
+
+    Throughput throughput;
+
+    QBENCHMARK
+    {
+        throughput.start();
+        QStringList::iterator file;
+
+        for (file = files.begin(); file != files.end(); ++file)
+        {
+            FileRecord record;
+            reader.parseFile(*file, record);
+        }
+
+        throughput.stop(files.count(), bytes);
+    }
+
+    throughput.report("header parsing");
+}
+
+void BenchScan::inflate()
+{
+    BenchReader reader(dir.path());
+    QStringList files;
+    QVector<BookInfo>::const_iterator it;
+
+    for (it = books.constBegin(); it != books.constEnd(); ++it)
+    {
+        if (it->archive)
+        {
+            files.append(it->fileName);
+        }
+    }
+
+    if (files.isEmpty())
+        QSKIP("No compressed books in the corpus");
+
+    Throughput throughput;
+
+    QBENCHMARK
+    {
+        throughput.start();
+        QByteArray head;
+        qint64 bytes = 0;
+        QStringList::iterator file;
+
+        for (file = files.begin(); file != files.end(); ++file)
+        {
+            reader.unzipHead(*file, head);
+            bytes += head.size();
+        }
+
+        // MB/s are counted by the unpacked bytes
+        throughput.stop(files.count(), bytes);
+    }
+
+    throughput.report("inflate");
+}
+
+void BenchScan::modelInsertion()
+{
+    qint64 bytes = 0;
+    QVector<FileRecord>::const_iterator it;
+
+    for (it = records.constBegin(); it != records.constEnd(); ++it)
+    {
+        bytes += it->getSize();
+    }
+
+    Throughput throughput;
+
+    QBENCHMARK
+    {
+        throughput.start();
+        TableModel model;
+        model.onBeginReading();
+
+        for (it = records.constBegin(); it != records.constEnd(); ++it)
+        {
+            model.onAppendRecord(*it);
+        }
+
+        model.onEndReading();
+        throughput.stop(records.count(), bytes);
+    }
+
+    throughput.report("model insertion");
+}
+
+QTEST_GUILESS_MAIN(BenchScan)
+
+#include "tst_scan.moc"
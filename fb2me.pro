@@ -4,41 +4,39 @@
 #
 #-------------------------------------------------
 
-QT       += core gui xml sql
+QT       += core gui xml sql concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 TARGET = fb2me
 TEMPLATE = app
+CONFIG += c++14
 VERSION = 0.4.6
 DEFINES += VERSIONSTR=\\\"$${VERSION}\\\"
 
 SOURCES += src/main.cpp\
     src/mainwindow.cpp \
-    src/tablemodel.cpp \
-    src/filerecord.cpp \
-    src/person.cpp \
-    src/filereader.cpp \
     src/settingswindow.cpp \
     src/settingshelper.cpp \
     src/recordeditor.cpp \
-    src/recordeditorhelper.cpp
+    src/recordeditorhelper.cpp \
+    src/jobstatuswidget.cpp \
+    src/folderwatcher.cpp \
+    src/batcheditdialog.cpp \
+    src/scanreportwidget.cpp
 
 HEADERS  += src/mainwindow.h \
-    src/tablemodel.h \
-    src/filerecord.h \
-    src/person.h \
-    src/filereader.h \
     src/settingswindow.h \
     src/settingshelper.h \
     src/recordeditor.h \
     src/recordeditorhelper.h \
-    src/consts.h \
-    src/types.h
+    src/jobstatuswidget.h \
+    src/folderwatcher.h \
+    src/batcheditdialog.h \
+    src/scanreportwidget.h
 
-# 3rd party components
-HEADERS += 3rdparty/miniz.h
-SOURCES += 3rdparty/miniz.c
+# Application core, shared with the benchmarks
+include(src/core.pri)
 
 RESOURCES += \
     res/fb2me.qrc
@@ -0,0 +1,345 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации указателя авторов.
+ *
+ * @~english
+ * @brief Source file for author index.
+ */
+
+#include "authorindex.h"
+
+#include <algorithm>
+
+/*
+ * Transliteration of lowercase Cyrillic letters from "а" to "я" by the common passport rules.
+ */
+static const char *const transliteration[32] =
+{
+    "a", "b", "v", "g", "d", "e", "zh", "z",
+    "i", "y", "k", "l", "m", "n", "o", "p",
+    "r", "s", "t", "u", "f", "kh", "ts", "ch",
+    "sh", "shch", "", "y", "", "e", "yu", "ya"
+};
+
+/*
+ * An initial or an empty name does not identify the author by itself.
+ */
+static bool isIncomplete(const QString &name)
+{
+    int letters = 0;
+
+    for (int i = 0; (i < name.size()) && (letters < 2); ++i)
+    {
+        if (name.at(i).isLetter())
+            letters++;
+    }
+
+    return letters < 2;
+}
+
+/*
+ * Number of known name parts, used to prefer the most complete spelling.
+ */
+static int completeness(const Person &author)
+{
+    return (author.getLastName().trimmed().size() > 1) + (author.getFirstName().trimmed().size() > 1) * 2 +
+           (author.getMiddleName().trimmed().size() > 1) + (!author.getNickname().trimmed().isEmpty());
+}
+
+QString AuthorIndex::normalize(const QString &name)
+{
+    QString folded = name.toCaseFolded();
+    QString result;
+    result.reserve(folded.size() + 4);
+
+    for (int i = 0; i < folded.size(); ++i)
+    {
+        ushort ch = folded.at(i).unicode();
+
+        if (ch == 0x0451) // ё
+            ch = 0x0435;
+
+        if ((ch >= 0x0430) && (ch <= 0x044F))
+            result += QLatin1String(transliteration[ch - 0x0430]);
+        else
+            if (QChar(ch).isLetterOrNumber())
+                result += QChar(ch);
+    }
+
+    // Endings "-ий", "-ый" and their transliterations "-iy", "-yy", "-ij" mean the same
+    if (result.endsWith("iy") || result.endsWith("yy") || result.endsWith("ij") || result.endsWith("ii"))
+        result.replace(result.size() - 2, 2, "y");
+
+    return result;
+}
+
+QString AuthorIndex::variantKey(const Person &author)
+{
+    return normalize(author.getLastName()) + '|' + normalize(author.getFirstName()) + '|' +
+           normalize(author.getMiddleName()) + '|' + normalize(author.getNickname());
+}
+
+void AuthorIndex::clear()
+{
+    variants.clear();
+    variantIds.clear();
+    groups.clear();
+    bookCounts.clear();
+}
+
+int AuthorIndex::findRoot(int id)
+{
+    int root = id;
+
+    while (variants.at(root).parent != root)
+        root = variants.at(root).parent;
+
+    while (variants.at(id).parent != root)
+    {
+        int next = variants.at(id).parent;
+        variants[id].parent = root;
+        id = next;
+    }
+
+    return root;
+}
+
+void AuthorIndex::unite(int a, int b)
+{
+    a = findRoot(a);
+    b = findRoot(b);
+
+    if (a != b)
+        variants[qMax(a, b)].parent = qMin(a, b);
+}
+
+void AuthorIndex::build(const QVector<FileRecord> &records)
+{
+    clear();
+
+    // Collecting distinct spellings
+    QVector<FileRecord>::const_iterator record;
+
+    for (record = records.constBegin(); record != records.constEnd(); ++record)
+    {
+        for (int i = 0; i < (*record).getAuthorCount(); ++i)
+        {
+            const Person &author = (*record).getAuthor(i);
+            QString key = variantKey(author);
+            QHash<QString, int>::const_iterator found = variantIds.constFind(key);
+
+            if (found != variantIds.constEnd())
+            {
+                variants[found.value()].books++;
+                continue;
+            }
+
+            Variant variant;
+            variant.person = author;
+            variant.last = normalize(author.getLastName());
+            variant.first = normalize(author.getFirstName());
+            variant.middle = normalize(author.getMiddleName());
+            variant.nickname = normalize(author.getNickname());
+            variant.books = 1;
+            variant.parent = variants.size();
+            variant.group = -1;
+            variantIds.insert(key, variants.size());
+            variants.append(variant);
+        }
+    }
+
+    // Spellings with the same last, first and middle names, the order of the names is often swapped in files
+    QHash<QString, int> fullNames;
+    QHash<QString, int> nicknames;
+    QMultiHash<QString, int> lastNames;
+    QMultiHash<QString, int> withMiddle; // Spellings with a middle name by the last and first names
+
+    for (int i = 0; i < variants.size(); ++i)
+    {
+        const Variant &variant = variants.at(i);
+
+        if (variant.last.isEmpty() && variant.first.isEmpty())
+        {
+            if (!variant.nickname.isEmpty())
+            {
+                QHash<QString, int>::const_iterator found = nicknames.constFind(variant.nickname);
+
+                if (found != nicknames.constEnd())
+                    unite(i, found.value());
+                else
+                    nicknames.insert(variant.nickname, i);
+            }
+
+            continue;
+        }
+
+        if (isIncomplete(variant.person.getFirstName()) || isIncomplete(variant.person.getLastName()))
+            continue;
+
+        QString name = (variant.last < variant.first) ? variant.last + '|' + variant.first :
+                       variant.first + '|' + variant.last;
+        QString key = name + '|' + variant.middle;
+        QHash<QString, int>::const_iterator found = fullNames.constFind(key);
+
+        if (found != fullNames.constEnd())
+            unite(i, found.value());
+        else
+            fullNames.insert(key, i);
+
+        if (!variant.middle.isEmpty())
+            withMiddle.insert(name, i);
+
+        lastNames.insert(variant.last, i);
+    }
+
+    // A spelling without the middle name joins the spellings with it only when they all have the same middle name
+    QHash<QString, int>::const_iterator full;
+
+    for (full = fullNames.constBegin(); full != fullNames.constEnd(); ++full)
+    {
+        if (!full.key().endsWith('|'))
+            continue;
+
+        QString name = full.key().left(full.key().size() - 1);
+        int candidate = -1;
+        bool ambiguous = false;
+        QMultiHash<QString, int>::const_iterator it = withMiddle.constFind(name);
+
+        for (; (it != withMiddle.constEnd()) && (it.key() == name) && (!ambiguous); ++it)
+        {
+            int root = findRoot(it.value());
+
+            if ((candidate != -1) && (candidate != root))
+                ambiguous = true;
+
+            candidate = root;
+        }
+
+        if ((candidate != -1) && (!ambiguous))
+            unite(full.value(), candidate);
+    }
+
+    // Initials are expanded only when the full name is unambiguous
+    for (int i = 0; i < variants.size(); ++i)
+    {
+        const Variant &variant = variants.at(i);
+
+        if ((!isIncomplete(variant.person.getFirstName())) || isIncomplete(variant.person.getLastName()))
+            continue;
+
+        int candidate = -1;
+        bool ambiguous = false;
+        QMultiHash<QString, int>::const_iterator it = lastNames.constFind(variant.last);
+
+        for (; (it != lastNames.constEnd()) && (it.key() == variant.last) && (!ambiguous); ++it)
+        {
+            const Variant &full = variants.at(it.value());
+
+            if ((!variant.first.isEmpty()) && (!full.first.startsWith(variant.first)))
+                continue;
+
+            int root = findRoot(it.value());
+
+            if ((candidate != -1) && (candidate != root))
+                ambiguous = true;
+
+            candidate = root;
+        }
+
+        if ((candidate != -1) && (!ambiguous))
+            unite(i, candidate);
+    }
+
+    // Numbering of groups, the canonical spelling is moved to the front
+    for (int i = 0; i < variants.size(); ++i)
+    {
+        int root = findRoot(i);
+
+        if (variants.at(root).group == -1)
+        {
+            variants[root].group = groups.size();
+            groups.append(QVector<int>());
+            bookCounts.append(0);
+        }
+
+        int group = variants.at(root).group;
+        variants[i].group = group;
+        groups[group].append(i);
+        bookCounts[group] += variants.at(i).books;
+    }
+
+    for (int group = 0; group < groups.size(); ++group)
+    {
+        QVector<int> &members = groups[group];
+        int best = 0;
+
+        for (int j = 1; j < members.size(); ++j)
+        {
+            const Variant &current = variants.at(members.at(j));
+            const Variant &chosen = variants.at(members.at(best));
+
+            if ((current.books > chosen.books) || ((current.books == chosen.books) &&
+                    (completeness(current.person) > completeness(chosen.person))))
+                best = j;
+        }
+
+        std::swap(members[0], members[best]);
+    }
+}
+
+int AuthorIndex::getGroupCount() const
+{
+    return groups.size();
+}
+
+const Person &AuthorIndex::getCanonical(int group) const
+{
+    return variants.at(groups.at(group).at(0)).person;
+}
+
+QVector<Person> AuthorIndex::getVariants(int group) const
+{
+    QVector<Person> result;
+    const QVector<int> &members = groups.at(group);
+    QVector<int>::const_iterator it;
+
+    for (it = members.constBegin(); it != members.constEnd(); ++it)
+        result.append(variants.at(*it).person);
+
+    return result;
+}
+
+int AuthorIndex::getBookCount(int group) const
+{
+    return bookCounts.at(group);
+}
+
+Person AuthorIndex::canonical(const Person &author) const
+{
+    QHash<QString, int>::const_iterator found = variantIds.constFind(variantKey(author));
+
+    if (found == variantIds.constEnd())
+        return author;
+
+    return getCanonical(variants.at(found.value()).group);
+}
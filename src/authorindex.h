@@ -0,0 +1,229 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef AUTHORINDEX_H
+#define AUTHORINDEX_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль указателя авторов.
+ *
+ * @~english
+ * @brief Module of author index.
+ */
+
+#include "filerecord.h"
+#include "person.h"
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+/**
+ * @~russian
+ * @brief Указатель авторов, объединяющий разные написания имени одного автора.
+ *
+ * Для каждой части имени строится нормализованный ключ: регистр свертывается, «ё» заменяется на «е»,
+ * знаки препинания удаляются, кириллица транслитерируется латиницей, поэтому «Стругацкий» и «Strugatsky»
+ * дают один ключ. Написания с одинаковыми фамилией и именем (в любом порядке) объединяются системой
+ * непересекающихся множеств, если отчество указано в обоих написаниях, оно тоже должно совпадать. Написание
+ * без отчества присоединяется к написаниям с отчеством, только если у всех них отчество одно. Написание только с инициалом или без имени присоединяется к группе,
+ * если группа с такими фамилией и первой буквой имени единственна, иначе остается отдельным.@n
+ * Каноническое имя группы - написание, встречающееся в наибольшем количестве книг, при равенстве -
+ * наиболее полное.
+ *
+ * @~english
+ * @brief Author index joining different spellings of the name of the same author.
+ *
+ * A normalized key is built for every name part: the case is folded, "ё" is replaced with "е", punctuation
+ * is removed, Cyrillic is transliterated to Latin, so "Стругацкий" and "Strugatsky" give the same key.
+ * Spellings with equal last and first names (in any order) are joined by a disjoint-set forest, if both
+ * spellings have the middle name, it must be equal too. A spelling without the middle name joins the spellings
+ * with it only if they all have the same middle name.
+ * A spelling with an initial only or without the first name joins a group if the group with such last name
+ * and the first letter of the first name is unique, otherwise it is left separate.@n
+ * The canonical name of a group is the spelling found in the largest number of books, with ties broken
+ * by the most complete one.
+ */
+class AuthorIndex
+{
+public:
+    /**
+     * @~russian
+     * @brief Построение указателя по авторам записей.
+     * @param records Записи.
+     *
+     * @~english
+     * @brief Building the index from authors of the records.
+     * @param records Records.
+     */
+    void build(const QVector<FileRecord> &records);
+
+    /**
+     * @~russian
+     * @brief Очистка указателя.
+     *
+     * @~english
+     * @brief Clearing the index.
+     */
+    void clear();
+
+    /**
+     * @~russian
+     * @brief Получение количества групп.
+     * @return Количество групп.
+     *
+     * @~english
+     * @brief Getting the number of groups.
+     * @return Number of groups.
+     */
+    int getGroupCount() const;
+
+    /**
+     * @~russian
+     * @brief Получение канонического имени группы.
+     * @param group Номер группы.
+     * @return Каноническое написание автора.
+     *
+     * @~english
+     * @brief Getting the canonical name of the group.
+     * @param group Group number.
+     * @return Canonical spelling of the author.
+     */
+    const Person &getCanonical(int group) const;
+
+    /**
+     * @~russian
+     * @brief Получение всех написаний группы.
+     * @param group Номер группы.
+     * @return Написания автора, каноническое - первое.
+     *
+     * @~english
+     * @brief Getting all spellings of the group.
+     * @param group Group number.
+     * @return Spellings of the author, the canonical one is the first.
+     */
+    QVector<Person> getVariants(int group) const;
+
+    /**
+     * @~russian
+     * @brief Получение количества книг группы.
+     * @param group Номер группы.
+     * @return Количество книг всех написаний автора.
+     *
+     * @~english
+     * @brief Getting the number of books of the group.
+     * @param group Group number.
+     * @return Number of books of all spellings of the author.
+     */
+    int getBookCount(int group) const;
+
+    /**
+     * @~russian
+     * @brief Замена автора каноническим написанием.
+     * @param author Автор.
+     * @return Каноническое написание или сам автор, если его нет в указателе.
+     *
+     * @~english
+     * @brief Substituting the author with the canonical spelling.
+     * @param author Author.
+     * @return Canonical spelling or the author itself if it is missing from the index.
+     */
+    Person canonical(const Person &author) const;
+
+    /**
+     * @~russian
+     * @brief Нормализация части имени.
+     * @param name Часть имени.
+     * @return Ключ для сравнения.
+     *
+     * @~english
+     * @brief Normalization of a name part.
+     * @param name Name part.
+     * @return Key for comparison.
+     */
+    static QString normalize(const QString &name);
+
+private:
+    /**
+     * @~russian
+     * @brief Отдельное написание автора.
+     *
+     * @~english
+     * @brief Single spelling of the author.
+     */
+    struct Variant
+    {
+        Person person; ///< @~russian Написание. @~english Spelling.
+        QString last; ///< @~russian Ключ фамилии. @~english Key of the last name.
+        QString first; ///< @~russian Ключ имени. @~english Key of the first name.
+        QString middle; ///< @~russian Ключ отчества. @~english Key of the middle name.
+        QString nickname; ///< @~russian Ключ псевдонима. @~english Key of the nickname.
+        int books; ///< @~russian Количество книг. @~english Number of books.
+        int parent; ///< @~russian Родитель в лесу множеств. @~english Parent in the disjoint-set forest.
+        int group; ///< @~russian Номер группы. @~english Group number.
+    };
+
+    QVector<Variant> variants; ///< @~russian Написания. @~english Spellings.
+    QHash<QString, int> variantIds; ///< @~russian Номера написаний по ключу. @~english Spelling numbers by key.
+    QVector<QVector<int> > groups; ///< @~russian Написания групп, каноническое - первое. @~english Spellings of groups, the canonical one is the first.
+    QVector<int> bookCounts; ///< @~russian Количество книг групп. @~english Number of books of groups.
+
+    /**
+     * @~russian
+     * @brief Ключ написания из ключей частей имени.
+     * @param author Автор.
+     * @return Ключ написания.
+     *
+     * @~english
+     * @brief Spelling key from keys of name parts.
+     * @param author Author.
+     * @return Spelling key.
+     */
+    static QString variantKey(const Person &author);
+
+    /**
+     * @~russian
+     * @brief Поиск корня множества со сжатием пути.
+     * @param id Номер написания.
+     * @return Номер корневого написания.
+     *
+     * @~english
+     * @brief Finding the set root with path compression.
+     * @param id Spelling number.
+     * @return Number of the root spelling.
+     */
+    int findRoot(int id);
+
+    /**
+     * @~russian
+     * @brief Объединение множеств двух написаний.
+     * @param a Номер первого написания.
+     * @param b Номер второго написания.
+     *
+     * @~english
+     * @brief Joining the sets of two spellings.
+     * @param a Number of the first spelling.
+     * @param b Number of the second spelling.
+     */
+    void unite(int a, int b);
+};
+
+#endif // AUTHORINDEX_H
@@ -0,0 +1,559 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации кодирования и декодирования base64.
+ *
+ * @~english
+ * @brief Source file for base64 encoding and decoding.
+ */
+
+#include "base64.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BASE64_SSSE3
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <immintrin.h>
+#if defined(__GNUC__)
+#include <cpuid.h>
+#define BASE64_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define BASE64_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#include <intrin.h>
+#define BASE64_TARGET_SSSE3
+#define BASE64_TARGET_AVX2
+#endif
+#endif
+
+const uchar skipChar = 0xFE; // Whitespace and control characters between base64 characters
+const uchar invalidChar = 0xFF; // Any other character, including padding inside the text
+
+static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+typedef bool (*decode_func)(const uchar *src, int size, uchar *dst);
+typedef void (*encode_func)(const uchar *src, int size, uchar *dst);
+
+/*
+ * Table of base64 character values, the values of skipped and invalid characters have the high bits set,
+ * and table of character pairs for 12-bit values used by encoding.
+ */
+struct Base64Tables
+{
+    uchar decode[256];
+    uchar pairs[4096][2];
+
+    Base64Tables()
+    {
+        memset(decode, invalidChar, sizeof(decode));
+        memset(decode, skipChar, 0x21);
+
+        for (int i = 0; i < 64; ++i)
+        {
+            decode[static_cast<uchar>(alphabet[i])] = static_cast<uchar>(i);
+        }
+
+        for (int i = 0; i < 4096; ++i)
+        {
+            pairs[i][0] = static_cast<uchar>(alphabet[i >> 6]);
+            pairs[i][1] = static_cast<uchar>(alphabet[i & 0x3F]);
+        }
+    }
+};
+
+/*
+ * Decoding and encoding functions of one instruction set.
+ */
+struct Base64Implementation
+{
+    decode_func decode;
+    encode_func encode;
+    const char *name;
+};
+
+static const Base64Tables &tables()
+{
+    static const Base64Tables instance;
+    return instance;
+}
+
+/*
+ * Removing of whitespace and control characters, returns the size of the remaining text.
+ * The destination may be the same as the source.
+ */
+static int compact(const uchar *src, int size, uchar *dst)
+{
+    const uchar *table = tables().decode;
+    int length = 0;
+    int i = 0;
+
+#ifdef BASE64_SSSE3
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    // Lines of FB2 binaries are long, so most blocks have no whitespace and are copied whole
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(block, space), space));
+
+        if (mask == 0)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + length), block);
+            length += 16;
+            continue;
+        }
+
+        for (int k = 0; k < 16; ++k)
+        {
+            if ((mask & (1 << k)) == 0)
+                dst[length++] = src[i + k];
+        }
+    }
+
+#endif
+
+    for (; i < size; ++i)
+    {
+        if (table[src[i]] != skipChar)
+            dst[length++] = src[i];
+    }
+
+    return length;
+}
+
+/*
+ * Decoding of the text without whitespace and padding, four characters give three bytes.
+ * The destination may be the same as the source.
+ */
+static bool decodeBlocks(const uchar *src, int size, uchar *dst)
+{
+    const uchar *table = tables().decode;
+    int i = 0;
+
+    for (; i + 4 <= size; i += 4)
+    {
+        quint32 a = table[src[i]];
+        quint32 b = table[src[i + 1]];
+        quint32 c = table[src[i + 2]];
+        quint32 d = table[src[i + 3]];
+
+        if (((a | b | c | d) & 0xC0) != 0)
+            return false;
+
+        quint32 value = (a << 18) | (b << 12) | (c << 6) | d;
+        *dst++ = static_cast<uchar>(value >> 16);
+        *dst++ = static_cast<uchar>(value >> 8);
+        *dst++ = static_cast<uchar>(value);
+    }
+
+    int rest = size - i;
+
+    if (rest >= 2)
+    {
+        quint32 a = table[src[i]];
+        quint32 b = table[src[i + 1]];
+        quint32 c = (rest == 3) ? table[src[i + 2]] : 0;
+
+        if (((a | b | c) & 0xC0) != 0)
+            return false;
+
+        quint32 value = (a << 18) | (b << 12) | (c << 6);
+        *dst++ = static_cast<uchar>(value >> 16);
+
+        if (rest == 3)
+            *dst = static_cast<uchar>(value >> 8);
+    }
+
+    return true;
+}
+
+/*
+ * Encoding of the data with padding, three bytes give four characters.
+ */
+static void encodeBlocks(const uchar *src, int size, uchar *dst)
+{
+    const Base64Tables &table = tables();
+    int i = 0;
+
+    for (; i + 3 <= size; i += 3)
+    {
+        quint32 value = (quint32(src[i]) << 16) | (quint32(src[i + 1]) << 8) | src[i + 2];
+        memcpy(dst, table.pairs[value >> 12], 2);
+        memcpy(dst + 2, table.pairs[value & 0xFFF], 2);
+        dst += 4;
+    }
+
+    int rest = size - i;
+
+    if (rest > 0)
+    {
+        quint32 value = (quint32(src[i]) << 16) | ((rest == 2) ? (quint32(src[i + 1]) << 8) : 0);
+        memcpy(dst, table.pairs[value >> 12], 2);
+        dst[2] = (rest == 2) ? static_cast<uchar>(alphabet[(value >> 6) & 0x3F]) : '=';
+        dst[3] = '=';
+    }
+}
+
+#ifdef BASE64_SSSE3
+
+/*
+ * Vector decoding of 16 characters per iteration, see Wojciech Muła and Daniel Lemire "Faster Base64 Encoding
+ * and Decoding Using AVX2 Instructions". The nibbles of each character select the validity bits and the offset
+ * to its value, then pairs and quads of 6-bit values are merged by multiply-add and 12 bytes are shuffled out.
+ */
+BASE64_TARGET_SSSE3 static bool decodeSsse3(const uchar *src, int size, uchar *dst)
+{
+    const __m128i lutLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mergePairs = _mm_set1_epi32(0x01400140);
+    const __m128i mergeQuads = _mm_set1_epi32(0x00011000);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    // 16 bytes are stored for 12 decoded ones, so at least 8 characters are left for the table tail
+    while (size >= 24)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        __m128i high = _mm_and_si128(_mm_srli_epi32(block, 4), mask2F);
+        __m128i low = _mm_and_si128(block, mask2F);
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lutLow, low), _mm_shuffle_epi8(lutHigh, high));
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, zero)) != 0xFFFF)
+            return false;
+
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(block, mask2F), high));
+        block = _mm_add_epi8(block, roll);
+        block = _mm_madd_epi16(_mm_maddubs_epi16(block, mergePairs), mergeQuads);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(block, pack));
+
+        src += 16;
+        dst += 12;
+        size -= 16;
+    }
+
+    return decodeBlocks(src, size, dst);
+}
+
+/*
+ * Vector encoding of 12 bytes per iteration by the same authors. The bytes are spread to 32-bit lanes, 6-bit
+ * values are moved into place by multiplication, and the offset from value to character is taken from a table
+ * indexed by the range of the value.
+ */
+BASE64_TARGET_SSSE3 static void encodeSsse3(const uchar *src, int size, uchar *dst)
+{
+    const __m128i spread = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i maskHigh = _mm_set1_epi32(0x0FC0FC00);
+    const __m128i shiftHigh = _mm_set1_epi32(0x04000040);
+    const __m128i maskLow = _mm_set1_epi32(0x003F03F0);
+    const __m128i shiftLow = _mm_set1_epi32(0x01000010);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    const __m128i range51 = _mm_set1_epi8(51);
+    const __m128i range26 = _mm_set1_epi8(26);
+    const __m128i lowRange = _mm_set1_epi8(13);
+
+    // 16 bytes are loaded for 12 encoded ones
+    while (size >= 16)
+    {
+        __m128i block = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src)), spread);
+        __m128i values = _mm_or_si128(_mm_mulhi_epu16(_mm_and_si128(block, maskHigh), shiftHigh),
+                                      _mm_mullo_epi16(_mm_and_si128(block, maskLow), shiftLow));
+        __m128i range = _mm_subs_epu8(values, range51);
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(range26, values), lowRange));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_add_epi8(_mm_shuffle_epi8(offsets, range), values));
+
+        src += 12;
+        dst += 16;
+        size -= 12;
+    }
+
+    encodeBlocks(src, size, dst);
+}
+
+/*
+ * The SSSE3 decoding on both 128-bit lanes, 32 characters per iteration. The lanes are shuffled separately,
+ * so 12 bytes of each lane are joined by a permutation of 32-bit words.
+ */
+BASE64_TARGET_AVX2 static bool decodeAvx2(const uchar *src, int size, uchar *dst)
+{
+    const __m256i lutLow = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHigh = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                             0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                             0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                             0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mergePairs = _mm256_set1_epi32(0x01400140);
+    const __m256i mergeQuads = _mm256_set1_epi32(0x00011000);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+    while (size >= 32)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        __m256i high = _mm256_and_si256(_mm256_srli_epi32(block, 4), mask2F);
+        __m256i low = _mm256_and_si256(block, mask2F);
+        __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lutLow, low), _mm256_shuffle_epi8(lutHigh, high));
+
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(invalid, zero)) != -1)
+            return false;
+
+        __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(block, mask2F), high));
+        block = _mm256_add_epi8(block, roll);
+        block = _mm256_madd_epi16(_mm256_maddubs_epi16(block, mergePairs), mergeQuads);
+        block = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(block, pack), join);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), block);
+
+        src += 32;
+        dst += 24;
+        size -= 32;
+    }
+
+    return decodeSsse3(src, size, dst);
+}
+
+/*
+ * The SSSE3 encoding on both 128-bit lanes, 24 bytes per iteration.
+ */
+BASE64_TARGET_AVX2 static void encodeAvx2(const uchar *src, int size, uchar *dst)
+{
+    const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i maskHigh = _mm256_set1_epi32(0x0FC0FC00);
+    const __m256i shiftHigh = _mm256_set1_epi32(0x04000040);
+    const __m256i maskLow = _mm256_set1_epi32(0x003F03F0);
+    const __m256i shiftLow = _mm256_set1_epi32(0x01000010);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    const __m256i range51 = _mm256_set1_epi8(51);
+    const __m256i range26 = _mm256_set1_epi8(26);
+    const __m256i lowRange = _mm256_set1_epi8(13);
+
+    // The second lane is loaded from the 12th byte, so 28 bytes are read for 24 encoded ones
+    while (size >= 28)
+    {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 12));
+        __m256i block = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(first), second, 1), spread);
+        __m256i values = _mm256_or_si256(_mm256_mulhi_epu16(_mm256_and_si256(block, maskHigh), shiftHigh),
+                                         _mm256_mullo_epi16(_mm256_and_si256(block, maskLow), shiftLow));
+        __m256i range = _mm256_subs_epu8(values, range51);
+        range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(range26, values), lowRange));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), values));
+
+        src += 24;
+        dst += 32;
+        size -= 24;
+    }
+
+    encodeSsse3(src, size, dst);
+}
+
+static bool hasSsse3()
+{
+    unsigned int ecx;
+#if defined(__GNUC__)
+    unsigned int eax, ebx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+
+#else
+    int info[4];
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+#endif
+
+    // SSSE3 is bit 9
+    return (ecx & (1 << 9)) != 0;
+}
+
+static bool hasAvx2()
+{
+    unsigned int ebx, ecx;
+    quint64 xcr0;
+#if defined(__GNUC__)
+    unsigned int eax, edx;
+
+    if ((__get_cpuid_max(0, 0) < 7) || (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)))
+        return false;
+
+    // OSXSAVE is bit 27, the operating system saves AVX registers if XCR0 has bits 1 and 2
+    if ((ecx & (1 << 27)) == 0)
+        return false;
+
+    __asm__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    xcr0 = (quint64(edx) << 32) | eax;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+#else
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+
+    if ((ecx & (1 << 27)) == 0)
+        return false;
+
+    xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    ebx = static_cast<unsigned int>(info[1]);
+#endif
+
+    // AVX2 is bit 5 of the extended features
+    return ((xcr0 & 6) == 6) && ((ebx & (1 << 5)) != 0);
+}
+
+#endif // BASE64_SSSE3
+
+static Base64Implementation selectImplementation()
+{
+#ifdef BASE64_SSSE3
+
+    if (hasSsse3() && hasAvx2())
+    {
+        Base64Implementation result = {decodeAvx2, encodeAvx2, "AVX2"};
+        return result;
+    }
+
+    if (hasSsse3())
+    {
+        Base64Implementation result = {decodeSsse3, encodeSsse3, "SSSE3"};
+        return result;
+    }
+
+#endif
+
+    Base64Implementation result = {decodeBlocks, encodeBlocks, "table"};
+    return result;
+}
+
+static const Base64Implementation &implementation()
+{
+    static const Base64Implementation instance = selectImplementation();
+    return instance;
+}
+
+/*
+ * The text is compacted right in the result array and decoded in place, the output never overtakes the input.
+ */
+static bool decodeWith(decode_func func, const char *data, int size, QByteArray &result)
+{
+    result.resize(size);
+    uchar *buffer = reinterpret_cast<uchar *>(result.data());
+    int length = compact(reinterpret_cast<const uchar *>(data), size, buffer);
+
+    for (int padding = 0; (padding < 2) && (length > 0) && (buffer[length - 1] == '='); ++padding)
+    {
+        --length;
+    }
+
+    if ((length % 4 == 1) || (!func(buffer, length, buffer)))
+    {
+        result.clear();
+        return false;
+    }
+
+    result.resize(length / 4 * 3 + ((length % 4 != 0) ? length % 4 - 1 : 0));
+    return true;
+}
+
+/*
+ * The text is encoded as one line at the end of the result array, then the lines are moved to their places
+ * from the first one, so the kernels work on long runs instead of single lines.
+ */
+static QByteArray encodeWith(encode_func func, const char *data, int size, int lineLength)
+{
+    int length = (size + 2) / 3 * 4;
+    lineLength = lineLength / 4 * 4;
+    int breaks = ((lineLength > 0) && (length > 0)) ? (length - 1) / lineLength : 0;
+
+    QByteArray result;
+    result.resize(length + breaks);
+    uchar *buffer = reinterpret_cast<uchar *>(result.data());
+    func(reinterpret_cast<const uchar *>(data), size, buffer + breaks);
+
+    for (int line = 0; line < breaks; ++line)
+    {
+        memmove(buffer + line * (lineLength + 1), buffer + breaks + line * lineLength, lineLength);
+        buffer[line * (lineLength + 1) + lineLength] = '\n';
+    }
+
+    return result;
+}
+
+bool Base64::decode(const char *data, int size, QByteArray &result)
+{
+    return decodeWith(implementation().decode, data, size, result);
+}
+
+bool Base64::decode(const QByteArray &text, QByteArray &result)
+{
+    return decodeWith(implementation().decode, text.constData(), text.size(), result);
+}
+
+bool Base64::decodeTable(const char *data, int size, QByteArray &result)
+{
+    return decodeWith(decodeBlocks, data, size, result);
+}
+
+QByteArray Base64::encode(const char *data, int size, int lineLength)
+{
+    return encodeWith(implementation().encode, data, size, lineLength);
+}
+
+QByteArray Base64::encode(const QByteArray &data, int lineLength)
+{
+    return encodeWith(implementation().encode, data.constData(), data.size(), lineLength);
+}
+
+QByteArray Base64::encodeTable(const char *data, int size, int lineLength)
+{
+    return encodeWith(encodeBlocks, data, size, lineLength);
+}
+
+bool Base64::isAccelerated()
+{
+    return implementation().decode != decodeBlocks;
+}
+
+const char *Base64::getInstructionSet()
+{
+    return implementation().name;
+}
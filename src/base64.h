@@ -0,0 +1,189 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef BASE64_H
+#define BASE64_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль кодирования и декодирования base64.
+ *
+ * @~english
+ * @brief Module of base64 encoding and decoding.
+ */
+
+#include <QByteArray>
+
+/**
+ * @~russian
+ * @brief Кодирование и декодирование base64 двоичных разделов FB2.
+ *
+ * Разделы @c binary разбиты на строки, поэтому при декодировании пробельные символы сначала удаляются, затем
+ * текст декодируется блоками по 32 или 16 символов. Реализация выбирается один раз при первом вызове: на x86-64
+ * с поддержкой AVX2 или SSSE3 символы переводятся и упаковываются векторными инструкциями, иначе используется
+ * табличный алгоритм. Все двоичные данные книг (обложки, изображения) кодируются и декодируются этим модулем.
+ *
+ * @~english
+ * @brief Base64 encoding and decoding of FB2 binary sections.
+ *
+ * The @c binary sections are split into lines, so whitespace characters are removed first when decoding, then
+ * the text is decoded by blocks of 32 or 16 characters. The implementation is chosen once at the first call:
+ * on x86-64 with AVX2 or SSSE3 support the characters are translated and packed by vector instructions,
+ * otherwise the table algorithm is used. All binary data of books (covers, images) is encoded and decoded
+ * by this module.
+ */
+class Base64
+{
+public:
+    /**
+     * @~russian
+     * @brief Декодирование текста base64 наилучшей доступной реализацией.
+     *
+     * Пробельные символы пропускаются, дополнение @c = в конце необязательно.
+     * @param data Текст base64.
+     * @param size Размер текста.
+     * @param result Массив, в который помещаются декодированные данные.
+     * @return @c true - если текст декодирован;@n
+     * @c false - если в тексте есть недопустимые символы.
+     *
+     * @~english
+     * @brief Decoding of base64 text by the best available implementation.
+     *
+     * Whitespace characters are skipped, the @c = padding at the end is optional.
+     * @param data Base64 text.
+     * @param size Text size.
+     * @param result Array receiving the decoded data.
+     * @return @c true - if the text is decoded;@n
+     * @c false - if the text has invalid characters.
+     */
+    static bool decode(const char *data, int size, QByteArray &result);
+
+    /**
+     * @~russian
+     * @brief Декодирование текста base64 наилучшей доступной реализацией.
+     * @param text Текст base64.
+     * @param result Массив, в который помещаются декодированные данные.
+     * @return @c true - если текст декодирован;@n
+     * @c false - если в тексте есть недопустимые символы.
+     *
+     * @~english
+     * @brief Decoding of base64 text by the best available implementation.
+     * @param text Base64 text.
+     * @param result Array receiving the decoded data.
+     * @return @c true - if the text is decoded;@n
+     * @c false - if the text has invalid characters.
+     */
+    static bool decode(const QByteArray &text, QByteArray &result);
+
+    /**
+     * @~russian
+     * @brief Декодирование текста base64 табличным алгоритмом.
+     * @param data Текст base64.
+     * @param size Размер текста.
+     * @param result Массив, в который помещаются декодированные данные.
+     * @return @c true - если текст декодирован;@n
+     * @c false - если в тексте есть недопустимые символы.
+     *
+     * @~english
+     * @brief Decoding of base64 text by the table algorithm.
+     * @param data Base64 text.
+     * @param size Text size.
+     * @param result Array receiving the decoded data.
+     * @return @c true - if the text is decoded;@n
+     * @c false - if the text has invalid characters.
+     */
+    static bool decodeTable(const char *data, int size, QByteArray &result);
+
+    /**
+     * @~russian
+     * @brief Кодирование данных в base64 наилучшей доступной реализацией.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @param lineLength Длина строки, округляется вниз до кратной 4; 0 - текст не разбивается на строки.
+     * @return Текст base64 с дополнением @c =, строки разделены символом @c \n.
+     *
+     * @~english
+     * @brief Encoding of data to base64 by the best available implementation.
+     * @param data Data.
+     * @param size Data size.
+     * @param lineLength Line length, rounded down to a multiple of 4; 0 - the text is not split into lines.
+     * @return Base64 text with @c = padding, the lines are separated by @c \n character.
+     */
+    static QByteArray encode(const char *data, int size, int lineLength = 0);
+
+    /**
+     * @~russian
+     * @brief Кодирование данных в base64 наилучшей доступной реализацией.
+     * @param data Данные.
+     * @param lineLength Длина строки, округляется вниз до кратной 4; 0 - текст не разбивается на строки.
+     * @return Текст base64 с дополнением @c =, строки разделены символом @c \n.
+     *
+     * @~english
+     * @brief Encoding of data to base64 by the best available implementation.
+     * @param data Data.
+     * @param lineLength Line length, rounded down to a multiple of 4; 0 - the text is not split into lines.
+     * @return Base64 text with @c = padding, the lines are separated by @c \n character.
+     */
+    static QByteArray encode(const QByteArray &data, int lineLength = 0);
+
+    /**
+     * @~russian
+     * @brief Кодирование данных в base64 табличным алгоритмом.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @param lineLength Длина строки, округляется вниз до кратной 4; 0 - текст не разбивается на строки.
+     * @return Текст base64 с дополнением @c =, строки разделены символом @c \n.
+     *
+     * @~english
+     * @brief Encoding of data to base64 by the table algorithm.
+     * @param data Data.
+     * @param size Data size.
+     * @param lineLength Line length, rounded down to a multiple of 4; 0 - the text is not split into lines.
+     * @return Base64 text with @c = padding, the lines are separated by @c \n character.
+     */
+    static QByteArray encodeTable(const char *data, int size, int lineLength = 0);
+
+    /**
+     * @~russian
+     * @brief Получение признака использования векторных инструкций.
+     * @return @c true - если используется AVX2 или SSSE3;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Getting whether vector instructions are used.
+     * @return @c true - if AVX2 or SSSE3 is used;@n
+     * @c false - if not.
+     */
+    static bool isAccelerated();
+
+    /**
+     * @~russian
+     * @brief Получение названия используемого набора инструкций.
+     * @return @c AVX2, @c SSSE3 или @c table.
+     *
+     * @~english
+     * @brief Getting the name of the used instruction set.
+     * @return @c AVX2, @c SSSE3 or @c table.
+     */
+    static const char *getInstructionSet();
+};
+
+#endif // BASE64_H
@@ -0,0 +1,275 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для окна пакетного изменения метаданных.
+ *
+ * @~english
+ * @brief Source file for batch metadata editing dialog.
+ */
+
+#include "batcheditdialog.h"
+
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QComboBox>
+#include <QLabel>
+#include <QMessageBox>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+const int maxPreviewRows = 1000; // A larger table is slow to fill and is not read anyway
+
+/*
+ * Record before and after the transformations, filled by the preview workers.
+ */
+struct PreviewItem
+{
+    FileRecord before;
+    FileRecord after;
+    bool changed;
+};
+
+/*
+ * Short description of the changed fields for the preview table.
+ */
+static QString describe(const FileRecord &record)
+{
+    QStringList parts;
+    QStringList sequences;
+    QStringList genres;
+    const sequence_t &sequenceList = record.getSequenceList();
+    const genre_t &genreList = record.getGenresList();
+
+    for (sequence_t::const_iterator it = sequenceList.constBegin(); it != sequenceList.constEnd(); ++it)
+        sequences.append((*it).second ? QString("%1 #%2").arg((*it).first).arg((*it).second) : (*it).first);
+
+    for (genre_t::const_iterator it = genreList.constBegin(); it != genreList.constEnd(); ++it)
+        genres.append((*it).first);
+
+    parts << record.getBookTitle() << record.getAuthorList().join("; ") << sequences.join("; ") << genres.join("; ");
+    return parts.join(" | ");
+}
+
+BatchEditDialog::BatchEditDialog(const QVector<FileRecord> &records, QWidget *parent)
+    : QDialog(parent), records(records)
+{
+    int count = records.count();
+
+    setWindowTitle(tr("Batch edit metadata"));
+
+    lblCount = new QLabel(tr("Transformations are applied to each of %n marked file(s) from top to bottom. "
+                             "Several values are separated with \";\", "
+                             "the sequence number follows \"#\".", "", count));
+    lblCount->setWordWrap(true);
+
+    tblRules = new QTableWidget(0, 4);
+    tblRules->setHorizontalHeaderLabels(QStringList() << tr("Field") << tr("Operation")
+                                        << tr("Pattern") << tr("Value"));
+    tblRules->horizontalHeader()->setStretchLastSection(true);
+    tblRules->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    btnAdd = new QPushButton(tr("Add"));
+    connect(btnAdd, SIGNAL(clicked()), this, SLOT(onAddRule()));
+    btnRemove = new QPushButton(tr("Remove"));
+    connect(btnRemove, SIGNAL(clicked()), this, SLOT(onRemoveRule()));
+    btnPreview = new QPushButton(tr("Preview"));
+    connect(btnPreview, SIGNAL(clicked()), this, SLOT(onPreview()));
+
+    boxRuleButtons = new QHBoxLayout();
+    boxRuleButtons->addWidget(btnAdd);
+    boxRuleButtons->addWidget(btnRemove);
+    boxRuleButtons->addStretch();
+    boxRuleButtons->addWidget(btnPreview);
+
+    lblPreview = new QLabel();
+
+    tblPreview = new QTableWidget(0, 3);
+    tblPreview->setHorizontalHeaderLabels(QStringList() << tr("File") << tr("Before") << tr("After"));
+    tblPreview->horizontalHeader()->setStretchLastSection(true);
+    tblPreview->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+    boxButtons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(boxButtons, SIGNAL(accepted()), this, SLOT(accept()));
+    connect(boxButtons, SIGNAL(rejected()), this, SLOT(reject()));
+
+    boxMain = new QVBoxLayout();
+    boxMain->addWidget(lblCount);
+    boxMain->addWidget(tblRules);
+    boxMain->addLayout(boxRuleButtons);
+    boxMain->addWidget(lblPreview);
+    boxMain->addWidget(tblPreview);
+    boxMain->addWidget(boxButtons);
+    this->setLayout(boxMain);
+
+    resize(800, 560);
+    onAddRule();
+}
+
+BatchEditDialog::~BatchEditDialog()
+{
+    delete tblRules;
+    delete btnAdd;
+    delete btnRemove;
+    delete btnPreview;
+    delete lblPreview;
+    delete tblPreview;
+    delete lblCount;
+    delete boxButtons;
+    delete boxRuleButtons;
+    delete boxMain;
+}
+
+QVector<MetadataTransform> BatchEditDialog::getTransforms() const
+{
+    QVector<MetadataTransform> transforms;
+
+    for (int row = 0; row < tblRules->rowCount(); ++row)
+    {
+        QComboBox *cbField = qobject_cast<QComboBox *>(tblRules->cellWidget(row, 0));
+        QComboBox *cbKind = qobject_cast<QComboBox *>(tblRules->cellWidget(row, 1));
+        QTableWidgetItem *itmPattern = tblRules->item(row, 2);
+        QTableWidgetItem *itmValue = tblRules->item(row, 3);
+
+        transforms.append(MetadataTransform(static_cast<MetadataField>(cbField->currentData().toInt()),
+                                            static_cast<TransformKind>(cbKind->currentData().toInt()),
+                                            itmPattern ? itmPattern->text() : QString(),
+                                            itmValue ? itmValue->text() : QString()));
+    }
+
+    return transforms;
+}
+
+void BatchEditDialog::accept()
+{
+    QVector<MetadataTransform> transforms = getTransforms();
+
+    for (int i = 0; i < transforms.count(); ++i)
+    {
+        QString error = transforms.at(i).validate();
+
+        if (!error.isEmpty())
+        {
+            QMessageBox::warning(this, windowTitle(), tr("Row %1: %2").arg(i + 1).arg(error));
+            tblRules->selectRow(i);
+            return;
+        }
+    }
+
+    QDialog::accept();
+}
+
+void BatchEditDialog::onAddRule()
+{
+    int row = tblRules->rowCount();
+    tblRules->insertRow(row);
+
+    // Item data is the enumeration value passed to MetadataTransform
+    QComboBox *cbField = new QComboBox();
+    cbField->addItem(tr("Book title"), mfBookTitle);
+    cbField->addItem(tr("Author"), mfAuthor);
+    cbField->addItem(tr("Sequence"), mfSequence);
+    cbField->addItem(tr("Genre"), mfGenre);
+    tblRules->setCellWidget(row, 0, cbField);
+
+    QComboBox *cbKind = new QComboBox();
+    cbKind->addItem(tr("Set"), tkSet);
+    cbKind->addItem(tr("Replace"), tkReplace);
+    cbKind->addItem(tr("Regular expression"), tkRegExp);
+    cbKind->addItem(tr("Fix look-alike letters"), tkFixHomoglyphs);
+    tblRules->setCellWidget(row, 1, cbKind);
+
+    tblRules->setItem(row, 2, new QTableWidgetItem());
+    tblRules->setItem(row, 3, new QTableWidgetItem());
+}
+
+void BatchEditDialog::onRemoveRule()
+{
+    int row = tblRules->currentRow();
+
+    if (row != -1)
+        tblRules->removeRow(row);
+}
+
+void BatchEditDialog::onPreview()
+{
+    QVector<MetadataTransform> transforms = getTransforms();
+
+    for (int i = 0; i < transforms.count(); ++i)
+    {
+        QString error = transforms.at(i).validate();
+
+        if (!error.isEmpty())
+        {
+            QMessageBox::warning(this, windowTitle(), tr("Row %1: %2").arg(i + 1).arg(error));
+            tblRules->selectRow(i);
+            return;
+        }
+    }
+
+    QVector<PreviewItem> items(records.count());
+
+    for (int i = 0; i < records.count(); ++i)
+    {
+        items[i].before = records.at(i);
+        items[i].after = records.at(i);
+        items[i].changed = false;
+    }
+
+    // Transformations are read-only and records are independent, so the copies are changed in parallel
+    QtConcurrent::blockingMap(items, [&transforms](PreviewItem & item)
+    {
+        item.changed = MetadataTransform::applyAll(transforms, item.after);
+    });
+
+    tblPreview->setRowCount(0);
+    int changed = 0;
+    QVector<PreviewItem>::const_iterator it;
+
+    for (it = items.constBegin(); it != items.constEnd(); ++it)
+    {
+        if (!(*it).changed)
+            continue;
+
+        changed++;
+
+        if (tblPreview->rowCount() >= maxPreviewRows)
+            continue;
+
+        int row = tblPreview->rowCount();
+        tblPreview->insertRow(row);
+        tblPreview->setItem(row, 0, new QTableWidgetItem(QFileInfo((*it).before.getFileName()).fileName()));
+        tblPreview->setItem(row, 1, new QTableWidgetItem(describe((*it).before)));
+        tblPreview->setItem(row, 2, new QTableWidgetItem(describe((*it).after)));
+    }
+
+    if (changed > maxPreviewRows)
+        lblPreview->setText(tr("%1 of %2 file(s) will be changed, the first %3 are shown")
+                            .arg(changed).arg(records.count()).arg(maxPreviewRows));
+    else
+        lblPreview->setText(tr("%1 of %2 file(s) will be changed").arg(changed).arg(records.count()));
+
+    tblPreview->resizeColumnsToContents();
+}
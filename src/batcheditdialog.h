@@ -0,0 +1,237 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef BATCHEDITDIALOG_H
+#define BATCHEDITDIALOG_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Заголовочный файл для окна пакетного изменения метаданных.
+ *
+ * @~english
+ * @brief Header file for batch metadata editing dialog.
+ */
+
+#include "metadatatransform.h"
+#include "filerecord.h"
+
+#include <QDialog>
+#include <QVector>
+
+// Forward class declarations
+class QVBoxLayout;
+class QHBoxLayout;
+class QDialogButtonBox;
+class QPushButton;
+class QTableWidget;
+class QLabel;
+
+/**
+ * @~russian
+ * @brief Окно списка преобразований для пакетного изменения метаданных отмеченных файлов.
+ *
+ * Каждая строка таблицы - одно преобразование: поле, операция, образец и новое значение.
+ * Преобразования применяются к каждой записи сверху вниз. Предварительный просмотр применяет их к копиям
+ * записей параллельно и показывает изменившиеся записи до и после изменения.
+ *
+ * @~english
+ * @brief Dialog of transformation list for batch editing of metadata of marked files.
+ *
+ * Each table row is a single transformation: field, operation, pattern and new value.
+ * Transformations are applied to every record from top to bottom. The preview applies them to copies
+ * of the records in parallel and shows the changed records before and after the change.
+ */
+class BatchEditDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор окна.
+     * @param records Отмеченные записи, используются для предварительного просмотра.
+     * @param parent Указатель на родительское окно.
+     *
+     * @~english
+     * @brief The dialog constructor.
+     * @param records Marked records, used for the preview.
+     * @param parent Parent window pointer.
+     */
+    BatchEditDialog(const QVector<FileRecord> &records, QWidget *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор окна.
+     *
+     * @~english
+     * @brief The dialog destructor.
+     */
+    ~BatchEditDialog();
+
+    /**
+     * @~russian
+     * @brief Получение списка преобразований.
+     * @return Список преобразований в порядке применения.
+     *
+     * @~english
+     * @brief Getting the list of transformations.
+     * @return List of transformations in order of application.
+     */
+    QVector<MetadataTransform> getTransforms() const;
+
+public slots:
+    /**
+     * @~russian
+     * @brief Проверка преобразований и закрытие окна.
+     *
+     * @~english
+     * @brief Validation of transformations and closing the dialog.
+     */
+    void accept();
+
+private slots:
+    /**
+     * @~russian
+     * @brief Обработчик кнопки «Добавить».
+     *
+     * @~english
+     * @brief «Add» button handler.
+     */
+    void onAddRule();
+
+    /**
+     * @~russian
+     * @brief Обработчик кнопки «Удалить».
+     *
+     * @~english
+     * @brief «Remove» button handler.
+     */
+    void onRemoveRule();
+
+    /**
+     * @~russian
+     * @brief Обработчик кнопки «Просмотр».
+     *
+     * @~english
+     * @brief «Preview» button handler.
+     */
+    void onPreview();
+
+private:
+    /**
+     * @~russian
+     * @brief Основной менеджер размещения.
+     *
+     * @~english
+     * @brief Main layout manager.
+     */
+    QVBoxLayout *boxMain;
+
+    /**
+     * @~russian
+     * @brief Менеджер размещения кнопок таблицы.
+     *
+     * @~english
+     * @brief Layout manager of table buttons.
+     */
+    QHBoxLayout *boxRuleButtons;
+
+    /**
+     * @~russian
+     * @brief Надпись с количеством отмеченных файлов.
+     *
+     * @~english
+     * @brief Label with the number of marked files.
+     */
+    QLabel *lblCount;
+
+    /**
+     * @~russian
+     * @brief Таблица преобразований.
+     *
+     * @~english
+     * @brief Table of transformations.
+     */
+    QTableWidget *tblRules;
+
+    /**
+     * @~russian
+     * @brief Кнопка «Добавить».
+     *
+     * @~english
+     * @brief «Add» button.
+     */
+    QPushButton *btnAdd;
+
+    /**
+     * @~russian
+     * @brief Кнопка «Удалить».
+     *
+     * @~english
+     * @brief «Remove» button.
+     */
+    QPushButton *btnRemove;
+
+    /**
+     * @~russian
+     * @brief Кнопка «Просмотр».
+     *
+     * @~english
+     * @brief «Preview» button.
+     */
+    QPushButton *btnPreview;
+
+    /**
+     * @~russian
+     * @brief Надпись с количеством изменяемых файлов.
+     *
+     * @~english
+     * @brief Label with the number of changed files.
+     */
+    QLabel *lblPreview;
+
+    /**
+     * @~russian
+     * @brief Таблица изменений: файл, значения до и после преобразований.
+     *
+     * @~english
+     * @brief Table of changes: file, values before and after transformations.
+     */
+    QTableWidget *tblPreview;
+
+    /**
+     * @~russian
+     * @brief Отмеченные записи.
+     *
+     * @~english
+     * @brief Marked records.
+     */
+    QVector<FileRecord> records;
+
+    /**
+     * @~russian
+     * @brief Кнопки «ОК» и «Отмена».
+     *
+     * @~english
+     * @brief «OK» and «Cancel» buttons.
+     */
+    QDialogButtonBox *boxButtons;
+};
+
+#endif // BATCHEDITDIALOG_H
@@ -0,0 +1,274 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для пакетных операций над файлами.
+ *
+ * @~english
+ * @brief Source file for batch file operations.
+ */
+
+#include "batchjob.h"
+#include "metadatawriter.h"
+#include "recordvalidator.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+
+BatchJob::BatchJob(BatchOperation operation, const QVector<BatchItem> &items, QObject *parent) :
+    Job(parent)
+{
+    this->operation = operation;
+    this->items = items;
+    threads = 1;
+    level = 9;
+    maxRatio = 0;
+    optimizedFiles = 0;
+
+    qint64 bytes = 0;
+    QVector<BatchItem>::iterator it;
+
+    for (it = this->items.begin(); it != this->items.end(); ++it)
+    {
+        bytes += (*it).record.getSize();
+    }
+
+    setTotal(this->items.count(), bytes);
+}
+
+QString BatchJob::getTitle() const
+{
+    switch (operation)
+    {
+    case boZip:
+        return tr("Compressing files");
+        break;
+
+    case boUnzip:
+        return tr("Uncompressing files");
+        break;
+
+    case boMove:
+        return tr("Moving files");
+        break;
+
+    case boCopy:
+        return tr("Copying files");
+        break;
+
+    case boRename:
+        return tr("Renaming files");
+        break;
+
+    case boEditMetadata:
+        return tr("Editing metadata");
+        break;
+
+    case boConvertUtf8:
+        return tr("Converting to UTF-8");
+        break;
+
+    case boOptimizeImages:
+        return tr("Optimizing images");
+        break;
+
+    default:
+        break;
+    }
+
+    return QString();
+}
+
+void BatchJob::setThreads(int threads)
+{
+    this->threads = threads;
+}
+
+void BatchJob::setCompression(int level, int maxRatio)
+{
+    this->level = level;
+    this->maxRatio = maxRatio;
+}
+
+void BatchJob::setImageOptions(int quality, int maxDimension)
+{
+    optimizer = ImageOptimizer(quality, maxDimension);
+}
+
+void BatchJob::setTransforms(const QVector<MetadataTransform> &transforms)
+{
+    this->transforms = transforms;
+}
+
+void BatchJob::run()
+{
+    // Each compression or file rewrite uses its own writer, so files are processed independently
+    if ((operation == boZip) || (operation == boEditMetadata) || (operation == boConvertUtf8) ||
+            (operation == boOptimizeImages))
+    {
+        // Workers access items concurrently, so the vector must not be shared with the caller
+        items.detach();
+        runParallel(items.count(), threads);
+
+        if (isCancelled())
+            emit EventMessage(tr("%1: cancelled").arg(getTitle()));
+
+        if (operation == boOptimizeImages)
+            emit EventMessage(tr("Images optimized in %1 files: %2 of %3 images replaced, %4 KB -> %5 KB")
+                              .arg(optimizedFiles).arg(imageTotals.recompressed).arg(imageTotals.images)
+                              .arg(imageTotals.before / 1024).arg(imageTotals.after / 1024));
+
+        return;
+    }
+
+    QVector<BatchItem>::iterator it;
+
+    for (it = items.begin(); it != items.end(); ++it)
+    {
+        if (!checkPoint())
+        {
+            emit EventMessage(tr("%1: cancelled").arg(getTitle()));
+            break;
+        }
+
+        qint64 size = (*it).record.getSize();
+        processItem(*it);
+        addProgress(1, size);
+    }
+}
+
+void BatchJob::processParallel(int index)
+{
+    BatchItem &item = items[index];
+    qint64 size = item.record.getSize();
+    processItem(item);
+    addProgress(1, size);
+}
+
+void BatchJob::processItem(BatchItem &item)
+{
+    QString fileName = item.record.getFileName();
+
+    switch (operation)
+    {
+    case boZip:
+        if (item.record.isArchive())
+        {
+            emit EventMessage(tr("File %1 already compressed").arg(item.record.getFileName()));
+            return;
+        }
+
+        emit EventMessage(item.record.zipFile(level, maxRatio));
+        break;
+
+    case boMove:
+        emit EventMessage(item.record.moveFile(item.target));
+        break;
+
+    case boCopy:
+        emit EventMessage(item.record.copyFile(item.target));
+        break;
+
+    case boRename:
+        emit EventMessage(item.record.renameFile(item.target));
+        break;
+
+    case boEditMetadata:
+    {
+        FileRecord edited = item.record;
+
+        if (!MetadataTransform::applyAll(transforms, edited))
+            return;
+
+        // The writer replaces the file atomically, so a crash leaves either the old or the new book
+        MetadataWriter writer(level);
+
+        if (!writer.write(edited, item.record))
+        {
+            emit ErrorMessage(writer.getError());
+            return;
+        }
+
+        edited.setSize(QFileInfo(fileName).size());
+        edited.setStatus(RecordValidator::classify(edited));
+        item.record = edited;
+        emit EventMessage(tr("Metadata of %1 changed").arg(fileName));
+        break;
+    }
+
+    case boConvertUtf8:
+    {
+        QString encoding = item.record.getEncoding().toLower();
+
+        // XML without declared encoding is UTF-8 already
+        if (encoding.isEmpty() || (encoding == "utf-8") || (encoding == "utf8"))
+            return;
+
+        FileRecord converted = item.record;
+        MetadataWriter writer(level);
+
+        if (!writer.convertToUtf8(converted))
+        {
+            emit ErrorMessage(writer.getError());
+            return;
+        }
+
+        converted.setEncoding("utf-8");
+        converted.setSize(QFileInfo(fileName).size());
+        item.record = converted;
+        emit EventMessage(tr("File %1 converted from %2 to UTF-8").arg(fileName, encoding));
+        break;
+    }
+
+    case boOptimizeImages:
+    {
+        MetadataWriter writer(level);
+
+        if (!writer.optimizeImages(item.record, optimizer))
+        {
+            emit ErrorMessage(writer.getError());
+            return;
+        }
+
+        const ImageOptimizer::Statistics &statistics = writer.getImageStatistics();
+        QMutexLocker locker(&mtxImageTotals);
+        imageTotals.add(statistics);
+
+        if (statistics.recompressed == 0)
+            return;
+
+        ++optimizedFiles;
+        locker.unlock();
+
+        qint64 before = item.record.getSize();
+        item.record.setSize(QFileInfo(fileName).size());
+        emit EventMessage(tr("Images of %1 optimized: %2 of %3 images replaced, file size %4 KB -> %5 KB")
+                          .arg(fileName).arg(statistics.recompressed).arg(statistics.images)
+                          .arg(before / 1024).arg(item.record.getSize() / 1024));
+        break;
+    }
+
+    default:
+        return;
+    }
+
+    emit ReplaceFile(fileName, item.record);
+}
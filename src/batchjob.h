@@ -0,0 +1,304 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef BATCHJOB_H
+#define BATCHJOB_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль пакетных операций над файлами.
+ *
+ * @~english
+ * @brief Module of batch file operations.
+ */
+
+#include "job.h"
+#include "filerecord.h"
+#include "metadatatransform.h"
+#include "imageoptimizer.h"
+
+#include <QVector>
+#include <QMutex>
+
+/**
+ * @~russian
+ * @brief Перечисление пакетных операций.
+ *
+ * @~english
+ * @brief Enumeration of batch operations.
+ */
+enum BatchOperation
+{
+    boZip, ///< @~russian Упаковка файлов. @~english Compressing of files.
+    boUnzip, ///< @~russian Распаковка файлов. @~english Uncompressing of files.
+    boMove, ///< @~russian Перемещение файлов. @~english Moving of files.
+    boCopy, ///< @~russian Копирование файлов. @~english Copying of files.
+    boRename, ///< @~russian Переименование файлов. @~english Renaming of files.
+    boEditMetadata, ///< @~russian Изменение метаданных. @~english Editing of metadata.
+    boConvertUtf8, ///< @~russian Перекодирование в UTF-8. @~english Recoding to UTF-8.
+    boOptimizeImages ///< @~russian Пережатие изображений. @~english Recompression of images.
+};
+
+/**
+ * @~russian
+ * @brief Элемент пакетной операции.
+ *
+ * @~english
+ * @brief Item of batch operation.
+ */
+struct BatchItem
+{
+    FileRecord record; ///< @~russian Копия обрабатываемой записи. @~english Copy of the processed record.
+    QString target; ///< @~russian Новое имя файла для перемещения, копирования и переименования. @~english New file name for moving, copying and renaming.
+};
+
+/**
+ * @~russian
+ * @brief Задание пакетной операции над выбранными записями.
+ *
+ * Записи обрабатываются в потоке задания, измененные записи возвращаются в модель данных сигналом
+ * ReplaceFile().
+ *
+ * @~english
+ * @brief Job of batch operation over selected records.
+ *
+ * Records are processed in the job thread, changed records are returned to the data model by
+ * ReplaceFile() signal.
+ */
+class BatchJob : public Job
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор задания.
+     * @param operation Выполняемая операция.
+     * @param items Список обрабатываемых записей.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor of the job.
+     * @param operation Performed operation.
+     * @param items List of processed records.
+     * @param parent Parent object.
+     */
+    BatchJob(BatchOperation operation, const QVector<BatchItem> &items, QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Получение заголовка задания для отображения пользователю.
+     * @return Заголовок задания.
+     *
+     * @~english
+     * @brief Getting the job title to display to the user.
+     * @return Job title.
+     */
+    QString getTitle() const;
+
+    /**
+     * @~russian
+     * @brief Установка количества потоков обработки.
+     * @param threads Количество потоков, 0 - по количеству процессоров.
+     *
+     * @~english
+     * @brief Setting the number of processing threads.
+     * @param threads Number of threads, 0 - by number of processors.
+     */
+    void setThreads(int threads);
+
+    /**
+     * @~russian
+     * @brief Установка параметров сжатия.
+     * @param level Уровень сжатия от 1 (быстрое) до 9 (наилучшее).
+     * @param maxRatio Максимальное отношение размера архива к размеру файла в процентах, 0 - без проверки.
+     *
+     * @~english
+     * @brief Setting compression parameters.
+     * @param level Compression level from 1 (fast) to 9 (best).
+     * @param maxRatio Maximum ratio of archive size to file size in percent, 0 - no check.
+     */
+    void setCompression(int level, int maxRatio);
+
+    /**
+     * @~russian
+     * @brief Установка параметров пережатия изображений.
+     * @param quality Качество JPEG от 1 до 100.
+     * @param maxDimension Наибольшая ширина и высота изображения, 0 - без уменьшения.
+     *
+     * @~english
+     * @brief Setting image recompression parameters.
+     * @param quality JPEG quality from 1 to 100.
+     * @param maxDimension Largest width and height of the image, 0 - without scaling.
+     */
+    void setImageOptions(int quality, int maxDimension);
+
+    /**
+     * @~russian
+     * @brief Установка преобразований метаданных для пакетного редактирования.
+     * @param transforms Список преобразований, применяемых к каждой записи по порядку.
+     *
+     * @~english
+     * @brief Setting metadata transformations for batch editing.
+     * @param transforms List of transformations applied to every record in order.
+     */
+    void setTransforms(const QVector<MetadataTransform> &transforms);
+
+    /**
+     * @~russian
+     * @brief Тело потока вычисления.
+     *
+     * @~english
+     * @brief Body of the thread.
+     */
+    void run();
+
+signals:
+    /**
+     * @~russian
+     * @brief Замена записи в модели данных.
+     *
+     * Запись ищется по имени файла, поскольку за время выполнения задания строки модели могут сместиться.
+     * @param fileName Имя файла до обработки.
+     * @param record Новая запись.
+     *
+     * @~english
+     * @brief Replace record in data model.
+     *
+     * The record is looked up by the file name because model rows could shift while the job is running.
+     * @param fileName File name before processing.
+     * @param record New record.
+     */
+    void ReplaceFile(const QString &fileName, const FileRecord &record);
+
+protected:
+    /**
+     * @~russian
+     * @brief Обработка одной записи в потоке пула.
+     * @param index Номер записи.
+     *
+     * @~english
+     * @brief Processing of one record in the pool thread.
+     * @param index Record number.
+     */
+    void processParallel(int index);
+
+    /**
+     * @~russian
+     * @brief Выполняемая операция.
+     *
+     * @~english
+     * @brief Performed operation.
+     */
+    BatchOperation operation;
+
+    /**
+     * @~russian
+     * @brief Список обрабатываемых записей.
+     *
+     * @~english
+     * @brief List of processed records.
+     */
+    QVector<BatchItem> items;
+
+    /**
+     * @~russian
+     * @brief Количество потоков обработки.
+     *
+     * @~english
+     * @brief Number of processing threads.
+     */
+    int threads;
+
+    /**
+     * @~russian
+     * @brief Уровень сжатия.
+     *
+     * @~english
+     * @brief Compression level.
+     */
+    int level;
+
+    /**
+     * @~russian
+     * @brief Максимальное отношение размера архива к размеру файла в процентах, 0 - без проверки.
+     *
+     * @~english
+     * @brief Maximum ratio of archive size to file size in percent, 0 - no check.
+     */
+    int maxRatio;
+
+    /**
+     * @~russian
+     * @brief Преобразования метаданных.
+     *
+     * @~english
+     * @brief Metadata transformations.
+     */
+    QVector<MetadataTransform> transforms;
+
+    /**
+     * @~russian
+     * @brief Оптимизатор изображений.
+     *
+     * @~english
+     * @brief Image optimizer.
+     */
+    ImageOptimizer optimizer;
+
+    /**
+     * @~russian
+     * @brief Суммарная статистика изображений всех файлов.
+     *
+     * @~english
+     * @brief Total image statistics of all files.
+     */
+    ImageOptimizer::Statistics imageTotals;
+
+    /**
+     * @~russian
+     * @brief Количество файлов с замененными изображениями.
+     *
+     * @~english
+     * @brief Number of files with replaced images.
+     */
+    int optimizedFiles;
+
+    /**
+     * @~russian
+     * @brief Защита суммарной статистики изображений.
+     *
+     * @~english
+     * @brief Protection of total image statistics.
+     */
+    QMutex mtxImageTotals;
+
+    /**
+     * @~russian
+     * @brief Обработка одной записи.
+     * @param item Обрабатываемая запись.
+     *
+     * @~english
+     * @brief Processing of a single record.
+     * @param item Processed record.
+     */
+    void processItem(BatchItem &item);
+};
+
+#endif // BATCHJOB_H
@@ -0,0 +1,129 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации кеша результатов анализа текста книг.
+ *
+ * @~english
+ * @brief Source file for the cache of book text analysis results.
+ */
+
+#include "bodycache.h"
+#include "filerecord.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+/*
+ * Signature and version of the cache file.
+ */
+static const quint32 cacheMagic = 0x46424253;
+static const quint32 cacheVersion = 2;
+
+static QDataStream &operator<<(QDataStream &stream, const BodyStatistics &statistics)
+{
+    return stream << statistics.words << statistics.characters << statistics.fingerprint;
+}
+
+static QDataStream &operator>>(QDataStream &stream, BodyStatistics &statistics)
+{
+    return stream >> statistics.words >> statistics.characters >> statistics.fingerprint;
+}
+
+BodyCache &BodyCache::instance()
+{
+    static BodyCache cache;
+    return cache;
+}
+
+BodyCache::BodyCache()
+{
+    fileName = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/bodies.dat";
+    changed = false;
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+
+    if ((magic != cacheMagic) || (version != cacheVersion))
+        return;
+
+    QHash<QString, BodyStatistics> loaded;
+    stream >> loaded;
+
+    if (stream.status() == QDataStream::Ok)
+        entries = loaded;
+}
+
+bool BodyCache::find(const QString &fileName, BodyStatistics &statistics)
+{
+    QString key = FileRecord::getVersionKey(fileName);
+    QMutexLocker locker(&mutex);
+    QHash<QString, BodyStatistics>::const_iterator it = entries.constFind(key);
+
+    if (it == entries.constEnd())
+        return false;
+
+    statistics = it.value();
+    return true;
+}
+
+void BodyCache::insert(const QString &fileName, const BodyStatistics &statistics)
+{
+    QString key = FileRecord::getVersionKey(fileName);
+    QMutexLocker locker(&mutex);
+    entries.insert(key, statistics);
+    changed = true;
+}
+
+void BodyCache::save()
+{
+    QMutexLocker locker(&mutex);
+
+    if (!changed)
+        return;
+
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << cacheMagic << cacheVersion << entries;
+
+    if ((stream.status() == QDataStream::Ok) && file.commit())
+        changed = false;
+}
@@ -0,0 +1,123 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef BODYCACHE_H
+#define BODYCACHE_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль кеша результатов анализа текста книг.
+ *
+ * @~english
+ * @brief Module of the cache of book text analysis results.
+ */
+
+#include "types.h"
+
+#include <QString>
+#include <QHash>
+#include <QMutex>
+
+/**
+ * @~russian
+ * @brief Кеш результатов анализа текста книг.
+ *
+ * Результат хранится по ключу «файл книги, размер, время изменения», поэтому текст каждой версии файла
+ * анализируется один раз, а измененная книга анализируется заново. Кеш один на программу, загружается при первом
+ * обращении и сохраняется после каждого задания анализа. Все методы потокобезопасны.
+ *
+ * @~english
+ * @brief Cache of book text analysis results.
+ *
+ * A result is stored by the key "book file, size, modification time", so the text of each file version is
+ * analyzed once, and a changed book is analyzed again. The cache is one per program, it is loaded at the first
+ * access and saved after each analysis job. All methods are thread-safe.
+ */
+class BodyCache
+{
+public:
+    /**
+     * @~russian
+     * @brief Получение кеша программы.
+     * @return Кеш.
+     *
+     * @~english
+     * @brief Getting the program cache.
+     * @return Cache.
+     */
+    static BodyCache &instance();
+
+    /**
+     * @~russian
+     * @brief Поиск результата для текущей версии файла.
+     * @param fileName Имя файла книги.
+     * @param statistics Статистика, в которую помещается найденный результат.
+     * @return @c true - если результат найден;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Searching the result for the current file version.
+     * @param fileName Book file name.
+     * @param statistics Statistics receiving the found result.
+     * @return @c true - if the result is found;@n
+     * @c false - if not.
+     */
+    bool find(const QString &fileName, BodyStatistics &statistics);
+
+    /**
+     * @~russian
+     * @brief Сохранение результата для текущей версии файла.
+     * @param fileName Имя файла книги.
+     * @param statistics Статистика текста.
+     *
+     * @~english
+     * @brief Storing the result for the current file version.
+     * @param fileName Book file name.
+     * @param statistics Text statistics.
+     */
+    void insert(const QString &fileName, const BodyStatistics &statistics);
+
+    /**
+     * @~russian
+     * @brief Запись кеша на диск, если он изменился.
+     *
+     * @~english
+     * @brief Writing the cache to disk if it is changed.
+     */
+    void save();
+
+private:
+    /**
+     * @~russian
+     * @brief Конструктор, загружает кеш с диска.
+     *
+     * @~english
+     * @brief Constructor, loads the cache from disk.
+     */
+    BodyCache();
+
+    QString fileName; ///< @~russian Файл кеша. @~english Cache file.
+    QMutex mutex; ///< @~russian Защита результатов. @~english Protection of results.
+    QHash<QString, BodyStatistics> entries; ///< @~russian Ключ версии файла -> результат. @~english File version key -> result.
+    bool changed; ///< @~russian Кеш изменен после загрузки или сохранения. @~english The cache is changed after loading or saving.
+};
+
+#endif // BODYCACHE_H
@@ -0,0 +1,100 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации задания анализа текста книг.
+ *
+ * @~english
+ * @brief Source file for the book text analysis job.
+ */
+
+#include "bodyjob.h"
+#include "bodyscanner.h"
+#include "bodycache.h"
+
+BodyJob::BodyJob(const QVector<FileRecord> &records, QObject *parent) :
+    Job(parent)
+{
+    this->records = records;
+    threads = 0;
+
+    qint64 bytes = 0;
+    QVector<FileRecord>::const_iterator it;
+
+    for (it = this->records.constBegin(); it != this->records.constEnd(); ++it)
+    {
+        bytes += (*it).getSize();
+    }
+
+    setTotal(this->records.count(), bytes);
+
+    qRegisterMetaType<BodyStatistics>("BodyStatistics");
+}
+
+QString BodyJob::getTitle() const
+{
+    return tr("Analyzing book text");
+}
+
+void BodyJob::setThreads(int threads)
+{
+    this->threads = threads;
+}
+
+void BodyJob::run()
+{
+    runParallel(records.count(), threads);
+
+    // Even a cancelled job keeps its results for the next time
+    BodyCache::instance().save();
+
+    if (isCancelled())
+        emit EventMessage(tr("%1: cancelled").arg(getTitle()));
+    else
+        emit EventMessage(tr("Text of %1 books analyzed, %2 taken from the cache, %3 not read")
+                          .arg(records.count()).arg(cached.load()).arg(failed.load()));
+}
+
+void BodyJob::processParallel(int index)
+{
+    const FileRecord &record = records.at(index);
+    BodyStatistics statistics;
+
+    if (BodyCache::instance().find(record.getFileName(), statistics))
+    {
+        cached.ref();
+    }
+    else if (BodyScanner::scan(record, statistics))
+    {
+        BodyCache::instance().insert(record.getFileName(), statistics);
+    }
+    else
+    {
+        failed.ref();
+        emit ErrorMessage(tr("Cannot read the text of %1").arg(record.getFileName()));
+        addProgress(1, record.getSize());
+        return;
+    }
+
+    emit BodyAnalyzed(record.getFileName(), statistics);
+    addProgress(1, record.getSize());
+}
@@ -0,0 +1,136 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef BODYJOB_H
+#define BODYJOB_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль задания анализа текста книг.
+ *
+ * @~english
+ * @brief Module of the book text analysis job.
+ */
+
+#include "job.h"
+#include "filerecord.h"
+
+#include <QVector>
+#include <QAtomicInt>
+#include <QMetaType>
+
+Q_DECLARE_METATYPE(BodyStatistics)
+
+/**
+ * @~russian
+ * @brief Задание анализа текста книг.
+ *
+ * Файлы анализируются параллельно. Результат для неизмененного файла берется из кеша, поэтому повторный анализ
+ * библиотеки читает только новые и измененные книги.
+ *
+ * @~english
+ * @brief Job of book text analysis.
+ *
+ * Files are analyzed in parallel. The result for an unchanged file is taken from the cache, so repeated analysis
+ * of the library reads only new and changed books.
+ */
+class BodyJob : public Job
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param records Анализируемые записи.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param records Analyzed records.
+     * @param parent Parent object.
+     */
+    explicit BodyJob(const QVector<FileRecord> &records, QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Получение названия задания.
+     * @return Название задания.
+     *
+     * @~english
+     * @brief Getting the job title.
+     * @return Job title.
+     */
+    QString getTitle() const;
+
+    /**
+     * @~russian
+     * @brief Установка количества потоков обработки.
+     * @param threads Количество потоков, 0 - по количеству процессоров.
+     *
+     * @~english
+     * @brief Setting the number of processing threads.
+     * @param threads Number of threads, 0 - by number of processors.
+     */
+    void setThreads(int threads);
+
+    /**
+     * @~russian
+     * @brief Выполнение задания.
+     *
+     * @~english
+     * @brief Running the job.
+     */
+    void run();
+
+signals:
+    /**
+     * @~russian
+     * @brief Сигнал о готовности статистики текста книги.
+     * @param fileName Имя файла книги.
+     * @param statistics Статистика текста.
+     *
+     * @~english
+     * @brief Signal of the book text statistics readiness.
+     * @param fileName Book file name.
+     * @param statistics Text statistics.
+     */
+    void BodyAnalyzed(const QString &fileName, const BodyStatistics &statistics);
+
+protected:
+    /**
+     * @~russian
+     * @brief Анализ одной записи в рабочем потоке.
+     * @param index Номер записи.
+     *
+     * @~english
+     * @brief Analysis of a single record in a worker thread.
+     * @param index Record number.
+     */
+    void processParallel(int index);
+
+private:
+    QVector<FileRecord> records; ///< @~russian Анализируемые записи. @~english Analyzed records.
+    int threads; ///< @~russian Количество потоков обработки. @~english Number of processing threads.
+    QAtomicInt cached; ///< @~russian Результатов из кеша. @~english Results from the cache.
+    QAtomicInt failed; ///< @~russian Непрочитанных файлов. @~english Unread files.
+};
+
+#endif // BODYJOB_H
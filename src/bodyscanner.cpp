@@ -0,0 +1,566 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации анализа текста книги.
+ *
+ * @~english
+ * @brief Source file for book text analysis.
+ */
+
+#include "bodyscanner.h"
+#include "filerecord.h"
+#include "cyrillicdecoder.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QChar>
+#include <QFile>
+
+#include <string.h>
+
+const int readChunkSize = 65536;
+
+/*
+ * Byte classes. A continuation byte of UTF-8 repeats the class of the lead byte, a markup byte ends the text run.
+ * The "none" class is never in the tables and marks the beginning of the text.
+ */
+const uint clSpace = 0;
+const uint clPunctuation = 1;
+const uint clWord = 2;
+const uint clNone = 3;
+const uint clContinuation = 4;
+const uint clMarkup = 8;
+
+/*
+ * Normalized characters that are not letters: a separator ends the word, an ignored character (stress mark,
+ * soft hyphen) is dropped from it.
+ */
+const uint chSeparator = 0;
+const uint chIgnored = 1;
+
+/*
+ * FNV-1a parameters of word hashes.
+ */
+const quint32 fnvBasis = 2166136261u;
+const quint32 fnvPrime = 16777619u;
+
+/*
+ * Finalizer of splitmix64, spreads the hash of a fragment over all bits.
+ */
+static inline quint64 mix(quint64 value)
+{
+    value ^= value >> 30;
+    value *= Q_UINT64_C(0xBF58476D1CE4E5B9);
+    value ^= value >> 27;
+    value *= Q_UINT64_C(0x94D049BB133111EB);
+    value ^= value >> 31;
+    return value;
+}
+
+/*
+ * Folding of a Unicode character for comparison of texts. Russian and Latin letters are handled without
+ * Unicode tables because they make up almost all of the text.
+ */
+static uint foldCharacter(uint code)
+{
+    if (((code >= 'a') && (code <= 'z')) || ((code >= '0') && (code <= '9')) || ((code >= 0x430) && (code <= 0x44F)))
+        return code;
+
+    if (((code >= 'A') && (code <= 'Z')) || ((code >= 0x410) && (code <= 0x42F)))
+        return code + 0x20;
+
+    if ((code == 0x401) || (code == 0x451))
+        return 0x435;
+
+    if (code < 0x80)
+        return chSeparator;
+
+    if ((code == 0xAD) || (QChar::category(code) == QChar::Mark_NonSpacing))
+        return chIgnored;
+
+    return QChar::isLetterOrNumber(code) ? QChar::toCaseFolded(code) : chSeparator;
+}
+
+/*
+ * Tables of byte classes for the supported encodings.
+ */
+struct BodyTables
+{
+    uchar utf8[256];
+    uchar windows1251[256];
+    uchar koi8r[256];
+    uchar singleByte[256];
+    uint latinLetters[256];
+    uint windows1251Letters[256];
+    uint koi8rLetters[256];
+    quint32 lowFactors[BodyStatistics::fingerprintSize];
+    quint32 highFactors[BodyStatistics::fingerprintSize];
+
+    BodyTables()
+    {
+        uchar ascii[128];
+
+        for (int i = 0; i < 128; ++i)
+        {
+            if (i <= 0x20)
+                ascii[i] = clSpace;
+            else if (((i >= '0') && (i <= '9')) || ((i >= 'A') && (i <= 'Z')) || ((i >= 'a') && (i <= 'z')))
+                ascii[i] = clWord;
+            else
+                ascii[i] = clPunctuation;
+        }
+
+        ascii[static_cast<int>('<')] = clMarkup;
+        ascii[static_cast<int>('&')] = clMarkup;
+
+        memcpy(utf8, ascii, 128);
+        memcpy(windows1251, ascii, 128);
+        memcpy(koi8r, ascii, 128);
+        memcpy(singleByte, ascii, 128);
+
+        // U+0080..U+00BF (lead byte C2) and U+2000..U+2FFF (lead byte E2) are punctuation and symbols
+        memset(utf8 + 0x80, clContinuation, 0x40);
+        memset(utf8 + 0xC0, clWord, 0x40);
+        utf8[0xC2] = clPunctuation;
+        utf8[0xE2] = clPunctuation;
+
+        // Cyrillic letters of windows-1251 besides the main range: Serbian, Macedonian, Ukrainian and Belarusian
+        static const uchar letters1251[] = {0x80, 0x81, 0x83, 0x8A, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x9A, 0x9C, 0x9D,
+                                            0x9E, 0x9F, 0xA1, 0xA2, 0xA3, 0xA5, 0xA8, 0xAA, 0xAF, 0xB2, 0xB3, 0xB4,
+                                            0xB8, 0xBA, 0xBC, 0xBD, 0xBE, 0xBF
+                                           };
+        memset(windows1251 + 0x80, clPunctuation, 0x40);
+        memset(windows1251 + 0xC0, clWord, 0x40);
+        windows1251[0xA0] = clSpace;
+
+        for (size_t i = 0; i < sizeof(letters1251); ++i)
+        {
+            windows1251[letters1251[i]] = clWord;
+        }
+
+        // The upper half of koi8-r below the letters is box drawing, Ё and ё are separate
+        memset(koi8r + 0x80, clPunctuation, 0x40);
+        memset(koi8r + 0xC0, clWord, 0x40);
+        koi8r[0x9A] = clSpace;
+        koi8r[0xA3] = clWord;
+        koi8r[0xB3] = clWord;
+
+        memset(singleByte + 0x80, clWord, 0x80);
+
+        // Normalized characters, unknown single-byte encodings are read as Latin-1
+        char bytes[256];
+        ushort windows1251Codes[256];
+        ushort koi8rCodes[256];
+
+        for (int i = 0; i < 256; ++i)
+        {
+            bytes[i] = static_cast<char>(i);
+        }
+
+        CyrillicDecoder::decode(bytes, 256, CyrillicDecoder::cpWindows1251, windows1251Codes);
+        CyrillicDecoder::decode(bytes, 256, CyrillicDecoder::cpKoi8R, koi8rCodes);
+
+        for (int i = 0; i < 256; ++i)
+        {
+            latinLetters[i] = foldCharacter(i);
+            windows1251Letters[i] = foldCharacter(windows1251Codes[i]);
+            koi8rLetters[i] = foldCharacter(koi8rCodes[i]);
+        }
+
+        // Odd factors of the hash functions come from a fixed seed because signatures are kept in the cache
+        quint64 seed = Q_UINT64_C(0x4642324D45484153);
+
+        for (int i = 0; i < BodyStatistics::fingerprintSize; ++i)
+        {
+            seed += Q_UINT64_C(0x9E3779B97F4A7C15);
+            quint64 value = mix(seed);
+            lowFactors[i] = static_cast<quint32>(value) | 1;
+            highFactors[i] = static_cast<quint32>(value >> 32) | 1;
+        }
+    }
+};
+
+static const BodyTables &tables()
+{
+    static const BodyTables instance;
+    return instance;
+}
+
+/*
+ * Callback of miniz extraction, stops unpacking as soon as the analysis is finished.
+ */
+static size_t feedScanner(void *opaque, mz_uint64 offset, const void *data, size_t size)
+{
+    Q_UNUSED(offset)
+
+    BodyScanner *scanner = static_cast<BodyScanner *>(opaque);
+    return scanner->feed(static_cast<const char *>(data), static_cast<int>(size)) ? 0 : size;
+}
+
+BodyScanner::BodyScanner(const QString &encoding) :
+    state(stText),
+    complete(false),
+    depth(0),
+    last(clNone),
+    nameLength(0),
+    nameDone(false),
+    closing(false),
+    words(0),
+    characters(0),
+    codePoint(0),
+    pending(0),
+    wordHash(fnvBasis),
+    wordLength(0),
+    hashedWords(0)
+{
+    QByteArray name = encoding.toLatin1().toLower();
+    utf8 = false;
+    letters = tables().latinLetters;
+
+    switch (CyrillicDecoder::codePageForName(name))
+    {
+    case CyrillicDecoder::cpWindows1251:
+        classes = tables().windows1251;
+        letters = tables().windows1251Letters;
+        break;
+
+    case CyrillicDecoder::cpKoi8R:
+        classes = tables().koi8r;
+        letters = tables().koi8rLetters;
+        break;
+
+    default:
+        // XML without declared encoding is UTF-8
+        utf8 = name.isEmpty() || name.startsWith("utf");
+        classes = utf8 ? tables().utf8 : tables().singleByte;
+        break;
+    }
+
+    memset(window, 0, sizeof(window));
+    memset(minimums, 0xFF, sizeof(minimums));
+}
+
+bool BodyScanner::feed(const char *data, int size)
+{
+    const uchar *current = reinterpret_cast<const uchar *>(data);
+    const uchar *end = current + size;
+
+    while ((current < end) && (!complete))
+    {
+        switch (state)
+        {
+        case stText:
+            if (depth == 0)
+            {
+                // Outside the body only tags are of interest
+                const uchar *tag = static_cast<const uchar *>(memchr(current, '<', end - current));
+                current = tag ? tag : end;
+            }
+            else
+            {
+                const uchar *text = current;
+                current = countText(current, end);
+                hashText(text, current);
+            }
+
+            if (current == end)
+                break;
+
+            // Markup and entities end the word being hashed
+            if (wordLength > 0)
+                endWord();
+
+            pending = 0;
+
+            if (*current == '<')
+            {
+                state = stTag;
+                nameLength = 0;
+                nameDone = false;
+                closing = false;
+
+                // Markup separates words
+                if (last != clNone)
+                    last = clSpace;
+            }
+            else
+            {
+                characters += 1 + ((last == clSpace) ? 1 : 0);
+                last = clPunctuation;
+                state = stEntity;
+            }
+
+            ++current;
+            break;
+
+        case stEntity:
+            while ((current < end) && (*current != ';') && (*current != '<') && (*current > ' '))
+            {
+                ++current;
+            }
+
+            if (current < end)
+            {
+                if (*current == ';')
+                    ++current;
+
+                state = stText;
+            }
+
+            break;
+
+        case stTag:
+            while ((current < end) && (!nameDone))
+            {
+                uchar c = *current;
+
+                if ((c == '/') && (nameLength == 0) && (!closing))
+                {
+                    closing = true;
+                    ++current;
+                    continue;
+                }
+
+                if ((c == '>') || (c == '/') || (c <= ' '))
+                {
+                    nameDone = true;
+                    break;
+                }
+
+                if (nameLength < maxNameLength)
+                    name[nameLength] = static_cast<char>(c);
+
+                ++nameLength;
+                ++current;
+            }
+
+            if (current < end)
+            {
+                const uchar *bracket = static_cast<const uchar *>(memchr(current, '>', end - current));
+
+                if (bracket)
+                {
+                    current = bracket + 1;
+                    state = stText;
+                    endTag();
+                }
+                else
+                    current = end;
+            }
+
+            break;
+        }
+    }
+
+    return complete;
+}
+
+BodyStatistics BodyScanner::getStatistics() const
+{
+    BodyStatistics statistics;
+    statistics.words = words;
+    statistics.characters = characters;
+
+    if (hashedWords - (shingleSize - 1) >= minShingles)
+    {
+        statistics.fingerprint.resize(BodyStatistics::fingerprintSize);
+        memcpy(statistics.fingerprint.data(), minimums, sizeof(minimums));
+    }
+
+    return statistics;
+}
+
+/*
+ * Every byte goes through the same arithmetic: a character starts on a byte that is not a continuation,
+ * a space is added before a visible character after whitespace, a word starts where the word class begins.
+ */
+const uchar *BodyScanner::countText(const uchar *data, const uchar *end)
+{
+    uint previous = last;
+    qint64 wordCount = 0;
+    qint64 characterCount = 0;
+
+    for (; data < end; ++data)
+    {
+        uint current = classes[*data];
+
+        if (current & clMarkup)
+            break;
+
+        uint continuation = current >> 2;
+        current = continuation ? previous : current;
+        uint start = (continuation ^ 1) & (current != clSpace);
+
+        characterCount += start + (start & (previous == clSpace));
+        wordCount += (current == clWord) & (previous != clWord);
+        previous = current;
+    }
+
+    last = previous;
+    words += wordCount;
+    characters += characterCount;
+    return data;
+}
+
+/*
+ * UTF-8 is decoded to Unicode so that the same book in different encodings gives the same hashes.
+ */
+void BodyScanner::hashText(const uchar *data, const uchar *end)
+{
+    for (; data < end; ++data)
+    {
+        uint code = *data;
+
+        if (utf8 && (code >= 0x80))
+        {
+            if (code >= 0xC0)
+            {
+                pending = (code >= 0xF0) ? 3 : ((code >= 0xE0) ? 2 : 1);
+                codePoint = code & (0x3F >> pending);
+                continue;
+            }
+
+            // A stray continuation byte is skipped
+            if (pending == 0)
+                continue;
+
+            codePoint = (codePoint << 6) | (code & 0x3F);
+
+            if (--pending > 0)
+                continue;
+
+            code = foldCharacter(codePoint);
+        }
+        else
+        {
+            pending = 0;
+            code = letters[code];
+        }
+
+        if (code > chIgnored)
+        {
+            wordHash = (wordHash ^ code) * fnvPrime;
+            ++wordLength;
+        }
+        else if ((code == chSeparator) && (wordLength > 0))
+            endWord();
+    }
+}
+
+/*
+ * A fragment of adjacent words is hashed to 64 bits, then every hash function of the signature is a cheap
+ * combination of its halves. The loop over the functions has no dependencies and is vectorized by the compiler.
+ */
+void BodyScanner::endWord()
+{
+    quint32 word = wordHash;
+    wordHash = fnvBasis;
+    wordLength = 0;
+
+    if (++hashedWords >= shingleSize)
+    {
+        quint64 shingle = word;
+
+        for (int i = 0; i < shingleSize - 1; ++i)
+        {
+            shingle = mix(shingle * Q_UINT64_C(0x9E3779B97F4A7C15) + window[i]);
+        }
+
+        quint32 low = static_cast<quint32>(shingle);
+        quint32 high = static_cast<quint32>(shingle >> 32);
+        const BodyTables &hashTables = tables();
+
+        for (int i = 0; i < BodyStatistics::fingerprintSize; ++i)
+        {
+            quint32 value = low * hashTables.lowFactors[i] + high * hashTables.highFactors[i];
+            minimums[i] = qMin(minimums[i], value);
+        }
+    }
+
+    for (int i = 0; i < shingleSize - 2; ++i)
+    {
+        window[i] = window[i + 1];
+    }
+
+    window[shingleSize - 2] = word;
+}
+
+void BodyScanner::endTag()
+{
+    if ((nameLength == 4) && (memcmp(name, "body", 4) == 0))
+    {
+        if (!closing)
+            ++depth;
+        else if (depth > 0)
+            --depth;
+    }
+    else if ((nameLength == 6) && (memcmp(name, "binary", 6) == 0) && (!closing))
+        complete = true;
+}
+
+bool BodyScanner::scan(const FileRecord &record, BodyStatistics &statistics)
+{
+    BodyScanner scanner(record.getEncoding());
+
+    if (record.isArchive())
+    {
+        mz_zip_archive archive;
+        memset(&archive, 0, sizeof(archive));
+
+        if (!mz_zip_reader_init_file(&archive, QFile::encodeName(record.getFileName()).constData(), 0))
+            return false;
+
+        // Unpacking stopped by the callback reports failure, so the scanner state is checked as well
+        bool succeeded = (mz_zip_reader_get_num_files(&archive) == 1) &&
+                         (mz_zip_reader_extract_to_callback(&archive, 0, feedScanner, &scanner, 0) || scanner.complete);
+        mz_zip_reader_end(&archive);
+
+        if (!succeeded)
+            return false;
+    }
+    else
+    {
+        QFile file(record.getFileName());
+
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        QByteArray chunk(readChunkSize, Qt::Uninitialized);
+        qint64 size;
+
+        while ((size = file.read(chunk.data(), chunk.size())) > 0)
+        {
+            if (scanner.feed(chunk.constData(), static_cast<int>(size)))
+                break;
+        }
+
+        if (size < 0)
+            return false;
+    }
+
+    statistics = scanner.getStatistics();
+    return true;
+}
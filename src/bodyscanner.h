@@ -0,0 +1,217 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef BODYSCANNER_H
+#define BODYSCANNER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль анализа текста книги.
+ *
+ * @~english
+ * @brief Module of book text analysis.
+ */
+
+#include "types.h"
+
+#include <QtGlobal>
+
+// Forward class declarations
+class FileRecord;
+
+/**
+ * @~russian
+ * @brief Потоковый подсчет слов и символов в тексте книги.
+ *
+ * Документ передается частями любого размера и не разбирается как XML: теги пропускаются, учитывается только
+ * текст внутри элементов @c body, сущность считается одним символом. Анализ заканчивается на первом разделе
+ * @c binary, поэтому изображения в конце книги не читаются.@n
+ * Байты классифицируются по таблице кодировки книги (UTF-8, windows-1251, koi8-r), цикл по тексту между тегами
+ * не содержит ветвлений, кроме проверки начала разметки.@n
+ * В том же проходе строится сигнатура MinHash текста: слова нормализуются (регистр свертывается, «ё» заменяется
+ * на «е», ударения и мягкие переносы удаляются), тройки соседних слов хэшируются, для каждой из
+ * BodyStatistics::fingerprintSize хэш-функций сохраняется минимум. Слова декодируются в Unicode, поэтому
+ * сигнатура не зависит от кодировки файла.
+ *
+ * @~english
+ * @brief Streaming count of words and characters in the book text.
+ *
+ * The document is passed in chunks of any size and is not parsed as XML: tags are skipped, only the text inside
+ * @c body elements is counted, an entity is counted as one character. The analysis ends at the first @c binary
+ * section, so images at the end of the book are not read.@n
+ * Bytes are classified by the table of the book encoding (UTF-8, windows-1251, koi8-r), the loop over the text
+ * between tags has no branches except the check for markup start.@n
+ * The MinHash signature of the text is built in the same pass: words are normalized (the case is folded, "ё" is
+ * replaced with "е", stress marks and soft hyphens are removed), triples of adjacent words are hashed, and the
+ * minimum is kept for each of BodyStatistics::fingerprintSize hash functions. Words are decoded to Unicode,
+ * so the signature does not depend on the file encoding.
+ */
+class BodyScanner
+{
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param encoding Кодировка книги из объявления XML.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param encoding Book encoding from XML declaration.
+     */
+    explicit BodyScanner(const QString &encoding);
+
+    /**
+     * @~russian
+     * @brief Обработка очередной части документа.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @return @c true - если анализ закончен и остаток документа не нужен;@n
+     * @c false - если нужны следующие части.
+     *
+     * @~english
+     * @brief Processing of the next part of the document.
+     * @param data Data.
+     * @param size Data size.
+     * @return @c true - if the analysis is finished and the rest of the document is not needed;@n
+     * @c false - if the next parts are needed.
+     */
+    bool feed(const char *data, int size);
+
+    /**
+     * @~russian
+     * @brief Получение статистики обработанной части документа.
+     * @return Статистика текста.
+     *
+     * @~english
+     * @brief Getting statistics of the processed part of the document.
+     * @return Text statistics.
+     */
+    BodyStatistics getStatistics() const;
+
+    /**
+     * @~russian
+     * @brief Анализ текста книги.
+     *
+     * Обычный файл читается частями, архив распаковывается частями через miniz.
+     * @param record Запись о файле.
+     * @param statistics Статистика, в которую помещается результат.
+     * @return @c true - если файл прочитан;@n
+     * @c false - если файл не удалось открыть или распаковать.
+     *
+     * @~english
+     * @brief Analysis of the book text.
+     *
+     * A plain file is read in chunks, an archive is unpacked in chunks by miniz.
+     * @param record File record.
+     * @param statistics Statistics receiving the result.
+     * @return @c true - if the file is read;@n
+     * @c false - if the file could not be opened or unpacked.
+     */
+    static bool scan(const FileRecord &record, BodyStatistics &statistics);
+
+private:
+    /**
+     * @~russian
+     * @brief Состояние разбора между частями документа.
+     *
+     * @~english
+     * @brief Parsing state between parts of the document.
+     */
+    enum State
+    {
+        stText, ///< @~russian Текст. @~english Text.
+        stTag, ///< @~russian Внутри тега. @~english Inside a tag.
+        stEntity ///< @~russian Внутри сущности. @~english Inside an entity.
+    };
+
+    static const int maxNameLength = 8; ///< @~russian Длина хранимого имени тега. @~english Length of the kept tag name.
+    static const int shingleSize = 3; ///< @~russian Слов в хэшируемом фрагменте. @~english Words in a hashed fragment.
+    static const int minShingles = 16; ///< @~russian Фрагментов для построения сигнатуры. @~english Fragments to build the signature.
+
+    const uchar *classes; ///< @~russian Таблица классов байт. @~english Table of byte classes.
+    const uint *letters; ///< @~russian Таблица нормализованных символов байт. @~english Table of normalized characters of bytes.
+    bool utf8; ///< @~russian Кодировка UTF-8. @~english UTF-8 encoding.
+    State state; ///< @~russian Состояние разбора. @~english Parsing state.
+    bool complete; ///< @~russian Анализ закончен. @~english The analysis is finished.
+    int depth; ///< @~russian Вложенность элементов @c body. @~english Nesting of @c body elements.
+    uint last; ///< @~russian Класс последнего символа текста. @~english Class of the last text character.
+    char name[maxNameLength]; ///< @~russian Начало имени текущего тега. @~english Beginning of the current tag name.
+    int nameLength; ///< @~russian Длина имени текущего тега. @~english Length of the current tag name.
+    bool nameDone; ///< @~russian Имя тега прочитано. @~english The tag name is read.
+    bool closing; ///< @~russian Текущий тег закрывающий. @~english The current tag is closing.
+    qint64 words; ///< @~russian Количество слов. @~english Number of words.
+    qint64 characters; ///< @~russian Количество символов. @~english Number of characters.
+    uint codePoint; ///< @~russian Декодируемый символ UTF-8. @~english UTF-8 character being decoded.
+    int pending; ///< @~russian Оставшиеся байты символа UTF-8. @~english Remaining bytes of UTF-8 character.
+    quint32 wordHash; ///< @~russian Хэш текущего слова. @~english Hash of the current word.
+    int wordLength; ///< @~russian Длина текущего слова. @~english Length of the current word.
+    quint32 window[shingleSize - 1]; ///< @~russian Хэши предыдущих слов. @~english Hashes of the previous words.
+    qint64 hashedWords; ///< @~russian Количество хэшированных слов. @~english Number of hashed words.
+    quint32 minimums[BodyStatistics::fingerprintSize]; ///< @~russian Минимумы хэш-функций. @~english Minimums of hash functions.
+
+    /**
+     * @~russian
+     * @brief Подсчет текста до начала разметки.
+     * @param data Начало текста.
+     * @param end Конец данных.
+     * @return Позиция начала разметки или конец данных.
+     *
+     * @~english
+     * @brief Counting the text up to the markup start.
+     * @param data Text start.
+     * @param end Data end.
+     * @return Position of the markup start or the data end.
+     */
+    const uchar *countText(const uchar *data, const uchar *end);
+
+    /**
+     * @~russian
+     * @brief Хэширование слов текста.
+     * @param data Начало текста.
+     * @param end Конец текста без разметки.
+     *
+     * @~english
+     * @brief Hashing words of the text.
+     * @param data Text start.
+     * @param end Text end without markup.
+     */
+    void hashText(const uchar *data, const uchar *end);
+
+    /**
+     * @~russian
+     * @brief Завершение текущего слова и добавление фрагмента в сигнатуру.
+     *
+     * @~english
+     * @brief Ending the current word and adding the fragment to the signature.
+     */
+    void endWord();
+
+    /**
+     * @~russian
+     * @brief Обработка прочитанного тега.
+     *
+     * @~english
+     * @brief Processing of the read tag.
+     */
+    void endTag();
+};
+
+#endif // BODYSCANNER_H
@@ -87,6 +87,76 @@ const QString nameValue = "Value";
  * @brief Name of group of settings «External editors».
  */
 const QString nameExtEditorGroup = "External editors";
+/**
+ * @~russian
+ * @brief Имя группы настроек «Обработка файлов».
+ * @~english
+ * @brief Name of group of settings «File processing».
+ */
+const QString nameProcessingGroup = "Processing";
+/**
+ * @~russian
+ * @brief Имя настройки «Количество потоков обработки», 0 - по количеству процессоров.
+ * @~english
+ * @brief Name of setting «Number of processing threads», 0 - by number of processors.
+ */
+const QString nameThreads = "Threads";
+/**
+ * @~russian
+ * @brief Имя настройки «Уровень сжатия».
+ * @~english
+ * @brief Name of setting «Compression level».
+ */
+const QString nameCompressionLevel = "CompressionLevel";
+/**
+ * @~russian
+ * @brief Имя настройки «Максимальное отношение размера архива к размеру файла в процентах», 0 - без проверки.
+ * @~english
+ * @brief Name of setting «Maximum ratio of archive size to file size in percent», 0 - no check.
+ */
+const QString nameMaxCompressionRatio = "MaxCompressionRatio";
+/**
+ * @~russian
+ * @brief Имя настройки «Качество JPEG при пережатии изображений».
+ * @~english
+ * @brief Name of setting «JPEG quality of image recompression».
+ */
+const QString nameImageQuality = "ImageQuality";
+/**
+ * @~russian
+ * @brief Имя настройки «Наибольший размер изображения в пикселях», 0 - без уменьшения.
+ * @~english
+ * @brief Name of setting «Largest image size in pixels», 0 - without scaling.
+ */
+const QString nameMaxImageSize = "MaxImageSize";
+/**
+ * @~russian
+ * @brief Имя настройки «Подставлять в шаблоны канонические имена авторов».
+ * @~english
+ * @brief Name of setting «Substitute canonical author names in templates».
+ */
+const QString nameCanonicalAuthors = "CanonicalAuthors";
+/**
+ * @~russian
+ * @brief Имя настройки «Анализировать текст книг после чтения».
+ * @~english
+ * @brief Name of setting «Analyze book text after reading».
+ */
+const QString nameAnalyzeBodies = "AnalyzeBodies";
+/**
+ * @~russian
+ * @brief Имя настройки «Наибольший размер общего архива в мегабайтах».
+ * @~english
+ * @brief Name of setting «Largest size of a shared archive in megabytes».
+ */
+const QString namePackSize = "PackSize";
+/**
+ * @~russian
+ * @brief Имя настройки «Сохранять каталог INPX при упаковке в общие архивы».
+ * @~english
+ * @brief Name of setting «Save INPX catalog when packing into shared archives».
+ */
+const QString nameWriteInpx = "WriteInpx";
 }
 
 #endif // CONSTS_H
@@ -0,0 +1,75 @@
+#-------------------------------------------------
+#
+# Application core shared by fb2me and the benchmarks
+#
+#-------------------------------------------------
+
+INCLUDEPATH += $$PWD $$PWD/..
+
+SOURCES += $$PWD/tablemodel.cpp \
+    $$PWD/filerecord.cpp \
+    $$PWD/person.cpp \
+    $$PWD/filereader.cpp \
+    $$PWD/job.cpp \
+    $$PWD/batchjob.cpp \
+    $$PWD/unzipjob.cpp \
+    $$PWD/paralleldeflate.cpp \
+    $$PWD/crc32.cpp \
+    $$PWD/metadatawriter.cpp \
+    $$PWD/metadatatransform.cpp \
+    $$PWD/scanarena.cpp \
+    $$PWD/genreregistry.cpp \
+    $$PWD/cyrillicdecoder.cpp \
+    $$PWD/recordvalidator.cpp \
+    $$PWD/homoglyphfixer.cpp \
+    $$PWD/authorindex.cpp \
+    $$PWD/profiler.cpp \
+    $$PWD/scanreport.cpp \
+    $$PWD/base64.cpp \
+    $$PWD/coverextractor.cpp \
+    $$PWD/covercache.cpp \
+    $$PWD/imageoptimizer.cpp \
+    $$PWD/bodyscanner.cpp \
+    $$PWD/bodycache.cpp \
+    $$PWD/bodyjob.cpp \
+    $$PWD/similarityindex.cpp \
+    $$PWD/repackjob.cpp \
+    $$PWD/csv.cpp
+
+HEADERS += $$PWD/tablemodel.h \
+    $$PWD/filerecord.h \
+    $$PWD/person.h \
+    $$PWD/filereader.h \
+    $$PWD/consts.h \
+    $$PWD/types.h \
+    $$PWD/job.h \
+    $$PWD/batchjob.h \
+    $$PWD/unzipjob.h \
+    $$PWD/paralleldeflate.h \
+    $$PWD/crc32.h \
+    $$PWD/metadatawriter.h \
+    $$PWD/metadatatransform.h \
+    $$PWD/scanarena.h \
+    $$PWD/genreregistry.h \
+    $$PWD/cyrillicdecoder.h \
+    $$PWD/recordvalidator.h \
+    $$PWD/homoglyphfixer.h \
+    $$PWD/authorindex.h \
+    $$PWD/profiler.h \
+    $$PWD/scanreport.h \
+    $$PWD/base64.h \
+    $$PWD/coverextractor.h \
+    $$PWD/covercache.h \
+    $$PWD/imageoptimizer.h \
+    $$PWD/bodyscanner.h \
+    $$PWD/bodycache.h \
+    $$PWD/bodyjob.h \
+    $$PWD/similarityindex.h \
+    $$PWD/repackjob.h \
+    $$PWD/csv.h
+
+# 3rd party components
+# mz_crc32() of miniz is replaced by the accelerated implementation from src/crc32.cpp
+DEFINES += MINIZ_EXTERNAL_CRC32
+HEADERS += $$PWD/../3rdparty/miniz.h
+SOURCES += $$PWD/../3rdparty/miniz.c
@@ -0,0 +1,234 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include "covercache.h"
+#include "coverextractor.h"
+#include "filerecord.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+/*
+ * Signature and version of the index file.
+ */
+static const quint32 indexMagic = 0x46424356;
+static const quint32 indexVersion = 1;
+
+/*
+ * Memory cache limit in kilobytes, about 700 thumbnails.
+ */
+static const int memoryLimit = 64 * 1024;
+
+/*
+ * Task of a worker thread: preparing the thumbnail of one book.
+ */
+class CoverTask : public QRunnable
+{
+public:
+    CoverTask(CoverCache *cache, const FileRecord &record): cache(cache), record(record) {}
+
+    void run()
+    {
+        cache->process(record);
+    }
+
+private:
+    CoverCache *cache;
+    FileRecord record;
+};
+
+CoverCache::CoverCache(QObject *parent): QObject(parent)
+{
+    directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/covers";
+    changed = false;
+    images.setMaxCost(memoryLimit);
+    loadIndex();
+}
+
+CoverCache::~CoverCache()
+{
+    pool.clear();
+    pool.waitForDone();
+    saveIndex();
+}
+
+QImage CoverCache::getThumbnail(const FileRecord &record)
+{
+    if (record.getCoverId().isEmpty())
+        return QImage();
+
+    const QString &fileName = record.getFileName();
+    QImage *image = images.object(fileName);
+
+    if (image)
+        return *image;
+
+    if (!pending.contains(fileName))
+    {
+        pending.insert(fileName);
+        pool.start(new CoverTask(this, record));
+    }
+
+    return QImage();
+}
+
+QString CoverCache::getThumbnailPath(const FileRecord &record)
+{
+    if (record.getCoverId().isEmpty())
+        return QString();
+
+    QString key = FileRecord::getVersionKey(record.getFileName());
+    QMutexLocker locker(&mutex);
+    QByteArray hash = index.value(key);
+    locker.unlock();
+
+    if (hash.isEmpty())
+        return QString();
+
+    return getPath(hash);
+}
+
+void CoverCache::process(const FileRecord &record)
+{
+    QString key = FileRecord::getVersionKey(record.getFileName());
+    QMutexLocker locker(&mutex);
+    QHash<QString, QByteArray>::const_iterator it = index.constFind(key);
+    bool known = (it != index.constEnd());
+    QByteArray hash = known ? it.value() : QByteArray();
+    locker.unlock();
+
+    QImage thumbnail;
+
+    // The thumbnail may be deleted from disk by the system cleaning the cache, then it is made again
+    if (known && (hash.isEmpty() || thumbnail.load(getPath(hash), "JPG")))
+    {
+        QMetaObject::invokeMethod(this, "onThumbnailReady", Qt::QueuedConnection,
+                                  Q_ARG(QString, record.getFileName()), Q_ARG(QImage, thumbnail));
+        return;
+    }
+
+    QByteArray data = CoverExtractor::extract(record);
+    QImage cover;
+    hash.clear();
+
+    if ((!data.isEmpty()) && cover.loadFromData(data))
+    {
+        hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+
+        if ((cover.width() > thumbnailWidth) || (cover.height() > thumbnailHeight))
+            thumbnail = cover.scaled(thumbnailWidth, thumbnailHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        else
+            thumbnail = cover;
+
+        // JPEG has no transparency: transparent areas are filled with white instead of black
+        if (thumbnail.hasAlphaChannel())
+        {
+            QImage opaque(thumbnail.size(), QImage::Format_RGB32);
+            opaque.fill(Qt::white);
+            QPainter painter(&opaque);
+            painter.drawImage(0, 0, thumbnail);
+            painter.end();
+            thumbnail = opaque;
+        }
+
+        QString path = getPath(hash);
+
+        if (!QFile::exists(path))
+        {
+            QDir().mkpath(QFileInfo(path).absolutePath());
+            QSaveFile file(path);
+
+            if (file.open(QIODevice::WriteOnly) && thumbnail.save(&file, "JPG", 85))
+                file.commit();
+        }
+    }
+
+    locker.relock();
+    index.insert(key, hash);
+    changed = true;
+    locker.unlock();
+
+    QMetaObject::invokeMethod(this, "onThumbnailReady", Qt::QueuedConnection,
+                              Q_ARG(QString, record.getFileName()), Q_ARG(QImage, thumbnail));
+}
+
+void CoverCache::onThumbnailReady(const QString &fileName, const QImage &image)
+{
+    pending.remove(fileName);
+    images.insert(fileName, new QImage(image), qMax(1, image.byteCount() / 1024));
+    emit ThumbnailReady(fileName);
+}
+
+QString CoverCache::getPath(const QByteArray &hash) const
+{
+    // Subdirectories by the first byte of the hash keep directories small on large libraries
+    return directory + '/' + QString::fromLatin1(hash.left(2)) + '/' + QString::fromLatin1(hash) + ".jpg";
+}
+
+void CoverCache::loadIndex()
+{
+    QFile file(directory + "/index.dat");
+
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+
+    if ((magic != indexMagic) || (version != indexVersion))
+        return;
+
+    QHash<QString, QByteArray> loaded;
+    stream >> loaded;
+
+    if (stream.status() == QDataStream::Ok)
+        index = loaded;
+}
+
+void CoverCache::saveIndex()
+{
+    if (!changed)
+        return;
+
+    QDir().mkpath(directory);
+    QSaveFile file(directory + "/index.dat");
+
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << indexMagic << indexVersion << index;
+
+    if (stream.status() == QDataStream::Ok)
+        file.commit();
+}
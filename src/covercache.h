@@ -0,0 +1,220 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef COVERCACHE_H
+#define COVERCACHE_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль кеша миниатюр обложек книг.
+ *
+ * @~english
+ * @brief Module of the book cover thumbnail cache.
+ */
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+#include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QMutex>
+#include <QThreadPool>
+
+// Forward class declarations
+class FileRecord;
+
+/**
+ * @~russian
+ * @brief Кеш миниатюр обложек книг.
+ *
+ * Обложки извлекаются и масштабируются в пуле рабочих потоков, поэтому запрос миниатюры не блокирует
+ * интерфейс: при промахе возвращается пустое изображение, а после подготовки миниатюры испускается
+ * сигнал ThumbnailReady().@n
+ * Миниатюры хранятся на диске в формате JPEG под именем, равным SHA-1 декодированной обложки, поэтому
+ * одинаковые обложки разных книг хранятся один раз. Индекс «файл книги, размер, время изменения -> хеш
+ * обложки» сохраняется между запусками, измененная книга обрабатывается заново. Последние использованные
+ * миниатюры держатся в памяти.
+ *
+ * @~english
+ * @brief Cache of book cover thumbnails.
+ *
+ * Covers are extracted and scaled in the pool of worker threads, so a thumbnail request does not block
+ * the interface: an empty image is returned on a miss, and ThumbnailReady() signal is emitted when
+ * the thumbnail is prepared.@n
+ * Thumbnails are stored on disk in JPEG format named after SHA-1 of the decoded cover, so identical covers
+ * of different books are stored once. The index "book file, size, modification time -> cover hash" is kept
+ * between runs, a changed book is processed again. Recently used thumbnails are held in memory.
+ */
+class CoverCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int thumbnailWidth = 120; ///< @~russian Ширина миниатюры. @~english Thumbnail width.
+    static const int thumbnailHeight = 180; ///< @~russian Высота миниатюры. @~english Thumbnail height.
+
+    /**
+     * @~russian
+     * @brief Конструктор.
+     *
+     * Загружает индекс кеша с диска.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor.
+     *
+     * Loads the cache index from disk.
+     * @param parent Parent object.
+     */
+    explicit CoverCache(QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор.
+     *
+     * Дожидается завершения начатых рабочих потоков и сохраняет индекс кеша.
+     *
+     * @~english
+     * @brief Destructor.
+     *
+     * Waits for the started workers to finish and saves the cache index.
+     */
+    virtual ~CoverCache();
+
+    /**
+     * @~russian
+     * @brief Получение миниатюры обложки без ожидания.
+     *
+     * Если миниатюры еще нет в памяти, ставится задача ее подготовки.
+     * @param record Запись о файле.
+     * @return Миниатюра;@n
+     * пустое изображение - если у книги нет обложки или миниатюра еще не готова.
+     *
+     * @~english
+     * @brief Getting the cover thumbnail without waiting.
+     *
+     * If the thumbnail is not in memory yet, a task to prepare it is queued.
+     * @param record File record.
+     * @return Thumbnail;@n
+     * empty image - if the book has no cover or the thumbnail is not ready yet.
+     */
+    QImage getThumbnail(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Получение пути к файлу миниатюры в дисковом кеше.
+     * @param record Запись о файле.
+     * @return Путь к файлу;@n
+     * пустая строка - если миниатюра еще не подготовлена.
+     *
+     * @~english
+     * @brief Getting the path to the thumbnail file in the disk cache.
+     * @param record File record.
+     * @return File path;@n
+     * empty string - if the thumbnail is not prepared yet.
+     */
+    QString getThumbnailPath(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Подготовка миниатюры обложки в текущем потоке.
+     *
+     * Вызывается рабочими потоками, результат передается в основной поток.
+     * @param record Запись о файле.
+     *
+     * @~english
+     * @brief Preparing the cover thumbnail in the current thread.
+     *
+     * Called by worker threads, the result is passed to the main thread.
+     * @param record File record.
+     */
+    void process(const FileRecord &record);
+
+signals:
+    /**
+     * @~russian
+     * @brief Сигнал о готовности миниатюры.
+     * @param fileName Имя файла книги.
+     *
+     * @~english
+     * @brief Signal of the thumbnail readiness.
+     * @param fileName Book file name.
+     */
+    void ThumbnailReady(const QString &fileName);
+
+private slots:
+    /**
+     * @~russian
+     * @brief Обработчик подготовленной миниатюры.
+     * @param fileName Имя файла книги.
+     * @param image Миниатюра, пустое изображение - если обложки нет.
+     *
+     * @~english
+     * @brief The handler of the prepared thumbnail.
+     * @param fileName Book file name.
+     * @param image Thumbnail, empty image - if there is no cover.
+     */
+    void onThumbnailReady(const QString &fileName, const QImage &image);
+
+private:
+    QString directory; ///< @~russian Каталог дискового кеша. @~english Disk cache directory.
+    QThreadPool pool; ///< @~russian Пул рабочих потоков. @~english Pool of worker threads.
+    QCache<QString, QImage> images; ///< @~russian Миниатюры в памяти по имени файла книги. @~english Thumbnails in memory by book file name.
+    QSet<QString> pending; ///< @~russian Файлы с поставленными задачами. @~english Files with queued tasks.
+    QMutex mutex; ///< @~russian Защита индекса. @~english Protection of the index.
+    QHash<QString, QByteArray> index; ///< @~russian Ключ книги -> хеш обложки, пустой хеш - нет обложки. @~english Book key -> cover hash, empty hash - no cover.
+    bool changed; ///< @~russian Индекс изменен после загрузки. @~english The index is changed after loading.
+
+    /**
+     * @~russian
+     * @brief Получение пути к файлу миниатюры по хешу обложки.
+     * @param hash Хеш обложки.
+     * @return Путь к файлу.
+     *
+     * @~english
+     * @brief Getting the path to the thumbnail file by the cover hash.
+     * @param hash Cover hash.
+     * @return File path.
+     */
+    QString getPath(const QByteArray &hash) const;
+
+    /**
+     * @~russian
+     * @brief Загрузка индекса кеша.
+     *
+     * @~english
+     * @brief Loading the cache index.
+     */
+    void loadIndex();
+
+    /**
+     * @~russian
+     * @brief Сохранение индекса кеша.
+     *
+     * @~english
+     * @brief Saving the cache index.
+     */
+    void saveIndex();
+};
+
+#endif // COVERCACHE_H
@@ -0,0 +1,205 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации извлечения обложки книги.
+ *
+ * @~english
+ * @brief Source file for book cover extraction.
+ */
+
+#include "coverextractor.h"
+#include "filerecord.h"
+#include "base64.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QFile>
+
+#include <string.h>
+#include <ctype.h>
+
+const int readChunkSize = 65536;
+const int maxTagSize = 4096; // Opening tag without the closing bracket within this size is considered broken
+
+/*
+ * Callback of miniz extraction, stops unpacking as soon as the cover section is complete.
+ */
+static size_t feedExtractor(void *opaque, mz_uint64 offset, const void *data, size_t size)
+{
+    Q_UNUSED(offset)
+
+    CoverExtractor *extractor = static_cast<CoverExtractor *>(opaque);
+    return extractor->feed(static_cast<const char *>(data), static_cast<int>(size)) ? 0 : size;
+}
+
+CoverExtractor::CoverExtractor(const QString &id) :
+    state(stSearching),
+    id(id.toUtf8()),
+    matcher("<binary")
+{
+}
+
+bool CoverExtractor::feed(const char *data, int size)
+{
+    if (state == stComplete)
+        return true;
+
+    if (state == stCollecting)
+    {
+        // Base64 text has no angle brackets, so the section ends at the first one
+        const char *end = static_cast<const char *>(memchr(data, '<', size));
+
+        if (end == 0)
+        {
+            payload.append(data, size);
+            return false;
+        }
+
+        payload.append(data, static_cast<int>(end - data));
+        state = stComplete;
+        return true;
+    }
+
+    pending.append(data, size);
+    int from = 0;
+
+    while (true)
+    {
+        int start = matcher.indexIn(pending, from);
+
+        if (start == -1)
+        {
+            // Only the end that may be the beginning of a split tag is kept
+            int keep = qMin(pending.size(), matcher.pattern().size() - 1);
+            pending.remove(0, pending.size() - keep);
+            return false;
+        }
+
+        int close = pending.indexOf('>', start);
+
+        if (close == -1)
+        {
+            if (pending.size() - start <= maxTagSize)
+            {
+                pending.remove(0, start);
+                return false;
+            }
+
+            from = start + 1;
+            continue;
+        }
+
+        if (isWantedTag(QByteArray::fromRawData(pending.constData() + start, close - start)))
+        {
+            state = stCollecting;
+            QByteArray rest = pending.mid(close + 1);
+            pending.clear();
+            return feed(rest.constData(), rest.size());
+        }
+
+        from = close + 1;
+    }
+}
+
+bool CoverExtractor::isComplete() const
+{
+    return state == stComplete;
+}
+
+const QByteArray &CoverExtractor::getPayload() const
+{
+    return payload;
+}
+
+bool CoverExtractor::isWantedTag(const QByteArray &tag) const
+{
+    int pos = 0;
+
+    while ((pos = tag.indexOf("id=", pos)) != -1)
+    {
+        // Only the whole attribute name, not the end of another one such as content-id
+        if ((pos > 0) && (isspace(static_cast<uchar>(tag.at(pos - 1)))) && (pos + 3 < tag.size()))
+        {
+            char quote = tag.at(pos + 3);
+
+            if ((quote == '"') || (quote == '\''))
+            {
+                int end = tag.indexOf(quote, pos + 4);
+                return (end != -1) && (tag.mid(pos + 4, end - pos - 4) == id);
+            }
+        }
+
+        pos += 3;
+    }
+
+    return false;
+}
+
+QByteArray CoverExtractor::extract(const FileRecord &record)
+{
+    if (record.getCoverId().isEmpty())
+        return QByteArray();
+
+    CoverExtractor extractor(record.getCoverId());
+
+    if (record.isArchive())
+    {
+        mz_zip_archive archive;
+        memset(&archive, 0, sizeof(archive));
+
+        if (!mz_zip_reader_init_file(&archive, record.getFileName().toStdString().c_str(), 0))
+            return QByteArray();
+
+        // Unpacking stopped by the callback reports failure, so the result is taken from the extractor
+        if (mz_zip_reader_get_num_files(&archive) == 1)
+            mz_zip_reader_extract_to_callback(&archive, 0, feedExtractor, &extractor, 0);
+
+        mz_zip_reader_end(&archive);
+    }
+    else
+    {
+        QFile file(record.getFileName());
+
+        if (!file.open(QIODevice::ReadOnly))
+            return QByteArray();
+
+        QByteArray chunk(readChunkSize, Qt::Uninitialized);
+        qint64 size;
+
+        while ((size = file.read(chunk.data(), chunk.size())) > 0)
+        {
+            if (extractor.feed(chunk.constData(), static_cast<int>(size)))
+                break;
+        }
+    }
+
+    QByteArray image;
+
+    if ((!extractor.isComplete()) || (!Base64::decode(extractor.getPayload(), image)))
+        return QByteArray();
+
+    return image;
+}
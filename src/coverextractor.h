@@ -0,0 +1,164 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef COVEREXTRACTOR_H
+#define COVEREXTRACTOR_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль извлечения обложки книги.
+ *
+ * @~english
+ * @brief Module of book cover extraction.
+ */
+
+#include <QByteArray>
+#include <QByteArrayMatcher>
+#include <QString>
+
+// Forward class declarations
+class FileRecord;
+
+/**
+ * @~russian
+ * @brief Поиск и извлечение изображения обложки из раздела @c binary.
+ *
+ * Файл просматривается потоком без разбора XML: открывающие теги @c binary ищутся алгоритмом Бойера-Мура,
+ * у каждого сравнивается только атрибут @c id. Текст base64 найденного раздела накапливается до закрывающего
+ * тега, после чего чтение (или распаковка архива) прекращается.
+ *
+ * @~english
+ * @brief Locating and extracting the cover image from @c binary section.
+ *
+ * The file is scanned as a stream without XML parsing: opening @c binary tags are searched by Boyer-Moore
+ * algorithm, only @c id attribute of each one is compared. Base64 text of the found section is collected up to
+ * the closing tag, then reading (or unpacking of the archive) stops.
+ */
+class CoverExtractor
+{
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param id Идентификатор искомого раздела @c binary.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param id Identifier of the wanted @c binary section.
+     */
+    explicit CoverExtractor(const QString &id);
+
+    /**
+     * @~russian
+     * @brief Обработка очередной части файла.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @return @c true - если раздел найден целиком и чтение можно прекратить;@n
+     * @c false - если нужны следующие данные.
+     *
+     * @~english
+     * @brief Processing the next part of the file.
+     * @param data Data.
+     * @param size Data size.
+     * @return @c true - if the section is found entirely and reading can be stopped;@n
+     * @c false - if the next data is needed.
+     */
+    bool feed(const char *data, int size);
+
+    /**
+     * @~russian
+     * @brief Проверка, найден ли раздел целиком.
+     * @return @c true - если найден;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Checking whether the section is found entirely.
+     * @return @c true - if found;@n
+     * @c false - if not.
+     */
+    bool isComplete() const;
+
+    /**
+     * @~russian
+     * @brief Получение текста base64 найденного раздела.
+     * @return Текст раздела.
+     *
+     * @~english
+     * @brief Getting base64 text of the found section.
+     * @return Section text.
+     */
+    const QByteArray &getPayload() const;
+
+    /**
+     * @~russian
+     * @brief Извлечение обложки книги.
+     *
+     * Читается файл записи или распаковывается архив до конца раздела обложки.
+     * @param record Запись с идентификатором обложки.
+     * @return Декодированный файл изображения, пустой - если обложки нет или она повреждена.
+     *
+     * @~english
+     * @brief Extracting the book cover.
+     *
+     * The file of the record is read or the archive is unpacked up to the end of the cover section.
+     * @param record Record with the cover identifier.
+     * @return Decoded image file, empty if there is no cover or it is broken.
+     */
+    static QByteArray extract(const FileRecord &record);
+
+private:
+    /**
+     * @~russian
+     * @brief Состояние поиска.
+     *
+     * @~english
+     * @brief Search state.
+     */
+    enum State
+    {
+        stSearching, ///< @~russian Поиск открывающего тега. @~english Searching the opening tag.
+        stCollecting, ///< @~russian Накопление текста раздела. @~english Collecting the section text.
+        stComplete ///< @~russian Раздел найден. @~english Section is found.
+    };
+
+    State state; ///< @~russian Состояние поиска. @~english Search state.
+    QByteArray id; ///< @~russian Идентификатор раздела в UTF-8. @~english Section identifier in UTF-8.
+    QByteArrayMatcher matcher; ///< @~russian Поиск открывающего тега. @~english Search of the opening tag.
+    QByteArray pending; ///< @~russian Необработанный конец предыдущей части. @~english Unprocessed end of the previous part.
+    QByteArray payload; ///< @~russian Текст base64 раздела. @~english Base64 text of the section.
+
+    /**
+     * @~russian
+     * @brief Проверка, совпадает ли атрибут @c id открывающего тега с искомым.
+     * @param tag Открывающий тег целиком.
+     * @return @c true - если совпадает;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Checking whether @c id attribute of the opening tag is the wanted one.
+     * @param tag Entire opening tag.
+     * @return @c true - if it is;@n
+     * @c false - if not.
+     */
+    bool isWantedTag(const QByteArray &tag) const;
+};
+
+#endif // COVEREXTRACTOR_H
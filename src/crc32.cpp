@@ -0,0 +1,365 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для расчета контрольной суммы CRC32.
+ *
+ * @~english
+ * @brief Source file for CRC32 checksum calculation.
+ */
+
+#include "crc32.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32_CLMUL
+#include <emmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#if defined(__GNUC__)
+#include <cpuid.h>
+#define CRC32_TARGET_CLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#include <intrin.h>
+#define CRC32_TARGET_CLMUL
+#endif
+#endif
+
+const quint32 crc32Polynomial = 0xEDB88320UL; // Reflected CRC-32 polynomial of zip and zlib
+const size_t minClmulSize = 64; // Shorter data is not worth loading of the folding registers
+
+typedef quint32 (*crc32_func)(quint32 crc, const uchar *data, size_t size);
+
+/*
+ * Tables of slice-by-8 algorithm: table[k][n] is CRC of the byte n followed by k zero bytes.
+ */
+struct Crc32Tables
+{
+    quint32 table[8][256];
+
+    Crc32Tables()
+    {
+        for (quint32 n = 0; n < 256; ++n)
+        {
+            quint32 c = n;
+
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? (c >> 1) ^ crc32Polynomial : c >> 1;
+            }
+
+            table[0][n] = c;
+        }
+
+        for (quint32 n = 0; n < 256; ++n)
+        {
+            for (int k = 1; k < 8; ++k)
+            {
+                table[k][n] = (table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF];
+            }
+        }
+    }
+};
+
+static const Crc32Tables &tables()
+{
+    static const Crc32Tables instance;
+    return instance;
+}
+
+#ifdef CRC32_CLMUL
+
+/*
+ * Folding of the data by carry-less multiplication, see Intel's "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction". Four 128-bit accumulators are folded 64 bytes ahead, then reduced to one,
+ * then to 64 bits and by Barrett reduction to the 32-bit CRC. The size must be at least 64 and a multiple of 16.
+ * The CRC is the internal (inverted) value.
+ */
+CRC32_TARGET_CLMUL static quint32 foldClmul(quint32 crc, const uchar *data, size_t size)
+{
+    static const quint64 k1k2[2] = { 0x0154442bd4ULL, 0x01c6e41596ULL };
+    static const quint64 k3k4[2] = { 0x01751997d0ULL, 0x00ccaa009eULL };
+    static const quint64 k5k0[2] = { 0x0163cd6124ULL, 0x0000000000ULL };
+    static const quint64 poly[2] = { 0x01db710641ULL, 0x01f7011641ULL };
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+    x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+    x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+    x4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    x0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(k1k2));
+
+    data += 64;
+    size -= 64;
+
+    while (size >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x00));
+        y6 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x10));
+        y7 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x20));
+        y8 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        data += 64;
+        size -= 64;
+    }
+
+    // Fold four accumulators into one
+    x0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(k3k4));
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Fold the remaining 16-byte blocks
+    while (size >= 16)
+    {
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        data += 16;
+        size -= 16;
+    }
+
+    // Fold 128 bits to 64 bits
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(k5k0));
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(poly));
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return static_cast<quint32>(_mm_extract_epi32(x1, 1));
+}
+
+static quint32 updateClmul(quint32 crc, const uchar *data, size_t size)
+{
+    if (size < minClmulSize)
+        return Crc32::updateTable(crc, data, size);
+
+    size_t folded = size & ~static_cast<size_t>(15);
+    crc = ~foldClmul(~crc, data, folded);
+
+    return Crc32::updateTable(crc, data + folded, size - folded);
+}
+
+static bool hasClmul()
+{
+    unsigned int ecx;
+#if defined(__GNUC__)
+    unsigned int eax, ebx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return false;
+
+#else
+    int info[4];
+    __cpuid(info, 1);
+    ecx = static_cast<unsigned int>(info[2]);
+#endif
+
+    // PCLMULQDQ is bit 1, SSE4.1 is bit 19
+    return ((ecx & (1 << 1)) != 0) && ((ecx & (1 << 19)) != 0);
+}
+
+#endif // CRC32_CLMUL
+
+static crc32_func selectImplementation()
+{
+#ifdef CRC32_CLMUL
+
+    if (hasClmul())
+        return updateClmul;
+
+#endif
+
+    return Crc32::updateTable;
+}
+
+static crc32_func implementation()
+{
+    static const crc32_func func = selectImplementation();
+    return func;
+}
+
+quint32 Crc32::update(quint32 crc, const uchar *data, size_t size)
+{
+    return implementation()(crc, data, size);
+}
+
+quint32 Crc32::updateTable(quint32 crc, const uchar *data, size_t size)
+{
+    const quint32 (*table)[256] = tables().table;
+    quint32 c = ~crc;
+
+    // Eight bytes per iteration, each through its own table, without dependency between the lookups
+    while (size >= 8)
+    {
+        quint32 low = c ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<quint32>(data[3]) << 24));
+        c = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+            table[3][data[4]] ^ table[2][data[5]] ^ table[1][data[6]] ^ table[0][data[7]];
+        data += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        c = (c >> 8) ^ table[0][(c ^ *data++) & 0xFF];
+        size--;
+    }
+
+    return ~c;
+}
+
+/*
+ * Multiplication of the 32x32 matrix over GF(2) by the vector.
+ */
+static quint32 gf2MatrixTimes(const quint32 *matrix, quint32 vector)
+{
+    quint32 sum = 0;
+
+    while (vector)
+    {
+        if (vector & 1)
+            sum ^= *matrix;
+
+        vector >>= 1;
+        matrix++;
+    }
+
+    return sum;
+}
+
+static void gf2MatrixSquare(quint32 *square, const quint32 *matrix)
+{
+    for (int n = 0; n < 32; n++)
+    {
+        square[n] = gf2MatrixTimes(matrix, matrix[n]);
+    }
+}
+
+quint32 Crc32::combine(quint32 crc1, quint32 crc2, qint64 size2)
+{
+    // Appending size2 zero bytes to the first fragment is the multiplication by the matrix
+    // of the one zero bit operator raised to the power of 8 * size2, computed by repeated squaring
+    quint32 even[32];
+    quint32 odd[32];
+
+    if (size2 <= 0)
+        return crc1;
+
+    odd[0] = crc32Polynomial;
+    quint32 row = 1;
+
+    for (int n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    gf2MatrixSquare(even, odd); // Two zero bits
+    gf2MatrixSquare(odd, even); // Four zero bits
+
+    do
+    {
+        gf2MatrixSquare(even, odd);
+
+        if (size2 & 1)
+            crc1 = gf2MatrixTimes(even, crc1);
+
+        size2 >>= 1;
+
+        if (size2 == 0)
+            break;
+
+        gf2MatrixSquare(odd, even);
+
+        if (size2 & 1)
+            crc1 = gf2MatrixTimes(odd, crc1);
+
+        size2 >>= 1;
+    }
+    while (size2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+bool Crc32::isAccelerated()
+{
+#ifdef CRC32_CLMUL
+    return implementation() == updateClmul;
+#else
+    return false;
+#endif
+}
+
+/*
+ * Replacement of mz_crc32() body, see MINIZ_EXTERNAL_CRC32 in miniz.c.
+ */
+extern "C" mz_ulong mz_crc32_external(mz_ulong crc, const mz_uint8 *ptr, size_t buf_len)
+{
+    return Crc32::update(static_cast<quint32>(crc), ptr, buf_len);
+}
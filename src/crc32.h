@@ -0,0 +1,120 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef CRC32_H
+#define CRC32_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль расчета контрольной суммы CRC32.
+ *
+ * @~english
+ * @brief Module of CRC32 checksum calculation.
+ */
+
+#include <QtGlobal>
+#include <stddef.h>
+
+/**
+ * @~russian
+ * @brief Расчет контрольной суммы CRC32 (полином zip/zlib).
+ *
+ * Реализация выбирается один раз при первом вызове: на x86-64 с поддержкой PCLMULQDQ данные сворачиваются
+ * умножением без переносов по 64 байта за итерацию, иначе используется табличный алгоритм slice-by-8.@n
+ * Модуль подменяет функцию mz_crc32() библиотеки miniz, если при сборке определен MINIZ_EXTERNAL_CRC32,
+ * поэтому ускоряются и упаковка, и проверка распакованных файлов.
+ *
+ * @~english
+ * @brief Calculation of CRC32 checksum (zip/zlib polynomial).
+ *
+ * The implementation is chosen once at the first call: on x86-64 with PCLMULQDQ support the data is folded
+ * by carry-less multiplication 64 bytes per iteration, otherwise the slice-by-8 table algorithm is used.@n
+ * The module replaces mz_crc32() function of miniz library if MINIZ_EXTERNAL_CRC32 is defined at build time,
+ * so both packing and verification of unpacked files are accelerated.
+ */
+class Crc32
+{
+public:
+    /**
+     * @~russian
+     * @brief Обновление контрольной суммы наилучшей доступной реализацией.
+     * @param crc Контрольная сумма предыдущих данных, 0 - для начала расчета.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @return Контрольная сумма с учетом данных.
+     *
+     * @~english
+     * @brief Updating the checksum by the best available implementation.
+     * @param crc Checksum of previous data, 0 to start the calculation.
+     * @param data Data.
+     * @param size Data size.
+     * @return Checksum including the data.
+     */
+    static quint32 update(quint32 crc, const uchar *data, size_t size);
+
+    /**
+     * @~russian
+     * @brief Обновление контрольной суммы табличным алгоритмом slice-by-8.
+     * @param crc Контрольная сумма предыдущих данных, 0 - для начала расчета.
+     * @param data Данные.
+     * @param size Размер данных.
+     * @return Контрольная сумма с учетом данных.
+     *
+     * @~english
+     * @brief Updating the checksum by slice-by-8 table algorithm.
+     * @param crc Checksum of previous data, 0 to start the calculation.
+     * @param data Data.
+     * @param size Data size.
+     * @return Checksum including the data.
+     */
+    static quint32 updateTable(quint32 crc, const uchar *data, size_t size);
+
+    /**
+     * @~russian
+     * @brief Объединение контрольных сумм двух последовательных фрагментов.
+     * @param crc1 Контрольная сумма первого фрагмента.
+     * @param crc2 Контрольная сумма второго фрагмента.
+     * @param size2 Размер второго фрагмента.
+     * @return Контрольная сумма объединенных фрагментов.
+     *
+     * @~english
+     * @brief Combining checksums of two consecutive fragments.
+     * @param crc1 Checksum of the first fragment.
+     * @param crc2 Checksum of the second fragment.
+     * @param size2 Size of the second fragment.
+     * @return Checksum of the joined fragments.
+     */
+    static quint32 combine(quint32 crc1, quint32 crc2, qint64 size2);
+
+    /**
+     * @~russian
+     * @brief Получение признака использования аппаратного ускорения.
+     * @return @c true - если используется PCLMULQDQ;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Getting whether hardware acceleration is used.
+     * @return @c true - if PCLMULQDQ is used;@n
+     * @c false - if not.
+     */
+    static bool isAccelerated();
+};
+
+#endif // CRC32_H
@@ -0,0 +1,63 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef CSV_H
+#define CSV_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль форматирования CSV.
+ *
+ * @~english
+ * @brief Module of CSV formatting.
+ */
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @~russian
+ * @brief Форматирование полей CSV для отчетов и таблиц соответствия.
+ *
+ * @~english
+ * @brief Formatting of CSV fields for reports and mappings.
+ */
+class Csv
+{
+public:
+    /**
+     * @~russian
+     * @brief Получение поля CSV.
+     *
+     * Поле заключается в кавычки, кавычки внутри поля удваиваются.
+     * @param text Значение поля.
+     * @return Поле в UTF-8.
+     *
+     * @~english
+     * @brief Getting a CSV field.
+     *
+     * The field is enclosed in quotes, quotes inside the field are doubled.
+     * @param text Field value.
+     * @return Field in UTF-8.
+     */
+    static QByteArray field(const QString &text);
+};
+
+#endif // CSV_H
@@ -0,0 +1,195 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации декодирования однобайтовых кириллических кодировок.
+ *
+ * @~english
+ * @brief Source file for decoding single-byte Cyrillic encodings.
+ */
+
+#include "cyrillicdecoder.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CYRILLIC_SSE2
+#include <emmintrin.h>
+#endif
+
+const int maxDeclarationSize = 256; // XML declaration is searched only at the very beginning
+
+/*
+ * Upper halves of the code pages, the lower half is ASCII. Unassigned 0x98 of windows-1251 gives U+FFFD.
+ */
+static const ushort windows1251[128] =
+{
+    0x0402, 0x0403, 0x201A, 0x0453, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x20AC, 0x2030, 0x0409, 0x2039, 0x040A, 0x040C, 0x040B, 0x040F,
+    0x0452, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0xFFFD, 0x2122, 0x0459, 0x203A, 0x045A, 0x045C, 0x045B, 0x045F,
+    0x00A0, 0x040E, 0x045E, 0x0408, 0x00A4, 0x0490, 0x00A6, 0x00A7,
+    0x0401, 0x00A9, 0x0404, 0x00AB, 0x00AC, 0x00AD, 0x00AE, 0x0407,
+    0x00B0, 0x00B1, 0x0406, 0x0456, 0x0491, 0x00B5, 0x00B6, 0x00B7,
+    0x0451, 0x2116, 0x0454, 0x00BB, 0x0458, 0x0405, 0x0455, 0x0457,
+    0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+    0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E, 0x041F,
+    0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+    0x0428, 0x0429, 0x042A, 0x042B, 0x042C, 0x042D, 0x042E, 0x042F,
+    0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+    0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E, 0x043F,
+    0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+    0x0448, 0x0449, 0x044A, 0x044B, 0x044C, 0x044D, 0x044E, 0x044F
+};
+
+static const ushort koi8r[128] =
+{
+    0x2500, 0x2502, 0x250C, 0x2510, 0x2514, 0x2518, 0x251C, 0x2524,
+    0x252C, 0x2534, 0x253C, 0x2580, 0x2584, 0x2588, 0x258C, 0x2590,
+    0x2591, 0x2592, 0x2593, 0x2320, 0x25A0, 0x2219, 0x221A, 0x2248,
+    0x2264, 0x2265, 0x00A0, 0x2321, 0x00B0, 0x00B2, 0x00B7, 0x00F7,
+    0x2550, 0x2551, 0x2552, 0x0451, 0x2553, 0x2554, 0x2555, 0x2556,
+    0x2557, 0x2558, 0x2559, 0x255A, 0x255B, 0x255C, 0x255D, 0x255E,
+    0x255F, 0x2560, 0x2561, 0x0401, 0x2562, 0x2563, 0x2564, 0x2565,
+    0x2566, 0x2567, 0x2568, 0x2569, 0x256A, 0x256B, 0x256C, 0x00A9,
+    0x044E, 0x0430, 0x0431, 0x0446, 0x0434, 0x0435, 0x0444, 0x0433,
+    0x0445, 0x0438, 0x0439, 0x043A, 0x043B, 0x043C, 0x043D, 0x043E,
+    0x043F, 0x044F, 0x0440, 0x0441, 0x0442, 0x0443, 0x0436, 0x0432,
+    0x044C, 0x044B, 0x0437, 0x0448, 0x044D, 0x0449, 0x0447, 0x044A,
+    0x042E, 0x0410, 0x0411, 0x0426, 0x0414, 0x0415, 0x0424, 0x0413,
+    0x0425, 0x0418, 0x0419, 0x041A, 0x041B, 0x041C, 0x041D, 0x041E,
+    0x041F, 0x042F, 0x0420, 0x0421, 0x0422, 0x0423, 0x0416, 0x0412,
+    0x042C, 0x042B, 0x0417, 0x0428, 0x042D, 0x0429, 0x0427, 0x042A
+};
+
+/*
+ * Full tables of 256 elements, so decoding of a byte is a single lookup without branches.
+ */
+struct CyrillicTables
+{
+    ushort windows1251[256];
+    ushort koi8r[256];
+
+    CyrillicTables()
+    {
+        for (int i = 0; i < 128; ++i)
+        {
+            this->windows1251[i] = i;
+            this->koi8r[i] = i;
+            this->windows1251[i + 128] = ::windows1251[i];
+            this->koi8r[i + 128] = ::koi8r[i];
+        }
+    }
+};
+
+static const CyrillicTables &tables()
+{
+    static const CyrillicTables instance;
+    return instance;
+}
+
+CyrillicDecoder::CodePage CyrillicDecoder::codePageForName(const QByteArray &name)
+{
+    QByteArray lower = name.trimmed().toLower();
+
+    if ((lower == "windows-1251") || (lower == "cp1251") || (lower == "x-cp1251"))
+        return cpWindows1251;
+
+    if ((lower == "koi8-r") || (lower == "koi8r"))
+        return cpKoi8R;
+
+    return cpNone;
+}
+
+QByteArray CyrillicDecoder::declaredEncoding(const QByteArray &data)
+{
+    int begin = data.startsWith("\xEF\xBB\xBF") ? 3 : 0;
+
+    if (data.indexOf("<?xml", begin) != begin)
+        return QByteArray();
+
+    int end = data.indexOf("?>", begin);
+
+    if ((end < 0) || (end > maxDeclarationSize))
+        return QByteArray();
+
+    int pos = data.indexOf("encoding", begin);
+
+    if ((pos < 0) || (pos > end))
+        return QByteArray();
+
+    pos += 8;
+
+    while ((pos < end) && ((data.at(pos) == ' ') || (data.at(pos) == '\t') || (data.at(pos) == '=')))
+    {
+        pos++;
+    }
+
+    if ((pos >= end) || ((data.at(pos) != '"') && (data.at(pos) != '\'')))
+        return QByteArray();
+
+    int close = data.indexOf(data.at(pos), pos + 1);
+
+    if ((close < 0) || (close > end))
+        return QByteArray();
+
+    return data.mid(pos + 1, close - pos - 1);
+}
+
+void CyrillicDecoder::decode(const char *data, int size, CodePage codePage, ushort *out)
+{
+    const ushort *table = (codePage == cpKoi8R) ? tables().koi8r : tables().windows1251;
+    const uchar *bytes = reinterpret_cast<const uchar *>(data);
+    int i = 0;
+
+#ifdef CYRILLIC_SSE2
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= size; i += 16)
+    {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + i));
+
+        // ASCII block is only widened, otherwise it goes through the table
+        if (_mm_movemask_epi8(block) == 0)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_unpacklo_epi8(block, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 8), _mm_unpackhi_epi8(block, zero));
+        }
+        else
+        {
+            for (int j = i; j < i + 16; ++j)
+            {
+                out[j] = table[bytes[j]];
+            }
+        }
+    }
+#endif
+
+    for (; i < size; ++i)
+    {
+        out[i] = table[bytes[i]];
+    }
+}
+
+QString CyrillicDecoder::decode(const char *data, int size, CodePage codePage)
+{
+    QString result(size, Qt::Uninitialized);
+    decode(data, size, codePage, reinterpret_cast<ushort *>(result.data()));
+    return result;
+}
@@ -0,0 +1,130 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef CYRILLICDECODER_H
+#define CYRILLICDECODER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль декодирования однобайтовых кириллических кодировок.
+ *
+ * @~english
+ * @brief Module of decoding single-byte Cyrillic encodings.
+ */
+
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @~russian
+ * @brief Табличное декодирование windows-1251 и koi8-r в UTF-16.
+ *
+ * Большая часть старых книг записана в windows-1251. Общий механизм QTextCodec для каждого файла создает
+ * декодер и преобразует текст через библиотеку ICU, здесь же каждый байт заменяется по таблице из 256
+ * элементов. На x86-64 блоки по 16 байт без символов старше 0x7F (разметка XML) расширяются инструкциями SSE2
+ * без обращения к таблице.
+ *
+ * @~english
+ * @brief Table-driven decoding of windows-1251 and koi8-r to UTF-16.
+ *
+ * Most of the legacy books are written in windows-1251. The generic QTextCodec mechanism creates a decoder
+ * for each file and converts the text through the ICU library, while here each byte is replaced by the table
+ * of 256 elements. On x86-64 blocks of 16 bytes without characters above 0x7F (XML markup) are widened
+ * by SSE2 instructions without table lookups.
+ */
+class CyrillicDecoder
+{
+public:
+    /**
+     * @~russian
+     * @brief Поддерживаемые кодовые страницы.
+     *
+     * @~english
+     * @brief Supported code pages.
+     */
+    enum CodePage
+    {
+        cpNone, ///< @~russian Кодировка не поддерживается. @~english Encoding is not supported.
+        cpWindows1251, ///< @~russian Кодировка windows-1251. @~english Windows-1251 encoding.
+        cpKoi8R ///< @~russian Кодировка koi8-r. @~english KOI8-R encoding.
+    };
+
+    /**
+     * @~russian
+     * @brief Определение кодовой страницы по названию кодировки.
+     * @param name Название кодировки без учета регистра, например @c windows-1251 или @c cp1251.
+     * @return Кодовая страница или cpNone.
+     *
+     * @~english
+     * @brief Determining the code page by the encoding name.
+     * @param name Case insensitive encoding name, for example @c windows-1251 or @c cp1251.
+     * @return Code page or cpNone.
+     */
+    static CodePage codePageForName(const QByteArray &name);
+
+    /**
+     * @~russian
+     * @brief Получение кодировки из объявления XML в начале документа.
+     * @param data Начало документа.
+     * @return Значение атрибута @c encoding или пустой массив, если объявления или атрибута нет.
+     *
+     * @~english
+     * @brief Getting the encoding from XML declaration at the beginning of the document.
+     * @param data Beginning of the document.
+     * @return Value of @c encoding attribute or empty array if there is no declaration or attribute.
+     */
+    static QByteArray declaredEncoding(const QByteArray &data);
+
+    /**
+     * @~russian
+     * @brief Декодирование текста в буфер.
+     * @param data Текст в однобайтовой кодировке.
+     * @param size Размер текста.
+     * @param codePage Кодовая страница, отличная от cpNone.
+     * @param out Буфер не менее чем на @a size символов UTF-16.
+     *
+     * @~english
+     * @brief Decoding the text to the buffer.
+     * @param data Text in the single-byte encoding.
+     * @param size Text size.
+     * @param codePage Code page other than cpNone.
+     * @param out Buffer for at least @a size UTF-16 characters.
+     */
+    static void decode(const char *data, int size, CodePage codePage, ushort *out);
+
+    /**
+     * @~russian
+     * @brief Декодирование текста в строку.
+     * @param data Текст в однобайтовой кодировке.
+     * @param size Размер текста.
+     * @param codePage Кодовая страница, отличная от cpNone.
+     * @return Декодированная строка.
+     *
+     * @~english
+     * @brief Decoding the text to the string.
+     * @param data Text in the single-byte encoding.
+     * @param size Text size.
+     * @param codePage Code page other than cpNone.
+     * @return Decoded string.
+     */
+    static QString decode(const char *data, int size, CodePage codePage);
+};
+
+#endif // CYRILLICDECODER_H
@@ -18,18 +18,100 @@
  ***********************************************************************/
 
 #include "filereader.h"
+#include "cyrillicdecoder.h"
+#include "recordvalidator.h"
+#include "profiler.h"
 
 #include <QDirIterator>
 #include <QFileInfo>
+#include <QDateTime>
 #include <QXmlStreamReader>
+#include <QBuffer>
+#include <QFile>
 
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
 #include "../3rdparty/miniz.h"
 
 #include <QDebug>
 
+const int initialHeadSize = 256 * 1024; // Book description usually fits, so the buffer is not grown
+const int maxKeptHeadSize = 4 * 1024 * 1024; // A larger buffer is released after an unusual book
+const int readChunkSize = 16 * 1024; // Size of the chunk read from an uncompressed book
+
+/*
+ * State of the file compared by the folder watcher.
+ */
+static filestate_t fileState(const QFileInfo &info)
+{
+    return qMakePair(info.size(), info.lastModified().toMSecsSinceEpoch());
+}
+
+/*
+ * Receiver of the unpacked beginning of the book.
+ */
+struct HeadSink
+{
+    QByteArray *data;
+    bool complete;
+};
+
+/*
+ * Appending of the next part of the book, returns true when the book description is complete.
+ */
+static bool appendHeadPart(QByteArray &head, const char *data, int size)
+{
+    int from = qMax(0, head.size() - 16);
+    head.append(data, size);
+
+    // Metadata ends with title-info, the rest of the book is not needed for the scan
+    return (head.indexOf("</title-info>", from) != -1) || (head.indexOf("<body", from) != -1);
+}
+
+/*
+ * Reading from the archive through the original miniz function with counting of bytes read.
+ */
+struct CountingRead
+{
+    mz_file_read_func read;
+    void *opaque;
+    qint64 bytes;
+};
+
+static size_t countRead(void *opaque, mz_uint64 offset, void *buffer, size_t size)
+{
+    CountingRead *counter = static_cast<CountingRead *>(opaque);
+    size_t result = counter->read(counter->opaque, offset, buffer, size);
+    counter->bytes += result;
+    return result;
+}
+
+/*
+ * Callback of miniz extraction, stops unpacking as soon as the book description is complete.
+ */
+static size_t appendHead(void *opaque, mz_uint64 offset, const void *data, size_t size)
+{
+    Q_UNUSED(offset)
+
+    HeadSink *sink = static_cast<HeadSink *>(opaque);
+
+    if (appendHeadPart(*sink->data, static_cast<const char *>(data), static_cast<int>(size)))
+    {
+        sink->complete = true;
+        return 0;
+    }
+
+    return size;
+}
+
 FileReader::FileReader(QStringList files)
 {
     filenames.clear();
+    recursive = false;
+    snapshotEnabled = false;
+    tableDecoding = true;
+    sample = ScanReport::Sample();
     QStringList::iterator it;
 
     for (it = files.begin(); it != files.end(); ++it)
@@ -41,49 +123,210 @@ FileReader::FileReader(QStringList files)
 FileReader::FileReader(QString dir, bool recursive)
 {
     filenames.clear();
+    directory = dir;
+    this->recursive = recursive;
+    snapshotEnabled = false;
+    tableDecoding = true;
+    sample = ScanReport::Sample();
+}
+
+FileReader::FileReader(const snapshot_t &snapshot, const QStringList &dirs, bool recursive)
+{
+    filenames.clear();
+    previous = snapshot;
+    changedDirs = dirs;
+    this->recursive = recursive;
+    sample = ScanReport::Sample();
+    setSnapshotEnabled(true);
+}
+
+void FileReader::setSnapshotEnabled(bool enabled)
+{
+    snapshotEnabled = enabled;
+    qRegisterMetaType<snapshot_t>("snapshot_t");
+}
+
+QString FileReader::getTitle() const
+{
+    return tr("Reading files");
+}
+
+void FileReader::listFiles()
+{
+    Profiler::Scope scope(Profiler::phEnumeration);
+    qint64 bytes = 0;
+    snapshot_t listed;
+
+    if (!changedDirs.isEmpty())
+    {
+        if (!listChanges(listed, bytes))
+            return;
+    }
+    else
+        if (!directory.isEmpty())
+        {
+            if (!listTree(directory, snapshotEnabled ? &listed : 0, bytes))
+                return;
+        }
+        else
+        {
+            QStringList::iterator it;
+
+            for (it = filenames.begin(); it != filenames.end(); ++it)
+            {
+                bytes += QFileInfo(*it).size();
+            }
+        }
+
+    setTotal(filenames.count(), bytes);
 
+    if (snapshotEnabled)
+        emit Snapshot(listed);
+}
+
+bool FileReader::listTree(const QString &path, snapshot_t *listed, qint64 &bytes)
+{
     QStringList ext = QStringList() << "*.fb2" << "*.fb2.zip";
     QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Files;
+    QDirIterator::IteratorFlags flags = recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
 
-    if (recursive)
+    if (listed != 0)
     {
-        QDirIterator it(dir, ext, filters, QDirIterator::Subdirectories);
+        // Subfolders without books are watched too, symbolic links are not followed by the watcher
+        filters |= QDir::NoSymLinks;
 
-        while (it.hasNext())
+        if (recursive)
+            filters |= QDir::AllDirs;
+
+        (*listed)[path];
+    }
+
+    QDirIterator it(path, ext, filters, flags);
+
+    while (it.hasNext())
+    {
+        if (!checkPoint())
+            return false;
+
+        QString name = it.next();
+        QFileInfo info = it.fileInfo();
+
+        if (info.isDir())
+        {
+            (*listed)[name];
+            continue;
+        }
+
+        filenames.append(name);
+        bytes += info.size();
+
+        if (listed != 0)
         {
-            filenames.append(it.next());
+            (*listed)[info.absolutePath()].insert(name, fileState(info));
         }
     }
-    else
+
+    return true;
+}
+
+bool FileReader::listChanges(snapshot_t &listed, qint64 &bytes)
+{
+    QStringList ext = QStringList() << "*.fb2" << "*.fb2.zip";
+    QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Files | QDir::NoSymLinks;
+
+    if (recursive)
+        filters |= QDir::AllDirs;
+
+    QStringList::const_iterator dir;
+
+    // Only the changed folders themselves are listed, not their subfolders
+    for (dir = changedDirs.constBegin(); dir != changedDirs.constEnd(); ++dir)
     {
-        QDirIterator it(dir, ext, filters);
+        const QHash<QString, filestate_t> files = previous.value(*dir);
+        QHash<QString, filestate_t> current;
+        QDirIterator it(*dir, ext, filters);
 
         while (it.hasNext())
         {
-            filenames.append(it.next());
+            if (!checkPoint())
+                return false;
+
+            QString name = it.next();
+            QFileInfo info = it.fileInfo();
+
+            if (info.isDir())
+            {
+                // Subfolders appeared since the previous reading are read together with their files
+                if ((!previous.contains(name)) && (!listed.contains(name)) && (!listTree(name, &listed, bytes)))
+                    return false;
+
+                continue;
+            }
+
+            filestate_t state = fileState(info);
+            QHash<QString, filestate_t>::const_iterator old = files.constFind(name);
+            current.insert(name, state);
+
+            if ((old == files.constEnd()) || (old.value() != state))
+            {
+                filenames.append(name);
+                bytes += info.size();
+            }
         }
-    };
+
+        listed.insert(*dir, current);
+    }
+
+    return true;
 }
 
 void FileReader::run()
 {
+    listFiles();
+
     QStringList::iterator it;
 
     for (it = filenames.begin(); it != filenames.end(); ++it)
     {
-        FileRecord *rec = new FileRecord();
+        if (!checkPoint())
+        {
+            emit EventMessage(tr("Reading cancelled"));
+            break;
+        }
+
+        FileRecord rec;
         QFileInfo f(*it);
+        bool regular;
+        qint64 fileStart = Profiler::now();
+        sample = ScanReport::Sample();
+
+        {
+            Profiler::Scope scope(Profiler::phStat);
+            regular = (f.isFile()) && (!f.isSymLink());
 
-        if ((f.isFile()) && (!f.isSymLink()))
+            if (regular)
+            {
+                rec.setSize(f.size());
+                rec.setFileName(f.canonicalFilePath());
+            }
+        }
+
+        if (regular)
         {
-            rec->setSize(f.size());
-            rec->setFileName(f.canonicalFilePath());
-            rec->setIsArchive(isFileArchive(*it));
-            parseFile((*it), *rec);
+            rec.setIsArchive(isFileArchive(*it));
+            sample.fileName = rec.getFileName();
+            sample.archive = rec.isArchive();
+            sample.size = rec.getSize();
+            parseFile((*it), rec);
+            sample.encoding = rec.getEncoding();
+            sample.totalTime = Profiler::now() - fileStart;
+            report.add(sample);
+            rec.setStatus(RecordValidator::classify(rec));
         }
 
-        emit AppendRecord(*rec);
-        delete rec;
+        emit AppendRecord(rec);
+
+        addProgress(1, f.size());
     }
 }
 
@@ -93,40 +336,60 @@ bool FileReader::isFileArchive(const QString &filename)
     return (f.suffix().toLower() == "zip");
 }
 
+const ScanReport &FileReader::getReport() const
+{
+    return report;
+}
+
 void FileReader::parseFile(QString &filename, FileRecord &record)
 {
     QFileInfo f(filename);
-    QFile file(filename);
-    QByteArray data;
+    QBuffer buffer(&head);
     QXmlStreamReader reader;
 
     if (f.suffix() == "fb2")
     {
-        if (!file.open(QFile::ReadOnly | QFile::Text))
+        if (0 != readHead(filename, head))
         {
+            sample.error = true;
             return;
         }
-
-        reader.setDevice(&file);
     }
     else
         if (f.suffix() == "zip")
         {
-            int res = unzipFile(filename, data);
+            int res = unzipHead(filename, head);
 
             if (0 != res)
             {
+                sample.error = true;
                 return;
             }
-
-            reader.addData(data);
         }
+        else
+            return;
+
+    Profiler::Scope scope(Profiler::phParse);
+    qint64 parseStart = Profiler::now();
+    CyrillicDecoder::CodePage codePage = CyrillicDecoder::codePageForName(CyrillicDecoder::declaredEncoding(head));
+
+    if (tableDecoding && (codePage != CyrillicDecoder::cpNone))
+    {
+        // Common legacy encodings are decoded by the table instead of creating a generic codec for each book
+        reader.addData(CyrillicDecoder::decode(head.constData(), head.size(), codePage));
+    }
+    else
+    {
+        // The reader takes the data from the reused buffer without copying it
+        buffer.open(QIODevice::ReadOnly);
+        reader.setDevice(&buffer);
+    }
 
     reader.readNext();
 
     if (reader.isStartDocument())
     {
-        record.setEncoding(reader.documentEncoding().toString());
+        record.setEncoding(intern(reader.documentEncoding().toString()));
     }
 
     if (reader.readNextStartElement())
@@ -150,56 +413,55 @@ void FileReader::parseFile(QString &filename, FileRecord &record)
                                     if (reader.attributes().hasAttribute("match"))
                                     {
                                         int match = reader.attributes().value("match").toInt();
-                                        record.addGenre(genre, match);
+                                        record.addGenre(intern(genre), match);
                                     }
                                     else
-                                        record.addGenre(genre);
+                                        record.addGenre(intern(genre));
                                 }
                                 else
                                     if (reader.name() == "author")
                                     {
-                                        Person *tmpAuthor = new Person();
+                                        Person tmpAuthor;
 
                                         while (reader.readNextStartElement())
                                         {
                                             if (reader.name() == "first-name")
                                             {
-                                                tmpAuthor->setFirstName(reader.readElementText());
+                                                tmpAuthor.setFirstName(intern(reader.readElementText()));
                                             }
 
                                             if (reader.name() == "middle-name")
                                             {
-                                                tmpAuthor->setMiddleName(reader.readElementText());
+                                                tmpAuthor.setMiddleName(intern(reader.readElementText()));
                                             }
 
                                             if (reader.name() == "last-name")
                                             {
-                                                tmpAuthor->setLastName(reader.readElementText());
+                                                tmpAuthor.setLastName(intern(reader.readElementText()));
                                             }
 
                                             if (reader.name() == "nickname")
                                             {
-                                                tmpAuthor->setNickname(reader.readElementText());
+                                                tmpAuthor.setNickname(intern(reader.readElementText()));
                                             }
 
                                             if (reader.name() == "home-page")
                                             {
-                                                tmpAuthor->addHomePage(reader.readElementText());
+                                                tmpAuthor.addHomePage(reader.readElementText());
                                             }
 
                                             if (reader.name() == "email")
                                             {
-                                                tmpAuthor->addEmail(reader.readElementText());
+                                                tmpAuthor.addEmail(reader.readElementText());
                                             }
 
                                             if (reader.name() == "id")
                                             {
-                                                tmpAuthor->setId(reader.readElementText());
+                                                tmpAuthor.setId(reader.readElementText());
                                             }
                                         }
 
-                                        record.addAuthor(*tmpAuthor);
-                                        delete tmpAuthor;
+                                        record.addAuthor(tmpAuthor);
                                     }
                                     else
                                         if (reader.name() == "book-title")
@@ -211,7 +473,7 @@ void FileReader::parseFile(QString &filename, FileRecord &record)
                                             {
                                                 if (reader.attributes().hasAttribute("name"))
                                                 {
-                                                    QString sequence = reader.attributes().value("name").toString();
+                                                    QString sequence = intern(reader.attributes().value("name").toString());
 
                                                     if (reader.attributes().hasAttribute("number"))
                                                     {
@@ -222,7 +484,31 @@ void FileReader::parseFile(QString &filename, FileRecord &record)
                                                         record.addSequence(sequence);
                                                 }
                                             }
-                                            else reader.skipCurrentElement();
+                                            else
+                                                if (reader.name() == "coverpage")
+                                                {
+                                                    // The first image is the cover, its link refers to a binary section
+                                                    while (reader.readNextStartElement())
+                                                    {
+                                                        if ((reader.name() == "image") && (record.getCoverId().isEmpty()))
+                                                        {
+                                                            QXmlStreamAttributes attributes = reader.attributes();
+                                                            QXmlStreamAttributes::const_iterator attr;
+
+                                                            for (attr = attributes.constBegin(); attr != attributes.constEnd(); ++attr)
+                                                            {
+                                                                if ((*attr).name() == "href")
+                                                                {
+                                                                    QString href = (*attr).value().toString();
+                                                                    record.setCoverId(href.startsWith('#') ? href.mid(1) : href);
+                                                                }
+                                                            }
+                                                        }
+
+                                                        reader.skipCurrentElement();
+                                                    }
+                                                }
+                                                else reader.skipCurrentElement();
                             }
                         }
                     }
@@ -231,46 +517,118 @@ void FileReader::parseFile(QString &filename, FileRecord &record)
         }
     }
 
-    file.close();
+    // Only the beginning of the book is read, so the missing end of the document is not an error
+    if ((reader.hasError()) && (reader.error() != QXmlStreamReader::PrematureEndOfDocumentError))
+        sample.error = true;
+
+    sample.parseTime += Profiler::now() - parseStart;
+}
+
+void FileReader::prepareHead(QByteArray &data)
+{
+    // Capacity is reserved, so resize() keeps the memory of the previous book
+    if (data.capacity() > maxKeptHeadSize)
+        data = QByteArray();
+
+    if (data.capacity() < initialHeadSize)
+        data.reserve(initialHeadSize);
+
+    data.resize(0);
+}
+
+int FileReader::readHead(const QString &filename, QByteArray &data)
+{
+    prepareHead(data);
+
+    QFile file(filename);
+
+    {
+        Profiler::Scope scope(Profiler::phOpen);
+
+        if (!file.open(QFile::ReadOnly))
+            return MZ_PARAM_ERROR;
+    }
+
+    Profiler::Scope scope(Profiler::phRead);
+    char chunk[readChunkSize];
+    qint64 size;
+
+    while ((size = file.read(chunk, readChunkSize)) > 0)
+    {
+        sample.bytesRead += size;
+
+        if (appendHeadPart(data, chunk, static_cast<int>(size)))
+            break;
+    }
+
+    return (size < 0) ? MZ_PARAM_ERROR : 0;
 }
 
-int FileReader::unzipFile(QString &filename, QByteArray &file)
+int FileReader::unzipHead(const QString &filename, QByteArray &data)
 {
+    prepareHead(data);
+
     mz_bool status;
     mz_zip_archive archive;
     memset(&archive, 0, sizeof(archive));
-    status = mz_zip_reader_init_file(&archive, filename.toStdString().c_str(), 0);
-
-    if (status < MZ_OK)
-        return status;
+    archive.m_pAlloc = ScanArena::allocFunc;
+    archive.m_pFree = ScanArena::freeFunc;
+    archive.m_pRealloc = ScanArena::reallocFunc;
+    archive.m_pAlloc_opaque = &arena;
 
-    if (mz_zip_reader_get_num_files(&archive) != 1)
     {
-        emit ErrorMessage(tr("The archive %1 more than one file, or no files in the archive").arg(filename));
-        return MZ_PARAM_ERROR;
+        Profiler::Scope scope(Profiler::phOpen);
+        status = mz_zip_reader_init_file(&archive, filename.toStdString().c_str(), 0);
     }
 
-    mz_zip_archive_file_stat file_stat;
-    status = mz_zip_reader_file_stat(&archive, 0, &file_stat);
-
-    if (status < MZ_OK)
+    if (!status)
     {
-        emit ErrorMessage(tr("Error reading the file %1").arg(filename));
-        mz_zip_reader_end(&archive);
+        arena.reset();
         return MZ_PARAM_ERROR;
     }
 
-    size_t uncompressed_size = file_stat.m_uncomp_size;
-    void *p = mz_zip_reader_extract_file_to_heap(&archive, file_stat.m_filename, &uncompressed_size, 0);
+    int result = 0;
 
-    if (!p)
+    if (mz_zip_reader_get_num_files(&archive) != 1)
     {
-        emit ErrorMessage(tr("Error extracting file %1").arg(filename));
-        mz_zip_reader_end(&archive);
-        return MZ_PARAM_ERROR;
+        emit ErrorMessage(tr("The archive %1 more than one file, or no files in the archive").arg(filename));
+        result = MZ_PARAM_ERROR;
+    }
+    else
+    {
+        HeadSink sink;
+        sink.data = &data;
+        sink.complete = false;
+
+        // Central directory is read while opening, the rest is counted during extraction
+        CountingRead counter = {archive.m_pRead, archive.m_pIO_opaque, 0};
+        archive.m_pRead = countRead;
+        archive.m_pIO_opaque = &counter;
+
+        Profiler::Scope scope(Profiler::phInflate);
+        status = mz_zip_reader_extract_to_callback(&archive, 0, appendHead, &sink, 0);
+        sample.bytesRead += counter.bytes + static_cast<qint64>(archive.m_archive_size - archive.m_central_directory_file_ofs);
+        sample.bytesInflated += data.size();
+
+        // Extraction stopped by the callback reports failure, but the description is complete
+        if ((!status) && (!sink.complete))
+        {
+            emit ErrorMessage(tr("Error extracting file %1").arg(filename));
+            result = MZ_PARAM_ERROR;
+        }
     }
 
-    file.append(static_cast<char *>(p));
     mz_zip_reader_end(&archive);
-    return 0;
+    arena.reset();
+    return result;
+}
+
+const QString &FileReader::intern(const QString &text)
+{
+    QSet<QString>::const_iterator it = strings.constFind(text);
+
+    if (it == strings.constEnd())
+        it = strings.insert(text);
+
+    return *it;
 }
@@ -34,19 +34,29 @@
  */
 
 #include "filerecord.h"
+#include "job.h"
+#include "scanarena.h"
+#include "scanreport.h"
 
-#include <QThread>
 #include <QString>
 #include <QStringList>
+#include <QByteArray>
+#include <QSet>
 
 /**
  * @~russian
  * @brief Поток чтения файлов.
  *
+ * Перечисление файлов в папке выполняется в потоке чтения, поэтому общее количество файлов становится
+ * известно после завершения перечисления.
+ *
  * @~english
  * @brief Thread of file reading.
+ *
+ * Listing of files in the folder is performed in the reading thread, so the total number of files becomes
+ * known after the listing is complete.
  */
-class FileReader : public QThread
+class FileReader : public Job
 {
     Q_OBJECT
 public:
@@ -78,6 +88,53 @@ public:
      */
     FileReader(QString dir, bool recursive);
 
+    /**
+     * @~russian
+     * @brief Конструктор потока повторного чтения изменившихся папок.
+     *
+     * Содержимое папок сравнивается со снимком, читаются только созданные и измененные файлы.
+     * Новые подпапки читаются целиком. Снимок прочитанных папок отсылается сигналом Snapshot().
+     * @param snapshot Снимок содержимого папок на момент предыдущего чтения.
+     * @param dirs Список изменившихся папок.
+     * @param recursive Обрабатывать ли новые подпапки.
+     *
+     * @~english
+     * @brief Constructor of the thread re-reading changed folders.
+     *
+     * Folders contents is compared with the snapshot, only created and modified files are read.
+     * New subfolders are read entirely. Snapshot of the listed folders is sent by Snapshot() signal.
+     * @param snapshot Snapshot of folders contents at the time of the previous reading.
+     * @param dirs List of changed folders.
+     * @param recursive Whether to read new subfolders.
+     */
+    FileReader(const snapshot_t &snapshot, const QStringList &dirs, bool recursive);
+
+    /**
+     * @~russian
+     * @brief Включение снимка содержимого папки при ее перечислении.
+     *
+     * Снимок отсылается сигналом Snapshot() после перечисления, до чтения файлов.
+     * @param enabled Строить ли снимок.
+     *
+     * @~english
+     * @brief Enabling of the folder contents snapshot during its listing.
+     *
+     * The snapshot is sent by Snapshot() signal after the listing, before reading files.
+     * @param enabled Whether to build the snapshot.
+     */
+    void setSnapshotEnabled(bool enabled);
+
+    /**
+     * @~russian
+     * @brief Получение заголовка задания для отображения пользователю.
+     * @return Заголовок задания.
+     *
+     * @~english
+     * @brief Getting the job title to display to the user.
+     * @return Job title.
+     */
+    QString getTitle() const;
+
     /**
      * @~russian
      * @brief Тело потока вычисления.
@@ -100,29 +157,22 @@ public:
      */
     void parseFile(QString &filename, FileRecord &record);
 
-signals:
     /**
      * @~russian
-     * @brief Отсылка сообщения в журнал сообщений.
-     * @param msg Текст сообщения.
+     * @brief Получение отчета о сканировании.
      *
-     * @~english
-     * @brief Sending messages to the message log.
-     * @param msg Message text.
-     */
-    void EventMessage(const QString &msg);
-
-    /**
-     * @~russian
-     * @brief Отсылка сообщения об ошибке в журнал сообщений.
-     * @param msg Текст сообщения.
+     * Отчет заполняется в потоке чтения, его можно получить после завершения потока.
+     * @return Отчет по папкам и типам файлов.
      *
      * @~english
-     * @brief Sending error messages to the message log.
-     * @param msg Message text.
+     * @brief Getting the scan report.
+     *
+     * The report is filled in the reading thread, it can be got after the thread is finished.
+     * @return Report by folders and file types.
      */
-    void ErrorMessage(const QString &msg);
+    const ScanReport &getReport() const;
 
+signals:
     /**
      * @~russian
      * @brief Добавление новой записи в модель данных.
@@ -134,9 +184,20 @@ signals:
      */
     void AppendRecord(const FileRecord &record);
 
+    /**
+     * @~russian
+     * @brief Отсылка снимка содержимого перечисленных папок.
+     * @param snapshot Снимок, в том числе папок без книг.
+     *
+     * @~english
+     * @brief Sending the snapshot of the listed folders contents.
+     * @param snapshot Snapshot including folders without books.
+     */
+    void Snapshot(const snapshot_t &snapshot);
+
 public slots:
 
-private:
+protected:
     /**
      * @~russian
      * @brief Список имен файлов.
@@ -146,6 +207,154 @@ private:
      */
     QStringList filenames;
 
+    /**
+     * @~russian
+     * @brief Декодировать ли windows-1251 и koi8-r по таблице перед разбором.
+     *
+     * Включено по умолчанию, отключается тестом производительности для сравнения с декодером Qt.
+     *
+     * @~english
+     * @brief Whether to decode windows-1251 and koi8-r by the table before parsing.
+     *
+     * Enabled by default, the benchmark disables it for comparison with the Qt decoder.
+     */
+    bool tableDecoding;
+
+    /**
+     * @~russian
+     * @brief Перечисление файлов в папке и подсчет общего объема работы.
+     *
+     * @~english
+     * @brief Listing of files in the folder and calculation of total amount of work.
+     */
+    void listFiles();
+
+    /**
+     * @~russian
+     * @brief Чтение начала несжатого файла до конца описания книги.
+     *
+     * Файл читается частями, чтение останавливается после элемента @c title-info.
+     * @param filename Имя файла.
+     * @param data Массив байтов, в который помещается начало файла.
+     * @return Код результата.
+     *
+     * @~english
+     * @brief Reading the beginning of the uncompressed file up to the end of the book description.
+     *
+     * The file is read by parts, reading stops after @c title-info element.
+     * @param filename File name.
+     * @param data Byte array receiving the beginning of the file.
+     * @return Result code.
+     */
+    int readHead(const QString &filename, QByteArray &data);
+
+    /**
+     * @~russian
+     * @brief Распаковка начала сжатого файла до конца описания книги.
+     *
+     * Распаковка останавливается после элемента @c title-info, текст книги не распаковывается.
+     * Временные буферы miniz выделяются из арены.
+     * @param filename Имя файла.
+     * @param data Массив байтов, в который помещается начало распакованного файла.
+     * @return Код результата.
+     *
+     * @~english
+     * @brief Unpacking the beginning of the compressed file up to the end of the book description.
+     *
+     * Unpacking stops after @c title-info element, the book text is not unpacked.
+     * Temporary miniz buffers are allocated from the arena.
+     * @param filename File name.
+     * @param data Byte array receiving the beginning of the unpacked file.
+     * @return Result code.
+     */
+    int unzipHead(const QString &filename, QByteArray &data);
+
+private:
+    /**
+     * @~russian
+     * @brief Папка, в которой будут считываться файлы.
+     *
+     * Пустая, если список файлов задан явно.
+     *
+     * @~english
+     * @brief The folder in which files will be read.
+     *
+     * Empty if the list of files is specified explicitly.
+     */
+    QString directory;
+
+    /**
+     * @~russian
+     * @brief Обрабатывать ли подпапки.
+     *
+     * @~english
+     * @brief Read folder recursively.
+     */
+    bool recursive;
+
+    /**
+     * @~russian
+     * @brief Строить ли снимок содержимого папок при перечислении.
+     *
+     * @~english
+     * @brief Whether to build the snapshot of folders contents during listing.
+     */
+    bool snapshotEnabled;
+
+    /**
+     * @~russian
+     * @brief Снимок содержимого папок на момент предыдущего чтения.
+     *
+     * @~english
+     * @brief Snapshot of folders contents at the time of the previous reading.
+     */
+    snapshot_t previous;
+
+    /**
+     * @~russian
+     * @brief Изменившиеся папки, которые сравниваются со снимком.
+     *
+     * @~english
+     * @brief Changed folders compared with the snapshot.
+     */
+    QStringList changedDirs;
+
+    /**
+     * @~russian
+     * @brief Перечисление файлов папки и ее подпапок.
+     * @param path Папка.
+     * @param listed Снимок, в который добавляются перечисленные папки, или 0.
+     * @param bytes Счетчик объема найденных файлов.
+     * @return @c true - если перечисление завершено;@n
+     * @c false - если задание отменено.
+     *
+     * @~english
+     * @brief Listing files of the folder and its subfolders.
+     * @param path Folder.
+     * @param listed Snapshot to which listed folders are added, or 0.
+     * @param bytes Counter of size of found files.
+     * @return @c true - if the listing is complete;@n
+     * @c false - if the job is cancelled.
+     */
+    bool listTree(const QString &path, snapshot_t *listed, qint64 &bytes);
+
+    /**
+     * @~russian
+     * @brief Перечисление созданных и измененных файлов в изменившихся папках.
+     * @param listed Снимок, в который добавляются перечисленные папки.
+     * @param bytes Счетчик объема найденных файлов.
+     * @return @c true - если перечисление завершено;@n
+     * @c false - если задание отменено.
+     *
+     * @~english
+     * @brief Listing created and modified files in changed folders.
+     * @param listed Snapshot to which listed folders are added.
+     * @param bytes Counter of size of found files.
+     * @return @c true - if the listing is complete;@n
+     * @c false - if the job is cancelled.
+     */
+    bool listChanges(snapshot_t &listed, qint64 &bytes);
+
     /**
      * @~russian
      * @brief Проверка, является ли файл архивом.
@@ -169,18 +378,82 @@ private:
 
     /**
      * @~russian
-     * @brief Распаковка сжатого файла в массив байтов.
-     * @param filename Имя файла.
-     * @param Массив байтов, содержащий в себе распакованный файл.
-     * @return Код результата.
+     * @brief Арена для временных буферов распаковки, освобождается после каждого файла.
      *
      * @~english
-     * @brief Unpack the compressed file into a byte array.
-     * @param filename File name.
-     * @param An array of bytes containing the decompressed file.
-     * @return Result code.
+     * @brief Arena for temporary unpacking buffers, released after each file.
+     */
+    ScanArena arena;
+
+    /**
+     * @~russian
+     * @brief Буфер распакованного начала книги, используется повторно для всех файлов.
+     *
+     * @~english
+     * @brief Buffer of the unpacked beginning of the book, reused for all files.
+     */
+    QByteArray head;
+
+    /**
+     * @~russian
+     * @brief Пул повторяющихся строк (жанры, серии, имена авторов, кодировки).
+     *
+     * @~english
+     * @brief Pool of repeating strings (genres, series, author names, encodings).
+     */
+    QSet<QString> strings;
+
+    /**
+     * @~russian
+     * @brief Отчет о сканировании.
+     *
+     * @~english
+     * @brief Scan report.
+     */
+    ScanReport report;
+
+    /**
+     * @~russian
+     * @brief Замеры текущего файла.
+     *
+     * @~english
+     * @brief Measurements of the current file.
+     */
+    ScanReport::Sample sample;
+
+    /**
+     * @~russian
+     * @brief Подготовка буфера начала книги к чтению следующего файла.
+     *
+     * Слишком большой после необычной книги буфер освобождается, иначе его память используется повторно.
+     * @param data Буфер начала книги.
+     *
+     * @~english
+     * @brief Preparing the buffer of the book beginning for reading the next file.
+     *
+     * The buffer that became too large after an unusual book is released, otherwise its memory is reused.
+     * @param data Buffer of the book beginning.
+     */
+    void prepareHead(QByteArray &data);
+
+    /**
+     * @~russian
+     * @brief Получение разделяемой копии строки из пула.
+     *
+     * Одинаковые значения всех записей ссылаются на одни данные, поэтому в долгоживущие записи
+     * не попадают отдельные копии одних и тех же строк.
+     * @param text Строка.
+     * @return Строка из пула.
+     *
+     * @~english
+     * @brief Getting a shared copy of the string from the pool.
+     *
+     * Equal values of all records refer to the same data, so long-lived records do not get separate copies
+     * of the same strings.
+     * @param text String.
+     * @return String from the pool.
      */
-    int unzipFile(QString &filename, QByteArray &file);
+    const QString &intern(const QString &text);
 
 };
 
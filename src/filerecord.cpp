@@ -33,65 +33,236 @@
 #endif
 #include "3rdparty/miniz.h"
 
+#include "paralleldeflate.h"
+#include "genreregistry.h"
+#include "profiler.h"
+
 #include <QString>
 #include <QVector>
 #include <QPair>
 #include <QStringList>
 #include <QDir>
 #include <QFile>
+#include <QDateTime>
 #include <QApplication>
 
-FileRecord::FileRecord()
+const qint64 parallelDeflateSize = 4 * 1024 * 1024; // Larger books are compressed by blocks in several threads
+
+/**
+ * @~russian
+ * @brief Разделяемые данные записи метаданных.
+ *
+ * @~english
+ * @brief Shared data of the metadata record.
+ */
+class FileRecordData : public QSharedData
+{
+public:
+    FileRecordData() :
+        status(stNormalRecord), size(0), archived(false), selected(false)
+    {
+
+    }
+    /**
+     * @~russian
+     * @brief Состояние записи - для различных отображений.
+     *
+     * @~english
+     * @brief Status of the record.
+     */
+    Status status;
+
+    /**
+     * @~russian
+     * @brief Полное имя файла.
+     *
+     * @~english
+     * @brief Full file name.
+     */
+    QString filename;
+
+    /**
+     * @~russian
+     * @brief Размер файла.
+     *
+     * @~english
+     * @brief File size.
+     */
+    qint64 size;
+
+    /**
+     * @~russian
+     * @brief Является ли файл архивом.
+     *
+     * @c true - если файл - архив;@n
+     * @c false - обычный файл.
+     *
+     * @~english
+     * @brief Is a file archive?
+     *
+     * @c true - if file is archive;@n
+     * @c false - if not.
+     */
+    bool archived;
+
+    /**
+     * @~russian
+     * @brief Название книги.
+     *
+     * Один, обязательно.
+     *
+     * @~english
+     * @brief Book title.
+     *
+     * One, required.
+     */
+    QString BookTitle;
+
+    /**
+     * @~russian
+     * @brief Автор книги.
+     *
+     * Один или более, обязательно.
+     *
+     * @~english
+     * @brief Book author.
+     *
+     * One or more, required.
+     */
+    QVector<Person> BookAuthor;
+
+    /**
+     * @~russian
+     * @brief Список жанров файла.
+     *
+     * @~english
+     * @brief Genres list of the file.
+     */
+    genre_t Genres;
+
+    /**
+     * @~russian
+     * @brief Идентификаторы жанров в справочнике, в порядке списка жанров.
+     *
+     * @~english
+     * @brief Identifiers of genres in the registry, in the order of genres list.
+     */
+    QVector<quint16> GenreIds;
+
+    /**
+     * @~russian
+     * @brief Список серий файла.
+     *
+     * @~english
+     * @brief Series list of the file.
+     */
+    sequence_t Sequences;
+
+    /**
+     * @~russian
+     * @brief Кодировка файла.
+     *
+     * @~english
+     * @brief Encoding of the file.
+     */
+    QString encoding;
+
+    /**
+     * @~russian
+     * @brief Идентификатор раздела @c binary с обложкой.
+     *
+     * @~english
+     * @brief Identifier of @c binary section with the cover.
+     */
+    QString coverId;
+
+    /**
+     * @~russian
+     * @brief Статистика текста книги.
+     *
+     * @~english
+     * @brief Statistics of the book text.
+     */
+    BodyStatistics bodyStatistics;
+
+    /**
+     * @~russian
+     * @brief Состояние пометки записи.
+     *
+     * @~english
+     * @brief The status of record selection.
+     */
+    bool selected;
+};
+
+FileRecord::FileRecord() :
+    d(new FileRecordData)
 {
-    archived = false;
-    selected = false;
+
+}
+
+FileRecord::FileRecord(const FileRecord &other) :
+    d(other.d)
+{
+
+}
+
+FileRecord::~FileRecord()
+{
+
+}
+
+FileRecord &FileRecord::operator=(const FileRecord &other)
+{
+    d = other.d;
+    return *this;
 }
 
 void FileRecord::setSize(qint64 Size)
 {
-    size = Size;
+    d->size = Size;
 }
 
-qint64 FileRecord::getSize()
+qint64 FileRecord::getSize() const
 {
-    return size;
+    return d->size;
 }
 
 void FileRecord::setFileName(const QString &Filename)
 {
-    filename = Filename;
+    d->filename = Filename;
 }
 
-QString FileRecord::getFileName() const
+const QString &FileRecord::getFileName() const
 {
-    return filename;
+    return d->filename;
 }
 
 void FileRecord::setIsArchive(bool IsArchive)
 {
-    archived = IsArchive;
+    d->archived = IsArchive;
 }
 
 bool FileRecord::isArchive() const
 {
-    return archived;
+    return d->archived;
 }
 
-void FileRecord::setBookTitle(QString title)
+void FileRecord::setBookTitle(const QString &title)
 {
-    BookTitle = title;
+    d->BookTitle = title;
 }
 
-QString FileRecord::getBookTitle() const
+const QString &FileRecord::getBookTitle() const
 {
-    return BookTitle;
+    return d->BookTitle;
 }
 
 QString FileRecord::getBookTitleExt() const
 {
-    QString result = BookTitle;
+    QString result = d->BookTitle;
 
-    if (archived)
+    if (d->archived)
         result += ".fb2.zip";
     else
         result += ".fb2";
@@ -99,43 +270,73 @@ QString FileRecord::getBookTitleExt() const
     return result;
 }
 
-void FileRecord::addGenre(QString genre_name, int genre_match)
+void FileRecord::addGenre(const QString &genre_name, int genre_match)
+{
+    d->Genres.append(qMakePair(genre_name, genre_match));
+    d->GenreIds.append(GenreRegistry::find(genre_name));
+}
+
+const genre_t &FileRecord::getGenresList() const
+{
+    return d->Genres;
+}
+
+void FileRecord::setGenresList(const genre_t &genres)
+{
+    d->Genres = genres;
+    d->GenreIds.clear();
+    d->GenreIds.reserve(genres.size());
+
+    for (genre_t::const_iterator it = genres.constBegin(); it != genres.constEnd(); ++it)
+        d->GenreIds.append(GenreRegistry::find(it->first));
+}
+
+const QVector<quint16> &FileRecord::getGenreIds() const
 {
-    Genres.append(qMakePair(genre_name, genre_match));
+    return d->GenreIds;
 }
 
-genre_t FileRecord::getGenresList()
+bool FileRecord::hasUnknownGenre() const
 {
-    return Genres;
+    return d->GenreIds.contains(GenreRegistry::unknownGenre);
+}
 
+void FileRecord::setEncoding(const QString &Encoding)
+{
+    d->encoding = Encoding;
 }
 
-void FileRecord::setEncoding(QString Encoding)
+const QString &FileRecord::getEncoding() const
 {
-    encoding = Encoding;
+    return d->encoding;
 }
 
-QString FileRecord::getEncoding() const
+void FileRecord::addAuthor(const Person &author)
 {
-    return encoding;
+    d->BookAuthor.append(author);
 }
 
-void FileRecord::addAuthor(Person author)
+const Person &FileRecord::getAuthor(int index) const
 {
-    BookAuthor.append(author);
+    return d->BookAuthor.at(index);
 }
 
-Person FileRecord::getAuthor(int index) const
+void FileRecord::setAuthor(int index, const Person &author)
 {
-    return BookAuthor.at(index);
+    d->BookAuthor[index] = author;
 }
 
-QStringList FileRecord::getAuthorList()
+void FileRecord::clearAuthors()
+{
+    d->BookAuthor.clear();
+}
+
+QStringList FileRecord::getAuthorList() const
 {
     QStringList tmp;
-    QVector<Person>::iterator it;
+    QVector<Person>::const_iterator it;
 
-    for (it = BookAuthor.begin(); it != BookAuthor.end(); ++it)
+    for (it = d->BookAuthor.constBegin(); it != d->BookAuthor.constEnd(); ++it)
     {
         tmp.append((*it).getFullNameLFM());
     }
@@ -143,89 +344,74 @@ QStringList FileRecord::getAuthorList()
     return tmp;
 }
 
-int FileRecord::getAuthorCount()
+int FileRecord::getAuthorCount() const
 {
-    return BookAuthor.count();
+    return d->BookAuthor.count();
 }
 
-void FileRecord::addSequence(QString sequence, int number)
+void FileRecord::addSequence(const QString &sequence, int number)
 {
-    Sequences.append(qMakePair(sequence, number));
+    d->Sequences.append(qMakePair(sequence, number));
 }
 
-sequence_t FileRecord::getSequenceList() const
+const sequence_t &FileRecord::getSequenceList() const
 {
-    return Sequences;
+    return d->Sequences;
 }
 
-void FileRecord::setSelected(bool Selected)
+void FileRecord::setSequenceList(const sequence_t &sequences)
 {
-    selected = Selected;
+    d->Sequences = sequences;
 }
 
-bool FileRecord::isSelected()
+void FileRecord::setSelected(bool Selected)
 {
-    return selected;
+    d->selected = Selected;
 }
 
-QString FileRecord::unzipFile()
+bool FileRecord::isSelected() const
 {
-    mz_bool status;
-    mz_zip_archive archive;
-    memset(&archive, 0, sizeof(archive));
-    status = mz_zip_reader_init_file(&archive, filename.toStdString().c_str(), 0);
-
-    qint64 oldSize = getSize();
-
-    if (status < MZ_OK)
-    {
-        return msgError(qApp->tr("Cannot open archive %1").arg(filename));
-    }
-
-    if (mz_zip_reader_get_num_files(&archive) != 1)
-    {
-        return msgError(qApp->tr("The archive %1 more than one file, or no files in the archive").arg(filename));
-    }
-
-    mz_zip_archive_file_stat file_stat;
-    status = mz_zip_reader_file_stat(&archive, 0, &file_stat);
+    return d->selected;
+}
 
-    if (status < MZ_OK)
-    {
-        mz_zip_reader_end(&archive);
-        return msgError(qApp->tr("Error reading the archive %1").arg(filename));
-    }
+void FileRecord::setStatus(Status status)
+{
+    d->status = status;
+}
 
-    QFileInfo tmp(filename);
-    QString resultFileName = QDir::toNativeSeparators(QString(tmp.canonicalPath() + "/" + file_stat.m_filename));
-    status = mz_zip_reader_extract_file_to_file(&archive, file_stat.m_filename, resultFileName.toStdString().c_str(), 0);
+Status FileRecord::getStatus() const
+{
+    return d->status;
+}
 
-    if (status < MZ_OK)
-    {
-        return msgError(qApp->tr("Error extracting file %2 from archive %1").arg(filename,
-                        QString(file_stat.m_filename)));
-    }
+void FileRecord::setCoverId(const QString &id)
+{
+    d->coverId = id;
+}
 
-    mz_zip_reader_end(&archive);
+const QString &FileRecord::getCoverId() const
+{
+    return d->coverId;
+}
 
-    QString oldFileName = filename;
-    setFileName(resultFileName);
-    QFileInfo tmp2(filename);
-    setSize(tmp2.size());
-    setIsArchive(false);
-    QFile::remove(oldFileName);
+void FileRecord::setBodyStatistics(const BodyStatistics &statistics)
+{
+    d->bodyStatistics = statistics;
+}
 
-    return msgResult(qApp->tr("Archive %1 succesfully unzipped (%2 -> %3)").arg(oldFileName, QString::number(oldSize),
-                     QString::number(getSize())));
+const BodyStatistics &FileRecord::getBodyStatistics() const
+{
+    return d->bodyStatistics;
 }
 
-QString FileRecord::zipFile()
+QString FileRecord::zipFile(int level, int maxRatio)
 {
+    Profiler::Scope scope(Profiler::phZip);
     //TODO Escape symbols in filename because files with non-valid names can't be compressed
     mz_bool status;
     mz_zip_archive archive;
     memset(&archive, 0, sizeof(archive));
-    QString archiveName = QString(filename + ".zip");
+    QString archiveName = QString(getFileName() + ".zip");
 
     archiveName = getNewName(archiveName);
 
@@ -235,26 +421,63 @@ QString FileRecord::zipFile()
 
     status = mz_zip_writer_init_file(&archive, archiveName.toStdString().c_str(), 0);
 
-    if (status < MZ_OK)
+    if (!status)
     {
         return msgError(qApp->tr("Cannot create archive %1").arg(archiveName));
     }
 
-    status = mz_zip_writer_add_file(&archive, tmp.completeBaseName().toStdString().c_str(), filename.toStdString().c_str(),
-                                    "", (mz_uint16)strlen(""), MZ_BEST_COMPRESSION);
+    if (oldSize >= parallelDeflateSize)
+    {
+        // The deflate stream is prepared in advance, miniz only stores it with the given size and checksum
+        QFile file(getFileName());
+        QByteArray data;
+        ParallelDeflate deflate(level);
+
+        if (file.open(QFile::ReadOnly))
+        {
+            data = file.readAll();
+            file.close();
+        }
+
+        status = (data.size() == oldSize) && deflate.compressBuffer(data);
+
+        if (status)
+        {
+            status = mz_zip_writer_add_mem_ex(&archive, tmp.completeBaseName().toStdString().c_str(),
+                                              deflate.getResult().constData(), deflate.getResult().size(), "", (mz_uint16)strlen(""),
+                                              level | MZ_ZIP_FLAG_COMPRESSED_DATA, data.size(), deflate.getCrc32());
+        }
+    }
+    else
+    {
+        status = mz_zip_writer_add_file(&archive, tmp.completeBaseName().toStdString().c_str(), getFileName().toStdString().c_str(),
+                                        "", (mz_uint16)strlen(""), level);
+    }
+
+    if (status)
+        status = mz_zip_writer_finalize_archive(&archive);
 
-    mz_zip_writer_finalize_archive(&archive);
     mz_zip_writer_end(&archive);
 
-    if (status < MZ_OK)
+    if (!status)
     {
         QFile::remove(archiveName);
-        return msgError(qApp->tr("Cannot compress file %2  to archive %1").arg(archiveName, filename));
+        return msgError(qApp->tr("Cannot compress file %2  to archive %1").arg(archiveName, getFileName()));
+    }
+
+    QFileInfo archiveInfo(archiveName);
+
+    if ((maxRatio > 0) && (archiveInfo.size() * 100 > oldSize * maxRatio))
+    {
+        qint64 archiveSize = archiveInfo.size();
+        QFile::remove(archiveName);
+        return msgResult(qApp->tr("File %1 left uncompressed, compression is not worth it (%2 -> %3)").arg(getFileName(),
+                         QString::number(oldSize), QString::number(archiveSize)));
     }
 
     QString oldFileName = getFileName();
     setFileName(archiveName);
-    QFileInfo tmp2(filename);
+    QFileInfo tmp2(getFileName());
     setSize(tmp2.size());
     setIsArchive(true);
     QFile::remove(oldFileName);
@@ -265,6 +488,7 @@ QString FileRecord::zipFile()
 
 QString FileRecord::moveFile(QString newName)
 {
+    Profiler::Scope scope(Profiler::phRename);
     newName = getNewName(newName);
 
     if (!makeDir(newName))
@@ -307,6 +531,7 @@ QString FileRecord::copyFile(QString newName)
 
 QString FileRecord::renameFile(QString newName)
 {
+    Profiler::Scope scope(Profiler::phRename);
     newName = getNewName(newName);
 
     if (!makeDir(newName))
@@ -358,6 +583,13 @@ QString FileRecord::getNewName(QString fileName)
     return fileName;
 }
 
+QString FileRecord::getVersionKey(const QString &fileName)
+{
+    QFileInfo info(fileName);
+    return info.absoluteFilePath() + '\n' + QString::number(info.size()) + '\n'
+           + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
 bool FileRecord::makeDir(QString fileName)
 {
     QFileInfo file(fileName);
@@ -32,6 +32,11 @@
 #include "types.h"
 #include "person.h"
 
+#include <QSharedDataPointer>
+
+// Forward class declarations
+class FileRecordData;
+
 /**
  * @~russian
  * @brief Перечисление возможных статусов записи.
@@ -50,8 +55,14 @@ enum Status
  * @~russian
  * @brief Класс единичной записи метаданных.
  *
+ * Данные записи разделяются неявно (копирование при записи), поэтому передача записи между потоками,
+ * моделью и окнами стоит лишь изменения счетчика ссылок.
+ *
  * @~english
  * @brief Single metadata record class.
+ *
+ * The record data is implicitly shared (copy-on-write), so passing the record between threads,
+ * the model and windows costs only a reference count change.
  */
 class FileRecord
 {
@@ -65,6 +76,80 @@ public:
      */
     FileRecord();
 
+    /**
+     * @~russian
+     * @brief Конструктор копирования.
+     *
+     * Данные не копируются, а разделяются до первого изменения одной из копий.
+     * @param other Копируемая запись.
+     *
+     * @~english
+     * @brief Copy constructor.
+     *
+     * The data is not copied but shared until one of the copies is changed.
+     * @param other Copied record.
+     */
+    FileRecord(const FileRecord &other);
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    /**
+     * @~russian
+     * @brief Конструктор перемещения.
+     * @param other Перемещаемая запись.
+     *
+     * @~english
+     * @brief Move constructor.
+     * @param other Moved record.
+     */
+    FileRecord(FileRecord &&other) Q_DECL_NOTHROW : d(std::move(other.d)) {}
+
+    /**
+     * @~russian
+     * @brief Оператор перемещающего присваивания.
+     * @param other Перемещаемая запись.
+     * @return Ссылка на эту запись.
+     *
+     * @~english
+     * @brief Move assignment operator.
+     * @param other Moved record.
+     * @return Reference to this record.
+     */
+    FileRecord &operator=(FileRecord &&other) Q_DECL_NOTHROW { swap(other); return *this; }
+#endif
+
+    /**
+     * @~russian
+     * @brief Деструктор записи.
+     *
+     * @~english
+     * @brief Destructor of a record.
+     */
+    ~FileRecord();
+
+    /**
+     * @~russian
+     * @brief Оператор присваивания.
+     * @param other Присваиваемая запись.
+     * @return Ссылка на эту запись.
+     *
+     * @~english
+     * @brief Assignment operator.
+     * @param other Assigned record.
+     * @return Reference to this record.
+     */
+    FileRecord &operator=(const FileRecord &other);
+
+    /**
+     * @~russian
+     * @brief Обмен данными с другой записью.
+     * @param other Другая запись.
+     *
+     * @~english
+     * @brief Swapping data with another record.
+     * @param other Another record.
+     */
+    void swap(FileRecord &other) Q_DECL_NOTHROW { d.swap(other.d); }
+
     /**
      * @~russian
      * @brief Установка размера файла.
@@ -85,7 +170,7 @@ public:
      * @brief Getting of file size.
      * @return File size.
      */
-    qint64 getSize();
+    qint64 getSize() const;
 
     /**
      * @~russian
@@ -107,7 +192,7 @@ public:
      * @brief Getting of file name.
      * @return File name.
      */
-    QString getFileName() const;
+    const QString &getFileName() const;
 
     /**
      * @~russian
@@ -148,7 +233,7 @@ public:
      * @brief Setting of book title.
      * @param title Book title.
      */
-    void setBookTitle(QString title);
+    void setBookTitle(const QString &title);
 
     /**
      * @~russian
@@ -159,7 +244,7 @@ public:
      * @brief Getting of book title.
      * @return Book title.
      */
-    QString getBookTitle() const;
+    const QString &getBookTitle() const;
 
     /**
      * @~russian
@@ -187,7 +272,7 @@ public:
      *
      * If not specified, the 100% (full match).
      */
-    void addGenre(QString genre_name, int genre_match = 100);
+    void addGenre(const QString &genre_name, int genre_match = 100);
 
     /**
      * @~russian
@@ -202,7 +287,46 @@ public:
      * For a further formatting list  issued "as is".
      * @return List of genres.
      */
-    genre_t getGenresList();
+    const genre_t &getGenresList() const;
+
+    /**
+     * @~russian
+     * @brief Замена списка жанров файла.
+     * @param genres Новый список жанров.
+     *
+     * @~english
+     * @brief Replacing the list of genres of the file.
+     * @param genres New list of genres.
+     */
+    void setGenresList(const genre_t &genres);
+
+    /**
+     * @~russian
+     * @brief Получение идентификаторов жанров файла в справочнике жанров.
+     *
+     * Порядок совпадает со списком жанров, для нестандартного кода хранится GenreRegistry::unknownGenre.
+     * @return Список идентификаторов жанров.
+     *
+     * @~english
+     * @brief Getting identifiers of the file genres in the genre registry.
+     *
+     * The order matches the list of genres, GenreRegistry::unknownGenre is kept for a non-standard code.
+     * @return List of genre identifiers.
+     */
+    const QVector<quint16> &getGenreIds() const;
+
+    /**
+     * @~russian
+     * @brief Проверка наличия нестандартных жанров.
+     * @return @c true - если хотя бы один код жанра отсутствует в справочнике;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Checking for non-standard genres.
+     * @return @c true - if at least one genre code is missing from the registry;@n
+     * @c false - if not.
+     */
+    bool hasUnknownGenre() const;
 
     /**
      * @~russian
@@ -213,7 +337,7 @@ public:
      * @brief Setting of file encoding.
      * @param Encoding Encoding
      */
-    void setEncoding(QString Encoding);
+    void setEncoding(const QString &Encoding);
 
     /**
      * @~russian
@@ -224,7 +348,7 @@ public:
      * @brief Getting of file encoding.
      * @return Encoding
      */
-    QString getEncoding() const;
+    const QString &getEncoding() const;
 
     /**
      * @~russian
@@ -235,7 +359,7 @@ public:
      * @brief Adding a new author in the list of authors of the record.
      * @param author Author.
      */
-    void addAuthor(Person author);
+    void addAuthor(const Person &author);
 
     /**
      * @~russian
@@ -248,7 +372,29 @@ public:
      * @param index Author's position in the list.
      * @return Author's record.
      */
-    Person getAuthor(int index) const;
+    const Person &getAuthor(int index) const;
+
+    /**
+     * @~russian
+     * @brief Замена автора в списке авторов.
+     * @param index Позиция автора в списке.
+     * @param author Новая запись об авторе.
+     *
+     * @~english
+     * @brief Replacing the author in the list of authors.
+     * @param index Author's position in the list.
+     * @param author New author's record.
+     */
+    void setAuthor(int index, const Person &author);
+
+    /**
+     * @~russian
+     * @brief Очистка списка авторов.
+     *
+     * @~english
+     * @brief Clearing the list of authors.
+     */
+    void clearAuthors();
 
     /**
      * @~russian
@@ -263,7 +409,7 @@ public:
      * List issued in the format of "Full Name", every author on a separate line.
      * @return List of authors.
      */
-    QStringList getAuthorList();
+    QStringList getAuthorList() const;
 
     /**
      * @~russian
@@ -274,7 +420,7 @@ public:
      * @brief Getting the number of authors in the list.
      * @return Number of authors.
      */
-    int getAuthorCount();
+    int getAuthorCount() const;
 
     /**
      * @~russian
@@ -291,7 +437,7 @@ public:
      *
      * If not specified, 0 (unnumbered book in the series).
      */
-    void addSequence(QString sequence, int number = 0);
+    void addSequence(const QString &sequence, int number = 0);
 
     /**
      * @~russian
@@ -306,7 +452,18 @@ public:
      * For a further formatting list  issued "as is".
      * @return List of series.
      */
-    sequence_t getSequenceList() const;
+    const sequence_t &getSequenceList() const;
+
+    /**
+     * @~russian
+     * @brief Замена списка серий файла.
+     * @param sequences Новый список серий.
+     *
+     * @~english
+     * @brief Replacing the list of series of the file.
+     * @param sequences New list of series.
+     */
+    void setSequenceList(const sequence_t &sequences);
 
     /**
      * @~russian
@@ -336,190 +493,177 @@ public:
      * @c true - a record marked as selected;@n
      * @c false - a record marked as unselected.
      */
-    bool isSelected();
+    bool isSelected() const;
 
     /**
      * @~russian
-     * @brief Распаковка содержимого указанного архива.
-     * @return Сообщение о результате операции.
+     * @brief Установка статуса записи.
+     * @param status Статус записи.
      *
      * @~english
-     * @brief Unpack the contents of the specified file.
-     * @return Message result.
+     * @brief Setting the status of the record.
+     * @param status Status of the record.
      */
-    QString unzipFile();
+    void setStatus(Status status);
 
     /**
      * @~russian
-     * @brief Упаковка указанного файла в архив.
-     * @return Сообщение о результате операции.
+     * @brief Получение статуса записи.
+     * @return Статус записи.
      *
      * @~english
-     * @brief Packing the specified file to the archive.
-     * @return Message result.
+     * @brief Getting the status of the record.
+     * @return Status of the record.
      */
-    QString zipFile();
+    Status getStatus() const;
 
     /**
      * @~russian
-     * @brief Перемещение указанного файла.
-     * @param newName Имя файла после перемещения.
-     * @return Сообщение о результате операции.
+     * @brief Установка идентификатора обложки.
+     * @param id Идентификатор раздела @c binary с обложкой, без начального @c #.
      *
      * @~english
-     * @brief Moving of the specified file.
-     * @param newName File name after moving.
-     * @return Message result.
+     * @brief Setting the cover identifier.
+     * @param id Identifier of @c binary section with the cover, without leading @c #.
      */
-    QString moveFile(QString newName);
+    void setCoverId(const QString &id);
 
     /**
      * @~russian
-     * @brief Копирование указанного файла.
-     * @param newName Имя файла после копирования.
-     * @return Сообщение о результате операции.
+     * @brief Получение идентификатора обложки.
+     * @return Идентификатор раздела @c binary с обложкой, пустой - если обложки нет.
      *
      * @~english
-     * @brief Copying of the specified file.
-     * @param newName File name after copying.
-     * @return Message result.
+     * @brief Getting the cover identifier.
+     * @return Identifier of @c binary section with the cover, empty if there is no cover.
      */
-    QString copyFile(QString newName);
+    const QString &getCoverId() const;
 
     /**
      * @~russian
-     * @brief Переименование указанного файла.
-     * @param newName Имя файла после переименования.
-     * @return Сообщение о результате операции.
+     * @brief Установка статистики текста книги.
+     * @param statistics Статистика текста.
      *
      * @~english
-     * @brief Renaming of the specified file.
-     * @param newName File name after renaming.
-     * @return Message result.
+     * @brief Setting statistics of the book text.
+     * @param statistics Text statistics.
      */
-    QString renameFile(QString newName);
+    void setBodyStatistics(const BodyStatistics &statistics);
 
-private:
     /**
      * @~russian
-     * @brief Состояние записи - для различных отображений.
+     * @brief Получение статистики текста книги.
+     * @return Статистика текста, недействительная - если текст не анализировался.
      *
      * @~english
-     * @brief Status of the record.
+     * @brief Getting statistics of the book text.
+     * @return Text statistics, invalid if the text was not analyzed.
      */
-    Status status;
+    const BodyStatistics &getBodyStatistics() const;
 
     /**
      * @~russian
-     * @brief Полное имя файла.
+     * @brief Упаковка указанного файла в архив.
+     *
+     * Если размер архива превышает @a maxRatio процентов от размера файла, то архив удаляется,
+     * а файл остается несжатым. При @a maxRatio <= 0 архив сохраняется всегда. Большие файлы сжимаются блоками в нескольких потоках (см. ParallelDeflate).
+     * @param level Уровень сжатия от 1 (быстрое) до 9 (наилучшее).
+     * @param maxRatio Максимальное отношение размера архива к размеру файла в процентах, 0 - без проверки.
+     * @return Сообщение о результате операции.
      *
      * @~english
-     * @brief Full file name.
+     * @brief Packing the specified file to the archive.
+     *
+     * If the archive size exceeds @a maxRatio percent of the file size, the archive is removed
+     * and the file remains uncompressed. If @a maxRatio <= 0, the archive is always kept. Large files are compressed by blocks in several threads (see ParallelDeflate).
+     * @param level Compression level from 1 (fast) to 9 (best).
+     * @param maxRatio Maximum ratio of archive size to file size in percent, 0 - no check.
+     * @return Message result.
      */
-    QString filename;
+    QString zipFile(int level = 9, int maxRatio = 0);
 
     /**
      * @~russian
-     * @brief Размер файла.
+     * @brief Перемещение указанного файла.
+     * @param newName Имя файла после перемещения.
+     * @return Сообщение о результате операции.
      *
      * @~english
-     * @brief File size.
+     * @brief Moving of the specified file.
+     * @param newName File name after moving.
+     * @return Message result.
      */
-    qint64 size;
+    QString moveFile(QString newName);
 
     /**
      * @~russian
-     * @brief Является ли файл архивом.
-     *
-     * @c true - если файл - архив;@n
-     * @c false - обычный файл.
+     * @brief Копирование указанного файла.
+     * @param newName Имя файла после копирования.
+     * @return Сообщение о результате операции.
      *
      * @~english
-     * @brief Is a file archive?
-     *
-     * @c true - if file is archive;@n
-     * @c false - if not.
+     * @brief Copying of the specified file.
+     * @param newName File name after copying.
+     * @return Message result.
      */
-    bool archived;
+    QString copyFile(QString newName);
 
     /**
      * @~russian
-     * @brief Название книги.
-     *
-     * Один, обязательно.
+     * @brief Переименование указанного файла.
+     * @param newName Имя файла после переименования.
+     * @return Сообщение о результате операции.
      *
      * @~english
-     * @brief Book title.
-     *
-     * One, required.
+     * @brief Renaming of the specified file.
+     * @param newName File name after renaming.
+     * @return Message result.
      */
-    QString BookTitle;
+    QString renameFile(QString newName);
 
     /**
      * @~russian
-     * @brief Автор книги.
+     * @brief Вспомогательная функция для получения имени файла при операциях над файлами в случае, если файл уже существует.
      *
-     * Один или более, обязательно.
+     * Если файл не существует, то возвращается оригинальное имя файла.
+     * @param fileName Первоначальное имя файла.
+     * @return Итоговое имя файла.
      *
      * @~english
-     * @brief Book author.
+     * @brief Helper function for the getting new file name in the file operation if the file already exists.
      *
-     * One or more, required.
+     * If the file does not exist, it returns the original file name.
+     * @param fileName The original file name.
+     * @return The final name of the file.
      */
-    QVector<Person> BookAuthor;
+    static QString getNewName(QString fileName);
 
     /**
      * @~russian
-     * @brief Список жанров файла.
+     * @brief Получение ключа версии файла для дисковых кешей.
      *
-     * @~english
-     * @brief Genres list of the file.
-     */
-    genre_t Genres;
-
-    /**
-     * @~russian
-     * @brief Список серий файла.
+     * Ключ меняется при изменении файла, поэтому устаревшие записи кешей не используются.
+     * @param fileName Имя файла книги.
+     * @return Ключ из имени, размера и времени изменения файла.
      *
      * @~english
-     * @brief Series list of the file.
-     */
-    sequence_t Sequences;
-
-    /**
-     * @~russian
-     * @brief Кодировка файла.
+     * @brief Getting the file version key for disk caches.
      *
-     * @~english
-     * @brief Encoding of the file.
+     * The key changes when the file is modified, so outdated cache entries are not used.
+     * @param fileName Book file name.
+     * @return Key of file name, size and modification time.
      */
-    QString encoding;
-
-    /**
-     * @~russian
-     * @brief Состояние пометки записи.
-     *
-     * @~english
-     * @brief The status of record selection.
-     */
-    bool selected;
+    static QString getVersionKey(const QString &fileName);
 
+private:
     /**
      * @~russian
-     * @brief Вспомогательная функция для получения имени файла при операциях над файлами в случае, если файл уже существует.
-     *
-     * Если файл не существует, то возвращается оригинальное имя файла.
-     * @param fileName Первоначальное имя файла.
-     * @return Итоговое имя файла.
+     * @brief Разделяемые данные записи.
      *
      * @~english
-     * @brief Helper function for the getting new file name in the file operation if the file already exists.
-     *
-     * If the file does not exist, it returns the original file name.
-     * @param fileName The original file name.
-     * @return The final name of the file.
+     * @brief Shared data of the record.
      */
-    QString getNewName(QString fileName);
+    QSharedDataPointer<FileRecordData> d;
 
     /**
      * @~russian
@@ -576,4 +720,7 @@ private:
 
 };
 
+// The record holds only a pointer to the shared data, so containers may relocate it by memcpy
+Q_DECLARE_SHARED(FileRecord)
+
 #endif // FILERECORD_H
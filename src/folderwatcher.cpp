@@ -0,0 +1,189 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для наблюдения за папкой.
+ *
+ * @~english
+ * @brief Source file for folder watching.
+ */
+
+#include "folderwatcher.h"
+#include "filereader.h"
+
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QFileInfo>
+
+const int debounceInterval = 500; // Milliseconds. Tools dropping files usually make a burst of events
+
+FolderWatcher::FolderWatcher(const QString &dir, bool recursive, QObject *parent) :
+    QObject(parent)
+{
+    // Deleted files cannot be canonicalized, so all paths are built from the canonical folder
+    directory = QFileInfo(dir).canonicalFilePath();
+    this->recursive = recursive;
+
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, SIGNAL(directoryChanged(QString)), this, SLOT(onDirectoryChanged(QString)));
+
+    tmrDebounce = new QTimer(this);
+    tmrDebounce->setSingleShot(true);
+    tmrDebounce->setInterval(debounceInterval);
+    connect(tmrDebounce, SIGNAL(timeout()), this, SLOT(onProcessChanges()));
+
+    reader = 0;
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    delete reader;
+    delete tmrDebounce;
+    delete watcher;
+}
+
+QString FolderWatcher::getDirectory() const
+{
+    return directory;
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &path)
+{
+    changedDirs.insert(path);
+
+    // The delay counts from the first pending event, so a long copy is processed in batches during the burst
+    if (!tmrDebounce->isActive())
+        tmrDebounce->start();
+}
+
+void FolderWatcher::onProcessChanges()
+{
+    // Changes are read one batch at a time, so the snapshot given to the reader is always up to date
+    if (reader != 0)
+        return;
+
+    QStringList dirs;
+    QStringList deleted;
+    QSet<QString>::const_iterator it;
+
+    for (it = changedDirs.constBegin(); it != changedDirs.constEnd(); ++it)
+    {
+        if (!snapshot.contains(*it))
+            continue;
+
+        if (QFileInfo(*it).isDir())
+            dirs.append(*it);
+        else
+            removeDirectory(*it, deleted);
+    }
+
+    changedDirs.clear();
+
+    if (!deleted.isEmpty())
+    {
+        emit RemoveFiles(deleted);
+    }
+
+    if (!dirs.isEmpty())
+    {
+        reader = new FileReader(snapshot, dirs, recursive);
+        connect(reader, SIGNAL(Snapshot(snapshot_t)), this, SLOT(onSnapshot(snapshot_t)));
+        connect(reader, SIGNAL(AppendRecord(FileRecord)), this, SIGNAL(UpdateRecord(FileRecord)));
+        connect(reader, SIGNAL(EventMessage(QString)), this, SIGNAL(EventMessage(QString)));
+        connect(reader, SIGNAL(ErrorMessage(QString)), this, SIGNAL(ErrorMessage(QString)));
+        connect(reader, SIGNAL(finished()), this, SLOT(onReaderFinished()));
+        reader->start();
+    }
+}
+
+void FolderWatcher::onReaderFinished()
+{
+    reader->deleteLater();
+    reader = 0;
+
+    if (!changedDirs.isEmpty())
+        tmrDebounce->start();
+}
+
+void FolderWatcher::onSnapshot(const snapshot_t &listed)
+{
+    QStringList added;
+    QStringList deleted;
+    snapshot_t::const_iterator dir;
+
+    for (dir = listed.constBegin(); dir != listed.constEnd(); ++dir)
+    {
+        snapshot_t::iterator previous = snapshot.find(dir.key());
+
+        if (previous == snapshot.end())
+        {
+            snapshot.insert(dir.key(), dir.value());
+            added.append(dir.key());
+            continue;
+        }
+
+        QHash<QString, filestate_t>::const_iterator it;
+
+        for (it = previous.value().constBegin(); it != previous.value().constEnd(); ++it)
+        {
+            if (!dir.value().contains(it.key()))
+            {
+                deleted.append(it.key());
+            }
+        }
+
+        previous.value() = dir.value();
+    }
+
+    if (!added.isEmpty())
+    {
+        watcher->addPaths(added);
+    }
+
+    if (!deleted.isEmpty())
+    {
+        emit RemoveFiles(deleted);
+    }
+}
+
+void FolderWatcher::removeDirectory(const QString &path, QStringList &deleted)
+{
+    QString prefix = path + "/";
+    QStringList dirs;
+    snapshot_t::const_iterator it;
+
+    for (it = snapshot.constBegin(); it != snapshot.constEnd(); ++it)
+    {
+        if ((it.key() == path) || (it.key().startsWith(prefix)))
+        {
+            dirs.append(it.key());
+        }
+    }
+
+    QStringList::const_iterator dir;
+
+    for (dir = dirs.constBegin(); dir != dirs.constEnd(); ++dir)
+    {
+        deleted.append(snapshot.value(*dir).keys());
+        snapshot.remove(*dir);
+        watcher->removePath(*dir);
+    }
+}
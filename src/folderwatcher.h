@@ -0,0 +1,285 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль наблюдения за папкой.
+ *
+ * @~english
+ * @brief Module of folder watching.
+ */
+
+#include "filerecord.h"
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+
+// Forward class declarations
+class QFileSystemWatcher;
+class QTimer;
+class FileReader;
+
+/**
+ * @~russian
+ * @brief Наблюдатель за папкой с книгами.
+ *
+ * Наблюдает за изменениями в папке (и ее подпапках) средствами операционной системы (inotify в Linux).
+ * Снимок содержимого строится потоком чтения при перечислении файлов. События накапливаются в течение
+ * короткого интервала, после чего поток чтения сравнивает со снимком только изменившиеся папки.
+ * Разбираются только созданные и измененные файлы, для удаленных файлов отсылается сигнал удаления записей.
+ *
+ * @~english
+ * @brief Watcher of the folder with books.
+ *
+ * Watches for changes in the folder (and its subfolders) by means of the operating system (inotify on Linux).
+ * The contents snapshot is built by the reading thread while listing files. Events are accumulated during
+ * a short interval, after that the reading thread compares only the changed folders with the snapshot.
+ * Only created and modified files are parsed, for deleted files a signal of record removal is sent.
+ */
+class FolderWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор наблюдателя.
+     *
+     * Наблюдение начинается после получения снимка содержимого папки слотом onSnapshot().
+     * @param dir Наблюдаемая папка.
+     * @param recursive Наблюдать ли за подпапками.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor of the watcher.
+     *
+     * Watching starts after the snapshot of the folder contents is received by onSnapshot() slot.
+     * @param dir Watched folder.
+     * @param recursive Whether to watch subfolders.
+     * @param parent Parent object.
+     */
+    FolderWatcher(const QString &dir, bool recursive, QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор наблюдателя.
+     *
+     * @~english
+     * @brief Destructor of the watcher.
+     */
+    virtual ~FolderWatcher();
+
+    /**
+     * @~russian
+     * @brief Получение наблюдаемой папки.
+     * @return Наблюдаемая папка.
+     *
+     * @~english
+     * @brief Getting the watched folder.
+     * @return Watched folder.
+     */
+    QString getDirectory() const;
+
+signals:
+    /**
+     * @~russian
+     * @brief Отсылка сообщения в журнал сообщений.
+     * @param msg Текст сообщения.
+     *
+     * @~english
+     * @brief Sending messages to the message log.
+     * @param msg Message text.
+     */
+    void EventMessage(const QString &msg);
+
+    /**
+     * @~russian
+     * @brief Отсылка сообщения об ошибке в журнал сообщений.
+     * @param msg Текст сообщения.
+     *
+     * @~english
+     * @brief Sending error messages to the message log.
+     * @param msg Message text.
+     */
+    void ErrorMessage(const QString &msg);
+
+    /**
+     * @~russian
+     * @brief Добавление новой или обновление существующей записи в модели данных.
+     * @param record Запись созданного или измененного файла.
+     *
+     * @~english
+     * @brief Append new or update existing record in data model.
+     * @param record Record of created or modified file.
+     */
+    void UpdateRecord(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Удаление записей удаленных файлов из модели данных.
+     * @param files Список имен удаленных файлов.
+     *
+     * @~english
+     * @brief Remove records of deleted files from data model.
+     * @param files List of deleted file names.
+     */
+    void RemoveFiles(const QStringList &files);
+
+public slots:
+    /**
+     * @~russian
+     * @brief Обработчик снимка содержимого папок, построенного потоком чтения.
+     *
+     * Новые папки берутся под наблюдение, для файлов, отсутствующих в новом снимке папки, отсылается
+     * сигнал удаления записей. Уже существующие файлы сигналов не вызывают.
+     * @param listed Снимок перечисленных папок.
+     *
+     * @~english
+     * @brief Handler of the folders contents snapshot built by the reading thread.
+     *
+     * New folders are taken under watching, for files missing in the new snapshot of the folder a signal
+     * of record removal is sent. Already existing files do not raise signals.
+     * @param listed Snapshot of the listed folders.
+     */
+    void onSnapshot(const snapshot_t &listed);
+
+private slots:
+    /**
+     * @~russian
+     * @brief Обработчик изменения содержимого папки.
+     * @param path Изменившаяся папка.
+     *
+     * @~english
+     * @brief Handler of folder contents change.
+     * @param path Changed folder.
+     */
+    void onDirectoryChanged(const QString &path);
+
+    /**
+     * @~russian
+     * @brief Обработка накопленных изменений.
+     *
+     * @~english
+     * @brief Processing of accumulated changes.
+     */
+    void onProcessChanges();
+
+    /**
+     * @~russian
+     * @brief Обработчик завершения потока чтения изменений.
+     *
+     * @~english
+     * @brief Handler of finishing the thread reading changes.
+     */
+    void onReaderFinished();
+
+private:
+    /**
+     * @~russian
+     * @brief Наблюдаемая папка.
+     *
+     * @~english
+     * @brief Watched folder.
+     */
+    QString directory;
+
+    /**
+     * @~russian
+     * @brief Наблюдать ли за подпапками.
+     *
+     * @~english
+     * @brief Whether to watch subfolders.
+     */
+    bool recursive;
+
+    /**
+     * @~russian
+     * @brief Системный наблюдатель за файловой системой.
+     *
+     * @~english
+     * @brief System file system watcher.
+     */
+    QFileSystemWatcher *watcher;
+
+    /**
+     * @~russian
+     * @brief Таймер накопления событий.
+     *
+     * Запускается первым событием после обработки и не перезапускается следующими, поэтому обработка
+     * не откладывается дольше интервала.
+     *
+     * @~english
+     * @brief Timer of events accumulation.
+     *
+     * Started by the first event after processing and not restarted by the next ones, so processing is not
+     * delayed longer than the interval.
+     */
+    QTimer *tmrDebounce;
+
+    /**
+     * @~russian
+     * @brief Папки, изменившиеся с момента последней обработки.
+     *
+     * @~english
+     * @brief Folders changed since the last processing.
+     */
+    QSet<QString> changedDirs;
+
+    /**
+     * @~russian
+     * @brief Поток чтения изменений, 0 - если не выполняется.
+     *
+     * Изменения, накопленные во время его работы, обрабатываются после его завершения.
+     *
+     * @~english
+     * @brief Thread reading changes, 0 if not running.
+     *
+     * Changes accumulated while it runs are processed after it finishes.
+     */
+    FileReader *reader;
+
+    /**
+     * @~russian
+     * @brief Снимок содержимого наблюдаемых папок: папка -> (файл -> состояние).
+     *
+     * @~english
+     * @brief Snapshot of watched folders contents: folder -> (file -> state).
+     */
+    snapshot_t snapshot;
+
+    /**
+     * @~russian
+     * @brief Удаление папки (и ее подпапок) из наблюдения.
+     * @param path Удаляемая папка.
+     * @param deleted Список, в который добавляются файлы удаленной папки.
+     *
+     * @~english
+     * @brief Removing the folder (and its subfolders) from watching.
+     * @param path Removed folder.
+     * @param deleted List to which files of the removed folder are added.
+     */
+    void removeDirectory(const QString &path, QStringList &deleted);
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,529 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации справочника жанров FB2.
+ *
+ * @~english
+ * @brief Source file for FB2 genre registry.
+ */
+
+#include "genreregistry.h"
+
+#include <QLocale>
+
+namespace
+{
+
+struct GenreCategoryEntry
+{
+    const char *key;
+    const char *nameRu;
+    const char *nameEn;
+};
+
+struct GenreEntry
+{
+    const char *code;
+    int category;
+    const char *nameRu;
+    const char *nameEn;
+};
+
+// Categories of the genre hierarchy, index is the category number
+const GenreCategoryEntry categoryTable[] =
+{
+    {"sf", "Фантастика", "Science fiction"},
+    {"det", "Детективы и триллеры", "Detectives and thrillers"},
+    {"prose", "Проза", "Prose"},
+    {"love", "Любовные романы", "Romance"},
+    {"adv", "Приключения", "Adventure"},
+    {"child", "Детское", "Children's"},
+    {"poetry", "Поэзия и драматургия", "Poetry and dramaturgy"},
+    {"antique", "Старинное", "Antique"},
+    {"sci", "Наука, образование", "Science, education"},
+    {"comp", "Компьютеры и интернет", "Computers and internet"},
+    {"ref", "Справочная литература", "Reference"},
+    {"nonf", "Документальная литература", "Nonfiction"},
+    {"religion", "Религия и духовность", "Religion and spirituality"},
+    {"humor", "Юмор", "Humor"},
+    {"home", "Домоводство", "Home and family"},
+    {"business", "Деловая литература", "Business"},
+    {"military", "Военное дело", "Military"},
+    {"other", "Прочее", "Other"}
+};
+
+// Standard FB2 genres grouped by category, index is the genre identifier
+constexpr GenreEntry genreTable[] =
+{
+    {"sf", 0, "Научная фантастика", "Science fiction"},
+    {"sf_history", 0, "Альтернативная история", "Alternative history"},
+    {"sf_action", 0, "Боевая фантастика", "Action science fiction"},
+    {"sf_epic", 0, "Эпическая фантастика", "Epic science fiction"},
+    {"sf_heroic", 0, "Героическая фантастика", "Heroic science fiction"},
+    {"sf_detective", 0, "Детективная фантастика", "Detective science fiction"},
+    {"sf_cyberpunk", 0, "Киберпанк", "Cyberpunk"},
+    {"sf_space", 0, "Космическая фантастика", "Space science fiction"},
+    {"sf_social", 0, "Социально-психологическая фантастика", "Social-philosophical science fiction"},
+    {"sf_horror", 0, "Ужасы и мистика", "Horror and mystic"},
+    {"sf_humor", 0, "Юмористическая фантастика", "Humorous science fiction"},
+    {"sf_fantasy", 0, "Фэнтези", "Fantasy"},
+    {"sf_fantasy_city", 0, "Городское фэнтези", "Urban fantasy"},
+    {"sf_mystic", 0, "Мистика", "Mystic"},
+    {"sf_postapocalyptic", 0, "Постапокалипсис", "Post-apocalyptic"},
+    {"sf_stimpank", 0, "Стимпанк", "Steampunk"},
+    {"sf_technofantasy", 0, "Технофэнтези", "Technofantasy"},
+    {"sf_litrpg", 0, "ЛитРПГ", "LitRPG"},
+    {"sf_etc", 0, "Фантастика: прочее", "Other science fiction"},
+    {"popadanec", 0, "Попаданцы", "Time travelers"},
+    {"hronoopera", 0, "Хроноопера", "Chrono opera"},
+
+    {"detective", 1, "Детективы", "Detectives"},
+    {"det_classic", 1, "Классический детектив", "Classical detective"},
+    {"det_police", 1, "Полицейский детектив", "Police stories"},
+    {"det_action", 1, "Боевик", "Action"},
+    {"det_irony", 1, "Иронический детектив", "Ironical detective"},
+    {"det_history", 1, "Исторический детектив", "Historical detective"},
+    {"det_espionage", 1, "Шпионский детектив", "Espionage detective"},
+    {"det_crime", 1, "Криминальный детектив", "Crime detective"},
+    {"det_political", 1, "Политический детектив", "Political detective"},
+    {"det_maniac", 1, "Маньяки", "Maniacs"},
+    {"det_hard", 1, "Крутой детектив", "Hard-boiled"},
+    {"det_cozy", 1, "Уютный детектив", "Cozy mystery"},
+    {"det_su", 1, "Советский детектив", "Soviet detective"},
+    {"thriller", 1, "Триллер", "Thriller"},
+
+    {"prose_classic", 2, "Классическая проза", "Classical prose"},
+    {"prose_history", 2, "Историческая проза", "Historical prose"},
+    {"prose_contemporary", 2, "Современная проза", "Contemporary prose"},
+    {"prose_counter", 2, "Контркультура", "Counterculture"},
+    {"prose_rus_classic", 2, "Русская классическая проза", "Russian classical prose"},
+    {"prose_su_classics", 2, "Советская классическая проза", "Soviet classical prose"},
+    {"prose_military", 2, "Проза о войне", "Military prose"},
+    {"prose_magic", 2, "Магический реализм", "Magical realism"},
+    {"prose_abs", 2, "Фантасмагория, абсурдистская проза", "Absurdist prose"},
+    {"prose_neformatny", 2, "Неформатная проза", "Experimental prose"},
+    {"prose_epic", 2, "Эпопея", "Epic"},
+    {"prose", 2, "Проза", "Prose"},
+    {"aphorisms", 2, "Афоризмы", "Aphorisms"},
+    {"essay", 2, "Эссе", "Essay"},
+    {"story", 2, "Рассказ", "Story"},
+    {"great_story", 2, "Повесть", "Novella"},
+    {"short_story", 2, "Короткий рассказ", "Short story"},
+    {"epistolary_fiction", 2, "Эпистолярная проза", "Epistolary fiction"},
+    {"foreign_prose", 2, "Зарубежная проза", "Foreign prose"},
+
+    {"love", 3, "Любовные романы", "Romance"},
+    {"love_contemporary", 3, "Современные любовные романы", "Contemporary romance"},
+    {"love_history", 3, "Исторические любовные романы", "Historical romance"},
+    {"love_detective", 3, "Остросюжетные любовные романы", "Romantic suspense"},
+    {"love_short", 3, "Короткие любовные романы", "Short romance"},
+    {"love_erotica", 3, "Эротика", "Erotica"},
+    {"love_sf", 3, "Любовное фэнтези, любовно-фантастические романы", "Romantic fantasy"},
+
+    {"adventure", 4, "Приключения", "Adventure"},
+    {"adv_western", 4, "Вестерн", "Western"},
+    {"adv_history", 4, "Исторические приключения", "Historical adventure"},
+    {"adv_indian", 4, "Приключения про индейцев", "Indians"},
+    {"adv_maritime", 4, "Морские приключения", "Maritime fiction"},
+    {"adv_geo", 4, "Путешествия и география", "Travel and geography"},
+    {"adv_animal", 4, "Природа и животные", "Nature and animals"},
+    {"adv_modern", 4, "Приключения в современном мире", "Modern adventure"},
+    {"adv_story", 4, "Авантюрный роман", "Picaresque novel"},
+
+    {"children", 5, "Детская литература", "Children's literature"},
+    {"child_tale", 5, "Сказка", "Fairy tales"},
+    {"child_verse", 5, "Детские стихи", "Children's verses"},
+    {"child_prose", 5, "Детская проза", "Children's prose"},
+    {"child_sf", 5, "Детская фантастика", "Children's science fiction"},
+    {"child_det", 5, "Детские остросюжетные", "Children's action"},
+    {"child_adv", 5, "Детские приключения", "Children's adventures"},
+    {"child_education", 5, "Детская образовательная литература", "Children's education"},
+    {"child_classical", 5, "Классическая детская литература", "Classical children's literature"},
+    {"child_folklore", 5, "Детский фольклор", "Children's folklore"},
+
+    {"poetry", 6, "Поэзия", "Poetry"},
+    {"poetry_classical", 6, "Классическая поэзия", "Classical poetry"},
+    {"poetry_modern", 6, "Современная поэзия", "Modern poetry"},
+    {"poetry_for_classical", 6, "Классическая зарубежная поэзия", "Classical foreign poetry"},
+    {"poetry_rus_classical", 6, "Классическая русская поэзия", "Classical Russian poetry"},
+    {"lyrics", 6, "Лирика", "Lyrics"},
+    {"song_poetry", 6, "Песенная поэзия", "Song poetry"},
+    {"palindromes", 6, "Палиндромы", "Palindromes"},
+    {"dramaturgy", 6, "Драматургия", "Dramaturgy"},
+    {"drama", 6, "Драма", "Drama"},
+    {"comedy", 6, "Комедия", "Comedy"},
+    {"tragedy", 6, "Трагедия", "Tragedy"},
+    {"screenplays", 6, "Сценарии", "Screenplays"},
+
+    {"antique", 7, "Старинная литература", "Antique literature"},
+    {"antique_ant", 7, "Античная литература", "Antique"},
+    {"antique_european", 7, "Европейская старинная литература", "European antique literature"},
+    {"antique_russian", 7, "Древнерусская литература", "Old Russian literature"},
+    {"antique_east", 7, "Древневосточная литература", "Old Eastern literature"},
+    {"antique_myths", 7, "Мифы. Легенды. Эпос", "Myths. Legends. Epos"},
+    {"folklore", 7, "Фольклор", "Folklore"},
+    {"folk_tale", 7, "Народные сказки", "Folk tales"},
+    {"proverbs", 7, "Пословицы, поговорки", "Proverbs"},
+    {"epic", 7, "Былины", "Bylina"},
+
+    {"science", 8, "Научная литература", "Scientific literature"},
+    {"sci_history", 8, "История", "History"},
+    {"sci_psychology", 8, "Психология", "Psychology"},
+    {"sci_culture", 8, "Культурология", "Cultural science"},
+    {"sci_religion", 8, "Религиоведение", "Religious studies"},
+    {"sci_philosophy", 8, "Философия", "Philosophy"},
+    {"sci_politics", 8, "Политика", "Politics"},
+    {"sci_juris", 8, "Юриспруденция", "Jurisprudence"},
+    {"sci_linguistic", 8, "Языкознание", "Linguistics"},
+    {"sci_medicine", 8, "Медицина", "Medicine"},
+    {"sci_phys", 8, "Физика", "Physics"},
+    {"sci_math", 8, "Математика", "Mathematics"},
+    {"sci_chem", 8, "Химия", "Chemistry"},
+    {"sci_biology", 8, "Биология", "Biology"},
+    {"sci_tech", 8, "Технические науки", "Technical"},
+    {"sci_cosmos", 8, "Астрономия и космос", "Astronomy and space"},
+    {"sci_geo", 8, "Геология и география", "Geology and geography"},
+    {"sci_ecology", 8, "Экология", "Ecology"},
+    {"sci_economy", 8, "Экономика", "Economy"},
+    {"sci_pedagogy", 8, "Педагогика", "Pedagogy"},
+    {"sci_social_studies", 8, "Обществознание, социология", "Social studies"},
+    {"sci_zoo", 8, "Зоология", "Zoology"},
+    {"sci_botany", 8, "Ботаника", "Botany"},
+    {"sci_state", 8, "Государство и право", "State and law"},
+    {"sci_textbook", 8, "Учебники и пособия", "Textbooks"},
+    {"military_history", 8, "Военная история", "Military history"},
+
+    {"computers", 9, "Околокомпьютерная литература", "Computers"},
+    {"comp_www", 9, "Интернет", "Internet"},
+    {"comp_programming", 9, "Программирование", "Programming"},
+    {"comp_hard", 9, "Компьютерное железо", "Hardware"},
+    {"comp_soft", 9, "Программы", "Software"},
+    {"comp_db", 9, "Базы данных", "Databases"},
+    {"comp_osnet", 9, "ОС и сети", "OS and networking"},
+    {"comp_dsp", 9, "Цифровая обработка сигналов", "Digital signal processing"},
+
+    {"reference", 10, "Справочная литература", "Reference"},
+    {"ref_encyc", 10, "Энциклопедии", "Encyclopedias"},
+    {"ref_dict", 10, "Словари", "Dictionaries"},
+    {"ref_ref", 10, "Справочники", "Reference books"},
+    {"ref_guide", 10, "Руководства", "Guidebooks"},
+
+    {"nonfiction", 11, "Документальная литература", "Nonfiction"},
+    {"nonf_biography", 11, "Биографии и мемуары", "Biographies and memoirs"},
+    {"nonf_publicism", 11, "Публицистика", "Publicism"},
+    {"nonf_criticism", 11, "Критика", "Criticism"},
+    {"nonf_military", 11, "Военная документалистика и аналитика", "Military nonfiction"},
+    {"design", 11, "Искусство и дизайн", "Art and design"},
+    {"art_criticism", 11, "Искусствоведение", "Art criticism"},
+    {"architecture_book", 11, "Архитектура", "Architecture"},
+    {"music", 11, "Музыка", "Music"},
+    {"cine", 11, "Кино", "Cinema"},
+    {"theatre", 11, "Театр", "Theatre"},
+    {"travel_notes", 11, "Путевые заметки", "Travel notes"},
+
+    {"religion", 12, "Религиозная литература", "Religion"},
+    {"religion_rel", 12, "Религия", "Religion"},
+    {"religion_esoterics", 12, "Эзотерика", "Esoterics"},
+    {"religion_self", 12, "Самосовершенствование", "Self-improvement"},
+    {"religion_orthodoxy", 12, "Православие", "Orthodoxy"},
+    {"religion_catholicism", 12, "Католицизм", "Catholicism"},
+    {"religion_protestantism", 12, "Протестантизм", "Protestantism"},
+    {"religion_islam", 12, "Ислам", "Islam"},
+    {"religion_judaism", 12, "Иудаизм", "Judaism"},
+    {"religion_budda", 12, "Буддизм", "Buddhism"},
+    {"religion_hinduism", 12, "Индуизм", "Hinduism"},
+    {"religion_paganism", 12, "Язычество", "Paganism"},
+    {"astrology", 12, "Астрология", "Astrology"},
+    {"palmistry", 12, "Хиромантия", "Palmistry"},
+
+    {"humor", 13, "Юмор", "Humor"},
+    {"humor_anecdote", 13, "Анекдоты", "Anecdote"},
+    {"humor_prose", 13, "Юмористическая проза", "Humorous prose"},
+    {"humor_verse", 13, "Юмористические стихи", "Humorous verses"},
+    {"humor_satire", 13, "Сатира", "Satire"},
+
+    {"home", 14, "Домоводство", "Home and family"},
+    {"home_cooking", 14, "Кулинария", "Cooking"},
+    {"home_pets", 14, "Домашние животные", "Pets"},
+    {"home_crafts", 14, "Хобби и ремесла", "Hobbies and crafts"},
+    {"home_entertain", 14, "Развлечения", "Entertaining"},
+    {"home_health", 14, "Здоровье", "Health"},
+    {"home_garden", 14, "Сад и огород", "Garden"},
+    {"home_diy", 14, "Сделай сам", "Do it yourself"},
+    {"home_sport", 14, "Спорт", "Sports"},
+    {"home_sex", 14, "Эротика, секс", "Erotica, sex"},
+    {"home_collecting", 14, "Коллекционирование", "Collecting"},
+    {"family", 14, "Семейные отношения", "Family relations"},
+    {"auto_regulations", 14, "Автомобили и ПДД", "Cars and traffic rules"},
+
+    {"sci_business", 15, "Деловая литература", "Business"},
+    {"economics", 15, "Экономика", "Economics"},
+    {"popular_business", 15, "Карьера, кадры", "Careers"},
+    {"org_behavior", 15, "Корпоративная культура", "Corporate culture"},
+    {"marketing", 15, "Маркетинг, PR, реклама", "Marketing, PR, advertising"},
+    {"management", 15, "Управление, подбор персонала", "Management"},
+    {"personal_finance", 15, "Личные финансы", "Personal finance"},
+    {"real_estate", 15, "Недвижимость", "Real estate"},
+    {"banking", 15, "Финансы", "Finance"},
+    {"accounting", 15, "Бухучет, налогообложение, аудит", "Accounting"},
+    {"small_business", 15, "Малый бизнес", "Small business"},
+    {"stock", 15, "Ценные бумаги, инвестиции", "Securities and investments"},
+    {"trade", 15, "Торговля", "Trade"},
+    {"industries", 15, "Отраслевые издания", "Industries"},
+    {"paper_work", 15, "Делопроизводство", "Paperwork"},
+
+    {"military_weapon", 16, "Военная техника и вооружение", "Military weapons"},
+    {"military_special", 16, "Военное дело", "Military science"},
+    {"military_arts", 16, "Боевые искусства", "Martial arts"},
+
+    {"other", 17, "Неотсортированное", "Unsorted"},
+    {"periodic", 17, "Журналы, газеты", "Periodicals"},
+    {"comics", 17, "Комиксы", "Comics"},
+    {"notes", 17, "Партитуры", "Sheet music"},
+    {"unfinished", 17, "Недописанное", "Unfinished"}
+};
+
+constexpr int genreCount = sizeof(genreTable) / sizeof(genreTable[0]);
+constexpr int categoryCount = sizeof(categoryTable) / sizeof(categoryTable[0]);
+
+/*
+ * Perfect hash by "hash and displace": the code hash selects a bucket, the displacement of the bucket
+ * selects the seed of the second hash, which gives a free slot for each code of the bucket.
+ */
+constexpr int bucketCount = 64;
+constexpr int slotCount = 256; // Power of two larger than the number of genres
+constexpr quint16 emptySlot = 0xFFFF;
+constexpr quint32 fnvBasis = 2166136261u;
+constexpr quint32 fnvPrime = 16777619u;
+
+static_assert(genreCount < slotCount, "Slot table is too small for the genre registry");
+
+struct PerfectHash
+{
+    quint16 displacement[bucketCount];
+    quint16 slots[slotCount];
+    bool valid;
+};
+
+constexpr quint32 hashCode(const char *code)
+{
+    quint32 hash = fnvBasis;
+
+    for (; *code; ++code)
+        hash = (hash ^ static_cast<uchar>(*code)) * fnvPrime;
+
+    return hash;
+}
+
+constexpr quint32 mixHash(quint32 hash)
+{
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+    hash *= 0xC2B2AE35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+constexpr int bucketOf(quint32 hash)
+{
+    return static_cast<int>(mixHash(hash) % bucketCount);
+}
+
+constexpr int slotOf(quint32 hash, quint32 displacement)
+{
+    return static_cast<int>(mixHash(hash ^ ((displacement + 1) * 0x9E3779B9u)) & (slotCount - 1));
+}
+
+constexpr PerfectHash buildHash()
+{
+    PerfectHash result = {};
+    quint32 hashes[genreCount] = {};
+    int sizes[bucketCount] = {};
+    int order[bucketCount] = {};
+
+    for (int i = 0; i < slotCount; ++i)
+        result.slots[i] = emptySlot;
+
+    for (int i = 0; i < genreCount; ++i)
+    {
+        hashes[i] = hashCode(genreTable[i].code);
+        ++sizes[bucketOf(hashes[i])];
+    }
+
+    // Largest buckets are placed first while the table is still empty
+    for (int i = 0; i < bucketCount; ++i)
+        order[i] = i;
+
+    for (int i = 0; i < bucketCount; ++i)
+    {
+        for (int j = i + 1; j < bucketCount; ++j)
+        {
+            if (sizes[order[j]] > sizes[order[i]])
+            {
+                int tmp = order[i];
+                order[i] = order[j];
+                order[j] = tmp;
+            }
+        }
+    }
+
+    for (int i = 0; i < bucketCount; ++i)
+    {
+        int bucket = order[i];
+
+        if (sizes[bucket] == 0)
+            continue;
+
+        bool placed = false;
+
+        for (quint32 displacement = 0; (displacement < 0xFFFF) && (!placed); ++displacement)
+        {
+            placed = true;
+
+            for (int j = 0; j < genreCount; ++j)
+            {
+                if (bucketOf(hashes[j]) != bucket)
+                    continue;
+
+                int slot = slotOf(hashes[j], displacement);
+
+                if (result.slots[slot] != emptySlot)
+                {
+                    placed = false;
+                    break;
+                }
+
+                result.slots[slot] = static_cast<quint16>(j);
+            }
+
+            if (!placed)
+            {
+                // Roll back the codes of this bucket placed with the rejected displacement
+                for (int slot = 0; slot < slotCount; ++slot)
+                {
+                    if ((result.slots[slot] != emptySlot) && (bucketOf(hashes[result.slots[slot]]) == bucket))
+                        result.slots[slot] = emptySlot;
+                }
+            }
+            else
+                result.displacement[bucket] = static_cast<quint16>(displacement);
+        }
+
+        if (!placed)
+            return result;
+    }
+
+    result.valid = true;
+    return result;
+}
+
+constexpr PerfectHash genreHash = buildHash();
+
+constexpr bool isHashComplete()
+{
+    for (int i = 0; i < genreCount; ++i)
+    {
+        quint32 hash = hashCode(genreTable[i].code);
+
+        if (genreHash.slots[slotOf(hash, genreHash.displacement[bucketOf(hash)])] != i)
+            return false;
+    }
+
+    return genreHash.valid;
+}
+
+static_assert(isHashComplete(), "Perfect hash of the genre registry cannot be built, change the seeds");
+
+bool isRussian()
+{
+    static const bool russian = (QLocale().language() == QLocale::Russian);
+    return russian;
+}
+
+}
+
+quint16 GenreRegistry::find(const QString &code)
+{
+    QString trimmed = code.trimmed();
+    quint32 hash = fnvBasis;
+
+    for (int i = 0; i < trimmed.size(); ++i)
+    {
+        ushort ch = trimmed.at(i).unicode();
+
+        // Codes are ASCII, anything else cannot be a standard genre
+        if ((ch == 0) || (ch > 127))
+            return unknownGenre;
+
+        hash = (hash ^ ch) * fnvPrime;
+    }
+
+    quint16 id = genreHash.slots[slotOf(hash, genreHash.displacement[bucketOf(hash)])];
+
+    if ((id == emptySlot) || (trimmed != QLatin1String(genreTable[id].code)))
+        return unknownGenre;
+
+    return id;
+}
+
+int GenreRegistry::getCount()
+{
+    return genreCount;
+}
+
+QString GenreRegistry::getCode(quint16 id)
+{
+    if (id >= genreCount)
+        return QString();
+
+    return QLatin1String(genreTable[id].code);
+}
+
+QString GenreRegistry::getName(quint16 id)
+{
+    if (id >= genreCount)
+        return QString();
+
+    return QString::fromUtf8(isRussian() ? genreTable[id].nameRu : genreTable[id].nameEn);
+}
+
+int GenreRegistry::getCategory(quint16 id)
+{
+    if (id >= genreCount)
+        return -1;
+
+    return genreTable[id].category;
+}
+
+int GenreRegistry::getCategoryCount()
+{
+    return categoryCount;
+}
+
+QString GenreRegistry::getCategoryName(int category)
+{
+    if ((category < 0) || (category >= categoryCount))
+        return QString();
+
+    return QString::fromUtf8(isRussian() ? categoryTable[category].nameRu : categoryTable[category].nameEn);
+}
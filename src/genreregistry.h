@@ -0,0 +1,149 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef GENREREGISTRY_H
+#define GENREREGISTRY_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль справочника жанров FB2.
+ *
+ * @~english
+ * @brief Module of FB2 genre registry.
+ */
+
+#include <QString>
+
+/**
+ * @~russian
+ * @brief Встроенный справочник стандартных жанров FB2.
+ *
+ * Около двухсот кодов жанров с русскими и английскими названиями сгруппированы по категориям.
+ * Идентификатор жанра - его номер в справочнике, он помещается в 16 бит. Поиск кода выполняется за O(1)
+ * по совершенной хеш-функции, таблица которой строится при компиляции.
+ *
+ * @~english
+ * @brief Built-in registry of standard FB2 genres.
+ *
+ * About two hundred genre codes with Russian and English names are grouped by categories.
+ * The genre identifier is its number in the registry, it fits in 16 bits. Code lookup is O(1)
+ * by the perfect hash function, whose table is built at compile time.
+ */
+class GenreRegistry
+{
+public:
+    /**
+     * @~russian
+     * @brief Идентификатор неизвестного жанра.
+     *
+     * @~english
+     * @brief Identifier of unknown genre.
+     */
+    static const quint16 unknownGenre = 0xFFFF;
+
+    /**
+     * @~russian
+     * @brief Поиск жанра по коду.
+     * @param code Код жанра из файла, пробелы по краям игнорируются.
+     * @return Идентификатор жанра или unknownGenre.
+     *
+     * @~english
+     * @brief Looking up the genre by code.
+     * @param code Genre code from the file, surrounding spaces are ignored.
+     * @return Genre identifier or unknownGenre.
+     */
+    static quint16 find(const QString &code);
+
+    /**
+     * @~russian
+     * @brief Получение количества жанров в справочнике.
+     * @return Количество жанров.
+     *
+     * @~english
+     * @brief Getting the number of genres in the registry.
+     * @return Number of genres.
+     */
+    static int getCount();
+
+    /**
+     * @~russian
+     * @brief Получение кода жанра.
+     * @param id Идентификатор жанра.
+     * @return Код жанра или пустая строка для неизвестного жанра.
+     *
+     * @~english
+     * @brief Getting the genre code.
+     * @param id Genre identifier.
+     * @return Genre code or empty string for unknown genre.
+     */
+    static QString getCode(quint16 id);
+
+    /**
+     * @~russian
+     * @brief Получение названия жанра на языке системы.
+     * @param id Идентификатор жанра.
+     * @return Название жанра или пустая строка для неизвестного жанра.
+     *
+     * @~english
+     * @brief Getting the genre name in the system language.
+     * @param id Genre identifier.
+     * @return Genre name or empty string for unknown genre.
+     */
+    static QString getName(quint16 id);
+
+    /**
+     * @~russian
+     * @brief Получение категории жанра.
+     * @param id Идентификатор жанра.
+     * @return Номер категории или -1 для неизвестного жанра.
+     *
+     * @~english
+     * @brief Getting the genre category.
+     * @param id Genre identifier.
+     * @return Category number or -1 for unknown genre.
+     */
+    static int getCategory(quint16 id);
+
+    /**
+     * @~russian
+     * @brief Получение количества категорий.
+     * @return Количество категорий.
+     *
+     * @~english
+     * @brief Getting the number of categories.
+     * @return Number of categories.
+     */
+    static int getCategoryCount();
+
+    /**
+     * @~russian
+     * @brief Получение названия категории на языке системы.
+     * @param category Номер категории.
+     * @return Название категории.
+     *
+     * @~english
+     * @brief Getting the category name in the system language.
+     * @param category Category number.
+     * @return Category name.
+     */
+    static QString getCategoryName(int category);
+};
+
+#endif // GENREREGISTRY_H
@@ -0,0 +1,160 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации исправления похожих букв кириллицы и латиницы.
+ *
+ * @~english
+ * @brief Source file for fixing look-alike Cyrillic and Latin letters.
+ */
+
+#include "homoglyphfixer.h"
+#include "recordvalidator.h"
+
+#include <string.h>
+
+/*
+ * Latin letters and Cyrillic letters of the same shape.
+ */
+static const struct
+{
+    char latin;
+    ushort cyrillic;
+} homoglyphs[] =
+{
+    {'A', 0x0410},
+    {'B', 0x0412},
+    {'C', 0x0421},
+    {'E', 0x0415},
+    {'H', 0x041D},
+    {'K', 0x041A},
+    {'M', 0x041C},
+    {'O', 0x041E},
+    {'P', 0x0420},
+    {'T', 0x0422},
+    {'X', 0x0425},
+    {'Y', 0x0423},
+    {'a', 0x0430},
+    {'c', 0x0441},
+    {'e', 0x0435},
+    {'o', 0x043E},
+    {'p', 0x0440},
+    {'x', 0x0445},
+    {'y', 0x0443}
+};
+
+/*
+ * Lookup tables in both directions, zero means no look-alike letter.
+ */
+struct HomoglyphTables
+{
+    ushort toCyrillic[128]; // Indexed by the Latin letter
+    ushort toLatin[256]; // Indexed by the Cyrillic letter minus 0x0400
+
+    HomoglyphTables()
+    {
+        memset(toCyrillic, 0, sizeof(toCyrillic));
+        memset(toLatin, 0, sizeof(toLatin));
+
+        for (size_t i = 0; i < sizeof(homoglyphs) / sizeof(homoglyphs[0]); ++i)
+        {
+            toCyrillic[static_cast<int>(homoglyphs[i].latin)] = homoglyphs[i].cyrillic;
+            toLatin[homoglyphs[i].cyrillic - 0x0400] = homoglyphs[i].latin;
+        }
+    }
+};
+
+static const HomoglyphTables &tables()
+{
+    static const HomoglyphTables instance;
+    return instance;
+}
+
+static inline bool isCyrillic(ushort ch)
+{
+    return (ch & 0xFF00) == 0x0400;
+}
+
+static inline bool isLatin(ushort ch)
+{
+    ushort lower = ch | 0x20;
+    return (lower >= 'a') && (lower <= 'z');
+}
+
+/*
+ * Replacing letters of the minority alphabet in the word [begin, end).
+ */
+static void fixWord(ushort *chars, int begin, int end, int cyrillic, int latin)
+{
+    const HomoglyphTables &table = tables();
+
+    for (int i = begin; i < end; ++i)
+    {
+        ushort ch = chars[i];
+        ushort replacement = 0;
+
+        if ((cyrillic > latin) && isLatin(ch))
+            replacement = table.toCyrillic[ch];
+        else
+            if ((latin > cyrillic) && isCyrillic(ch))
+                replacement = table.toLatin[ch - 0x0400];
+
+        if (replacement != 0)
+            chars[i] = replacement;
+    }
+}
+
+QString HomoglyphFixer::fix(const QString &text)
+{
+    if (!RecordValidator::hasMixedWords(text))
+        return text;
+
+    QString result = text;
+    ushort *chars = reinterpret_cast<ushort *>(result.data());
+    int size = result.size();
+    int begin = 0;
+    int cyrillic = 0;
+    int latin = 0;
+
+    // The extra iteration past the end closes the last word
+    for (int i = 0; i <= size; ++i)
+    {
+        ushort ch = (i < size) ? chars[i] : ' ';
+
+        if (isCyrillic(ch))
+            cyrillic++;
+        else
+            if (isLatin(ch))
+                latin++;
+            else
+                if (!QChar(ch).isLetterOrNumber())
+                {
+                    if ((cyrillic > 0) && (latin > 0))
+                        fixWord(chars, begin, i, cyrillic, latin);
+
+                    begin = i + 1;
+                    cyrillic = 0;
+                    latin = 0;
+                }
+    }
+
+    return result;
+}
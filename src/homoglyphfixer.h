@@ -0,0 +1,70 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef HOMOGLYPHFIXER_H
+#define HOMOGLYPHFIXER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль исправления похожих букв кириллицы и латиницы.
+ *
+ * @~english
+ * @brief Module of fixing look-alike Cyrillic and Latin letters.
+ */
+
+#include <QString>
+
+/**
+ * @~russian
+ * @brief Замена похожих букв другого алфавита внутри слова.
+ *
+ * Для каждого слова, в котором смешаны кириллица и латиница, определяется преобладающий алфавит, и буквы
+ * другого алфавита, имеющие похожее начертание (например, латинские «a», «e», «o», «c»), заменяются
+ * парными буквами преобладающего. При равном количестве букв слово не изменяется.@n
+ * Строки без смешанных слов отбрасываются быстрой проверкой RecordValidator::hasMixedWords() и возвращаются
+ * без копирования, поэтому исправление большого количества записей почти ничего не стоит.
+ *
+ * @~english
+ * @brief Replacing look-alike letters of another alphabet inside a word.
+ *
+ * For each word with mixed Cyrillic and Latin letters the dominant alphabet is determined, and letters
+ * of the other alphabet having a similar shape (for example, Latin "a", "e", "o", "c") are replaced by
+ * the paired letters of the dominant one. The word is not changed when the letter counts are equal.@n
+ * Strings without mixed words are rejected by the fast RecordValidator::hasMixedWords() check and returned
+ * without copying, so fixing a large number of records costs almost nothing.
+ */
+class HomoglyphFixer
+{
+public:
+    /**
+     * @~russian
+     * @brief Исправление строки.
+     * @param text Исходная строка.
+     * @return Исправленная строка или исходная, если исправлять нечего.
+     *
+     * @~english
+     * @brief Fixing the string.
+     * @param text Original string.
+     * @return Fixed string or the original one if there is nothing to fix.
+     */
+    static QString fix(const QString &text);
+};
+
+#endif // HOMOGLYPHFIXER_H
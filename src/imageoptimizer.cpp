@@ -0,0 +1,168 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации пережатия изображений книги.
+ *
+ * @~english
+ * @brief Source file for book image recompression.
+ */
+
+#include "imageoptimizer.h"
+#include "base64.h"
+
+#include <QBuffer>
+#include <QImage>
+#include <QRegularExpression>
+
+// FB2 editors wrap base64 text in lines of this length
+const int lineLength = 76;
+
+/*
+ * An image is opaque if its format has no alpha channel or all pixels have full alpha.
+ */
+static bool isOpaque(const QImage &image)
+{
+    if (!image.hasAlphaChannel())
+        return true;
+
+    QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+
+    for (int y = 0; y < argb.height(); ++y)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(argb.constScanLine(y));
+
+        for (int x = 0; x < argb.width(); ++x)
+        {
+            if (qAlpha(line[x]) != 255)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+ImageOptimizer::Statistics::Statistics()
+{
+    images = 0;
+    recompressed = 0;
+    before = 0;
+    after = 0;
+}
+
+void ImageOptimizer::Statistics::add(const Statistics &other)
+{
+    images += other.images;
+    recompressed += other.recompressed;
+    before += other.before;
+    after += other.after;
+}
+
+ImageOptimizer::ImageOptimizer(int quality, int maxDimension)
+{
+    this->quality = quality;
+    this->maxDimension = maxDimension;
+}
+
+ImageOptimizer::Result ImageOptimizer::optimizeBinary(const QByteArray &element) const
+{
+    Result result;
+    result.element = element;
+
+    int tagEnd = element.indexOf('>');
+    int closing = element.lastIndexOf("</");
+
+    // Empty element has nothing to recompress
+    if ((tagEnd < 0) || (closing <= tagEnd) || (element.at(tagEnd - 1) == '/'))
+        return result;
+
+    result.statistics.images = 1;
+
+    QByteArray image;
+    QByteArray optimized;
+    QByteArray contentType;
+
+    if ((!Base64::decode(element.constData() + tagEnd + 1, closing - tagEnd - 1, image)) ||
+            (!optimizeImage(image, optimized, contentType)))
+        return result;
+
+    QString tag = QString::fromLatin1(element.constData(), tagEnd);
+    QRegularExpression type("content-type\\s*=\\s*([\"'])[^\"']*\\1");
+    QString attribute = QString("content-type=\"%1\"").arg(QString::fromLatin1(contentType));
+
+    if (tag.contains(type))
+        tag.replace(type, attribute);
+    else
+        tag.append(' ').append(attribute);
+
+    result.element = tag.toLatin1();
+    result.element.append(">\n");
+    result.element.append(Base64::encode(optimized, lineLength));
+    result.element.append('\n');
+    result.element.append(element.constData() + closing, element.size() - closing);
+
+    result.statistics.recompressed = 1;
+    result.statistics.before = image.size();
+    result.statistics.after = optimized.size();
+    return result;
+}
+
+bool ImageOptimizer::optimizeImage(const QByteArray &image, QByteArray &result, QByteArray &contentType) const
+{
+    // GIF may be animated, and only the first frame would be kept
+    if (image.startsWith("GIF8"))
+        return false;
+
+    QImage picture;
+
+    if (!picture.loadFromData(image))
+        return false;
+
+    bool scale = (maxDimension > 0) && ((picture.width() > maxDimension) || (picture.height() > maxDimension));
+
+    if (image.startsWith("\xFF\xD8\xFF") && (!scale))
+        return false;
+
+    if (scale)
+        picture = picture.scaled(maxDimension, maxDimension, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    result.clear();
+    QBuffer buffer(&result);
+    buffer.open(QIODevice::WriteOnly);
+
+    if (isOpaque(picture))
+    {
+        if (!picture.save(&buffer, "JPG", quality))
+            return false;
+
+        contentType = "image/jpeg";
+    }
+    else
+    {
+        if (!picture.save(&buffer, "PNG"))
+            return false;
+
+        contentType = "image/png";
+    }
+
+    return (!result.isEmpty()) && (result.size() < image.size());
+}
@@ -0,0 +1,162 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef IMAGEOPTIMIZER_H
+#define IMAGEOPTIMIZER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль пережатия изображений книги.
+ *
+ * @~english
+ * @brief Module of book image recompression.
+ */
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/**
+ * @~russian
+ * @brief Пережатие изображений из разделов @c binary.
+ *
+ * Непрозрачные изображения без потерь (PNG, BMP и т.п.) сохраняются в JPEG с заданным качеством, прозрачные
+ * остаются в PNG. Изображения больше заданного размера уменьшаются с сохранением пропорций, JPEG без
+ * уменьшения не пережимается, чтобы не терять качество повторно, GIF не изменяется, так как может быть
+ * анимирован. Новое изображение используется, только если оно меньше исходного.@n
+ * Объект не изменяется при обработке, поэтому один оптимизатор используется из нескольких потоков.
+ *
+ * @~english
+ * @brief Recompression of images from @c binary sections.
+ *
+ * Opaque lossless images (PNG, BMP, etc.) are saved to JPEG with the given quality, transparent ones stay
+ * in PNG. Images larger than the given size are scaled down keeping proportions, JPEG without scaling is not
+ * recompressed so as not to lose quality again, GIF is not changed because it may be animated. The new image
+ * is used only if it is smaller than the original one.@n
+ * The object is not changed by processing, so one optimizer is used from several threads.
+ */
+class ImageOptimizer
+{
+public:
+    /**
+     * @~russian
+     * @brief Статистика обработки изображений.
+     *
+     * @~english
+     * @brief Statistics of image processing.
+     */
+    struct Statistics
+    {
+        int images; ///< @~russian Найдено изображений. @~english Images found.
+        int recompressed; ///< @~russian Заменено изображений. @~english Images replaced.
+        qint64 before; ///< @~russian Размер замененных изображений до обработки. @~english Size of replaced images before processing.
+        qint64 after; ///< @~russian Размер замененных изображений после обработки. @~english Size of replaced images after processing.
+
+        /**
+         * @~russian
+         * @brief Конструктор пустой статистики.
+         *
+         * @~english
+         * @brief Constructor of empty statistics.
+         */
+        Statistics();
+
+        /**
+         * @~russian
+         * @brief Добавление статистики другой обработки.
+         * @param other Добавляемая статистика.
+         *
+         * @~english
+         * @brief Adding statistics of another processing.
+         * @param other Added statistics.
+         */
+        void add(const Statistics &other);
+    };
+
+    /**
+     * @~russian
+     * @brief Результат обработки раздела @c binary.
+     *
+     * @~english
+     * @brief Result of @c binary section processing.
+     */
+    struct Result
+    {
+        QByteArray element; ///< @~russian Элемент целиком, исходный - если изображение не изменено. @~english Entire element, the original one if the image is not changed.
+        Statistics statistics; ///< @~russian Статистика элемента. @~english Statistics of the element.
+    };
+
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param quality Качество JPEG от 1 до 100.
+     * @param maxDimension Наибольшая ширина и высота изображения, 0 - без уменьшения.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param quality JPEG quality from 1 to 100.
+     * @param maxDimension Largest width and height of the image, 0 - without scaling.
+     */
+    explicit ImageOptimizer(int quality = 80, int maxDimension = 1600);
+
+    /**
+     * @~russian
+     * @brief Обработка раздела @c binary.
+     *
+     * Атрибут @c content-type заменяется типом нового изображения, идентификатор раздела сохраняется,
+     * поэтому ссылки на изображение в тексте книги остаются верными.
+     * @param element Элемент @c binary целиком, от открывающего до закрывающего тега.
+     * @return Результат обработки.
+     *
+     * @~english
+     * @brief Processing of @c binary section.
+     *
+     * The @c content-type attribute is replaced with the type of the new image, the section identifier is kept,
+     * so links to the image in the book text stay valid.
+     * @param element Entire @c binary element, from the opening to the closing tag.
+     * @return Processing result.
+     */
+    Result optimizeBinary(const QByteArray &element) const;
+
+    /**
+     * @~russian
+     * @brief Пережатие изображения.
+     * @param image Исходное изображение.
+     * @param result Массив, в который помещается новое изображение.
+     * @param contentType Строка, в которую помещается MIME-тип нового изображения.
+     * @return @c true - если новое изображение меньше исходного;@n
+     * @c false - если изображение следует оставить без изменений.
+     *
+     * @~english
+     * @brief Recompression of the image.
+     * @param image Original image.
+     * @param result Array receiving the new image.
+     * @param contentType String receiving MIME type of the new image.
+     * @return @c true - if the new image is smaller than the original one;@n
+     * @c false - if the image should be left unchanged.
+     */
+    bool optimizeImage(const QByteArray &image, QByteArray &result, QByteArray &contentType) const;
+
+private:
+    int quality; ///< @~russian Качество JPEG. @~english JPEG quality.
+    int maxDimension; ///< @~russian Наибольшая ширина и высота изображения. @~english Largest width and height of the image.
+};
+
+#endif // IMAGEOPTIMIZER_H
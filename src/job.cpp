@@ -0,0 +1,282 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для фоновых заданий.
+ *
+ * @~english
+ * @brief Source file for background jobs.
+ */
+
+#include "job.h"
+
+#include <QTimer>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QRunnable>
+
+/*
+ * Worker of Job::runParallel(). All workers share the counter of the next item, so a slow item
+ * does not stall the others and the number of items in progress never exceeds the number of workers.
+ */
+class JobWorker : public QRunnable
+{
+public:
+    JobWorker(Job *job, QAtomicInt *next, int count)
+    {
+        this->job = job;
+        this->next = next;
+        this->count = count;
+    }
+
+    void run()
+    {
+        int index;
+
+        while (job->checkPoint() && ((index = next->fetchAndAddOrdered(1)) < count))
+        {
+            job->processParallel(index);
+        }
+    }
+
+private:
+    Job *job;
+    QAtomicInt *next;
+    int count;
+};
+
+JobProgress::JobProgress()
+{
+    doneItems = 0;
+    totalItems = -1;
+    doneBytes = 0;
+    totalBytes = -1;
+    itemsPerSecond = 0;
+    bytesPerSecond = 0;
+    elapsed = 0;
+    eta = -1;
+}
+
+Job::Job(QObject *parent): QThread(parent)
+{
+    cancelled.store(0);
+    paused.store(0);
+    totalItems.store(-1);
+    totalBytes.store(-1);
+    doneItems.store(0);
+    doneBytes.store(0);
+    lastItems = 0;
+    lastBytes = 0;
+    itemsRate = 0;
+    bytesRate = 0;
+    pausedTime = 0;
+
+    tmrProgress = new QTimer(this);
+    tmrProgress->setInterval(1000);
+
+    connect(tmrProgress, SIGNAL(timeout()), this, SLOT(onTimer()));
+    connect(this, SIGNAL(started()), this, SLOT(onStarted()));
+    connect(this, SIGNAL(finished()), this, SLOT(onFinished()));
+
+    qRegisterMetaType<JobProgress>("JobProgress");
+}
+
+Job::~Job()
+{
+    onCancel();
+    wait();
+    delete tmrProgress;
+}
+
+bool Job::isCancelled() const
+{
+    return cancelled.load() != 0;
+}
+
+bool Job::isPaused() const
+{
+    return paused.load() != 0;
+}
+
+JobProgress Job::getProgress() const
+{
+    JobProgress progress;
+
+    progress.doneItems = doneItems.load();
+    progress.totalItems = totalItems.load();
+    progress.doneBytes = doneBytes.load();
+    progress.totalBytes = totalBytes.load();
+    progress.itemsPerSecond = itemsRate;
+    progress.bytesPerSecond = bytesRate;
+    progress.elapsed = tmrElapsed.isValid() ? tmrElapsed.elapsed() / 1000 : 0;
+
+    // Average rate since start gives more stable estimation than the last second rate.
+    // The job does not progress while paused, so paused time is excluded
+    qint64 msec = tmrElapsed.isValid() ? tmrElapsed.elapsed() - pausedTime : 0;
+
+    if (tmrPaused.isValid())
+        msec -= tmrPaused.elapsed();
+
+    if (msec > 0)
+    {
+        if ((progress.totalBytes > 0) && (progress.doneBytes > 0))
+        {
+            progress.eta = (progress.totalBytes - progress.doneBytes) * msec / progress.doneBytes / 1000;
+        }
+        else
+            if ((progress.totalItems > 0) && (progress.doneItems > 0))
+            {
+                progress.eta = (progress.totalItems - progress.doneItems) * msec / progress.doneItems / 1000;
+            }
+    }
+
+    return progress;
+}
+
+void Job::onCancel()
+{
+    QMutexLocker locker(&mtxPause);
+
+    if (cancelled.testAndSetOrdered(0, 1))
+    {
+        cndPause.wakeAll();
+        emit Cancelled();
+    }
+}
+
+void Job::onPause()
+{
+    if (paused.testAndSetOrdered(0, 1))
+    {
+        tmrPaused.start();
+        emit Paused();
+    }
+}
+
+void Job::onResume()
+{
+    QMutexLocker locker(&mtxPause);
+
+    if (paused.testAndSetOrdered(1, 0))
+    {
+        pausedTime += tmrPaused.elapsed();
+        tmrPaused.invalidate();
+        cndPause.wakeAll();
+        emit Resumed();
+    }
+}
+
+void Job::onTogglePause()
+{
+    if (isPaused())
+        onResume();
+    else
+        onPause();
+}
+
+bool Job::checkPoint()
+{
+    if (paused.load() != 0)
+    {
+        QMutexLocker locker(&mtxPause);
+
+        while ((paused.load() != 0) && (cancelled.load() == 0))
+        {
+            cndPause.wait(&mtxPause);
+        }
+    }
+
+    return cancelled.load() == 0;
+}
+
+void Job::setTotal(qint64 items, qint64 bytes)
+{
+    totalItems.store(items);
+    totalBytes.store(bytes);
+}
+
+void Job::addProgress(qint64 items, qint64 bytes)
+{
+    doneItems.fetchAndAddRelaxed(items);
+    doneBytes.fetchAndAddRelaxed(bytes);
+}
+
+void Job::onStarted()
+{
+    // A job paused before the start is counted as paused from the start
+    pausedTime = 0;
+
+    if (tmrPaused.isValid())
+        tmrPaused.start();
+
+    tmrElapsed.start();
+    tmrTick.start();
+    tmrProgress->start();
+}
+
+void Job::onFinished()
+{
+    tmrProgress->stop();
+    emit Progress(getProgress());
+}
+
+void Job::onTimer()
+{
+    qint64 msec = tmrTick.restart();
+    qint64 items = doneItems.load();
+    qint64 bytes = doneBytes.load();
+
+    if (msec > 0)
+    {
+        itemsRate = (items - lastItems) * 1000.0 / msec;
+        bytesRate = (bytes - lastBytes) * 1000.0 / msec;
+    }
+
+    lastItems = items;
+    lastBytes = bytes;
+
+    emit Progress(getProgress());
+}
+
+void Job::runParallel(int count, int threads)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    if (threads > count)
+        threads = count;
+
+    QAtomicInt next(0);
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    for (int i = 0; i < threads; ++i)
+    {
+        pool.start(new JobWorker(this, &next, count));
+    }
+
+    pool.waitForDone();
+}
+
+void Job::processParallel(int index)
+{
+    Q_UNUSED(index)
+}
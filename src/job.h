@@ -0,0 +1,476 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef JOB_H
+#define JOB_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль фоновых заданий.
+ *
+ * Задание выполняется в отдельном потоке и поддерживает отмену, приостановку и отчет о ходе выполнения.
+ *
+ * @~english
+ * @brief Module of background jobs.
+ *
+ * A job is performed in a separate thread and supports cancellation, pausing and progress reporting.
+ */
+
+#include <QThread>
+#include <QString>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QMetaType>
+
+// Forward class declarations
+class QTimer;
+
+/**
+ * @~russian
+ * @brief Состояние выполнения задания.
+ *
+ * @~english
+ * @brief Progress of the job.
+ */
+struct JobProgress
+{
+    /**
+     * @~russian
+     * @brief Конструктор пустого состояния.
+     *
+     * @~english
+     * @brief Constructor of empty progress.
+     */
+    JobProgress();
+
+    qint64 doneItems; ///< @~russian Обработано элементов. @~english Processed items.
+    qint64 totalItems; ///< @~russian Всего элементов, -1 - если неизвестно. @~english Total items, -1 if unknown.
+    qint64 doneBytes; ///< @~russian Обработано байт. @~english Processed bytes.
+    qint64 totalBytes; ///< @~russian Всего байт, -1 - если неизвестно. @~english Total bytes, -1 if unknown.
+    double itemsPerSecond; ///< @~russian Элементов в секунду за последнюю секунду. @~english Items per second during the last second.
+    double bytesPerSecond; ///< @~russian Байт в секунду за последнюю секунду. @~english Bytes per second during the last second.
+    qint64 elapsed; ///< @~russian Прошло секунд с начала задания. @~english Seconds elapsed since job start.
+    qint64 eta; ///< @~russian Оставшееся время в секундах без учета приостановок, -1 - если неизвестно. @~english Remaining time in seconds excluding pauses, -1 if unknown.
+};
+
+Q_DECLARE_METATYPE(JobProgress)
+
+/**
+ * @~russian
+ * @brief Базовый класс фонового задания.
+ *
+ * Наследник реализует метод run(), периодически вызывая checkPoint() и addProgress().@n
+ * Отмена и приостановка кооперативные: поток останавливается только в checkPoint().
+ *
+ * @~english
+ * @brief Base class of the background job.
+ *
+ * A descendant implements run() method, periodically calling checkPoint() and addProgress().@n
+ * Cancellation and pausing are cooperative: the thread stops only in checkPoint().
+ */
+class Job : public QThread
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор задания.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor of the job.
+     * @param parent Parent object.
+     */
+    explicit Job(QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор задания.
+     *
+     * @~english
+     * @brief Destructor of the job.
+     */
+    virtual ~Job();
+
+    /**
+     * @~russian
+     * @brief Получение заголовка задания для отображения пользователю.
+     * @return Заголовок задания.
+     *
+     * @~english
+     * @brief Getting the job title to display to the user.
+     * @return Job title.
+     */
+    virtual QString getTitle() const = 0;
+
+    /**
+     * @~russian
+     * @brief Получение признака отмены задания.
+     * @return @c true - если задание отменено;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Getting whether the job was cancelled.
+     * @return @c true - if job is cancelled;@n
+     * @c false - if not.
+     */
+    bool isCancelled() const;
+
+    /**
+     * @~russian
+     * @brief Получение признака приостановки задания.
+     * @return @c true - если задание приостановлено;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Getting whether the job is paused.
+     * @return @c true - if job is paused;@n
+     * @c false - if not.
+     */
+    bool isPaused() const;
+
+    /**
+     * @~russian
+     * @brief Получение текущего состояния выполнения задания.
+     * @return Состояние выполнения.
+     *
+     * @~english
+     * @brief Getting the current progress of the job.
+     * @return Job progress.
+     */
+    JobProgress getProgress() const;
+
+signals:
+    /**
+     * @~russian
+     * @brief Отсылка сообщения в журнал сообщений.
+     * @param msg Текст сообщения.
+     *
+     * @~english
+     * @brief Sending messages to the message log.
+     * @param msg Message text.
+     */
+    void EventMessage(const QString &msg);
+
+    /**
+     * @~russian
+     * @brief Отсылка сообщения об ошибке в журнал сообщений.
+     * @param msg Текст сообщения.
+     *
+     * @~english
+     * @brief Sending error messages to the message log.
+     * @param msg Message text.
+     */
+    void ErrorMessage(const QString &msg);
+
+    /**
+     * @~russian
+     * @brief Отсылка состояния выполнения задания.
+     *
+     * Сигнал отсылается раз в секунду и по окончании задания.
+     * @param progress Состояние выполнения.
+     *
+     * @~english
+     * @brief Sending progress of the job.
+     *
+     * The signal is sent once a second and at the end of the job.
+     * @param progress Job progress.
+     */
+    void Progress(const JobProgress &progress);
+
+    /**
+     * @~russian
+     * @brief Задание приостановлено.
+     *
+     * @~english
+     * @brief The job is paused.
+     */
+    void Paused();
+
+    /**
+     * @~russian
+     * @brief Задание возобновлено.
+     *
+     * @~english
+     * @brief The job is resumed.
+     */
+    void Resumed();
+
+    /**
+     * @~russian
+     * @brief Задание отменено.
+     *
+     * @~english
+     * @brief The job is cancelled.
+     */
+    void Cancelled();
+
+public slots:
+    /**
+     * @~russian
+     * @brief Отмена задания.
+     *
+     * @~english
+     * @brief Cancel the job.
+     */
+    void onCancel();
+
+    /**
+     * @~russian
+     * @brief Приостановка задания.
+     *
+     * @~english
+     * @brief Pause the job.
+     */
+    void onPause();
+
+    /**
+     * @~russian
+     * @brief Возобновление задания.
+     *
+     * @~english
+     * @brief Resume the job.
+     */
+    void onResume();
+
+    /**
+     * @~russian
+     * @brief Переключение приостановки задания.
+     *
+     * @~english
+     * @brief Toggle pausing of the job.
+     */
+    void onTogglePause();
+
+protected:
+    /**
+     * @~russian
+     * @brief Точка проверки состояния задания.
+     *
+     * Если задание приостановлено, то поток блокируется до возобновления или отмены.
+     * @return @c true - если выполнение следует продолжить;@n
+     * @c false - если задание отменено.
+     *
+     * @~english
+     * @brief Checkpoint of job state.
+     *
+     * If the job is paused, the thread is blocked until resuming or cancellation.
+     * @return @c true - if execution should continue;@n
+     * @c false - if the job is cancelled.
+     */
+    bool checkPoint();
+
+    /**
+     * @~russian
+     * @brief Установка общего объема работы.
+     * @param items Количество элементов, -1 - если неизвестно.
+     * @param bytes Количество байт, -1 - если неизвестно.
+     *
+     * @~english
+     * @brief Setting total amount of work.
+     * @param items Number of items, -1 if unknown.
+     * @param bytes Number of bytes, -1 if unknown.
+     */
+    void setTotal(qint64 items, qint64 bytes);
+
+    /**
+     * @~russian
+     * @brief Учет выполненной работы.
+     * @param items Количество обработанных элементов.
+     * @param bytes Количество обработанных байт.
+     *
+     * @~english
+     * @brief Accounting of done work.
+     * @param items Number of processed items.
+     * @param bytes Number of processed bytes.
+     */
+    void addProgress(qint64 items, qint64 bytes);
+
+    /**
+     * @~russian
+     * @brief Параллельная обработка элементов задания.
+     *
+     * Создает пул из указанного количества потоков, каждый из которых последовательно забирает очередной
+     * элемент и вызывает для него processParallel(). Одновременно обрабатывается не более @a threads
+     * элементов. Метод возвращает управление после обработки всех элементов или отмены задания.
+     * @param count Количество элементов.
+     * @param threads Количество потоков, 0 - по количеству процессоров.
+     *
+     * @~english
+     * @brief Parallel processing of job items.
+     *
+     * Creates a pool of the specified number of threads, each of which takes the next item in turn
+     * and calls processParallel() for it. At most @a threads items are processed simultaneously.
+     * The method returns after all items are processed or the job is cancelled.
+     * @param count Number of items.
+     * @param threads Number of threads, 0 - by number of processors.
+     */
+    void runParallel(int count, int threads);
+
+    /**
+     * @~russian
+     * @brief Обработка одного элемента в потоке пула.
+     *
+     * Вызывается из нескольких потоков одновременно, реализация должна быть потокобезопасной.
+     * @param index Номер элемента.
+     *
+     * @~english
+     * @brief Processing of one item in the pool thread.
+     *
+     * It is called from several threads simultaneously, implementation should be thread-safe.
+     * @param index Item number.
+     */
+    virtual void processParallel(int index);
+
+private slots:
+    /**
+     * @~russian
+     * @brief Обработка начала выполнения потока.
+     *
+     * @~english
+     * @brief Processing of thread start.
+     */
+    void onStarted();
+
+    /**
+     * @~russian
+     * @brief Обработка окончания выполнения потока.
+     *
+     * @~english
+     * @brief Processing of thread finish.
+     */
+    void onFinished();
+
+    /**
+     * @~russian
+     * @brief Ежесекундный расчет скорости выполнения.
+     *
+     * @~english
+     * @brief Calculation of throughput every second.
+     */
+    void onTimer();
+
+private:
+    /**
+     * @~russian
+     * @brief Признак отмены задания.
+     *
+     * @~english
+     * @brief Flag of job cancellation.
+     */
+    QAtomicInt cancelled;
+
+    /**
+     * @~russian
+     * @brief Признак приостановки задания.
+     *
+     * @~english
+     * @brief Flag of job pausing.
+     */
+    QAtomicInt paused;
+
+    /**
+     * @~russian
+     * @brief Мьютекс для ожидания возобновления.
+     *
+     * @~english
+     * @brief Mutex for waiting for resuming.
+     */
+    QMutex mtxPause;
+
+    /**
+     * @~russian
+     * @brief Условие ожидания возобновления.
+     *
+     * @~english
+     * @brief Wait condition for resuming.
+     */
+    QWaitCondition cndPause;
+
+    QAtomicInteger<qint64> totalItems; ///< @~russian Всего элементов. @~english Total items.
+    QAtomicInteger<qint64> totalBytes; ///< @~russian Всего байт. @~english Total bytes.
+    QAtomicInteger<qint64> doneItems; ///< @~russian Обработано элементов. @~english Processed items.
+    QAtomicInteger<qint64> doneBytes; ///< @~russian Обработано байт. @~english Processed bytes.
+
+    /**
+     * @~russian
+     * @brief Таймер расчета скорости выполнения.
+     *
+     * @~english
+     * @brief Timer of throughput calculation.
+     */
+    QTimer *tmrProgress;
+
+    /**
+     * @~russian
+     * @brief Время с начала выполнения задания.
+     *
+     * @~english
+     * @brief Time since job start.
+     */
+    QElapsedTimer tmrElapsed;
+
+    /**
+     * @~russian
+     * @brief Время с предыдущего расчета скорости.
+     *
+     * @~english
+     * @brief Time since previous throughput calculation.
+     */
+    QElapsedTimer tmrTick;
+
+    /**
+     * @~russian
+     * @brief Время с момента приостановки задания.
+     *
+     * Действителен, только пока задание приостановлено.
+     *
+     * @~english
+     * @brief Time since the job was paused.
+     *
+     * It is valid only while the job is paused.
+     */
+    QElapsedTimer tmrPaused;
+
+    /**
+     * @~russian
+     * @brief Суммарное время приостановки в миллисекундах.
+     *
+     * Не учитывается при расчете оставшегося времени.
+     *
+     * @~english
+     * @brief Total paused time in milliseconds.
+     *
+     * It is excluded from the estimation of remaining time.
+     */
+    qint64 pausedTime;
+
+    qint64 lastItems; ///< @~russian Элементов на момент предыдущего расчета. @~english Items at previous calculation.
+    qint64 lastBytes; ///< @~russian Байт на момент предыдущего расчета. @~english Bytes at previous calculation.
+    double itemsRate; ///< @~russian Последняя скорость в элементах. @~english Last rate in items.
+    double bytesRate; ///< @~russian Последняя скорость в байтах. @~english Last rate in bytes.
+
+    friend class JobWorker;
+};
+
+#endif // JOB_H
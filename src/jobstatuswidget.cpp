@@ -0,0 +1,152 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для виджета состояния задания.
+ *
+ * @~english
+ * @brief Source file for job status widget.
+ */
+
+#include "jobstatuswidget.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QProgressBar>
+#include <QToolButton>
+
+JobStatusWidget::JobStatusWidget(Job *job, QWidget *parent) :
+    QWidget(parent)
+{
+    lblTitle = new QLabel(job->getTitle());
+
+    prgProgress = new QProgressBar();
+    prgProgress->setRange(0, 0); // Busy indicator until the total is known
+    prgProgress->setMaximumWidth(200);
+
+    lblStatistics = new QLabel();
+
+    btnPause = new QToolButton();
+    btnPause->setText(tr("Pause"));
+    btnPause->setCheckable(true);
+    connect(btnPause, SIGNAL(clicked()), job, SLOT(onTogglePause()));
+
+    btnCancel = new QToolButton();
+    btnCancel->setText(tr("Cancel"));
+    connect(btnCancel, SIGNAL(clicked()), job, SLOT(onCancel()));
+
+    boxMain = new QHBoxLayout();
+    boxMain->setContentsMargins(0, 0, 0, 0);
+    boxMain->addWidget(lblTitle);
+    boxMain->addWidget(prgProgress);
+    boxMain->addWidget(lblStatistics);
+    boxMain->addWidget(btnPause);
+    boxMain->addWidget(btnCancel);
+    this->setLayout(boxMain);
+
+    connect(job, SIGNAL(Progress(JobProgress)), this, SLOT(onProgress(JobProgress)));
+    connect(job, SIGNAL(Paused()), this, SLOT(onPaused()));
+    connect(job, SIGNAL(Resumed()), this, SLOT(onResumed()));
+    connect(job, SIGNAL(Cancelled()), this, SLOT(onCancelled()));
+}
+
+JobStatusWidget::~JobStatusWidget()
+{
+    delete btnCancel;
+    delete btnPause;
+    delete lblStatistics;
+    delete prgProgress;
+    delete lblTitle;
+    delete boxMain;
+}
+
+void JobStatusWidget::onProgress(const JobProgress &progress)
+{
+    // QProgressBar works with int, so the progress is shown in per mille
+    if ((progress.totalBytes > 0) || (progress.totalItems > 0))
+    {
+        prgProgress->setRange(0, 1000);
+
+        if (progress.totalBytes > 0)
+            prgProgress->setValue(static_cast<int>(progress.doneBytes * 1000 / progress.totalBytes));
+        else
+            prgProgress->setValue(static_cast<int>(progress.doneItems * 1000 / progress.totalItems));
+    }
+
+    QString items;
+
+    if (progress.totalItems >= 0)
+        items = QString("%1/%2").arg(QString::number(progress.doneItems), QString::number(progress.totalItems));
+    else
+        items = QString::number(progress.doneItems);
+
+    QString bytes;
+
+    if (progress.totalBytes >= 0)
+        bytes = QString("%1/%2").arg(formatBytes(progress.doneBytes), formatBytes(progress.totalBytes));
+    else
+        bytes = formatBytes(progress.doneBytes);
+
+    QString eta = (progress.eta >= 0) ? formatTime(progress.eta) : QString("--:--:--");
+
+    lblStatistics->setText(tr("%1 files, %2; %3 files/s, %4/s; elapsed %5, left %6").arg(items, bytes,
+                           QString::number(progress.itemsPerSecond, 'f', 1), formatBytes(progress.bytesPerSecond),
+                           formatTime(progress.elapsed), eta));
+}
+
+void JobStatusWidget::onPaused()
+{
+    btnPause->setChecked(true);
+    btnPause->setText(tr("Resume"));
+}
+
+void JobStatusWidget::onResumed()
+{
+    btnPause->setChecked(false);
+    btnPause->setText(tr("Pause"));
+}
+
+void JobStatusWidget::onCancelled()
+{
+    btnPause->setEnabled(false);
+    btnCancel->setEnabled(false);
+    lblTitle->setText(tr("%1 (cancelling)").arg(lblTitle->text()));
+}
+
+QString JobStatusWidget::formatBytes(double bytes) const
+{
+    if (bytes >= 1024.0 * 1024.0 * 1024.0)
+        return tr("%1 GB").arg(QString::number(bytes / (1024.0 * 1024.0 * 1024.0), 'f', 2));
+
+    if (bytes >= 1024.0 * 1024.0)
+        return tr("%1 MB").arg(QString::number(bytes / (1024.0 * 1024.0), 'f', 1));
+
+    if (bytes >= 1024.0)
+        return tr("%1 KB").arg(QString::number(bytes / 1024.0, 'f', 1));
+
+    return tr("%1 B").arg(QString::number(bytes, 'f', 0));
+}
+
+QString JobStatusWidget::formatTime(qint64 seconds) const
+{
+    return QString("%1:%2:%3").arg(seconds / 3600, 2, 10, QChar('0')).arg((seconds / 60) % 60, 2, 10,
+                                   QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+}
@@ -0,0 +1,153 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef JOBSTATUSWIDGET_H
+#define JOBSTATUSWIDGET_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль виджета состояния задания для строки состояния.
+ *
+ * @~english
+ * @brief Module of the job status widget for the status bar.
+ */
+
+#include "job.h"
+
+#include <QWidget>
+
+// Forward class declarations
+class QHBoxLayout;
+class QLabel;
+class QProgressBar;
+class QToolButton;
+
+/**
+ * @~russian
+ * @brief Виджет состояния задания.
+ *
+ * Показывает ход выполнения, скорость и оставшееся время, позволяет приостановить или отменить задание.
+ *
+ * @~english
+ * @brief Job status widget.
+ *
+ * Shows progress, throughput and remaining time, allows to pause or cancel the job.
+ */
+class JobStatusWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор виджета.
+     * @param job Отображаемое задание.
+     * @param parent Родительский виджет.
+     *
+     * @~english
+     * @brief Constructor of the widget.
+     * @param job Displayed job.
+     * @param parent Parent widget.
+     */
+    explicit JobStatusWidget(Job *job, QWidget *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор виджета.
+     *
+     * @~english
+     * @brief Destructor of the widget.
+     */
+    virtual ~JobStatusWidget();
+
+public slots:
+    /**
+     * @~russian
+     * @brief Обновление отображаемого состояния задания.
+     * @param progress Состояние выполнения.
+     *
+     * @~english
+     * @brief Update of displayed job progress.
+     * @param progress Job progress.
+     */
+    void onProgress(const JobProgress &progress);
+
+    /**
+     * @~russian
+     * @brief Обработка приостановки задания.
+     *
+     * @~english
+     * @brief Processing of job pausing.
+     */
+    void onPaused();
+
+    /**
+     * @~russian
+     * @brief Обработка возобновления задания.
+     *
+     * @~english
+     * @brief Processing of job resuming.
+     */
+    void onResumed();
+
+    /**
+     * @~russian
+     * @brief Обработка отмены задания.
+     *
+     * @~english
+     * @brief Processing of job cancellation.
+     */
+    void onCancelled();
+
+private:
+    QHBoxLayout *boxMain; ///< @~russian Компоновка виджета. @~english Widget layout.
+    QLabel *lblTitle; ///< @~russian Заголовок задания. @~english Job title.
+    QProgressBar *prgProgress; ///< @~russian Индикатор выполнения. @~english Progress bar.
+    QLabel *lblStatistics; ///< @~russian Скорость и оставшееся время. @~english Throughput and remaining time.
+    QToolButton *btnPause; ///< @~russian Кнопка приостановки. @~english Pause button.
+    QToolButton *btnCancel; ///< @~russian Кнопка отмены. @~english Cancel button.
+
+    /**
+     * @~russian
+     * @brief Форматирование количества байт для отображения.
+     * @param bytes Количество байт.
+     * @return Отформатированная строка.
+     *
+     * @~english
+     * @brief Formatting of byte count for display.
+     * @param bytes Number of bytes.
+     * @return Formatted string.
+     */
+    QString formatBytes(double bytes) const;
+
+    /**
+     * @~russian
+     * @brief Форматирование интервала времени для отображения.
+     * @param seconds Интервал в секундах.
+     * @return Отформатированная строка.
+     *
+     * @~english
+     * @brief Formatting of time interval for display.
+     * @param seconds Interval in seconds.
+     * @return Formatted string.
+     */
+    QString formatTime(qint64 seconds) const;
+};
+
+#endif // JOBSTATUSWIDGET_H
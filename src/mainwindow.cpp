@@ -32,8 +32,17 @@
 
 #include "tablemodel.h"
 #include "filereader.h"
+#include "folderwatcher.h"
 #include "settingswindow.h"
 #include "recordeditor.h"
+#include "metadatawriter.h"
+#include "batcheditdialog.h"
+#include "jobstatuswidget.h"
+#include "genreregistry.h"
+#include "recordvalidator.h"
+#include "authorindex.h"
+#include "profiler.h"
+#include "scanreportwidget.h"
 #include "consts.h"
 
 #include <QWidget>
@@ -51,11 +60,15 @@
 #include <QStandardPaths>
 #include <QDateTime>
 #include <QTabWidget>
+#include <QTreeWidget>
+#include <QHeaderView>
 #include <QDialog>
 #include <QSettings>
 #include <QProcess>
 #include <QLabel>
 #include <QDebug>
+#include <QFileInfo>
+#include <QDir>
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
 {
@@ -89,6 +102,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     tmrLoadTime = new QTime();
     cntPreviousLoaded = 0;
+    cntRunningJobs = 0;
+    watcher = 0;
 
     this->setMenuBar(barMainMenu);
     this->addToolBar(barTools);
@@ -115,6 +130,17 @@ MainWindow::MainWindow(QWidget *parent)
 
     menuFile->addSeparator();
 
+    actnFileWatchDir = new QAction(tr("Watch directory..."), this);
+    connect(actnFileWatchDir, SIGNAL(triggered()), this, SLOT(onFileWatchDir()));
+    menuFile->addAction(actnFileWatchDir);
+
+    actnFileStopWatching = new QAction(tr("Stop watching"), this);
+    actnFileStopWatching->setEnabled(false);
+    connect(actnFileStopWatching, SIGNAL(triggered()), this, SLOT(onFileStopWatching()));
+    menuFile->addAction(actnFileStopWatching);
+
+    menuFile->addSeparator();
+
     actnFileClearFileList = new QAction(tr("Clear list of files"), this);
     connect(actnFileClearFileList, SIGNAL(triggered()), this, SLOT(onFileClearFileList()));
     menuFile->addAction(actnFileClearFileList);
@@ -145,6 +171,38 @@ MainWindow::MainWindow(QWidget *parent)
     actnSelectInvertSelection = new QAction(tr("Invert selection"), this);
     menuSelect->addAction(actnSelectInvertSelection);
 
+    actnSelectSimilar = new QAction(tr("Select similar books"), this);
+    menuSelect->addAction(actnSelectSimilar);
+
+    subSelectGenre = new QMenu(tr("Select by genre"), this);
+    menuSelect->addMenu(subSelectGenre);
+
+    for (int i = 0; i < GenreRegistry::getCategoryCount(); ++i)
+    {
+        QAction *category = new QAction(GenreRegistry::getCategoryName(i), this);
+        category->setProperty("category", i);
+        connect(category, SIGNAL(triggered()), this, SLOT(onSelectGenreCategory()));
+        subSelectGenre->addAction(category);
+    }
+
+    subSelectGenre->addSeparator();
+
+    QAction *unknownGenres = new QAction(tr("Unknown genres"), this);
+    unknownGenres->setProperty("category", -1);
+    connect(unknownGenres, SIGNAL(triggered()), this, SLOT(onSelectGenreCategory()));
+    subSelectGenre->addAction(unknownGenres);
+
+    subSelectStatus = new QMenu(tr("Select by status"), this);
+    menuSelect->addMenu(subSelectStatus);
+
+    for (int i = stIncorrectAuthorField; i <= stMixedCyrLat; ++i)
+    {
+        QAction *status = new QAction(TableModel::getStatusName(static_cast<Status>(i)), this);
+        status->setProperty("status", i);
+        connect(status, SIGNAL(triggered()), this, SLOT(onSelectStatus()));
+        subSelectStatus->addAction(status);
+    }
+
     // Setup Tools menu
 
     actnToolsUncompress = new QAction(tr("Uncompress"), this);
@@ -155,6 +213,27 @@ MainWindow::MainWindow(QWidget *parent)
     actnToolsCompress->setEnabled(false);
     menuTools->addAction(actnToolsCompress);
 
+    actnToolsBatchEdit = new QAction(tr("Batch edit metadata..."), this);
+    actnToolsBatchEdit->setEnabled(false);
+    connect(actnToolsBatchEdit, SIGNAL(triggered()), this, SLOT(onToolsBatchEdit()));
+    menuTools->addAction(actnToolsBatchEdit);
+
+    actnToolsConvertUtf8 = new QAction(tr("Convert to UTF-8"), this);
+    actnToolsConvertUtf8->setEnabled(false);
+    menuTools->addAction(actnToolsConvertUtf8);
+
+    actnToolsOptimizeImages = new QAction(tr("Optimize images"), this);
+    actnToolsOptimizeImages->setEnabled(false);
+    menuTools->addAction(actnToolsOptimizeImages);
+
+    actnToolsAnalyzeText = new QAction(tr("Count words and pages"), this);
+    actnToolsAnalyzeText->setEnabled(false);
+    menuTools->addAction(actnToolsAnalyzeText);
+
+    actnToolsRepack = new QAction(tr("Repack into shared archives..."), this);
+    actnToolsRepack->setEnabled(false);
+    menuTools->addAction(actnToolsRepack);
+
     subToolsMoveTo = new QMenu(tr("Move to"), this);
     menuTools->addMenu(subToolsMoveTo);
     subToolsCopyTo = new QMenu(tr("Copy to"), this);
@@ -164,6 +243,10 @@ MainWindow::MainWindow(QWidget *parent)
 
     menuTools->addSeparator();
 
+    actnToolsExportTrace = new QAction(tr("Export trace..."), this);
+    connect(actnToolsExportTrace, SIGNAL(triggered()), this, SLOT(onToolsExportTrace()));
+    menuTools->addAction(actnToolsExportTrace);
+
     actnToolsSettings = new QAction(QIcon::fromTheme("preferences-system", QIcon(":/img/preferences-system.png")),
                                     tr("Settings..."), this);
     connect(actnToolsSettings, SIGNAL(triggered()), this, SLOT(onToolsSettings()));
@@ -237,12 +320,18 @@ MainWindow::MainWindow(QWidget *parent)
     connect(mdlData, SIGNAL(EventMessage(QString)), this, SLOT(onEventMessage(QString)));
     connect(mdlData, SIGNAL(ErrorMessage(QString)), this, SLOT(onErrorMessage(QString)));
     connect(mdlData, SIGNAL(SetSelected(int)), this, SLOT(onSetSelected(int)));
+    connect(mdlData, SIGNAL(StartJob(Job *)), this, SLOT(onStartJob(Job *)));
 
     connect(actnToolsUncompress, SIGNAL(triggered()), mdlData, SLOT(onUnzipSelected()));
     connect(actnToolsCompress, SIGNAL(triggered()), mdlData, SLOT(onZipSelected()));
+    connect(actnToolsConvertUtf8, SIGNAL(triggered()), mdlData, SLOT(onConvertSelectedToUtf8()));
+    connect(actnToolsOptimizeImages, SIGNAL(triggered()), mdlData, SLOT(onOptimizeSelectedImages()));
+    connect(actnToolsAnalyzeText, SIGNAL(triggered()), mdlData, SLOT(onAnalyzeSelected()));
+    connect(actnToolsRepack, SIGNAL(triggered()), this, SLOT(onToolsRepack()));
 
     connect(actnSelectAllFiles, SIGNAL(triggered()), mdlData, SLOT(onSelectAll()));
     connect(actnSelectInvertSelection, SIGNAL(triggered()), mdlData, SLOT(onInvertSelection()));
+    connect(actnSelectSimilar, SIGNAL(triggered()), mdlData, SLOT(onSelectSimilar()));
 
     tblData->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(tblData, SIGNAL(customContextMenuRequested(QPoint)), this, SLOT(onTableContextMenuRequested(QPoint)));
@@ -255,6 +344,28 @@ MainWindow::MainWindow(QWidget *parent)
     edtLog->setReadOnly(true);
     tabInfo->addTab(edtLog, tr("Message Log"));
 
+    treeAuthors = new QTreeWidget();
+    treeAuthors->setHeaderLabels(QStringList() << tr("Author") << tr("Books"));
+    treeAuthors->setUniformRowHeights(true);
+    treeAuthors->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    treeAuthors->header()->setStretchLastSection(false);
+    tabInfo->addTab(treeAuthors, tr("Author groups"));
+
+    treeStatistics = new QTreeWidget();
+    treeStatistics->setHeaderLabels(QStringList() << tr("Phase") << tr("Count") << tr("Total")
+                                    << tr("p50") << tr("p95") << tr("p99") << tr("Max"));
+    treeStatistics->setRootIsDecorated(false);
+    treeStatistics->setUniformRowHeights(true);
+    treeStatistics->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    treeStatistics->header()->setStretchLastSection(false);
+    tabInfo->addTab(treeStatistics, tr("Statistics"));
+
+    wgtScanReport = new ScanReportWidget();
+    connect(wgtScanReport, SIGNAL(EventMessage(QString)), this, SLOT(onEventMessage(QString)));
+    connect(wgtScanReport, SIGNAL(ErrorMessage(QString)), this, SLOT(onErrorMessage(QString)));
+    tabInfo->addTab(wgtScanReport, tr("Scan report"));
+    connect(tabInfo, SIGNAL(currentChanged(int)), this, SLOT(onInfoTabChanged(int)));
+
     // TODO Add context menu for Message Log
 
     splMain->setStretchFactor(0, 1); // First widget must be wide than second
@@ -274,6 +385,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    delete watcher;
+    delete wgtScanReport;
+    delete treeStatistics;
+    delete treeAuthors;
     delete edtLog;
     delete tabInfo;
     delete mdlData;
@@ -288,15 +403,28 @@ MainWindow::~MainWindow()
     subToolsMoveTo->clear();
     delete subToolsMoveTo;
     delete actnToolsSettings;
+    delete actnToolsExportTrace;
+    delete actnToolsRepack;
+    delete actnToolsAnalyzeText;
+    delete actnToolsOptimizeImages;
+    delete actnToolsConvertUtf8;
+    delete actnToolsBatchEdit;
     delete actnToolsCompress;
     delete actnToolsUncompress;
     delete actnFileExit;
+    subSelectStatus->clear();
+    delete subSelectStatus;
+    subSelectGenre->clear();
+    delete subSelectGenre;
+    delete actnSelectSimilar;
     delete actnSelectInvertSelection;
     delete actnSelectOnlyCompressed;
     delete actnSelectAllFiles;
     delete actnFileClearFileListLog;
     delete actnFileClearLog;
     delete actnFileClearFileList;
+    delete actnFileStopWatching;
+    delete actnFileWatchDir;
     delete actnFileAppendDirRecursively;
     delete actnFileAppendDir;
     delete actnFileOpen;
@@ -313,18 +441,16 @@ MainWindow::~MainWindow()
 
 void MainWindow::setReaderSigSlots(FileReader *rd)
 {
+    // Statistics and trace describe the last scan and the operations after it
+    Profiler::reset();
+
     connect(rd, SIGNAL(started()), mdlData, SLOT(onBeginReading()));
-    connect(rd, SIGNAL(started()), this, SLOT(onBlockInput()));
     connect(rd, SIGNAL(started()), this, SLOT(onBeginReading()));
-    connect(rd, SIGNAL(finished()), rd, SLOT(deleteLater()));
     connect(rd, SIGNAL(finished()), mdlData, SLOT(onEndReading()));
-    connect(rd, SIGNAL(finished()), this, SLOT(onUnblockInput()));
     connect(rd, SIGNAL(finished()), this, SLOT(onEndReading()));
     connect(rd, SIGNAL(AppendRecord(FileRecord)), mdlData, SLOT(onAppendRecord(FileRecord)));
-    connect(rd, SIGNAL(EventMessage(QString)), this, SLOT(onEventMessage(QString)));
-    connect(rd, SIGNAL(ErrorMessage(QString)), this, SLOT(onErrorMessage(QString)));
 
-    rd->start();
+    onStartJob(rd);
 }
 
 void MainWindow::addTemplatesListToMenu(const setting_t &list)
@@ -384,13 +510,17 @@ void MainWindow::onErrorMessage(const QString &msg)
 
 void MainWindow::onBlockInput()
 {
-    QApplication::setOverrideCursor(Qt::BusyCursor);
-    QApplication::processEvents();
+    if (cntRunningJobs++ == 0)
+    {
+        QApplication::setOverrideCursor(Qt::BusyCursor);
+        QApplication::processEvents();
+    }
 }
 
 void MainWindow::onUnblockInput()
 {
-    QApplication::restoreOverrideCursor();
+    if ((cntRunningJobs > 0) && (--cntRunningJobs == 0))
+        QApplication::restoreOverrideCursor();
 }
 
 void MainWindow::onBeginReading()
@@ -402,9 +532,105 @@ void MainWindow::onEndReading()
 {
     onSetSelected(mdlData->getSelectedRecordsCount());
     int count = mdlData->getRecordsCount() - cntPreviousLoaded;
-    int sec = tmrLoadTime->elapsed() / 1000;
-    barStatus->showMessage(tr("%1 files loaded in %2 seconds").arg(QString::number(count), QString::number(sec)), 5000);
+    double sec = tmrLoadTime->elapsed() / 1000.0;
+    barStatus->showMessage(tr("%1 files loaded in %2 seconds").arg(QString::number(count), QString::number(sec, 'f', 1)),
+                           5000);
     cntPreviousLoaded = mdlData->getRecordsCount();
+
+    FileReader *reader = qobject_cast<FileReader *>(sender());
+
+    if (reader != 0)
+        wgtScanReport->setReport(reader->getReport());
+
+    if (tabInfo->currentWidget() == treeAuthors)
+        fillAuthorGroups();
+}
+
+void MainWindow::onInfoTabChanged(int index)
+{
+    if (tabInfo->widget(index) == treeAuthors)
+        fillAuthorGroups();
+    else
+        if (tabInfo->widget(index) == treeStatistics)
+            fillStatistics();
+}
+
+void MainWindow::onJobFinished()
+{
+    if (tabInfo->currentWidget() == treeStatistics)
+        fillStatistics();
+}
+
+/*
+ * Name of the author for the list of groups, the nickname is used if the name is not given.
+ */
+static QString authorName(const Person &author)
+{
+    QString name = author.getFullNameLFM().simplified();
+    return name.isEmpty() ? author.getNickname() : name;
+}
+
+void MainWindow::fillAuthorGroups()
+{
+    AuthorIndex authors = mdlData->buildAuthorIndex();
+    QList<QTreeWidgetItem *> items;
+
+    for (int group = 0; group < authors.getGroupCount(); ++group)
+    {
+        QVector<Person> variants = authors.getVariants(group);
+        QTreeWidgetItem *item = new QTreeWidgetItem(QStringList() << authorName(variants.at(0))
+                << QString::number(authors.getBookCount(group)));
+
+        // Other spellings are shown under the canonical one
+        for (int i = 1; i < variants.size(); ++i)
+            item->addChild(new QTreeWidgetItem(QStringList() << authorName(variants.at(i))));
+
+        items.append(item);
+    }
+
+    treeAuthors->clear();
+    treeAuthors->addTopLevelItems(items);
+    treeAuthors->sortItems(0, Qt::AscendingOrder);
+}
+
+/*
+ * Duration in the unit suitable for its magnitude.
+ */
+static QString durationText(qint64 nsecs)
+{
+    if (nsecs < 1000)
+        return MainWindow::tr("%1 ns").arg(nsecs);
+
+    if (nsecs < 1000000)
+        return MainWindow::tr("%1 us").arg(nsecs / 1000.0, 0, 'f', 1);
+
+    if (nsecs < Q_INT64_C(1000000000))
+        return MainWindow::tr("%1 ms").arg(nsecs / 1000000.0, 0, 'f', 1);
+
+    return MainWindow::tr("%1 s").arg(nsecs / 1000000000.0, 0, 'f', 2);
+}
+
+void MainWindow::fillStatistics()
+{
+    treeStatistics->clear();
+
+    for (int phase = 0; phase < Profiler::phCount; ++phase)
+    {
+        Profiler::Statistics stats = Profiler::getStatistics(static_cast<Profiler::Phase>(phase));
+
+        if (stats.count == 0)
+            continue;
+
+        QTreeWidgetItem *item = new QTreeWidgetItem(QStringList()
+                << Profiler::getPhaseName(static_cast<Profiler::Phase>(phase))
+                << QString::number(stats.count) << durationText(stats.total) << durationText(stats.p50)
+                << durationText(stats.p95) << durationText(stats.p99) << durationText(stats.max));
+
+        for (int column = 1; column < item->columnCount(); ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+
+        treeStatistics->addTopLevelItem(item);
+    }
 }
 
 void MainWindow::onSetSelected(int count)
@@ -413,6 +639,11 @@ void MainWindow::onSetSelected(int count)
     {
         actnToolsUncompress->setEnabled(true);
         actnToolsCompress->setEnabled(true);
+        actnToolsBatchEdit->setEnabled(true);
+        actnToolsConvertUtf8->setEnabled(true);
+        actnToolsOptimizeImages->setEnabled(true);
+        actnToolsAnalyzeText->setEnabled(true);
+        actnToolsRepack->setEnabled(true);
 
         QList<QAction *>::iterator it;
 
@@ -435,6 +666,11 @@ void MainWindow::onSetSelected(int count)
     {
         actnToolsUncompress->setEnabled(false);
         actnToolsCompress->setEnabled(false);
+        actnToolsBatchEdit->setEnabled(false);
+        actnToolsConvertUtf8->setEnabled(false);
+        actnToolsOptimizeImages->setEnabled(false);
+        actnToolsAnalyzeText->setEnabled(false);
+        actnToolsRepack->setEnabled(false);
 
         QList<QAction *>::iterator it;
 
@@ -457,6 +693,22 @@ void MainWindow::onSetSelected(int count)
     setStatusBarCounter(count, mdlData->getRecordsCount());
 }
 
+void MainWindow::onStartJob(Job *job)
+{
+    JobStatusWidget *status = new JobStatusWidget(job);
+    barStatus->insertPermanentWidget(0, status);
+
+    connect(job, SIGNAL(started()), this, SLOT(onBlockInput()));
+    connect(job, SIGNAL(finished()), job, SLOT(deleteLater()));
+    connect(job, SIGNAL(finished()), status, SLOT(deleteLater()));
+    connect(job, SIGNAL(finished()), this, SLOT(onUnblockInput()));
+    connect(job, SIGNAL(finished()), this, SLOT(onJobFinished()));
+    connect(job, SIGNAL(EventMessage(QString)), this, SLOT(onEventMessage(QString)));
+    connect(job, SIGNAL(ErrorMessage(QString)), this, SLOT(onErrorMessage(QString)));
+
+    job->start();
+}
+
 void MainWindow::onFileOpen()
 {
     QStringList filenames = QFileDialog::getOpenFileNames(this, tr("Open file"), workingDir,
@@ -493,6 +745,42 @@ void MainWindow::onFileAppendDirRecursively()
     }
 }
 
+void MainWindow::onFileWatchDir()
+{
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Watch Directory"), workingDir,
+                  QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+
+    if (dir.isEmpty())
+        return;
+
+    onFileStopWatching();
+
+    watcher = new FolderWatcher(dir, true);
+    connect(watcher, SIGNAL(UpdateRecord(FileRecord)), mdlData, SLOT(onUpdateRecord(FileRecord)));
+    connect(watcher, SIGNAL(RemoveFiles(QStringList)), mdlData, SLOT(onRemoveFiles(QStringList)));
+    connect(watcher, SIGNAL(EventMessage(QString)), this, SLOT(onEventMessage(QString)));
+    connect(watcher, SIGNAL(ErrorMessage(QString)), this, SLOT(onErrorMessage(QString)));
+    actnFileStopWatching->setEnabled(true);
+    onEventMessage(tr("Watching of directory %1 started").arg(watcher->getDirectory()));
+
+    // The folder is listed once: the reader passes its listing to the watcher as the snapshot
+    FileReader *reader = new FileReader(watcher->getDirectory(), true);
+    reader->setSnapshotEnabled(true);
+    connect(reader, SIGNAL(Snapshot(snapshot_t)), watcher, SLOT(onSnapshot(snapshot_t)));
+    setReaderSigSlots(reader);
+}
+
+void MainWindow::onFileStopWatching()
+{
+    if (watcher == 0)
+        return;
+
+    onEventMessage(tr("Watching of directory %1 stopped").arg(watcher->getDirectory()));
+    delete watcher;
+    watcher = 0;
+    actnFileStopWatching->setEnabled(false);
+}
+
 void MainWindow::onFileClearFileList()
 {
     emit mdlData->onClearList();
@@ -539,6 +827,16 @@ void MainWindow::onToolsCopyTo()
     }
 }
 
+void MainWindow::onSelectGenreCategory()
+{
+    mdlData->onSelectGenreCategory(sender()->property("category").toInt());
+}
+
+void MainWindow::onSelectStatus()
+{
+    mdlData->onSelectStatus(sender()->property("status").toInt());
+}
+
 void MainWindow::onToolsInplaceRename()
 {
     //TODO This function not working properly. It should rename the file in-place, and not move it to subdirectory.
@@ -547,6 +845,15 @@ void MainWindow::onToolsInplaceRename()
     emit mdlData->InplaceRename(basedir, pattern);
 }
 
+void MainWindow::onToolsRepack()
+{
+    QString targetDir = QFileDialog::getExistingDirectory(this, tr("Repack books to folder"), workingDir,
+                        QFileDialog::ShowDirsOnly | QFileDialog::DontResolveSymlinks);
+
+    if (!targetDir.isEmpty())
+        mdlData->onRepackSelected(targetDir);
+}
+
 void MainWindow::onToolsExternalEditor()
 {
     QString command = sender()->property("command").toString();
@@ -561,6 +868,30 @@ void MainWindow::onToolsExternalEditor()
     }
 }
 
+void MainWindow::onToolsBatchEdit()
+{
+    BatchEditDialog *dialog = new BatchEditDialog(mdlData->getSelectedRecords(), this);
+
+    if (dialog->exec() == QDialog::Accepted)
+        mdlData->onEditSelected(dialog->getTransforms());
+
+    delete dialog;
+}
+
+void MainWindow::onToolsExportTrace()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Export trace"), QDir(workingDir).filePath("trace.json"),
+                       tr("Chrome trace (*.json)"));
+
+    if (filename.isEmpty())
+        return;
+
+    if (Profiler::exportTrace(filename))
+        onEventMessage(tr("Trace saved to %1").arg(filename));
+    else
+        onErrorMessage(tr("Cannot save trace to %1").arg(filename));
+}
+
 void MainWindow::onToolsSettings()
 {
     SettingsWindow *settings = new SettingsWindow();
@@ -662,10 +993,26 @@ void MainWindow::onTableOpenEditor()
     QModelIndex index = sender()->property("index").toModelIndex();
     FileRecord record = mdlData->getRecord(index);
 
-    RecordEditor *editor = new RecordEditor(&record);
+    RecordEditor *editor = new RecordEditor(record);
 
     if (editor->exec() == QDialog::Accepted)
     {
+        FileRecord edited = editor->getRecord();
+
+        QSettings settings(NAMES::nameDeveloper, NAMES::nameApplication);
+        settings.beginGroup(NAMES::nameProcessingGroup);
+        MetadataWriter writer(settings.value(NAMES::nameCompressionLevel, 9).toInt());
+        settings.endGroup();
+
+        if (writer.write(edited, record))
+        {
+            edited.setSize(QFileInfo(edited.getFileName()).size());
+            edited.setStatus(RecordValidator::classify(edited));
+            mdlData->onReplaceRecord(index, edited);
+            onEventMessage(tr("Metadata of file %1 successfully saved").arg(edited.getFileName()));
+        }
+        else
+            onErrorMessage(tr("Cannot save metadata of file %1: %2").arg(edited.getFileName(), writer.getError()));
     }
 
     delete editor;
@@ -38,10 +38,14 @@ class QSplitter;
 class QTableView;
 class QTextEdit;
 class QTabWidget;
+class QTreeWidget;
 class QLabel;
 
 class TableModel;
 class FileReader;
+class FolderWatcher;
+class Job;
+class ScanReportWidget;
 
 /**
  * @~russian
@@ -103,6 +107,24 @@ private:
      */
     QMenu *menuSelect;
 
+    /**
+     * @~russian
+     * @brief Подменю «Отметить по жанру» меню «Выбор».
+     *
+     * @~english
+     * @brief The submenu «Select by genre» of Select menu.
+     */
+    QMenu *subSelectGenre;
+
+    /**
+     * @~russian
+     * @brief Подменю «Отметить по статусу» меню «Выбор».
+     *
+     * @~english
+     * @brief The submenu «Select by status» of Select menu.
+     */
+    QMenu *subSelectStatus;
+
     /**
      * @~russian
      * @brief Меню «Инструменты».
@@ -206,6 +228,24 @@ private:
      */
     QAction *actnFileAppendDirRecursively;
 
+    /**
+     * @~russian
+     * @brief Действие «Наблюдать за папкой» меню «Файл».
+     *
+     * @~english
+     * @brief Watch Directory action.
+     */
+    QAction *actnFileWatchDir;
+
+    /**
+     * @~russian
+     * @brief Действие «Прекратить наблюдение» меню «Файл».
+     *
+     * @~english
+     * @brief Stop Watching action.
+     */
+    QAction *actnFileStopWatching;
+
     /**
      * @~russian
      * @brief Действие «Очистить список файлов» меню «Файл».
@@ -269,6 +309,15 @@ private:
      */
     QAction *actnSelectInvertSelection;
 
+    /**
+     * @~russian
+     * @brief Действие «Отметить похожие книги» меню «Выбор».
+     *
+     * @~english
+     * @brief Select Similar Books action.
+     */
+    QAction *actnSelectSimilar;
+
     /**
      * @~russian
      * @brief Действие «Распаковать» меню «Инструменты».
@@ -287,6 +336,60 @@ private:
      */
     QAction *actnToolsCompress;
 
+    /**
+     * @~russian
+     * @brief Действие «Пакетное изменение метаданных» меню «Инструменты».
+     *
+     * @~english
+     * @brief Batch edit metadata of selected files action.
+     */
+    QAction *actnToolsBatchEdit;
+
+    /**
+     * @~russian
+     * @brief Действие «Перекодировать в UTF-8» меню «Инструменты».
+     *
+     * @~english
+     * @brief Convert to UTF-8 action of Tools menu.
+     */
+    QAction *actnToolsConvertUtf8;
+
+    /**
+     * @~russian
+     * @brief Действие «Оптимизировать изображения» меню «Инструменты».
+     *
+     * @~english
+     * @brief Optimize images action of Tools menu.
+     */
+    QAction *actnToolsOptimizeImages;
+
+    /**
+     * @~russian
+     * @brief Действие «Анализировать текст» меню «Инструменты».
+     *
+     * @~english
+     * @brief Analyze text action of Tools menu.
+     */
+    QAction *actnToolsAnalyzeText;
+
+    /**
+     * @~russian
+     * @brief Действие «Упаковать в общие архивы» меню «Инструменты».
+     *
+     * @~english
+     * @brief Repack Into Shared Archives action of Tools menu.
+     */
+    QAction *actnToolsRepack;
+
+    /**
+     * @~russian
+     * @brief Действие «Сохранить трассу...» меню «Инструменты».
+     *
+     * @~english
+     * @brief Export trace action of Tools menu.
+     */
+    QAction *actnToolsExportTrace;
+
     /**
      * @~russian
      * @brief Действие «Настройки» меню «Инструменты».
@@ -354,6 +457,33 @@ private:
      */
     QTextEdit *edtLog;
 
+    /**
+     * @~russian
+     * @brief Группы написаний авторов.
+     *
+     * @~english
+     * @brief Groups of author spellings.
+     */
+    QTreeWidget *treeAuthors;
+
+    /**
+     * @~russian
+     * @brief Статистика времени этапов обработки.
+     *
+     * @~english
+     * @brief Time statistics of processing phases.
+     */
+    QTreeWidget *treeStatistics;
+
+    /**
+     * @~russian
+     * @brief Отчет о последнем сканировании по папкам и типам файлов.
+     *
+     * @~english
+     * @brief Report of the last scan by folders and file types.
+     */
+    ScanReportWidget *wgtScanReport;
+
     /**
      * @~russian
      * @brief Рабочая директория.
@@ -376,6 +506,15 @@ private:
      */
     TableModel *mdlData;
 
+    /**
+     * @~russian
+     * @brief Наблюдатель за папкой, 0 - если наблюдение не ведется.
+     *
+     * @~english
+     * @brief Folder watcher, 0 if watching is not performed.
+     */
+    FolderWatcher *watcher;
+
     /**
      * @~russian
      * @brief Список внешних редакторов для отображения во всплывающем меню.
@@ -407,6 +546,37 @@ private:
      */
     int cntPreviousLoaded;
 
+    /**
+     * @~russian
+     * @brief Количество выполняющихся заданий.
+     *
+     * Курсор восстанавливается, только когда завершается последнее задание.
+     *
+     * @~english
+     * @brief Number of running jobs.
+     *
+     * The mouse pointer is restored only when the last job finishes.
+     */
+    int cntRunningJobs;
+
+    /**
+     * @~russian
+     * @brief Заполнение закладки групп авторов по текущему списку файлов.
+     *
+     * @~english
+     * @brief Filling the tab of author groups from the current file list.
+     */
+    void fillAuthorGroups();
+
+    /**
+     * @~russian
+     * @brief Заполнение закладки статистики по замерам этапов обработки.
+     *
+     * @~english
+     * @brief Filling the statistics tab from measurements of processing phases.
+     */
+    void fillStatistics();
+
     /**
      * @~russian
      * @brief Соединение сигналов потока чтения со слотами обработки.
@@ -470,12 +640,12 @@ public slots:
      * @~russian
      * @brief Обработчик начала длительной операции.
      *
-     * Переключает курсор для наглядности.
+     * Переключает курсор для наглядности при запуске первой из одновременно выполняющихся операций.
      *
      * @~english
      * @brief Handler beginning of a lengthy operation.
      *
-     * Switches mouse pointer for clarity.
+     * Switches mouse pointer for clarity when the first of simultaneously running operations starts.
      */
     void onBlockInput();
 
@@ -483,12 +653,12 @@ public slots:
      * @~russian
      * @brief Обработчик окончания длительной операции.
      *
-     * Переключает курсор для наглядности.
+     * Восстанавливает курсор, когда завершается последняя из одновременно выполняющихся операций.
      *
      * @~english
      * @brief Handler end of a lengthy operation.
      *
-     * Switches mouse pointer for clarity.
+     * Restores mouse pointer when the last of simultaneously running operations finishes.
      */
     void onUnblockInput();
 
@@ -510,6 +680,30 @@ public slots:
      */
     void onEndReading();
 
+    /**
+     * @~russian
+     * @brief Обработчик переключения закладок панели информации.
+     *
+     * Группы авторов и статистика строятся только при открытии их закладок.
+     * @param index Номер открытой закладки.
+     *
+     * @~english
+     * @brief Handler of switching tabs of information panel.
+     *
+     * Author groups and statistics are built only when their tabs are opened.
+     * @param index Number of the opened tab.
+     */
+    void onInfoTabChanged(int index);
+
+    /**
+     * @~russian
+     * @brief Обработчик завершения фонового задания, обновляет открытую закладку статистики.
+     *
+     * @~english
+     * @brief Handler of background job finish, updates the opened statistics tab.
+     */
+    void onJobFinished();
+
     /**
      * @~russian
      * @brief Обработчик установки количества выбранных записей в таблице.
@@ -521,6 +715,23 @@ public slots:
      */
     void onSetSelected(int count);
 
+    /**
+     * @~russian
+     * @brief Обработчик запуска фонового задания.
+     *
+     * Соединяет сигналы задания со слотами обработки, добавляет виджет состояния задания в строку состояния
+     * и запускает задание.
+     * @param job Указатель на задание.
+     *
+     * @~english
+     * @brief Handler of background job start.
+     *
+     * Connects signals of the job with handler slots, adds the job status widget to the status bar
+     * and starts the job.
+     * @param job Pointer to the job.
+     */
+    void onStartJob(Job *job);
+
 private slots:
 
     /**
@@ -550,6 +761,28 @@ private slots:
      */
     void onFileAppendDirRecursively();
 
+    /**
+     * @~russian
+     * @brief Обработчик действия «Наблюдать за папкой».
+     *
+     * Загружает файлы папки и ее подпапок и далее поддерживает таблицу в актуальном состоянии.
+     *
+     * @~english
+     * @brief Watch Directory action handler.
+     *
+     * Loads files of the folder and its subfolders and then keeps the table up to date.
+     */
+    void onFileWatchDir();
+
+    /**
+     * @~russian
+     * @brief Обработчик действия «Прекратить наблюдение».
+     *
+     * @~english
+     * @brief Stop Watching action handler.
+     */
+    void onFileStopWatching();
+
     /**
      * @~russian
      * @brief Обработчик действия «Очистить список файлов».
@@ -613,6 +846,15 @@ private slots:
      */
     void onToolsInplaceRename();
 
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Упаковать в общие архивы» меню «Инструменты».
+     *
+     * @~english
+     * @brief Handler for «Repack into shared archives» action of Tools menu.
+     */
+    void onToolsRepack();
+
     /**
      * @~russian
      * @brief Обработчик сигнала «Вызвать внешний редактор».
@@ -622,6 +864,46 @@ private slots:
      */
     void onToolsExternalEditor();
 
+    /**
+     * @~russian
+     * @brief Обработчик действия «Пакетное изменение метаданных».
+     *
+     * @~english
+     * @brief Batch edit metadata action handler.
+     */
+    void onToolsBatchEdit();
+
+    /**
+     * @~russian
+     * @brief Обработчик действия «Сохранить трассу...».
+     *
+     * Замеры этапов сохраняются в формате Chrome Trace для просмотра в chrome://tracing или Perfetto.
+     *
+     * @~english
+     * @brief Export trace action handler.
+     *
+     * Phase measurements are saved in Chrome Trace format for viewing in chrome://tracing or Perfetto.
+     */
+    void onToolsExportTrace();
+
+    /**
+     * @~russian
+     * @brief Обработчик действий подменю «Отметить по жанру» меню «Выбор».
+     *
+     * @~english
+     * @brief Handler for actions of «Select by genre» submenu of Select menu.
+     */
+    void onSelectGenreCategory();
+
+    /**
+     * @~russian
+     * @brief Обработчик действий подменю «Отметить по статусу» меню «Выбор».
+     *
+     * @~english
+     * @brief Handler for actions of «Select by status» submenu of Select menu.
+     */
+    void onSelectStatus();
+
     /**
      * @~russian
      * @brief Обработчик действия «Настройки».
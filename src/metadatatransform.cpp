@@ -0,0 +1,295 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации преобразований метаданных.
+ *
+ * @~english
+ * @brief Source file for metadata transformations.
+ */
+
+#include "metadatatransform.h"
+#include "filerecord.h"
+#include "person.h"
+#include "homoglyphfixer.h"
+
+#include <QCoreApplication>
+#include <QStringList>
+
+MetadataTransform::MetadataTransform(MetadataField field, TransformKind kind, const QString &pattern,
+                                     const QString &value)
+{
+    this->field = field;
+    this->kind = kind;
+    this->pattern = pattern;
+    this->value = value;
+
+    // Compiled once here, the transformation is then shared read-only by all worker threads
+    if (kind == tkRegExp)
+    {
+        regexp.setPattern(pattern);
+        regexp.optimize();
+    }
+}
+
+QString MetadataTransform::validate() const
+{
+    if ((kind == tkReplace) && pattern.isEmpty())
+        return QCoreApplication::translate("MetadataTransform", "Pattern is empty");
+
+    if ((kind == tkRegExp) && !regexp.isValid())
+        return QCoreApplication::translate("MetadataTransform", "Invalid regular expression \"%1\": %2")
+                .arg(pattern, regexp.errorString());
+
+    return QString();
+}
+
+bool MetadataTransform::apply(FileRecord &record) const
+{
+    switch (field)
+    {
+    case mfBookTitle:
+    {
+        QString title = record.getBookTitle();
+        QString changed = (kind == tkSet) ? value.trimmed() : transform(title);
+
+        if (changed == title)
+            return false;
+
+        record.setBookTitle(changed);
+        return true;
+    }
+
+    case mfAuthor:
+        return applyAuthors(record);
+
+    case mfSequence:
+    {
+        sequence_t sequences = record.getSequenceList();
+        sequence_t changed;
+
+        if (kind == tkSet)
+        {
+            QStringList items = value.split(';', QString::SkipEmptyParts);
+            QStringList::const_iterator it;
+
+            for (it = items.constBegin(); it != items.constEnd(); ++it)
+            {
+                QString name = (*it).section('#', 0, 0).trimmed();
+
+                if (!name.isEmpty())
+                    changed.append(qMakePair(name, (*it).section('#', 1).trimmed().toInt()));
+            }
+        }
+        else
+        {
+            // Only the name is transformed, the number in the series is kept
+            sequence_t::const_iterator it;
+
+            for (it = sequences.constBegin(); it != sequences.constEnd(); ++it)
+            {
+                QString name = transform((*it).first);
+
+                if (!name.isEmpty())
+                    changed.append(qMakePair(name, (*it).second));
+            }
+        }
+
+        if (changed == sequences)
+            return false;
+
+        record.setSequenceList(changed);
+        return true;
+    }
+
+    case mfGenre:
+    {
+        genre_t genres = record.getGenresList();
+        genre_t changed;
+
+        if (kind == tkSet)
+        {
+            QStringList items = value.split(';', QString::SkipEmptyParts);
+            QStringList::const_iterator it;
+
+            for (it = items.constBegin(); it != items.constEnd(); ++it)
+            {
+                if (!(*it).trimmed().isEmpty())
+                    changed.append(qMakePair((*it).trimmed(), 100));
+            }
+        }
+        else
+        {
+            genre_t::const_iterator it;
+
+            for (it = genres.constBegin(); it != genres.constEnd(); ++it)
+            {
+                QString name = transform((*it).first);
+
+                if (!name.isEmpty())
+                    changed.append(qMakePair(name, (*it).second));
+            }
+        }
+
+        if (changed == genres)
+            return false;
+
+        record.setGenresList(changed);
+        return true;
+    }
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+bool MetadataTransform::applyAll(const QVector<MetadataTransform> &transforms, FileRecord &record)
+{
+    bool changed = false;
+    QVector<MetadataTransform>::const_iterator it;
+
+    for (it = transforms.constBegin(); it != transforms.constEnd(); ++it)
+    {
+        if ((*it).apply(record))
+            changed = true;
+    }
+
+    return changed;
+}
+
+Person MetadataTransform::parseAuthor(const QString &name)
+{
+    QStringList parts = name.simplified().split(' ', QString::SkipEmptyParts);
+
+    if (parts.count() == 1)
+        return Person(parts.at(0));
+
+    Person author(parts.value(1), parts.value(0));
+
+    if (parts.count() > 2)
+        author.setMiddleName(parts.mid(2).join(' '));
+
+    return author;
+}
+
+QString MetadataTransform::transform(const QString &text) const
+{
+    switch (kind)
+    {
+    case tkSet:
+        return value;
+
+    case tkReplace:
+        return (text == pattern) ? value : text;
+
+    case tkRegExp:
+        return QString(text).replace(regexp, value);
+
+    case tkFixHomoglyphs:
+        return HomoglyphFixer::fix(text);
+
+    default:
+        break;
+    }
+
+    return text;
+}
+
+bool MetadataTransform::applyAuthors(FileRecord &record) const
+{
+    QVector<Person> authors;
+    bool changed = false;
+
+    if (kind == tkSet)
+    {
+        QStringList items = value.split(';', QString::SkipEmptyParts);
+        QStringList::const_iterator it;
+
+        for (it = items.constBegin(); it != items.constEnd(); ++it)
+        {
+            if (!(*it).trimmed().isEmpty())
+                authors.append(parseAuthor(*it));
+        }
+
+        changed = true;
+    }
+    else
+    {
+        for (int i = 0; i < record.getAuthorCount(); ++i)
+        {
+            Person author = record.getAuthor(i);
+
+            if (kind == tkReplace)
+            {
+                // Names are compared without the padding of empty parts
+                if (author.getFullNameLFM().simplified() == pattern.simplified())
+                {
+                    changed = true;
+
+                    if (value.trimmed().isEmpty())
+                        continue;
+
+                    Person replaced = parseAuthor(value);
+                    replaced.setId(author.getId());
+
+                    for (int j = 0; j < author.getHomePageCount(); ++j)
+                        replaced.addHomePage(author.getHomePageByNumber(j));
+
+                    for (int j = 0; j < author.getEmailCount(); ++j)
+                        replaced.addEmail(author.getEmailByNumber(j));
+
+                    author = replaced;
+                }
+            }
+            else
+            {
+                QString first = author.getFirstName();
+                QString middle = author.getMiddleName();
+                QString last = author.getLastName();
+                QString nick = author.getNickname();
+
+                author.setFirstName(transform(first));
+                author.setMiddleName(transform(middle));
+                author.setLastName(transform(last));
+                author.setNickname(transform(nick));
+
+                if ((author.getFirstName() != first) || (author.getMiddleName() != middle)
+                        || (author.getLastName() != last) || (author.getNickname() != nick))
+                    changed = true;
+            }
+
+            authors.append(author);
+        }
+    }
+
+    if (!changed)
+        return false;
+
+    record.clearAuthors();
+    QVector<Person>::const_iterator it;
+
+    for (it = authors.constBegin(); it != authors.constEnd(); ++it)
+        record.addAuthor(*it);
+
+    return true;
+}
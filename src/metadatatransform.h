@@ -0,0 +1,204 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef METADATATRANSFORM_H
+#define METADATATRANSFORM_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль преобразований метаданных для пакетного редактирования.
+ *
+ * @~english
+ * @brief Module of metadata transformations for batch editing.
+ */
+
+#include <QString>
+#include <QVector>
+#include <QRegularExpression>
+
+// Forward class declarations
+class FileRecord;
+class Person;
+
+/**
+ * @~russian
+ * @brief Перечисление изменяемых полей метаданных.
+ *
+ * @~english
+ * @brief Enumeration of changed metadata fields.
+ */
+enum MetadataField
+{
+    mfBookTitle, ///< @~russian Название книги. @~english Book title.
+    mfAuthor, ///< @~russian Авторы. @~english Authors.
+    mfSequence, ///< @~russian Серии. @~english Series.
+    mfGenre ///< @~russian Жанры. @~english Genres.
+};
+
+/**
+ * @~russian
+ * @brief Перечисление видов преобразования.
+ *
+ * @~english
+ * @brief Enumeration of transformation kinds.
+ */
+enum TransformKind
+{
+    tkSet, ///< @~russian Установка значения. @~english Setting the value.
+    tkReplace, ///< @~russian Замена совпадающего значения. @~english Replacing the equal value.
+    tkRegExp, ///< @~russian Замена по регулярному выражению. @~english Replacing by regular expression.
+    tkFixHomoglyphs ///< @~russian Исправление похожих букв кириллицы и латиницы. @~english Fixing look-alike Cyrillic and Latin letters.
+};
+
+/**
+ * @~russian
+ * @brief Преобразование одного поля метаданных записи.
+ *
+ * Установка (tkSet) заменяет поле целиком: несколько авторов, серий или жанров разделяются «;», авторы
+ * задаются в формате «Фамилия Имя Отчество», номер в серии указывается после «#». Замена (tkReplace)
+ * изменяет только значения, полностью совпадающие с образцом, авторы сравниваются по полному имени,
+ * пустое новое значение удаляет элемент списка. Регулярное выражение (tkRegExp) применяется к каждому
+ * значению поля, у авторов - к каждой части имени. Исправление похожих букв (tkFixHomoglyphs) применяется
+ * так же, как регулярное выражение, образец и новое значение не используются (см. HomoglyphFixer).
+ *
+ * @~english
+ * @brief Transformation of a single metadata field of the record.
+ *
+ * Setting (tkSet) replaces the whole field: several authors, series or genres are separated by ";",
+ * authors are given in "Last First Middle" format, the number in the series follows "#". Replacing (tkReplace)
+ * changes only the values fully equal to the pattern, authors are compared by the full name, an empty new value
+ * removes the list item. Regular expression (tkRegExp) is applied to every value of the field, for authors -
+ * to every part of the name. Fixing of look-alike letters (tkFixHomoglyphs) is applied the same way as
+ * the regular expression, the pattern and the new value are not used (see HomoglyphFixer).
+ */
+class MetadataTransform
+{
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param field Изменяемое поле.
+     * @param kind Вид преобразования.
+     * @param pattern Образец для замены или регулярное выражение, для установки не используется.
+     * @param value Новое значение или строка замены.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param field Changed field.
+     * @param kind Transformation kind.
+     * @param pattern Pattern to replace or regular expression, not used for setting.
+     * @param value New value or replacement string.
+     */
+    MetadataTransform(MetadataField field = mfBookTitle, TransformKind kind = tkSet,
+                      const QString &pattern = QString(), const QString &value = QString());
+
+    /**
+     * @~russian
+     * @brief Проверка корректности преобразования.
+     * @return Описание ошибки или пустая строка, если преобразование корректно.
+     *
+     * @~english
+     * @brief Validation of the transformation.
+     * @return Error description or empty string if the transformation is valid.
+     */
+    QString validate() const;
+
+    /**
+     * @~russian
+     * @brief Применение преобразования к записи.
+     * @param record Изменяемая запись.
+     * @return @c true - если запись изменилась;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Applying the transformation to the record.
+     * @param record Changed record.
+     * @return @c true - if the record changed;@n
+     * @c false - if not.
+     */
+    bool apply(FileRecord &record) const;
+
+    /**
+     * @~russian
+     * @brief Применение списка преобразований к записи по порядку.
+     * @param transforms Список преобразований.
+     * @param record Изменяемая запись.
+     * @return @c true - если запись изменилась;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Applying the list of transformations to the record in order.
+     * @param transforms List of transformations.
+     * @param record Changed record.
+     * @return @c true - if the record changed;@n
+     * @c false - if not.
+     */
+    static bool applyAll(const QVector<MetadataTransform> &transforms, FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Разбор автора из строки «Фамилия Имя Отчество».
+     * @param name Строка с именем.
+     * @return Запись об авторе, из одного слова получается псевдоним.
+     *
+     * @~english
+     * @brief Parsing the author from "Last First Middle" string.
+     * @param name String with the name.
+     * @return Author's record, a single word becomes a nickname.
+     */
+    static Person parseAuthor(const QString &name);
+
+private:
+    MetadataField field; ///< @~russian Изменяемое поле. @~english Changed field.
+    TransformKind kind; ///< @~russian Вид преобразования. @~english Transformation kind.
+    QString pattern; ///< @~russian Образец. @~english Pattern.
+    QString value; ///< @~russian Новое значение. @~english New value.
+    QRegularExpression regexp; ///< @~russian Скомпилированное выражение. @~english Compiled expression.
+
+    /**
+     * @~russian
+     * @brief Преобразование одного строкового значения.
+     * @param text Исходное значение.
+     * @return Новое значение.
+     *
+     * @~english
+     * @brief Transformation of a single string value.
+     * @param text Original value.
+     * @return New value.
+     */
+    QString transform(const QString &text) const;
+
+    /**
+     * @~russian
+     * @brief Применение преобразования к авторам записи.
+     * @param record Изменяемая запись.
+     * @return @c true - если авторы изменились;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Applying the transformation to the authors of the record.
+     * @param record Changed record.
+     * @return @c true - if the authors changed;@n
+     * @c false - if not.
+     */
+    bool applyAuthors(FileRecord &record) const;
+};
+
+#endif // METADATATRANSFORM_H
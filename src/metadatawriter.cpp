@@ -0,0 +1,1379 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для записи метаданных в файл книги.
+ *
+ * @~english
+ * @brief Source file for writing metadata to the book file.
+ */
+
+#include "metadatawriter.h"
+#include "filerecord.h"
+#include "person.h"
+#include "crc32.h"
+#include "cyrillicdecoder.h"
+#include "imageoptimizer.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QTextCodec>
+#include <QTextDecoder>
+#include <QRegularExpression>
+#include <QScopedPointer>
+#include <QDateTime>
+#include <QVector>
+#include <QtEndian>
+#include <QApplication>
+#include <QQueue>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+const int readChunkSize = 64 * 1024; // Size of the chunk of the copied file
+const int maxHeadSize = 16 * 1024 * 1024; // The description is searched only at the beginning of the book
+
+/*
+ * A tag found by XmlScanner.
+ */
+struct XmlTag
+{
+    enum Kind { Start, End, Empty, Other };
+
+    Kind kind;
+    int begin; // Position of '<'
+    int end; // Position after '>'
+    QByteArray name; // Qualified name, empty for comments, instructions and CDATA
+};
+
+/*
+ * Minimal scanner of XML tags in ASCII-compatible encodings. It knows only tag boundaries, quotes,
+ * comments, CDATA and processing instructions, which is enough to find element ranges without
+ * decoding and parsing the document.
+ */
+class XmlScanner
+{
+public:
+    explicit XmlScanner(const QByteArray &text, int pos = 0, int limit = -1)
+        : text(text)
+    {
+        this->pos = pos;
+        this->limit = (limit < 0) ? text.size() : limit;
+    }
+
+    // Returns false at the end of the text or on an incomplete tag
+    bool next(XmlTag &tag)
+    {
+        int begin = text.indexOf('<', pos);
+
+        if ((begin < 0) || (begin >= limit))
+            return false;
+
+        int end;
+        tag.begin = begin;
+        tag.kind = XmlTag::Other;
+        tag.name.clear();
+
+        if (startsWith(begin, "<!--"))
+        {
+            end = findEnd(begin + 4, "-->");
+        }
+        else
+            if (startsWith(begin, "<![CDATA["))
+            {
+                end = findEnd(begin + 9, "]]>");
+            }
+            else
+                if (startsWith(begin, "<?"))
+                {
+                    end = findEnd(begin + 2, "?>");
+                }
+                else
+                    if (startsWith(begin, "<!"))
+                    {
+                        end = findEnd(begin + 2, ">");
+                    }
+                    else
+                    {
+                        end = findTagEnd(begin + 1);
+
+                        if (end < 0)
+                            return false;
+
+                        int nameBegin = begin + 1;
+
+                        if (text.at(nameBegin) == '/')
+                        {
+                            tag.kind = XmlTag::End;
+                            nameBegin++;
+                        }
+                        else
+                            tag.kind = (text.at(end - 2) == '/') ? XmlTag::Empty : XmlTag::Start;
+
+                        int nameEnd = nameBegin;
+
+                        while ((nameEnd < end - 1) && (!isNameEnd(text.at(nameEnd))))
+                        {
+                            nameEnd++;
+                        }
+
+                        tag.name = text.mid(nameBegin, nameEnd - nameBegin);
+                    }
+
+        if ((end < 0) || (end > limit))
+            return false;
+
+        tag.end = end;
+        pos = end;
+        return true;
+    }
+
+    static QByteArray localName(const QByteArray &name)
+    {
+        int colon = name.indexOf(':');
+        return (colon < 0) ? name : name.mid(colon + 1);
+    }
+
+    static QByteArray prefix(const QByteArray &name)
+    {
+        int colon = name.indexOf(':');
+        return (colon < 0) ? QByteArray() : name.left(colon + 1);
+    }
+
+private:
+    const QByteArray &text;
+    int pos;
+    int limit;
+
+    bool startsWith(int pos, const char *str) const
+    {
+        return qstrncmp(text.constData() + pos, str, qstrlen(str)) == 0;
+    }
+
+    int findEnd(int from, const char *terminator) const
+    {
+        int found = text.indexOf(terminator, from);
+        return (found < 0) ? -1 : found + qstrlen(terminator);
+    }
+
+    int findTagEnd(int from) const
+    {
+        char quote = 0;
+
+        for (int i = from; i < text.size(); ++i)
+        {
+            char c = text.at(i);
+
+            if (quote)
+            {
+                if (c == quote)
+                    quote = 0;
+            }
+            else
+                if ((c == '"') || (c == '\''))
+                    quote = c;
+                else
+                    if (c == '>')
+                        return i + 1;
+        }
+
+        return -1;
+    }
+
+    static bool isNameEnd(char c)
+    {
+        return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '/') || (c == '>');
+    }
+};
+
+/*
+ * Search of the title-info element range in the beginning of the document. The document arrives in chunks,
+ * and each search resumes after the last complete tag, so the accumulated beginning is scanned only once.
+ */
+class TitleInfoLocator
+{
+public:
+    TitleInfoLocator()
+    {
+        pos = 0;
+        depth = 0;
+        begin = -1;
+        end = -1;
+    }
+
+    // Returns 1 if found, 0 if more data is needed, -1 if the document has no title-info
+    int locate(const QByteArray &head)
+    {
+        XmlScanner scanner(head, pos);
+        XmlTag tag;
+
+        while (scanner.next(tag))
+        {
+            QByteArray name = XmlScanner::localName(tag.name);
+            pos = tag.end;
+
+            if (begin < 0)
+            {
+                if ((tag.kind == XmlTag::Start) && (name == "title-info"))
+                {
+                    begin = tag.begin;
+                    depth = 1;
+                }
+                else
+                    if (((tag.kind == XmlTag::Start) || (tag.kind == XmlTag::Empty)) && (name == "body"))
+                        return -1;
+            }
+            else
+            {
+                if (tag.kind == XmlTag::Start)
+                    depth++;
+                else
+                    if (tag.kind == XmlTag::End)
+                    {
+                        depth--;
+
+                        if (depth == 0)
+                        {
+                            end = tag.end;
+                            return 1;
+                        }
+                    }
+            }
+        }
+
+        return 0;
+    }
+
+    int begin; // Position of the title-info start tag
+    int end; // Position after the title-info end tag
+
+private:
+    int pos; // End of the last complete tag
+    int depth;
+};
+
+/*
+ * Encoding of the text for the document: XML escaping and character references
+ * for the characters which the document encoding does not have.
+ */
+static QByteArray encodeText(const QString &text, QTextCodec *codec)
+{
+    QByteArray result;
+
+    for (int i = 0; i < text.size(); ++i)
+    {
+        QChar c = text.at(i);
+
+        switch (c.unicode())
+        {
+        case '&':
+            result += "&amp;";
+            continue;
+
+        case '<':
+            result += "&lt;";
+            continue;
+
+        case '>':
+            result += "&gt;";
+            continue;
+
+        case '"':
+            result += "&quot;";
+            continue;
+
+        default:
+            break;
+        }
+
+        QString symbol(c);
+
+        if (c.isHighSurrogate() && (i + 1 < text.size()))
+            symbol += text.at(++i);
+
+        if (codec->canEncode(symbol))
+            result += codec->fromUnicode(symbol);
+        else
+            result += "&#" + QByteArray::number(symbol.toUcs4().value(0)) + ";";
+    }
+
+    return result;
+}
+
+static QByteArray textElement(const QByteArray &name, const QString &text, QTextCodec *codec)
+{
+    return "<" + name + ">" + encodeText(text, codec) + "</" + name + ">";
+}
+
+/*
+ * Serialized elements of one kind replacing the original elements of this kind.
+ */
+struct TitleInfoGroup
+{
+    QByteArray name; // Local name of the elements
+    QVector<QByteArray> items;
+    bool replaced; // Original elements of a group which is not replaced are copied as is
+    bool emitted;
+};
+
+static QVector<TitleInfoGroup> makeGroups(const FileRecord &record, QTextCodec *codec, const QByteArray &prefix,
+        const QByteArray &indent, int replaced)
+{
+    QVector<TitleInfoGroup> groups(4);
+    QByteArray innerIndent = indent.isEmpty() ? QByteArray() : indent + "  ";
+
+    groups[0].name = "genre";
+    const genre_t &genres = record.getGenresList();
+    genre_t::const_iterator genre;
+
+    for (genre = genres.constBegin(); genre != genres.constEnd(); ++genre)
+    {
+        QByteArray item = "<" + prefix + "genre";
+
+        if ((*genre).second != 100)
+            item += " match=\"" + QByteArray::number((*genre).second) + "\"";
+
+        item += ">" + encodeText((*genre).first, codec) + "</" + prefix + "genre>";
+        groups[0].items.append(item);
+    }
+
+    groups[1].name = "author";
+
+    for (int i = 0; i < record.getAuthorCount(); ++i)
+    {
+        const Person &author = record.getAuthor(i);
+        QByteArray item = "<" + prefix + "author>";
+
+        if (!author.getFirstName().isEmpty())
+            item += innerIndent + textElement(prefix + "first-name", author.getFirstName(), codec);
+
+        if (!author.getMiddleName().isEmpty())
+            item += innerIndent + textElement(prefix + "middle-name", author.getMiddleName(), codec);
+
+        if (!author.getLastName().isEmpty())
+            item += innerIndent + textElement(prefix + "last-name", author.getLastName(), codec);
+
+        if (!author.getNickname().isEmpty())
+            item += innerIndent + textElement(prefix + "nickname", author.getNickname(), codec);
+
+        for (int j = 0; j < author.getHomePageCount(); ++j)
+        {
+            item += innerIndent + textElement(prefix + "home-page", author.getHomePageByNumber(j), codec);
+        }
+
+        for (int j = 0; j < author.getEmailCount(); ++j)
+        {
+            item += innerIndent + textElement(prefix + "email", author.getEmailByNumber(j), codec);
+        }
+
+        if (!author.getId().isEmpty())
+            item += innerIndent + textElement(prefix + "id", author.getId(), codec);
+
+        item += indent + "</" + prefix + "author>";
+        groups[1].items.append(item);
+    }
+
+    groups[2].name = "book-title";
+    groups[2].items.append(textElement(prefix + "book-title", record.getBookTitle(), codec));
+
+    groups[3].name = "sequence";
+    const sequence_t &sequences = record.getSequenceList();
+    sequence_t::const_iterator sequence;
+
+    for (sequence = sequences.constBegin(); sequence != sequences.constEnd(); ++sequence)
+    {
+        QByteArray item = "<" + prefix + "sequence name=\"" + encodeText((*sequence).first, codec) + "\"";
+
+        if ((*sequence).second != 0)
+            item += " number=\"" + QByteArray::number((*sequence).second) + "\"";
+
+        item += "/>";
+        groups[3].items.append(item);
+    }
+
+    const int flags[] = {MetadataWriter::tgGenres, MetadataWriter::tgAuthors, MetadataWriter::tgTitle,
+                         MetadataWriter::tgSequences
+                        };
+
+    for (int i = 0; i < groups.size(); ++i)
+    {
+        groups[i].replaced = (replaced & flags[i]) != 0;
+        groups[i].emitted = !groups.at(i).replaced;
+    }
+
+    return groups;
+}
+
+static void emitGroup(QByteArray &result, TitleInfoGroup &group, const QByteArray &firstIndent, const QByteArray &indent)
+{
+    for (int i = 0; i < group.items.size(); ++i)
+    {
+        result += (i == 0) ? firstIndent : indent;
+        result += group.items.at(i);
+    }
+
+    group.emitted = true;
+}
+
+static int groupIndex(const QVector<TitleInfoGroup> &groups, const QByteArray &name)
+{
+    for (int i = 0; i < groups.size(); ++i)
+    {
+        if (groups.at(i).name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+/*
+ * Comparison of the author fields written to the document.
+ */
+static bool isSameAuthor(const Person &a, const Person &b)
+{
+    if ((a.getFirstName() != b.getFirstName()) || (a.getMiddleName() != b.getMiddleName()) ||
+            (a.getLastName() != b.getLastName()) || (a.getNickname() != b.getNickname()) || (a.getId() != b.getId()) ||
+            (a.getHomePageCount() != b.getHomePageCount()) || (a.getEmailCount() != b.getEmailCount()))
+        return false;
+
+    for (int i = 0; i < a.getHomePageCount(); ++i)
+    {
+        if (a.getHomePageByNumber(i) != b.getHomePageByNumber(i))
+            return false;
+    }
+
+    for (int i = 0; i < a.getEmailCount(); ++i)
+    {
+        if (a.getEmailByNumber(i) != b.getEmailByNumber(i))
+            return false;
+    }
+
+    return true;
+}
+
+MetadataWriter::MetadataWriter(int level)
+{
+    this->level = level;
+    recode = false;
+    groups = tgAll;
+    optimizer = 0;
+}
+
+QString MetadataWriter::getError() const
+{
+    return error;
+}
+
+int MetadataWriter::changedGroups(const FileRecord &record, const FileRecord &original)
+{
+    int result = 0;
+
+    if (record.getGenresList() != original.getGenresList())
+        result |= tgGenres;
+
+    if (record.getAuthorCount() != original.getAuthorCount())
+        result |= tgAuthors;
+    else
+        for (int i = 0; i < record.getAuthorCount(); ++i)
+        {
+            if (!isSameAuthor(record.getAuthor(i), original.getAuthor(i)))
+            {
+                result |= tgAuthors;
+                break;
+            }
+        }
+
+    if (record.getBookTitle() != original.getBookTitle())
+        result |= tgTitle;
+
+    if (record.getSequenceList() != original.getSequenceList())
+        result |= tgSequences;
+
+    return result;
+}
+
+QByteArray MetadataWriter::replaceTitleInfo(const QByteArray &titleInfo, const FileRecord &record, QTextCodec *codec,
+        int groups)
+{
+    XmlScanner scanner(titleInfo);
+    XmlTag open;
+
+    if ((!scanner.next(open)) || (open.kind != XmlTag::Start))
+        return titleInfo;
+
+    // The closing tag is the last one, children are scanned before it
+    int close = titleInfo.lastIndexOf('<');
+    QByteArray prefix = XmlScanner::prefix(open.name);
+
+    QByteArray result = titleInfo.left(open.end);
+    QByteArray indent;
+    int depth = 0;
+    int last = open.end; // End of the last top-level child
+    int childBegin = -1;
+    XmlTag tag;
+    XmlScanner children(titleInfo, open.end, close);
+
+    // Indentation of children is taken from the text before the first child
+    {
+        XmlScanner first(titleInfo, open.end, close);
+
+        if (first.next(tag))
+            indent = titleInfo.mid(open.end, tag.begin - open.end);
+
+        if (indent.trimmed().size() > 0)
+            indent.clear();
+    }
+
+    QVector<TitleInfoGroup> items = makeGroups(record, codec, prefix, indent, groups);
+    int groupBookTitle = groupIndex(items, "book-title");
+
+    while (children.next(tag))
+    {
+        if (depth == 0)
+            childBegin = tag.begin;
+
+        if (tag.kind == XmlTag::Start)
+            depth++;
+        else
+            if (tag.kind == XmlTag::End)
+                depth--;
+
+        if (depth > 0)
+            continue;
+
+        if (tag.kind == XmlTag::Other)
+        {
+            // Comments between children are kept
+            result += titleInfo.mid(last, tag.end - last);
+            last = tag.end;
+            continue;
+        }
+
+        QByteArray gap = titleInfo.mid(last, childBegin - last);
+        QByteArray name = XmlScanner::localName(tag.name);
+        int current = groupIndex(items, name);
+
+        // Genres, authors and the title precede all other elements, missing ones are inserted before them
+        int precede = (current < 0) ? groupBookTitle + 1 : current;
+
+        for (int i = 0; i < precede; ++i)
+        {
+            if (!items.at(i).emitted)
+                emitGroup(result, items[i], indent, indent);
+        }
+
+        if ((current < 0) || (!items.at(current).replaced))
+        {
+            result += gap + titleInfo.mid(childBegin, tag.end - childBegin);
+        }
+        else
+            if (!items.at(current).emitted)
+            {
+                emitGroup(result, items[current], gap, indent);
+            }
+
+        // The other elements of a replaced group are dropped with their indentation
+        last = tag.end;
+    }
+
+    for (int i = 0; i < items.size(); ++i)
+    {
+        if (!items.at(i).emitted)
+            emitGroup(result, items[i], indent, indent);
+    }
+
+    result += titleInfo.mid(last);
+    return result;
+}
+
+/*
+ * Receiver of the spliced document.
+ */
+class MetadataSink
+{
+public:
+    virtual ~MetadataSink() {}
+    virtual bool write(const char *data, qint64 size) = 0;
+};
+
+/*
+ * Writing of the document as is.
+ */
+class PlainSink : public MetadataSink
+{
+public:
+    explicit PlainSink(QIODevice *device)
+    {
+        this->device = device;
+    }
+
+    bool write(const char *data, qint64 size)
+    {
+        return device->write(data, size) == size;
+    }
+
+private:
+    QIODevice *device;
+};
+
+/*
+ * Streaming compression of the document into the zip entry data.
+ */
+class DeflateSink : public MetadataSink
+{
+public:
+    DeflateSink(QIODevice *device, int level)
+    {
+        this->device = device;
+        crc = MZ_CRC32_INIT;
+        size = 0;
+        compressedSize = 0;
+        failed = false;
+
+        // The compressor state is about 300 KB, too much for the stack
+        compressor = new tdefl_compressor;
+        tdefl_init(compressor, putBuffer, this, tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY));
+    }
+
+    ~DeflateSink()
+    {
+        delete compressor;
+    }
+
+    bool write(const char *data, qint64 size)
+    {
+        crc = Crc32::update(crc, reinterpret_cast<const uchar *>(data), size);
+        this->size += size;
+
+        return (tdefl_compress_buffer(compressor, data, size, TDEFL_NO_FLUSH) == TDEFL_STATUS_OKAY) && (!failed);
+    }
+
+    bool finish()
+    {
+        return (tdefl_compress_buffer(compressor, 0, 0, TDEFL_FINISH) == TDEFL_STATUS_DONE) && (!failed);
+    }
+
+    quint32 crc;
+    qint64 size;
+    qint64 compressedSize;
+
+private:
+    QIODevice *device;
+    tdefl_compressor *compressor;
+    bool failed;
+
+    static mz_bool putBuffer(const void *buffer, int length, void *user)
+    {
+        DeflateSink *sink = static_cast<DeflateSink *>(user);
+
+        if (sink->device->write(static_cast<const char *>(buffer), length) != length)
+        {
+            sink->failed = true;
+            return MZ_FALSE;
+        }
+
+        sink->compressedSize += length;
+        return MZ_TRUE;
+    }
+};
+
+/*
+ * Processing of the document passing through the writer in chunks.
+ */
+class DocumentFilter
+{
+public:
+    virtual ~DocumentFilter() {}
+    virtual bool feed(const char *data, qint64 size) = 0;
+    virtual bool finish() = 0;
+
+    QString error;
+};
+
+/*
+ * Codec of the document encoding. A document without the declaration is in UTF-8,
+ * for an encoding unknown to Qt 0 is returned: writing it in another encoding would corrupt the book.
+ */
+static QTextCodec *documentCodec(const QString &encoding)
+{
+    if (encoding.isEmpty())
+        return QTextCodec::codecForName("UTF-8");
+
+    return QTextCodec::codecForName(encoding.toLatin1());
+}
+
+/*
+ * The document passes through the splicer in chunks. The beginning is kept until the end of title-info is found,
+ * then it is written with the replaced title-info and all further data goes to the sink directly.
+ */
+class MetadataSplicer : public DocumentFilter
+{
+public:
+    MetadataSplicer(const FileRecord &record, int groups, MetadataSink *sink)
+        : record(record)
+    {
+        this->groups = groups;
+        this->sink = sink;
+        spliced = false;
+        failed = false;
+    }
+
+    bool feed(const char *data, qint64 size)
+    {
+        if (failed)
+            return false;
+
+        if (spliced)
+            return sink->write(data, size);
+
+        head.append(data, size);
+
+        int found = locator.locate(head);
+
+        if ((found < 0) || ((found == 0) && (head.size() > maxHeadSize)))
+        {
+            error = qApp->tr("Book description is not found");
+            failed = true;
+            return false;
+        }
+
+        if (found == 0)
+            return true;
+
+        QTextCodec *codec = documentCodec(record.getEncoding());
+
+        if (!codec)
+        {
+            error = qApp->tr("Unknown encoding %1").arg(record.getEncoding());
+            failed = true;
+            return false;
+        }
+
+        int begin = locator.begin;
+        int end = locator.end;
+        QByteArray titleInfo = MetadataWriter::replaceTitleInfo(head.mid(begin, end - begin), record, codec, groups);
+
+        spliced = true;
+        failed = !(sink->write(head.constData(), begin) && sink->write(titleInfo.constData(), titleInfo.size()) &&
+                   sink->write(head.constData() + end, head.size() - end));
+        head.clear();
+
+        if (failed)
+            error = qApp->tr("Write error");
+
+        return !failed;
+    }
+
+    bool finish()
+    {
+        if ((!spliced) && (!failed))
+        {
+            error = qApp->tr("Book description is not found");
+            failed = true;
+        }
+
+        return !failed;
+    }
+
+private:
+    const FileRecord &record;
+    int groups; // Groups of title-info to replace
+    MetadataSink *sink;
+    TitleInfoLocator locator;
+    QByteArray head;
+    bool spliced;
+    bool failed;
+};
+
+/*
+ * Conversion of the document to UTF-8. Windows-1251 and koi8-r are decoded by the table, other encodings
+ * by the stateful decoder of the codec, so multibyte characters may be split between chunks.
+ * The encoding in XML declaration is replaced, the rest of the text is only recoded.
+ */
+class Utf8Recoder : public DocumentFilter
+{
+public:
+    Utf8Recoder(const QString &encoding, MetadataSink *sink)
+    {
+        this->sink = sink;
+        declared = false;
+        failed = false;
+        decoder = 0;
+        codePage = CyrillicDecoder::codePageForName(encoding.toLatin1());
+
+        if (codePage == CyrillicDecoder::cpNone)
+        {
+            QTextCodec *codec = documentCodec(encoding);
+
+            if (codec)
+                decoder = codec->makeDecoder();
+            else
+            {
+                error = qApp->tr("Unknown encoding %1").arg(encoding);
+                failed = true;
+            }
+        }
+    }
+
+    ~Utf8Recoder()
+    {
+        delete decoder;
+    }
+
+    bool feed(const char *data, qint64 size)
+    {
+        if (failed)
+            return false;
+
+        QString text = decoder ? decoder->toUnicode(data, size) : CyrillicDecoder::decode(data, size, codePage);
+
+        if (!declared)
+        {
+            head.append(text);
+
+            // Wait for the end of the declaration, a document without it is passed as is
+            if ((head.indexOf("?>") < 0) && (head.size() < maxDeclarationLength))
+                return true;
+
+            return putHead();
+        }
+
+        return put(text);
+    }
+
+    bool finish()
+    {
+        if (failed)
+            return false;
+
+        if ((!declared) && (!putHead()))
+            return false;
+
+        return !failed;
+    }
+
+private:
+    static const int maxDeclarationLength = 1024;
+
+    MetadataSink *sink;
+    QTextDecoder *decoder;
+    CyrillicDecoder::CodePage codePage;
+    QString head;
+    bool declared;
+    bool failed;
+
+    bool putHead()
+    {
+        declared = true;
+
+        if (head.startsWith(QChar(0xFEFF)))
+            head.remove(0, 1);
+
+        int end = head.indexOf("?>");
+
+        if (head.startsWith("<?xml") && (end > 0))
+        {
+            QRegularExpression encoding("encoding\\s*=\\s*([\"'])[^\"']*\\1");
+            QString declaration = head.left(end);
+            declaration.replace(encoding, "encoding=\"utf-8\"");
+            head.replace(0, end, declaration);
+        }
+
+        bool result = put(head);
+        head.clear();
+        return result;
+    }
+
+    bool put(const QString &text)
+    {
+        QByteArray bytes = text.toUtf8();
+
+        if (!sink->write(bytes.constData(), bytes.size()))
+        {
+            error = qApp->tr("Write error");
+            failed = true;
+        }
+
+        return !failed;
+    }
+};
+
+/*
+ * Recompression of images in binary sections. The text between the sections goes to the sink as is, each section
+ * is optimized in the global thread pool, and the results are written in the document order as soon as they are
+ * ready, so the images of one book are recompressed in parallel.
+ */
+class ImageRecompressor : public DocumentFilter
+{
+public:
+    ImageRecompressor(const ImageOptimizer &optimizer, ImageOptimizer::Statistics &statistics, MetadataSink *sink)
+        : optimizer(optimizer), statistics(statistics)
+    {
+        this->sink = sink;
+        inside = false;
+        failed = false;
+        scanned = 0;
+        running = 0;
+    }
+
+    ~ImageRecompressor()
+    {
+        // Tasks refer to the optimizer, so they must be finished even after an error
+        QQueue<Piece>::iterator it;
+
+        for (it = pieces.begin(); it != pieces.end(); ++it)
+        {
+            if ((*it).image)
+                (*it).result.waitForFinished();
+        }
+    }
+
+    bool feed(const char *data, qint64 size)
+    {
+        if (failed)
+            return false;
+
+        buffer.append(data, size);
+        int position = 0;
+
+        for (;;)
+        {
+            if (!inside)
+            {
+                int begin = findOpening(position);
+
+                if (begin < 0)
+                {
+                    // The end of the buffer may be the beginning of a split tag
+                    int rest = qMax(position, buffer.size() - openingTag.size());
+                    put(buffer.mid(position, rest - position));
+                    position = rest;
+                    break;
+                }
+
+                put(buffer.mid(position, begin - position));
+                position = begin;
+                scanned = begin;
+                inside = true;
+            }
+
+            int end = buffer.indexOf(closingTag, scanned);
+
+            if (end < 0)
+            {
+                // Long sections come in many chunks, so the text already scanned is not searched again
+                scanned = qMax(position, buffer.size() - closingTag.size() + 1);
+                break;
+            }
+
+            end += closingTag.size();
+            schedule(buffer.mid(position, end - position));
+            position = end;
+            inside = false;
+        }
+
+        buffer.remove(0, position);
+        scanned -= position;
+        return flush(false);
+    }
+
+    bool finish()
+    {
+        // An unclosed section is left as is
+        put(buffer);
+        buffer.clear();
+        return flush(true);
+    }
+
+private:
+    /*
+     * A part of the document: either the text or the section being optimized.
+     */
+    struct Piece
+    {
+        bool image;
+        QByteArray text;
+        QFuture<ImageOptimizer::Result> result;
+    };
+
+    static const QByteArray openingTag;
+    static const QByteArray closingTag;
+
+    const ImageOptimizer &optimizer;
+    ImageOptimizer::Statistics &statistics;
+    MetadataSink *sink;
+    QByteArray buffer;
+    QQueue<Piece> pieces;
+    bool inside;
+    bool failed;
+    int scanned;
+    int running;
+
+    int findOpening(int from) const
+    {
+        int begin;
+
+        while ((begin = buffer.indexOf(openingTag, from)) >= 0)
+        {
+            int next = begin + openingTag.size();
+
+            // The character after the name is not received yet
+            if (next >= buffer.size())
+                return -1;
+
+            char c = buffer.at(next);
+
+            if ((c == '>') || (c == '/') || (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'))
+                return begin;
+
+            from = begin + 1;
+        }
+
+        return -1;
+    }
+
+    void put(const QByteArray &text)
+    {
+        if (text.isEmpty())
+            return;
+
+        // The text is written directly until a section is waiting before it
+        if (pieces.isEmpty())
+        {
+            write(text);
+            return;
+        }
+
+        Piece piece;
+        piece.image = false;
+        piece.text = text;
+        pieces.enqueue(piece);
+    }
+
+    void schedule(const QByteArray &element)
+    {
+        // The number of sections in memory is limited, the oldest one is awaited
+        if (running >= 2 * QThreadPool::globalInstance()->maxThreadCount())
+            flush(true, 1);
+
+        Piece piece;
+        piece.image = true;
+        piece.result = QtConcurrent::run(&optimizer, &ImageOptimizer::optimizeBinary, element);
+        pieces.enqueue(piece);
+        ++running;
+    }
+
+    bool flush(bool wait, int count = -1)
+    {
+        while ((!pieces.isEmpty()) && (count != 0))
+        {
+            Piece &piece = pieces.head();
+
+            if (piece.image)
+            {
+                if ((!wait) && (!piece.result.isFinished()))
+                    break;
+
+                ImageOptimizer::Result result = piece.result.result();
+                statistics.add(result.statistics);
+                write(result.element);
+                --running;
+                --count;
+            }
+            else
+                write(piece.text);
+
+            pieces.dequeue();
+        }
+
+        return !failed;
+    }
+
+    void write(const QByteArray &data)
+    {
+        if ((!failed) && (!sink->write(data.constData(), data.size())))
+        {
+            error = qApp->tr("Write error");
+            failed = true;
+        }
+    }
+};
+
+const QByteArray ImageRecompressor::openingTag("<binary");
+const QByteArray ImageRecompressor::closingTag("</binary>");
+
+static DocumentFilter *createFilter(const FileRecord &record, int groups, MetadataSink *sink, bool recode,
+                                    const ImageOptimizer *optimizer, ImageOptimizer::Statistics &statistics)
+{
+    if (optimizer)
+        return new ImageRecompressor(*optimizer, statistics, sink);
+
+    if (recode)
+        return new Utf8Recoder(record.getEncoding(), sink);
+
+    return new MetadataSplicer(record, groups, sink);
+}
+
+static size_t feedFilter(void *opaque, mz_uint64 offset, const void *buffer, size_t size)
+{
+    Q_UNUSED(offset)
+    DocumentFilter *filter = static_cast<DocumentFilter *>(opaque);
+    return filter->feed(static_cast<const char *>(buffer), size) ? size : 0;
+}
+
+static void writeLe16(QByteArray &data, quint16 value)
+{
+    uchar buffer[2];
+    qToLittleEndian(value, buffer);
+    data.append(reinterpret_cast<const char *>(buffer), 2);
+}
+
+static void writeLe32(QByteArray &data, quint32 value)
+{
+    uchar buffer[4];
+    qToLittleEndian(value, buffer);
+    data.append(reinterpret_cast<const char *>(buffer), 4);
+}
+
+bool MetadataWriter::write(const FileRecord &record, const FileRecord &original)
+{
+    error.clear();
+    recode = false;
+    optimizer = 0;
+    groups = changedGroups(record, original);
+
+    if (groups == 0)
+        return true;
+
+    if (record.isArchive())
+        return writeArchive(record);
+
+    return writePlain(record);
+}
+
+bool MetadataWriter::convertToUtf8(const FileRecord &record)
+{
+    error.clear();
+    recode = true;
+    optimizer = 0;
+
+    if (record.isArchive())
+        return writeArchive(record);
+
+    return writePlain(record);
+}
+
+bool MetadataWriter::optimizeImages(const FileRecord &record, const ImageOptimizer &optimizer)
+{
+    error.clear();
+    recode = false;
+    this->optimizer = &optimizer;
+    imageStatistics = ImageOptimizer::Statistics();
+
+    bool result = record.isArchive() ? writeArchive(record) : writePlain(record);
+    this->optimizer = 0;
+    return result;
+}
+
+const ImageOptimizer::Statistics &MetadataWriter::getImageStatistics() const
+{
+    return imageStatistics;
+}
+
+bool MetadataWriter::writePlain(const FileRecord &record)
+{
+    QFile source(record.getFileName());
+    QSaveFile target(record.getFileName());
+
+    if (!source.open(QFile::ReadOnly))
+    {
+        error = qApp->tr("Cannot open file %1").arg(record.getFileName());
+        return false;
+    }
+
+    if (!target.open(QFile::WriteOnly))
+    {
+        error = qApp->tr("Cannot create file %1").arg(target.fileName());
+        return false;
+    }
+
+    PlainSink sink(&target);
+    QScopedPointer<DocumentFilter> filter(createFilter(record, groups, &sink, recode, optimizer, imageStatistics));
+    QByteArray buffer;
+
+    while (!source.atEnd())
+    {
+        buffer = source.read(readChunkSize);
+
+        if (buffer.isEmpty() || (!filter->feed(buffer.constData(), buffer.size())))
+            break;
+    }
+
+    if ((!source.atEnd()) || (!filter->finish()))
+    {
+        error = filter->error.isEmpty() ? qApp->tr("Error reading the file %1").arg(record.getFileName()) : filter->error;
+        target.cancelWriting();
+        return false;
+    }
+
+    source.close();
+
+    // A book without replaced images is left untouched
+    if (optimizer && (imageStatistics.recompressed == 0))
+    {
+        target.cancelWriting();
+        return true;
+    }
+
+    if (!target.commit())
+    {
+        error = qApp->tr("Cannot replace file %1").arg(record.getFileName());
+        return false;
+    }
+
+    return true;
+}
+
+bool MetadataWriter::writeArchive(const FileRecord &record)
+{
+    mz_zip_archive archive;
+    memset(&archive, 0, sizeof(archive));
+
+    if (!mz_zip_reader_init_file(&archive, QFile::encodeName(record.getFileName()).constData(), 0))
+    {
+        error = qApp->tr("Cannot open archive %1").arg(record.getFileName());
+        return false;
+    }
+
+    mz_zip_archive_file_stat file_stat;
+
+    if ((mz_zip_reader_get_num_files(&archive) != 1) || (!mz_zip_reader_file_stat(&archive, 0, &file_stat)))
+    {
+        mz_zip_reader_end(&archive);
+        error = qApp->tr("The archive %1 more than one file, or no files in the archive").arg(record.getFileName());
+        return false;
+    }
+
+    QSaveFile target(record.getFileName());
+
+    if (!target.open(QFile::WriteOnly))
+    {
+        mz_zip_reader_end(&archive);
+        error = qApp->tr("Cannot create file %1").arg(target.fileName());
+        return false;
+    }
+
+    QByteArray entryName(file_stat.m_filename);
+    // The name encoding flag of the source entry is kept, the data descriptor flag is always set
+    quint16 flags = (file_stat.m_bit_flag & 0x0800) | 0x0008;
+    QDateTime now = QDateTime::currentDateTime();
+    quint16 dosTime = (now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2);
+    quint16 dosDate = ((now.date().year() - 1980) << 9) | (now.date().month() << 5) | now.date().day();
+
+    // Sizes and checksum are unknown until the end of the stream, so they follow the data in the data descriptor
+    QByteArray header;
+    writeLe32(header, 0x04034b50); // Local file header signature
+    writeLe16(header, 20); // Version needed to extract
+    writeLe16(header, flags);
+    writeLe16(header, MZ_DEFLATED);
+    writeLe16(header, dosTime);
+    writeLe16(header, dosDate);
+    writeLe32(header, 0); // CRC-32
+    writeLe32(header, 0); // Compressed size
+    writeLe32(header, 0); // Uncompressed size
+    writeLe16(header, entryName.size());
+    writeLe16(header, 0); // Extra field length
+    header.append(entryName);
+
+    bool succeeded = (target.write(header) == header.size());
+
+    DeflateSink sink(&target, level);
+    QScopedPointer<DocumentFilter> filter(createFilter(record, groups, &sink, recode, optimizer, imageStatistics));
+
+    // The archive is inflated by parts into the filter, the whole book is never in memory
+    succeeded = succeeded && mz_zip_reader_extract_to_callback(&archive, 0, feedFilter, filter.data(), 0);
+    mz_zip_reader_end(&archive);
+
+    succeeded = succeeded && filter->finish() && sink.finish();
+
+    if ((!succeeded) || (sink.size > 0xFFFFFFFFLL) || (sink.compressedSize > 0xFFFFFFFFLL))
+    {
+        error = filter->error.isEmpty() ? qApp->tr("Error extracting file %2 from archive %1").arg(record.getFileName(),
+                QString::fromLocal8Bit(entryName)) : filter->error;
+        target.cancelWriting();
+        return false;
+    }
+
+    if (optimizer && (imageStatistics.recompressed == 0))
+    {
+        target.cancelWriting();
+        return true;
+    }
+
+    QByteArray trailer;
+    writeLe32(trailer, 0x08074b50); // Data descriptor signature
+    writeLe32(trailer, sink.crc);
+    writeLe32(trailer, sink.compressedSize);
+    writeLe32(trailer, sink.size);
+
+    quint32 centralOffset = header.size() + sink.compressedSize + 16;
+    QByteArray central;
+    writeLe32(central, 0x02014b50); // Central directory header signature
+    writeLe16(central, file_stat.m_version_made_by);
+    writeLe16(central, 20); // Version needed to extract
+    writeLe16(central, flags);
+    writeLe16(central, MZ_DEFLATED);
+    writeLe16(central, dosTime);
+    writeLe16(central, dosDate);
+    writeLe32(central, sink.crc);
+    writeLe32(central, sink.compressedSize);
+    writeLe32(central, sink.size);
+    writeLe16(central, entryName.size());
+    writeLe16(central, 0); // Extra field length
+    writeLe16(central, 0); // Comment length
+    writeLe16(central, 0); // Disk number
+    writeLe16(central, file_stat.m_internal_attr);
+    writeLe32(central, file_stat.m_external_attr);
+    writeLe32(central, 0); // Offset of the local header
+    central.append(entryName);
+
+    trailer.append(central);
+    writeLe32(trailer, 0x06054b50); // End of central directory signature
+    writeLe16(trailer, 0); // Disk number
+    writeLe16(trailer, 0); // Disk with the central directory
+    writeLe16(trailer, 1); // Entries on this disk
+    writeLe16(trailer, 1); // Total entries
+    writeLe32(trailer, central.size());
+    writeLe32(trailer, centralOffset);
+    writeLe16(trailer, 0); // Comment length
+
+    if ((target.write(trailer) != trailer.size()) || (!target.commit()))
+    {
+        error = qApp->tr("Cannot replace file %1").arg(record.getFileName());
+        return false;
+    }
+
+    return true;
+}
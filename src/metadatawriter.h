@@ -0,0 +1,258 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef METADATAWRITER_H
+#define METADATAWRITER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль записи метаданных в файл книги.
+ *
+ * @~english
+ * @brief Module of writing metadata to the book file.
+ */
+
+#include <QString>
+#include <QByteArray>
+
+#include "imageoptimizer.h"
+
+// Forward class declarations
+class FileRecord;
+class QTextCodec;
+
+/**
+ * @~russian
+ * @brief Запись измененных метаданных в файл книги.
+ *
+ * Файл не разбирается целиком: в начале файла находится диапазон байт элемента @c title-info,
+ * в нем заменяются только измененные группы элементов, хранящихся в записи (жанры, авторы, название, серии),
+ * неизмененные группы и остальные элементы (аннотация, дата, обложка и т.д.) переносятся байт в байт.
+ * Неизмененные начало и конец файла копируются потоком, в памяти хранится только описание книги.@n
+ * Архив .fb2.zip распаковывается и сжимается заново тоже потоком, поэтому расход памяти не зависит
+ * от размера книги. Результат записывается во временный файл, который атомарно заменяет исходный.
+ *
+ * @~english
+ * @brief Writing changed metadata to the book file.
+ *
+ * The file is not parsed entirely: the byte range of @c title-info element is located at the beginning
+ * of the file, and only the changed groups of elements kept in the record (genres, authors, title, series)
+ * are replaced in it, unchanged groups and the other elements (annotation, date, coverpage, etc.) are carried
+ * over byte for byte. The unchanged beginning and end of the file are copied by streaming, only the book
+ * description is kept in memory.@n
+ * The .fb2.zip archive is also unpacked and compressed again by streaming, so memory usage does not depend
+ * on the book size. The result is written to a temporary file which atomically replaces the original.
+ */
+class MetadataWriter
+{
+public:
+    /**
+     * @~russian
+     * @brief Группы элементов @c title-info, хранящиеся в записи.
+     *
+     * @~english
+     * @brief Groups of @c title-info elements kept in the record.
+     */
+    enum TitleGroup
+    {
+        tgGenres = 0x01, ///< @~russian Жанры. @~english Genres.
+        tgAuthors = 0x02, ///< @~russian Авторы. @~english Authors.
+        tgTitle = 0x04, ///< @~russian Название. @~english Title.
+        tgSequences = 0x08, ///< @~russian Серии. @~english Series.
+        tgAll = 0x0F ///< @~russian Все группы. @~english All groups.
+    };
+
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param level Уровень сжатия архивов от 1 (быстрое) до 9 (наилучшее).
+     *
+     * @~english
+     * @brief Constructor.
+     * @param level Compression level of archives from 1 (fast) to 9 (best).
+     */
+    explicit MetadataWriter(int level = 9);
+
+    /**
+     * @~russian
+     * @brief Запись метаданных в файл записи.
+     *
+     * Переписываются только группы элементов, отличающиеся от исходной записи. Если изменений нет,
+     * файл не перезаписывается.
+     * @param record Запись с измененными метаданными.
+     * @param original Запись в том виде, в котором она прочитана из файла.
+     * @return @c true - если запись прошла успешно;@n
+     * @c false - если нет, исходный файл при этом не изменяется.
+     *
+     * @~english
+     * @brief Writing metadata to the file of the record.
+     *
+     * Only the groups of elements differing from the original record are rewritten. If there are no changes,
+     * the file is not rewritten.
+     * @param record Record with changed metadata.
+     * @param original Record as it was read from the file.
+     * @return @c true - if writing succeeded;@n
+     * @c false - if not, the original file is not changed in this case.
+     */
+    bool write(const FileRecord &record, const FileRecord &original);
+
+    /**
+     * @~russian
+     * @brief Перекодирование файла записи в UTF-8.
+     *
+     * Книга проходит через перекодировщик потоком, в объявлении XML кодировка заменяется на @c utf-8.
+     * @param record Запись о файле, кодировка берется из записи.
+     * @return @c true - если перекодирование прошло успешно;@n
+     * @c false - если нет, исходный файл при этом не изменяется.
+     *
+     * @~english
+     * @brief Recoding the file of the record to UTF-8.
+     *
+     * The book streams through the recoder, the encoding in XML declaration is replaced with @c utf-8.
+     * @param record File record, the encoding is taken from the record.
+     * @return @c true - if recoding succeeded;@n
+     * @c false - if not, the original file is not changed in this case.
+     */
+    bool convertToUtf8(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Пережатие изображений в файле записи.
+     *
+     * Книга проходит через оптимизатор потоком, разделы @c binary пережимаются параллельно в общем пуле потоков.
+     * Если ни одно изображение не заменено, файл не перезаписывается.
+     * @param record Запись о файле.
+     * @param optimizer Оптимизатор изображений.
+     * @return @c true - если обработка прошла успешно;@n
+     * @c false - если нет, исходный файл при этом не изменяется.
+     *
+     * @~english
+     * @brief Recompression of images in the file of the record.
+     *
+     * The book streams through the optimizer, the @c binary sections are recompressed in parallel in the global
+     * thread pool. If no image is replaced, the file is not rewritten.
+     * @param record File record.
+     * @param optimizer Image optimizer.
+     * @return @c true - if processing succeeded;@n
+     * @c false - if not, the original file is not changed in this case.
+     */
+    bool optimizeImages(const FileRecord &record, const ImageOptimizer &optimizer);
+
+    /**
+     * @~russian
+     * @brief Получение статистики последнего пережатия изображений.
+     * @return Статистика изображений.
+     *
+     * @~english
+     * @brief Getting statistics of the last image recompression.
+     * @return Image statistics.
+     */
+    const ImageOptimizer::Statistics &getImageStatistics() const;
+
+    /**
+     * @~russian
+     * @brief Получение описания последней ошибки.
+     * @return Описание ошибки.
+     *
+     * @~english
+     * @brief Getting description of the last error.
+     * @return Error description.
+     */
+    QString getError() const;
+
+    /**
+     * @~russian
+     * @brief Определение групп элементов, в которых записи различаются.
+     * @param record Запись с измененными метаданными.
+     * @param original Исходная запись.
+     * @return Комбинация значений TitleGroup.
+     *
+     * @~english
+     * @brief Determining the groups of elements in which the records differ.
+     * @param record Record with changed metadata.
+     * @param original Original record.
+     * @return Combination of TitleGroup values.
+     */
+    static int changedGroups(const FileRecord &record, const FileRecord &original);
+
+    /**
+     * @~russian
+     * @brief Замена элементов записи внутри элемента @c title-info.
+     *
+     * Элементы групп, не указанных в @a groups, копируются байт в байт.
+     * @param titleInfo Исходный элемент @c title-info целиком, в кодировке документа.
+     * @param record Запись с метаданными.
+     * @param codec Кодировка документа.
+     * @param groups Заменяемые группы элементов, комбинация значений TitleGroup.
+     * @return Новый элемент @c title-info в кодировке документа.
+     *
+     * @~english
+     * @brief Replacing elements of the record inside @c title-info element.
+     *
+     * Elements of groups not specified in @a groups are copied byte for byte.
+     * @param titleInfo Entire original @c title-info element, in the document encoding.
+     * @param record Record with metadata.
+     * @param codec Document encoding.
+     * @param groups Replaced groups of elements, combination of TitleGroup values.
+     * @return New @c title-info element in the document encoding.
+     */
+    static QByteArray replaceTitleInfo(const QByteArray &titleInfo, const FileRecord &record, QTextCodec *codec,
+                                       int groups = tgAll);
+
+private:
+    int level; ///< @~russian Уровень сжатия. @~english Compression level.
+    bool recode; ///< @~russian Перекодирование в UTF-8 вместо записи метаданных. @~english Recoding to UTF-8 instead of writing metadata.
+    int groups; ///< @~russian Заменяемые группы элементов @c title-info. @~english Replaced groups of @c title-info elements.
+    const ImageOptimizer *optimizer; ///< @~russian Оптимизатор изображений вместо записи метаданных. @~english Image optimizer instead of writing metadata.
+    ImageOptimizer::Statistics imageStatistics; ///< @~russian Статистика изображений. @~english Image statistics.
+    QString error; ///< @~russian Описание последней ошибки. @~english Description of the last error.
+
+    /**
+     * @~russian
+     * @brief Запись метаданных в несжатый файл.
+     * @param record Запись с метаданными.
+     * @return @c true - если запись прошла успешно;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Writing metadata to the uncompressed file.
+     * @param record Record with metadata.
+     * @return @c true - if writing succeeded;@n
+     * @c false - if not.
+     */
+    bool writePlain(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Запись метаданных в архив.
+     * @param record Запись с метаданными.
+     * @return @c true - если запись прошла успешно;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Writing metadata to the archive.
+     * @param record Record with metadata.
+     * @return @c true - if writing succeeded;@n
+     * @c false - if not.
+     */
+    bool writeArchive(const FileRecord &record);
+};
+
+#endif // METADATAWRITER_H
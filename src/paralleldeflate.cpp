@@ -0,0 +1,229 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для параллельного сжатия больших файлов.
+ *
+ * @~english
+ * @brief Source file for parallel compression of large files.
+ */
+
+#include "paralleldeflate.h"
+#include "crc32.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QVector>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QRunnable>
+
+/*
+ * One block of the source data and the result of its compression.
+ */
+struct DeflateBlock
+{
+    const mz_uint8 *dict; // The end of the previous block, primes the dictionary
+    mz_uint dictSize;
+    const mz_uint8 *data;
+    mz_uint size;
+    bool last; // Only the last block is finished, the others end with a sync flush
+    QByteArray output;
+    quint32 crc;
+    bool succeeded;
+};
+
+static mz_bool putBuffer(const void *buffer, int length, void *user)
+{
+    static_cast<QByteArray *>(user)->append(static_cast<const char *>(buffer), length);
+    return MZ_TRUE;
+}
+
+/*
+ * Puts the dictionary into the freshly initialized compressor as if it had just compressed it:
+ * the window contains the dictionary and the hash chains point to its positions. This is what
+ * deflateSetDictionary() does in zlib, tdefl has no public API for it.
+ */
+static void primeDictionary(tdefl_compressor *d, const mz_uint8 *dict, mz_uint size)
+{
+    if (size > TDEFL_LZ_DICT_SIZE)
+    {
+        dict += size - TDEFL_LZ_DICT_SIZE;
+        size = TDEFL_LZ_DICT_SIZE;
+    }
+
+    if (size < TDEFL_MIN_MATCH_LEN)
+        return;
+
+    memcpy(d->m_dict, dict, size);
+    // The window is followed by a copy of its beginning, so matches may be compared without wrapping
+    memcpy(d->m_dict + TDEFL_LZ_DICT_SIZE, d->m_dict, TDEFL_MAX_MATCH_LEN - 1);
+
+    d->m_lookahead_pos = size;
+    d->m_dict_size = size;
+    d->m_lz_code_buf_dict_pos = size;
+
+    // The hash of a position is inserted when its third byte is read, so the last two positions
+    // of the dictionary are inserted by the compressor itself together with the first bytes of the block
+#if MINIZ_USE_UNALIGNED_LOADS_AND_STORES && MINIZ_LITTLE_ENDIAN
+
+    if (((d->m_flags & TDEFL_MAX_PROBES_MASK) == 1) &&
+            ((d->m_flags & TDEFL_GREEDY_PARSING_FLAG) != 0) &&
+            ((d->m_flags & (TDEFL_FILTER_MATCHES | TDEFL_FORCE_ALL_RAW_BLOCKS | TDEFL_RLE_MATCHES)) == 0))
+    {
+        // Hashing of the fast level 1 parser, which keeps only the last position of each trigram
+        for (mz_uint pos = 0; pos + 2 < size; ++pos)
+        {
+            mz_uint trigram = dict[pos] | (dict[pos + 1] << 8) | (dict[pos + 2] << 16);
+            mz_uint hash = (trigram ^ (trigram >> (24 - (TDEFL_LZ_HASH_BITS - 8)))) & TDEFL_LEVEL1_HASH_SIZE_MASK;
+            d->m_hash[hash] = (mz_uint16)pos;
+        }
+
+        return;
+    }
+
+#endif
+
+    for (mz_uint pos = 0; pos + 2 < size; ++pos)
+    {
+        mz_uint hash = ((dict[pos] << (TDEFL_LZ_HASH_SHIFT * 2)) ^ (dict[pos + 1] << TDEFL_LZ_HASH_SHIFT) ^ dict[pos + 2]) &
+                       (TDEFL_LZ_HASH_SIZE - 1);
+        d->m_next[pos & TDEFL_LZ_DICT_SIZE_MASK] = d->m_hash[hash];
+        d->m_hash[hash] = (mz_uint16)pos;
+    }
+}
+
+/*
+ * Compression of one block in the thread of the global pool.
+ */
+class DeflateTask : public QRunnable
+{
+public:
+    DeflateTask(DeflateBlock *block, mz_uint flags, QSemaphore *done)
+    {
+        this->block = block;
+        this->flags = flags;
+        this->done = done;
+    }
+
+    void run()
+    {
+        block->crc = Crc32::update(MZ_CRC32_INIT, block->data, block->size);
+
+        // The compressor state is about 300 KB, too much for the stack of a pool thread
+        tdefl_compressor *compressor = new tdefl_compressor;
+
+        block->output.reserve(block->size / 2);
+        block->succeeded = (tdefl_init(compressor, putBuffer, &block->output, flags) == TDEFL_STATUS_OKAY);
+
+        if (block->succeeded)
+        {
+            primeDictionary(compressor, block->dict, block->dictSize);
+
+            tdefl_status status = tdefl_compress_buffer(compressor, block->data, block->size,
+                                  block->last ? TDEFL_FINISH : TDEFL_SYNC_FLUSH);
+            block->succeeded = (status == (block->last ? TDEFL_STATUS_DONE : TDEFL_STATUS_OKAY));
+        }
+
+        delete compressor;
+        done->release();
+    }
+
+private:
+    DeflateBlock *block;
+    mz_uint flags;
+    QSemaphore *done;
+};
+
+ParallelDeflate::ParallelDeflate(int level)
+{
+    this->level = level;
+    crc = MZ_CRC32_INIT;
+}
+
+bool ParallelDeflate::compressBuffer(const QByteArray &data)
+{
+    result.clear();
+    crc = MZ_CRC32_INIT;
+
+    const mz_uint8 *source = reinterpret_cast<const mz_uint8 *>(data.constData());
+    int count = qMax(1, (data.size() + blockSize - 1) / blockSize);
+    mz_uint flags = tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY);
+
+    QVector<DeflateBlock> blocks(count);
+    QSemaphore done;
+
+    for (int i = 0; i < count; ++i)
+    {
+        DeflateBlock &block = blocks[i];
+        int offset = i * blockSize;
+
+        block.data = source + offset;
+        block.size = qMin(blockSize, data.size() - offset);
+        block.dictSize = qMin(offset, (int)TDEFL_LZ_DICT_SIZE);
+        block.dict = block.data - block.dictSize;
+        block.last = (i == count - 1);
+        block.crc = MZ_CRC32_INIT;
+        block.succeeded = false;
+    }
+
+    // Tasks are started after the vector is filled, it must not be reallocated while they run
+    for (int i = 0; i < count; ++i)
+    {
+        QThreadPool::globalInstance()->start(new DeflateTask(&blocks[i], flags, &done));
+    }
+
+    done.acquire(count);
+
+    int size = 0;
+    QVector<DeflateBlock>::const_iterator it;
+
+    for (it = blocks.constBegin(); it != blocks.constEnd(); ++it)
+    {
+        if (!(*it).succeeded)
+            return false;
+
+        size += (*it).output.size();
+    }
+
+    result.reserve(size);
+
+    for (it = blocks.constBegin(); it != blocks.constEnd(); ++it)
+    {
+        result.append((*it).output);
+        crc = Crc32::combine(crc, (*it).crc, (*it).size);
+    }
+
+    return true;
+}
+
+const QByteArray &ParallelDeflate::getResult() const
+{
+    return result;
+}
+
+quint32 ParallelDeflate::getCrc32() const
+{
+    return crc;
+}
@@ -0,0 +1,120 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef PARALLELDEFLATE_H
+#define PARALLELDEFLATE_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль параллельного сжатия больших файлов.
+ *
+ * @~english
+ * @brief Module of parallel compression of large files.
+ */
+
+#include <QByteArray>
+#include <QtGlobal>
+
+/**
+ * @~russian
+ * @brief Параллельное сжатие одного большого буфера в один поток deflate.
+ *
+ * Данные делятся на блоки фиксированного размера, которые сжимаются независимо в потоках глобального пула.
+ * Словарь каждого блока заполняется последними 32 КБ предыдущего блока, поэтому степень сжатия почти
+ * не отличается от последовательного сжатия. Блоки завершаются синхронизирующим сбросом (выравнивание
+ * на границу байта без признака последнего блока), поэтому их простое объединение является корректным
+ * потоком deflate. Контрольная сумма CRC32 считается для каждого блока отдельно и затем объединяется.
+ *
+ * @~english
+ * @brief Parallel compression of one large buffer into one deflate stream.
+ *
+ * The data is split into fixed-size blocks which are compressed independently in the threads of the global pool.
+ * The dictionary of each block is primed with the last 32 KB of the previous block, so the compression ratio
+ * is almost the same as with sequential compression. Blocks end with a sync flush (byte alignment
+ * without the final block flag), so their plain concatenation is a valid deflate stream.
+ * The CRC32 checksum is calculated for each block separately and then combined.
+ */
+class ParallelDeflate
+{
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param level Уровень сжатия от 0 до 10.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param level Compression level from 0 to 10.
+     */
+    explicit ParallelDeflate(int level = 9);
+
+    /**
+     * @~russian
+     * @brief Сжатие буфера.
+     * @param data Исходные данные.
+     * @return @c true - если сжатие прошло успешно;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Compressing the buffer.
+     * @param data Source data.
+     * @return @c true - if compression succeeded;@n
+     * @c false - if not.
+     */
+    bool compressBuffer(const QByteArray &data);
+
+    /**
+     * @~russian
+     * @brief Получение сжатых данных (поток deflate без заголовка zlib).
+     * @return Сжатые данные.
+     *
+     * @~english
+     * @brief Getting compressed data (deflate stream without zlib header).
+     * @return Compressed data.
+     */
+    const QByteArray &getResult() const;
+
+    /**
+     * @~russian
+     * @brief Получение контрольной суммы CRC32 исходных данных.
+     * @return Контрольная сумма.
+     *
+     * @~english
+     * @brief Getting CRC32 checksum of the source data.
+     * @return Checksum.
+     */
+    quint32 getCrc32() const;
+
+    /**
+     * @~russian
+     * @brief Размер блока, сжимаемого одним потоком.
+     *
+     * @~english
+     * @brief Size of the block compressed by one thread.
+     */
+    static const int blockSize = 128 * 1024;
+
+private:
+    int level; ///< @~russian Уровень сжатия. @~english Compression level.
+    QByteArray result; ///< @~russian Сжатые данные. @~english Compressed data.
+    quint32 crc; ///< @~russian Контрольная сумма исходных данных. @~english Checksum of the source data.
+};
+
+#endif // PARALLELDEFLATE_H
@@ -19,72 +19,194 @@
 
 #include "person.h"
 
-Person::Person()
+/**
+ * @~russian
+ * @brief Разделяемые данные описания автора.
+ *
+ * @~english
+ * @brief Shared data of the author description.
+ */
+class PersonData : public QSharedData
+{
+public:
+    /**
+     * @~russian
+     * @brief Имя.
+     *
+     * Один, обязателен при отсутствии <nickname>, иначе опционально.
+     *
+     * @~english
+     * @brief First name.
+     *
+     * One required in the absence of <nickname>, otherwise optional.
+     */
+    QString first_name;
+
+    /**
+     * @~russian
+     * @brief Отчество.
+     *
+     * Один, опционально.
+     *
+     * @~english
+     * @brief Middle name.
+     *
+     * One, optional.
+     */
+    QString middle_name;
+
+    /**
+     * @~russian
+     * @brief Фамилия.
+     *
+     * Один, обязателен при отсутствии <nickname>, иначе опционально.
+     *
+     * @~english
+     * @brief Last name.
+     *
+     * One required in the absence of <nickname>, otherwise optional.
+     */
+    QString last_name;
+
+    /**
+     * @~russian
+     * @brief Псевдоним.
+     *
+     * Один, обязателен при отсутствии <first-name> и <last-name>, иначе опционально.
+     *
+     * @~english
+     * @brief Nickname.
+     *
+     * One required in the absence of mandatory <first-name> and <last-name>, otherwise optional.
+     */
+    QString nickname;
+
+    /**
+     * @~russian
+     * @brief Домашняя страница.
+     *
+     * Любое количество, опционально.
+     *
+     * @~english
+     * @brief Home page.
+     *
+     * Any number, optional.
+     */
+    QVector<QString> home_page;
+
+    /**
+     * @~russian
+     * @brief E-Mail.
+     *
+     * Любое количество, опционально.
+     *
+     * @~english
+     * @brief E-mail.
+     *
+     * Any number, optional.
+     */
+    QVector<QString> email;
+
+    /**
+     * @~russian
+     * @brief Идентификатор автора.
+     *
+     * Один, опционально. Назначается библиотекой.
+     *
+     * @~english
+     * @brief The author identifier.
+     *
+     * One, optional. Assigned from library.
+     */
+    QString id;
+};
+
+Person::Person() :
+    d(new PersonData)
+{
+
+}
+
+Person::Person(const QString &firstName, const QString &lastName) :
+    d(new PersonData)
+{
+    d->first_name = firstName;
+    d->last_name = lastName;
+}
+
+Person::Person(const QString &nickName) :
+    d(new PersonData)
+{
+    d->nickname = nickName;
+}
+
+Person::Person(const Person &other) :
+    d(other.d)
 {
 
 }
 
-Person::Person(QString firstName, QString lastName)
+Person::~Person()
 {
-    first_name = firstName;
-    last_name = lastName;
+
 }
 
-Person::Person(QString nickName)
+Person &Person::operator=(const Person &other)
 {
-    nickname = nickName;
+    d = other.d;
+    return *this;
 }
 
-bool Person::isCorrect()
+bool Person::isCorrect() const
 {
-    return (((!first_name.isEmpty()) && (!last_name.isEmpty())) || (!nickname.isEmpty()));
+    return (((!d->first_name.isEmpty()) && (!d->last_name.isEmpty())) || (!d->nickname.isEmpty()));
 }
 
-QString Person::getFullNameLFM()
+QString Person::getFullNameLFM() const
 {
-    return QString("%1 %2 %3").arg(last_name, first_name, middle_name);
+    return QString("%1 %2 %3").arg(d->last_name, d->first_name, d->middle_name);
 }
 
-QString Person::getFullNameFML()
+QString Person::getFullNameFML() const
 {
-    return QString("%1 %2 %3").arg(first_name, middle_name, last_name);
+    return QString("%1 %2 %3").arg(d->first_name, d->middle_name, d->last_name);
 }
 
-void Person::setFirstName(QString firstName)
+void Person::setFirstName(const QString &firstName)
 {
-    first_name = firstName;
+    d->first_name = firstName;
 }
 
-QString Person::getFirstName()
+const QString &Person::getFirstName() const
 {
-    return first_name;
+    return d->first_name;
 }
 
-void Person::setMiddleName(QString middleName)
+void Person::setMiddleName(const QString &middleName)
 {
-    middle_name = middleName;
+    d->middle_name = middleName;
 }
 
-QString Person::getMiddleName()
+const QString &Person::getMiddleName() const
 {
-    return middle_name;
+    return d->middle_name;
 }
 
-void Person::setLastName(QString lastName)
+void Person::setLastName(const QString &lastName)
 {
-    last_name = lastName;
+    d->last_name = lastName;
 }
 
-QString Person::getLastName()
+const QString &Person::getLastName() const
 {
-    return last_name;
+    return d->last_name;
 }
 
 QString Person::getFirstLetterOfLastName() const
 {
-    if (last_name.size() > 0)
+    if (d->last_name.size() > 0)
     {
-        return last_name.at(0);
+        return d->last_name.at(0);
     }
     else
     {
@@ -92,62 +214,62 @@ QString Person::getFirstLetterOfLastName() const
     }
 }
 
-void Person::setNickname(QString nickName)
+void Person::setNickname(const QString &nickName)
 {
-    nickname = nickName;
+    d->nickname = nickName;
 }
 
-QString Person::getNickname()
+const QString &Person::getNickname() const
 {
-    return nickname;
+    return d->nickname;
 }
 
-void Person::addHomePage(QString homePage)
+void Person::addHomePage(const QString &homePage)
 {
-    home_page.append(homePage);
+    d->home_page.append(homePage);
 }
 
-int Person::getHomePageCount()
+int Person::getHomePageCount() const
 {
-    return home_page.count();
+    return d->home_page.count();
 }
 
-QString Person::getHomePageByNumber(int number)
+const QString &Person::getHomePageByNumber(int number) const
 {
-    return home_page.at(number);
+    return d->home_page.at(number);
 }
 
-QVector<QString> Person::getHomePageAll()
+const QVector<QString> &Person::getHomePageAll() const
 {
-    return home_page;
+    return d->home_page;
 }
 
-void Person::addEmail(QString eMail)
+void Person::addEmail(const QString &eMail)
 {
-    email.append(eMail);
+    d->email.append(eMail);
 }
 
-int Person::getEmailCount()
+int Person::getEmailCount() const
 {
-    return email.count();
+    return d->email.count();
 }
 
-QString Person::getEmailByNumber(int number)
+const QString &Person::getEmailByNumber(int number) const
 {
-    return email.at(number);
+    return d->email.at(number);
 }
 
-QVector<QString> Person::getEmailAll()
+const QVector<QString> &Person::getEmailAll() const
 {
-    return email;
+    return d->email;
 }
 
-void Person::setId(QString Id)
+void Person::setId(const QString &Id)
 {
-    id = Id;
+    d->id = Id;
 }
 
-QString Person::getId()
+const QString &Person::getId() const
 {
-    return id;
+    return d->id;
 }
@@ -31,19 +31,25 @@
 
 #include <QString>
 #include <QVector>
+#include <QSharedDataPointer>
+
+// Forward class declarations
+class PersonData;
 
 /**
  * @~russian
  * @brief Класс описания автора.
  *
  * Содержит информацию об авторе книги, документа и т.п., заданную в соответствии со спецификацией формата.
- * Не является независимым классом, а лишь составной частью записи метаданных.
+ * Не является независимым классом, а лишь составной частью записи метаданных.@n
+ * Данные разделяются неявно, поэтому передача описания по значению стоит лишь изменения счетчика ссылок.
  *
  * @~english
  * @brief Person description class.
  *
  * It contains information about the author of the book, file, etc., accordingly the format specification.
- * It is not an independent class, but merely part of the metadata records.
+ * It is not an independent class, but merely part of the metadata records.@n
+ * The data is implicitly shared, so passing the description by value costs only a reference count change.
  */
 class Person
 {
@@ -66,7 +72,7 @@ public:
      * @~english
      * @brief Class constructor.
      */
-    Person(QString firstName, QString lastName);
+    Person(const QString &firstName, const QString &lastName);
 
     /**
      * @~russian
@@ -77,7 +83,81 @@ public:
      * @~english
      * @brief Class constructor.
      */
-    Person(QString nickName);
+    Person(const QString &nickName);
+
+    /**
+     * @~russian
+     * @brief Конструктор копирования.
+     *
+     * Данные не копируются, а разделяются до первого изменения одной из копий.
+     * @param other Копируемая запись.
+     *
+     * @~english
+     * @brief Copy constructor.
+     *
+     * The data is not copied but shared until one of the copies is changed.
+     * @param other Copied record.
+     */
+    Person(const Person &other);
+
+#ifdef Q_COMPILER_RVALUE_REFS
+    /**
+     * @~russian
+     * @brief Конструктор перемещения.
+     * @param other Перемещаемая запись.
+     *
+     * @~english
+     * @brief Move constructor.
+     * @param other Moved record.
+     */
+    Person(Person &&other) Q_DECL_NOTHROW : d(std::move(other.d)) {}
+
+    /**
+     * @~russian
+     * @brief Оператор перемещающего присваивания.
+     * @param other Перемещаемая запись.
+     * @return Ссылка на эту запись.
+     *
+     * @~english
+     * @brief Move assignment operator.
+     * @param other Moved record.
+     * @return Reference to this record.
+     */
+    Person &operator=(Person &&other) Q_DECL_NOTHROW { swap(other); return *this; }
+#endif
+
+    /**
+     * @~russian
+     * @brief Деструктор.
+     *
+     * @~english
+     * @brief Destructor.
+     */
+    ~Person();
+
+    /**
+     * @~russian
+     * @brief Оператор присваивания.
+     * @param other Присваиваемая запись.
+     * @return Ссылка на эту запись.
+     *
+     * @~english
+     * @brief Assignment operator.
+     * @param other Assigned record.
+     * @return Reference to this record.
+     */
+    Person &operator=(const Person &other);
+
+    /**
+     * @~russian
+     * @brief Обмен данными с другой записью.
+     * @param other Другая запись.
+     *
+     * @~english
+     * @brief Swapping data with another record.
+     * @param other Another record.
+     */
+    void swap(Person &other) Q_DECL_NOTHROW { d.swap(other.d); }
 
     /**
      * @~russian
@@ -94,7 +174,7 @@ public:
      * @c true - in the absence of errors, @n
      * @c false - in the case of non-compliance recording specification.
      */
-    bool isCorrect();
+    bool isCorrect() const;
 
     /**
      * @~russian
@@ -109,7 +189,7 @@ public:
      * Author's name, in order Surname - Name - Middle name.
      * @return Full name.
      */
-    QString getFullNameLFM();
+    QString getFullNameLFM() const;
 
     /**
      * @~russian
@@ -124,7 +204,7 @@ public:
      * Author's name, in order Name - Middle name - Surname.
      * @return Full name.
      */
-    QString getFullNameFML();
+    QString getFullNameFML() const;
 
     /**
      * @~russian
@@ -135,7 +215,7 @@ public:
      * @brief Set first name of the author.
      * @param firstName First name.
      */
-    void setFirstName(QString firstName);
+    void setFirstName(const QString &firstName);
 
     /**
      * @~russian
@@ -146,7 +226,7 @@ public:
      * @brief Get first name of the author.
      * @return First name.
      */
-    QString getFirstName();
+    const QString &getFirstName() const;
 
     /**
      * @~russian
@@ -157,7 +237,7 @@ public:
      * @brief Set middle name of the author.
      * @param middleName Middle name.
      */
-    void setMiddleName(QString middleName);
+    void setMiddleName(const QString &middleName);
 
     /**
      * @~russian
@@ -168,7 +248,7 @@ public:
      * @brief Get middle name of the author.
      * @return Middle name.
      */
-    QString getMiddleName();
+    const QString &getMiddleName() const;
 
     /**
      * @~russian
@@ -179,7 +259,7 @@ public:
      * @brief Set last name of the author.
      * @param lastName Last name.
      */
-    void setLastName(QString lastName);
+    void setLastName(const QString &lastName);
 
     /**
      * @~russian
@@ -190,7 +270,7 @@ public:
      * @brief Get last name of the author.
      * @return Last name.
      */
-    QString getLastName();
+    const QString &getLastName() const;
 
     /**
      * @~russian
@@ -212,7 +292,7 @@ public:
      * @brief Set nickname of the author.
      * @param nickName Nickname.
      */
-    void setNickname(QString nickName);
+    void setNickname(const QString &nickName);
 
     /**
      * @~russian
@@ -223,7 +303,7 @@ public:
      * @brief Get nickname of the author.
      * @return Nickname.
      */
-    QString getNickname();
+    const QString &getNickname() const;
 
     /**
      * @~russian
@@ -234,7 +314,7 @@ public:
      * @brief Adding the author's home page.
      * @param homePage Home page.
      */
-    void addHomePage(QString homePage);
+    void addHomePage(const QString &homePage);
 
     /**
      * @~russian
@@ -245,7 +325,7 @@ public:
      * @brief Getting the total number of home pages of the author.
      * @return The number of home pages.
      */
-    int getHomePageCount();
+    int getHomePageCount() const;
 
     /**
      * @~russian
@@ -258,7 +338,7 @@ public:
      * @param number Home page number in the list.
      * @return Home page.
      */
-    QString getHomePageByNumber(int number);
+    const QString &getHomePageByNumber(int number) const;
 
     /**
      * @~russian
@@ -269,7 +349,7 @@ public:
      * @brief Getting all home pages.
      * @return The list of home pages.
      */
-    QVector<QString> getHomePageAll();
+    const QVector<QString> &getHomePageAll() const;
 
     /**
      * @~russian
@@ -280,7 +360,7 @@ public:
      * @brief Adding e-mail the author.
      * @param eMail E-mail address.
      */
-    void addEmail(QString eMail);
+    void addEmail(const QString &eMail);
 
     /**
      * @~russian
@@ -291,7 +371,7 @@ public:
      * @brief Getting the total number of e-mail addresses of the author.
      * @return The number of addresses.
      */
-    int getEmailCount();
+    int getEmailCount() const;
 
     /**
      * @~russian
@@ -304,7 +384,7 @@ public:
      * @param number Number of e-mail addresses on the list.
      * @return E-mail address.
      */
-    QString getEmailByNumber(int number);
+    const QString &getEmailByNumber(int number) const;
 
     /**
      * @~russian
@@ -315,7 +395,7 @@ public:
      * @brief getEmailAll
      * @return
      */
-    QVector<QString> getEmailAll();
+    const QVector<QString> &getEmailAll() const;
 
     /**
      * @~russian
@@ -326,7 +406,7 @@ public:
      * @brief Set ID of the author.
      * @param Id ID.
      */
-    void setId(QString Id);
+    void setId(const QString &Id);
 
     /**
      * @~russian
@@ -337,99 +417,20 @@ public:
      * @brief Get ID of the author.
      * @return ID.
      */
-    QString getId();
-private:
-
-    /**
-     * @~russian
-     * @brief Имя.
-     *
-     * Один, обязателен при отсутствии <nickname>, иначе опционально.
-     *
-     * @~english
-     * @brief First name.
-     *
-     * One required in the absence of <nickname>, otherwise optional.
-     */
-    QString first_name;
-
-    /**
-     * @~russian
-     * @brief Отчество.
-     *
-     * Один, опционально.
-     *
-     * @~english
-     * @brief Middle name.
-     *
-     * One, optional.
-     */
-    QString middle_name;
-
-    /**
-     * @~russian
-     * @brief Фамилия.
-     *
-     * Один, обязателен при отсутствии <nickname>, иначе опционально.
-     *
-     * @~english
-     * @brief Last name.
-     *
-     * One required in the absence of <nickname>, otherwise optional.
-     */
-    QString last_name;
-
-    /**
-     * @~russian
-     * @brief Псевдоним.
-     *
-     * Один, обязателен при отсутствии <first-name> и <last-name>, иначе опционально.
-     *
-     * @~english
-     * @brief Nickname.
-     *
-     * One required in the absence of mandatory <first-name> and <last-name>, otherwise optional.
-     */
-    QString nickname;
-
-    /**
-     * @~russian
-     * @brief Домашняя страница.
-     *
-     * Любое количество, опционально.
-     *
-     * @~english
-     * @brief Home page.
-     *
-     * Any number, optional.
-     */
-    QVector<QString> home_page;
-
-    /**
-     * @~russian
-     * @brief E-Mail.
-     *
-     * Любое количество, опционально.
-     *
-     * @~english
-     * @brief E-mail.
-     *
-     * Any number, optional.
-     */
-    QVector<QString> email;
+    const QString &getId() const;
 
+private:
     /**
      * @~russian
-     * @brief Идентификатор автора.
-     *
-     * Один, опционально. Назначается библиотекой.
+     * @brief Разделяемые данные описания.
      *
      * @~english
-     * @brief The author identifier.
-     *
-     * One, optional. Assigned from library.
+     * @brief Shared data of the description.
      */
-    QString id;
+    QSharedDataPointer<PersonData> d;
 };
 
+// The record holds only a pointer to the shared data, so containers may relocate it by memcpy
+Q_DECLARE_SHARED(Person)
+
 #endif // PERSON_H
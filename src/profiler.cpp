@@ -0,0 +1,372 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include "profiler.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadStorage>
+#include <QAtomicInt>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSaveFile>
+
+#include <string.h>
+
+namespace
+{
+
+// Histogram buckets: 16 linear sub-buckets for each power of two, values below 16 ns have own buckets
+const int subBits = 4;
+const int subCount = 1 << subBits;
+const int bucketCount = (64 - subBits + 1) * subCount;
+const int maxEvents = 1000000;
+const int eventBlock = 4096; // Events reserved by a thread at once from the common limit
+
+struct TraceEvent
+{
+    qint64 start;
+    qint64 duration;
+    quintptr thread;
+    int phase;
+};
+
+struct PhaseData
+{
+    qint64 count;
+    qint64 total;
+    qint64 max;
+    quint32 buckets[bucketCount];
+};
+
+/*
+ * Measurements of one thread. Its mutex is taken by the owner thread for every measurement and is contended
+ * only while the statistics are merged or reset, so the threads do not wait for each other.
+ */
+struct ThreadData
+{
+    QMutex mutex;
+    PhaseData phases[Profiler::phCount];
+    QVector<TraceEvent> events;
+    int eventQuota; // Reserved events left, -1 if the common limit is exhausted
+    bool owned; // A finished thread leaves its measurements to the next new thread
+
+    ThreadData()
+    {
+        memset(phases, 0, sizeof(phases));
+        eventQuota = 0;
+        owned = true;
+    }
+};
+
+struct ProfilerData
+{
+    QMutex mutex; // Guards the list of threads
+    QElapsedTimer clock;
+    QList<ThreadData *> threads;
+    QAtomicInt eventBudget; // Events which all threads may still log
+
+    ProfilerData() : eventBudget(maxEvents)
+    {
+        clock.start();
+    }
+};
+
+ProfilerData &data()
+{
+    // Never destroyed, threads may finish after the static objects are destroyed
+    static ProfilerData *instance = new ProfilerData;
+    return *instance;
+}
+
+/*
+ * Link of a thread to its measurements, released when the thread finishes.
+ */
+class ThreadHandle
+{
+public:
+    explicit ThreadHandle(ThreadData *local) : local(local) {}
+
+    ~ThreadHandle()
+    {
+        QMutexLocker locker(&data().mutex);
+        local->owned = false;
+    }
+
+    ThreadData *local;
+};
+
+ThreadData &threadData()
+{
+    static QThreadStorage<ThreadHandle *> handles;
+
+    if (!handles.hasLocalData())
+    {
+        ProfilerData &profiler = data();
+        QMutexLocker locker(&profiler.mutex);
+        ThreadData *local = 0;
+        QList<ThreadData *>::const_iterator it;
+
+        for (it = profiler.threads.constBegin(); (it != profiler.threads.constEnd()) && (!local); ++it)
+        {
+            if (!(*it)->owned)
+                local = *it;
+        }
+
+        if (local)
+            local->owned = true;
+        else
+        {
+            local = new ThreadData;
+            profiler.threads.append(local);
+        }
+
+        handles.setLocalData(new ThreadHandle(local));
+    }
+
+    return *handles.localData()->local;
+}
+
+int bucketIndex(qint64 value)
+{
+    if (value < subCount)
+        return (value < 0) ? 0 : static_cast<int>(value);
+
+    int exponent = 63 - qCountLeadingZeroBits(static_cast<quint64>(value));
+    int sub = static_cast<int>(value >> (exponent - subBits)) & (subCount - 1);
+    return (exponent - subBits + 1) * subCount + sub;
+}
+
+// Middle of the bucket value range
+qint64 bucketValue(int index)
+{
+    if (index < subCount)
+        return index;
+
+    int exponent = index / subCount + subBits - 1;
+    qint64 width = Q_INT64_C(1) << (exponent - subBits);
+    return (subCount + index % subCount) * width + width / 2;
+}
+
+qint64 percentile(const PhaseData &phase, int percent)
+{
+    qint64 target = (phase.count * percent + 99) / 100;
+    qint64 seen = 0;
+
+    for (int i = 0; i < bucketCount; ++i)
+    {
+        seen += phase.buckets[i];
+
+        if (seen >= target)
+            return qMin(bucketValue(i), phase.max);
+    }
+
+    return phase.max;
+}
+
+}
+
+qint64 Profiler::now()
+{
+    return data().clock.nsecsElapsed();
+}
+
+void Profiler::record(Phase phase, qint64 start, qint64 duration)
+{
+    ThreadData &local = threadData();
+    quintptr thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    QMutexLocker locker(&local.mutex);
+
+    PhaseData &stats = local.phases[phase];
+    stats.count++;
+    stats.total += duration;
+    stats.max = qMax(stats.max, duration);
+    stats.buckets[bucketIndex(duration)]++;
+
+    if (local.eventQuota == 0)
+    {
+        int budget = data().eventBudget.fetchAndAddRelaxed(-eventBlock);
+        local.eventQuota = (budget > 0) ? qMin(budget, eventBlock) : -1;
+    }
+
+    if (local.eventQuota > 0)
+    {
+        TraceEvent event = {start, duration, thread, phase};
+        local.events.append(event);
+        local.eventQuota--;
+    }
+}
+
+void Profiler::reset()
+{
+    ProfilerData &profiler = data();
+    QMutexLocker locker(&profiler.mutex);
+    QList<ThreadData *>::const_iterator it;
+
+    for (it = profiler.threads.constBegin(); it != profiler.threads.constEnd(); ++it)
+    {
+        QMutexLocker threadLocker(&(*it)->mutex);
+        memset((*it)->phases, 0, sizeof((*it)->phases));
+        (*it)->events.clear();
+        (*it)->eventQuota = 0;
+    }
+
+    profiler.eventBudget.store(maxEvents);
+}
+
+Profiler::Statistics Profiler::getStatistics(Phase phase)
+{
+    ProfilerData &profiler = data();
+    PhaseData stats;
+    memset(&stats, 0, sizeof(stats));
+
+    {
+        QMutexLocker locker(&profiler.mutex);
+        QList<ThreadData *>::const_iterator it;
+
+        for (it = profiler.threads.constBegin(); it != profiler.threads.constEnd(); ++it)
+        {
+            QMutexLocker threadLocker(&(*it)->mutex);
+            const PhaseData &local = (*it)->phases[phase];
+            stats.count += local.count;
+            stats.total += local.total;
+            stats.max = qMax(stats.max, local.max);
+
+            for (int i = 0; i < bucketCount; ++i)
+            {
+                stats.buckets[i] += local.buckets[i];
+            }
+        }
+    }
+
+    Statistics result;
+    result.count = stats.count;
+    result.total = stats.total;
+    result.max = stats.max;
+
+    if (stats.count > 0)
+    {
+        result.p50 = percentile(stats, 50);
+        result.p95 = percentile(stats, 95);
+        result.p99 = percentile(stats, 99);
+    }
+    else
+    {
+        result.p50 = result.p95 = result.p99 = 0;
+    }
+
+    return result;
+}
+
+QString Profiler::getPhaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case phEnumeration:
+        return QCoreApplication::translate("Profiler", "Enumeration");
+    case phStat:
+        return QCoreApplication::translate("Profiler", "File properties");
+    case phOpen:
+        return QCoreApplication::translate("Profiler", "Open");
+    case phRead:
+        return QCoreApplication::translate("Profiler", "Read");
+    case phInflate:
+        return QCoreApplication::translate("Profiler", "Inflate");
+    case phParse:
+        return QCoreApplication::translate("Profiler", "XML parse");
+    case phModelInsert:
+        return QCoreApplication::translate("Profiler", "Model insert");
+    case phZip:
+        return QCoreApplication::translate("Profiler", "Compress");
+    case phUnzip:
+        return QCoreApplication::translate("Profiler", "Uncompress");
+    case phRename:
+        return QCoreApplication::translate("Profiler", "Rename");
+    default:
+        return QString();
+    }
+}
+
+bool Profiler::exportTrace(const QString &fileName)
+{
+    ProfilerData &profiler = data();
+    QVector<TraceEvent> events;
+
+    {
+        QMutexLocker locker(&profiler.mutex);
+        QList<ThreadData *>::const_iterator it;
+
+        for (it = profiler.threads.constBegin(); it != profiler.threads.constEnd(); ++it)
+        {
+            QMutexLocker threadLocker(&(*it)->mutex);
+            events += (*it)->events;
+        }
+    }
+
+    QSaveFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    // Thread handles are replaced with small numbers in order of appearance
+    QHash<quintptr, int> threads;
+    QByteArray buffer = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    QVector<TraceEvent>::const_iterator it;
+
+    for (it = events.constBegin(); it != events.constEnd(); ++it)
+    {
+        QHash<quintptr, int>::const_iterator thread = threads.constFind((*it).thread);
+
+        if (thread == threads.constEnd())
+            thread = threads.insert((*it).thread, threads.count() + 1);
+
+        if (it != events.constBegin())
+            buffer.append(',');
+
+        buffer.append("\n{\"name\":\"");
+        buffer.append(getPhaseName(static_cast<Phase>((*it).phase)).toUtf8());
+        buffer.append("\",\"cat\":\"fb2me\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+        buffer.append(QByteArray::number(thread.value()));
+        buffer.append(",\"ts\":");
+        buffer.append(QByteArray::number((*it).start / 1000.0, 'f', 3));
+        buffer.append(",\"dur\":");
+        buffer.append(QByteArray::number((*it).duration / 1000.0, 'f', 3));
+        buffer.append('}');
+
+        if (buffer.size() >= 65536)
+        {
+            if (file.write(buffer) != buffer.size())
+                return false;
+
+            buffer.clear();
+        }
+    }
+
+    buffer.append("\n]}\n");
+
+    if (file.write(buffer) != buffer.size())
+        return false;
+
+    return file.commit();
+}
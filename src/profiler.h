@@ -0,0 +1,215 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль замера времени этапов обработки файлов.
+ *
+ * @~english
+ * @brief Module of timing of file processing phases.
+ */
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @~russian
+ * @brief Замер времени этапов сканирования и файловых операций.
+ *
+ * Каждый замер добавляется в гистограмму своего этапа, по которой оцениваются перцентили, и в журнал событий,
+ * который выгружается в формате Chrome Trace (chrome://tracing, Perfetto). Журнал ограничен миллионом событий,
+ * после этого пополняются только гистограммы. Каждый поток пишет замеры в собственные гистограммы и журнал,
+ * поэтому потоки не ждут друг друга, данные потоков объединяются при получении сводки и выгрузке журнала.
+ * Все функции потокобезопасны.
+ *
+ * @~english
+ * @brief Timing of scan phases and file operations.
+ *
+ * Each measurement is added to the histogram of its phase, from which the percentiles are estimated, and to the
+ * event log, which is exported in Chrome Trace format (chrome://tracing, Perfetto). The log is limited to a million
+ * events, only the histograms are updated after that. Each thread writes measurements to its own histograms and
+ * log, so the threads do not wait for each other, the data of the threads is merged when the summary is requested
+ * and the log is exported. All functions are thread-safe.
+ */
+class Profiler
+{
+public:
+    /**
+     * @~russian
+     * @brief Этапы обработки.
+     *
+     * @~english
+     * @brief Processing phases.
+     */
+    enum Phase
+    {
+        phEnumeration, ///< @~russian Перечисление файлов в папке. @~english Listing of files in the folder.
+        phStat, ///< @~russian Получение свойств файла. @~english Getting file properties.
+        phOpen, ///< @~russian Открытие файла или архива. @~english Opening of the file or archive.
+        phRead, ///< @~russian Чтение начала несжатого файла. @~english Reading the beginning of the uncompressed file.
+        phInflate, ///< @~russian Распаковка начала архива. @~english Unpacking the beginning of the archive.
+        phParse, ///< @~russian Разбор описания книги. @~english Parsing of the book description.
+        phModelInsert, ///< @~russian Добавление записи в модель. @~english Inserting the record to the model.
+        phZip, ///< @~russian Сжатие файла. @~english Compressing the file.
+        phUnzip, ///< @~russian Распаковка файла. @~english Uncompressing the file.
+        phRename, ///< @~russian Переименование или перемещение файла. @~english Renaming or moving the file.
+        phCount ///< @~russian Количество этапов. @~english Number of phases.
+    };
+
+    /**
+     * @~russian
+     * @brief Сводка замеров этапа, время в наносекундах.
+     *
+     * Перцентили оцениваются по гистограмме с погрешностью не более 3%.
+     *
+     * @~english
+     * @brief Summary of phase measurements, time in nanoseconds.
+     *
+     * The percentiles are estimated from the histogram with an error of 3% at most.
+     */
+    struct Statistics
+    {
+        qint64 count; ///< @~russian Количество замеров. @~english Number of measurements.
+        qint64 total; ///< @~russian Суммарное время. @~english Total time.
+        qint64 p50; ///< @~russian Медиана. @~english Median.
+        qint64 p95; ///< @~russian 95-й перцентиль. @~english 95th percentile.
+        qint64 p99; ///< @~russian 99-й перцентиль. @~english 99th percentile.
+        qint64 max; ///< @~russian Наибольшее время. @~english Maximum time.
+    };
+
+    /**
+     * @~russian
+     * @brief Замер времени до конца области видимости.
+     *
+     * @~english
+     * @brief Timing up to the end of the scope.
+     */
+    class Scope
+    {
+    public:
+        /**
+         * @~russian
+         * @brief Начало замера.
+         * @param phase Этап обработки.
+         *
+         * @~english
+         * @brief Starting the measurement.
+         * @param phase Processing phase.
+         */
+        explicit Scope(Phase phase) : phase(phase), start(Profiler::now()) {}
+
+        /**
+         * @~russian
+         * @brief Окончание замера и его запись.
+         *
+         * @~english
+         * @brief Finishing the measurement and recording it.
+         */
+        ~Scope() { Profiler::record(phase, start, Profiler::now() - start); }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+
+        Phase phase; ///< @~russian Этап обработки. @~english Processing phase.
+        qint64 start; ///< @~russian Время начала. @~english Start time.
+    };
+
+    /**
+     * @~russian
+     * @brief Получение текущего времени.
+     * @return Время в наносекундах с момента запуска программы.
+     *
+     * @~english
+     * @brief Getting the current time.
+     * @return Time in nanoseconds since the program start.
+     */
+    static qint64 now();
+
+    /**
+     * @~russian
+     * @brief Запись замера.
+     * @param phase Этап обработки.
+     * @param start Время начала.
+     * @param duration Продолжительность.
+     *
+     * @~english
+     * @brief Recording the measurement.
+     * @param phase Processing phase.
+     * @param start Start time.
+     * @param duration Duration.
+     */
+    static void record(Phase phase, qint64 start, qint64 duration);
+
+    /**
+     * @~russian
+     * @brief Удаление всех замеров.
+     *
+     * @~english
+     * @brief Removing all measurements.
+     */
+    static void reset();
+
+    /**
+     * @~russian
+     * @brief Получение сводки замеров этапа.
+     * @param phase Этап обработки.
+     * @return Сводка замеров.
+     *
+     * @~english
+     * @brief Getting the summary of phase measurements.
+     * @param phase Processing phase.
+     * @return Summary of measurements.
+     */
+    static Statistics getStatistics(Phase phase);
+
+    /**
+     * @~russian
+     * @brief Получение названия этапа для отображения пользователю.
+     * @param phase Этап обработки.
+     * @return Название этапа.
+     *
+     * @~english
+     * @brief Getting the phase name to display to the user.
+     * @param phase Processing phase.
+     * @return Phase name.
+     */
+    static QString getPhaseName(Phase phase);
+
+    /**
+     * @~russian
+     * @brief Выгрузка журнала событий в формате Chrome Trace.
+     * @param fileName Имя файла JSON.
+     * @return @c true - если выгрузка прошла успешно;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Exporting the event log in Chrome Trace format.
+     * @param fileName Name of JSON file.
+     * @return @c true - if export succeeded;@n
+     * @c false - if not.
+     */
+    static bool exportTrace(const QString &fileName);
+};
+
+#endif // PROFILER_H
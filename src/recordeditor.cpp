@@ -20,6 +20,7 @@
 #include "recordeditor.h"
 #include "filerecord.h"
 #include "person.h"
+#include "genreregistry.h"
 
 #include <QDialogButtonBox>
 #include <QVBoxLayout>
@@ -31,7 +32,7 @@
 #include <QComboBox>
 #include <QStackedLayout>
 
-RecordEditor::RecordEditor(FileRecord *rec, QWidget *parent) :
+RecordEditor::RecordEditor(const FileRecord &rec, QWidget *parent) :
     QDialog(parent)
 {
     boxButtons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
@@ -45,7 +46,6 @@ RecordEditor::RecordEditor(FileRecord *rec, QWidget *parent) :
     lblBookTitle = new QLabel(tr("Book title"));
 
     edtBookTitle = new QLineEdit();
-    edtBookTitle->setReadOnly(true);
 
     gbxAuthorList = new AuthorContainer(tr("List of authors"), this);
 
@@ -68,12 +68,25 @@ RecordEditor::~RecordEditor()
     delete boxMain;
 }
 
-void RecordEditor::setData(FileRecord *rec)
+void RecordEditor::setData(const FileRecord &rec)
 {
     record = rec;
     updateUI();
 }
 
+FileRecord RecordEditor::getRecord() const
+{
+    FileRecord result = record;
+    result.setBookTitle(edtBookTitle->text());
+
+    for (int i = 0; i < authorList.size(); ++i)
+    {
+        result.setAuthor(i, authorList.at(i)->getAuthor());
+    }
+
+    return result;
+}
+
 void RecordEditor::updateUI()
 {
     // Remove old UI
@@ -94,28 +107,31 @@ void RecordEditor::updateUI()
 
     // Make updated UI
 
-    edtBookTitle->setText(record->getBookTitle());
+    authorList.clear();
+
+    edtBookTitle->setText(record.getBookTitle());
 
-    for (int i = 0; i < record->getAuthorCount(); ++i)
+    for (int i = 0; i < record.getAuthorCount(); ++i)
     {
-        Person tmpAuthor = record->getAuthor(i);
-        AuthorDisplay *tmp = new AuthorDisplay(&tmpAuthor, i, gbxAuthorList);
+        const Person &tmpAuthor = record.getAuthor(i);
+        AuthorDisplay *tmp = new AuthorDisplay(tmpAuthor, i, gbxAuthorList);
         gbxAuthorList->addItem(tmp, tmpAuthor.getFullNameLFM());
+        authorList.append(tmp);
     }
 
-    sequence_t tmpSequence = record->getSequenceList();
+    const sequence_t &tmpSequence = record.getSequenceList();
 
     for (int i = 0; i < tmpSequence.size(); ++i)
     {
-        SeriesDisplay *tmp = new SeriesDisplay(&tmpSequence, i, gbxSeriesList);
+        SeriesDisplay *tmp = new SeriesDisplay(tmpSequence, i, gbxSeriesList);
         gbxSeriesList->addItem(tmp);
     }
 
-    genre_t tmpGenres = record->getGenresList();
+    const genre_t &tmpGenres = record.getGenresList();
 
     for (int i = 0; i < tmpGenres.size(); ++i)
     {
-        GenresDisplay *tmp = new GenresDisplay(&tmpGenres, i, gbxGenresList);
+        GenresDisplay *tmp = new GenresDisplay(tmpGenres, i, gbxGenresList);
         gbxGenresList->addItem(tmp);
     }
 
@@ -134,20 +150,19 @@ void RecordEditor::updateUI()
 // class AuthorDisplay
 //==============================================================================
 
-AuthorDisplay::AuthorDisplay(Person *author, int index, QWidget *parent):
+AuthorDisplay::AuthorDisplay(const Person &author, int index, QWidget *parent):
     RecordEditorHelper(index, parent)
 {
-    QLineEdit *edtFirstName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("First name")));
-    edtFirstName->setReadOnly(true); // While there is no XML editing, data about the author only display
-    edtFirstName->setText(author->getFirstName());
+    person = author;
 
-    QLineEdit *edtMiddleName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Middle name")));
-    edtMiddleName->setReadOnly(true);
-    edtMiddleName->setText(author->getMiddleName());
+    edtFirstName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("First name")));
+    edtFirstName->setText(author.getFirstName());
 
-    QLineEdit *edtLastName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Last name")));
-    edtLastName->setReadOnly(true);
-    edtLastName->setText(author->getLastName());
+    edtMiddleName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Middle name")));
+    edtMiddleName->setText(author.getMiddleName());
+
+    edtLastName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Last name")));
+    edtLastName->setText(author.getLastName());
 }
 
 AuthorDisplay::~AuthorDisplay()
@@ -155,20 +170,29 @@ AuthorDisplay::~AuthorDisplay()
 
 }
 
+Person AuthorDisplay::getAuthor() const
+{
+    Person result = person;
+    result.setFirstName(edtFirstName->text());
+    result.setMiddleName(edtMiddleName->text());
+    result.setLastName(edtLastName->text());
+    return result;
+}
+
 //==============================================================================
 // class SeriesDisplay
 //==============================================================================
 
-SeriesDisplay::SeriesDisplay(sequence_t *series, int index, QWidget *parent):
+SeriesDisplay::SeriesDisplay(const sequence_t &series, int index, QWidget *parent):
     RecordEditorHelper(index, parent)
 {
     QLineEdit *edtName = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Name of sequence")));
     edtName->setReadOnly(true);
-    edtName->setText(series->at(index).first);
+    edtName->setText(series.at(index).first);
 
     QLineEdit *edtNumber = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Number of book in sequence")));
     edtNumber->setReadOnly(true);
-    edtNumber->setText(QString::number(series->at(index).second));
+    edtNumber->setText(QString::number(series.at(index).second));
 }
 
 SeriesDisplay::~SeriesDisplay()
@@ -180,15 +204,23 @@ SeriesDisplay::~SeriesDisplay()
 // class GenresDisplay
 //==============================================================================
 
-GenresDisplay::GenresDisplay(genre_t *genres, int index, QWidget *parent):
+GenresDisplay::GenresDisplay(const genre_t &genres, int index, QWidget *parent):
     RecordEditorHelper(index, parent)
 {
     QComboBox *cbGenre = qobject_cast<QComboBox *>(addItem(ftComboBox, tr("Genre")));
-    cbGenre->addItem(genres->at(index).first); // In the future there will be filling out a list of genres
-    cbGenre->setCurrentIndex(cbGenre->findText(genres->at(index).first));
+    const QString &code = genres.at(index).first;
+
+    for (int i = 0; i < GenreRegistry::getCount(); ++i)
+        cbGenre->addItem(GenreRegistry::getName(i), GenreRegistry::getCode(i));
+
+    // Non-standard code is kept as is so that it is not lost on editing
+    if (GenreRegistry::find(code) == GenreRegistry::unknownGenre)
+        cbGenre->addItem(code, code.trimmed());
+
+    cbGenre->setCurrentIndex(cbGenre->findData(code.trimmed()));
 
     QLineEdit *edtGenreMatch = qobject_cast<QLineEdit *>(addItem(ftLineEdit, tr("Genre match")));
-    edtGenreMatch->setText(QString::number(genres->at(index).second));
+    edtGenreMatch->setText(QString::number(genres.at(index).second));
 }
 
 GenresDisplay::~GenresDisplay()
@@ -247,7 +279,7 @@ void SeriesContainer::onAddSeries()
 {
     sequence_t tmp;
     tmp.append(qMakePair(QString(""), 0));
-    SeriesDisplay *newSeries = new SeriesDisplay(&tmp, 0, this);
+    SeriesDisplay *newSeries = new SeriesDisplay(tmp, 0, this);
     addItem(newSeries);
 }
 
@@ -270,6 +302,6 @@ void GenresContainer::onAddGenre()
 {
     genre_t tmp;
     tmp.append(qMakePair(QString(""), 100));
-    GenresDisplay *newGenre = new GenresDisplay(&tmp, 0, this);
+    GenresDisplay *newGenre = new GenresDisplay(tmp, 0, this);
     addItem(newGenre);
 }
@@ -30,10 +30,13 @@
  */
 
 #include "types.h"
+#include "person.h"
+#include "filerecord.h"
 #include "recordeditorhelper.h"
 
 #include <QDialog>
 #include <QWidget>
+#include <QVector>
 
 // Forward class declarations
 class QVBoxLayout;
@@ -46,10 +49,8 @@ class QGridLayout;
 class QComboBox;
 class QStackedLayout;
 
-class FileRecord;
-class Person;
-
 class AuthorContainer;
+class AuthorDisplay;
 class SeriesContainer;
 class GenresContainer;
 
@@ -76,7 +77,7 @@ public:
      * @param rec Record displayed in the edit dialog
      * @param parent Parent window pointer.
      */
-    explicit RecordEditor(FileRecord *rec, QWidget *parent = 0);
+    explicit RecordEditor(const FileRecord &rec, QWidget *parent = 0);
 
     /**
      * @~russian
@@ -96,7 +97,18 @@ public:
      * @brief Setting a new content for edited recording.
      * @param rec New record.
      */
-    void setData(FileRecord *rec);
+    void setData(const FileRecord &rec);
+
+    /**
+     * @~russian
+     * @brief Получение записи с изменениями, внесенными в диалоге.
+     * @return Измененная запись.
+     *
+     * @~english
+     * @brief Getting the record with changes made in the dialog.
+     * @return Changed record.
+     */
+    FileRecord getRecord() const;
 
 private:
     /**
@@ -124,7 +136,7 @@ private:
      * @~english
      * @brief Edited record.
      */
-    FileRecord *record;
+    FileRecord record;
 
     /**
      * @~russian
@@ -153,6 +165,15 @@ private:
      */
     AuthorContainer *gbxAuthorList;
 
+    /**
+     * @~russian
+     * @brief Список отображаемых авторов.
+     *
+     * @~english
+     * @brief List of displayed authors.
+     */
+    QVector<AuthorDisplay *> authorList;
+
     /**
      * @~russian
      * @brief Рамка списка книжных серий.
@@ -214,7 +235,7 @@ public:
      * @param index Number of entries about the author in the author list.
      * @param parent Parent window pointer.
      */
-    explicit AuthorDisplay(Person *author, int index, QWidget *parent = 0);
+    explicit AuthorDisplay(const Person &author, int index, QWidget *parent = 0);
 
     /**
      * @~russian
@@ -224,6 +245,23 @@ public:
      * @brief Destructor of class.
      */
     virtual ~AuthorDisplay();
+
+    /**
+     * @~russian
+     * @brief Получение записи об авторе с изменениями, внесенными в диалоге.
+     * @return Запись об авторе.
+     *
+     * @~english
+     * @brief Getting the author's record with changes made in the dialog.
+     * @return Author's record.
+     */
+    Person getAuthor() const;
+
+private:
+    Person person; ///< @~russian Исходная запись об авторе. @~english Original author's record.
+    QLineEdit *edtFirstName; ///< @~russian Поле имени. @~english First name field.
+    QLineEdit *edtMiddleName; ///< @~russian Поле отчества. @~english Middle name field.
+    QLineEdit *edtLastName; ///< @~russian Поле фамилии. @~english Last name field.
 };
 
 /**
@@ -250,7 +288,7 @@ public:
      * @param index Number of entries about the series in the series list.
      * @param parent Parent window pointer.
      */
-    SeriesDisplay(sequence_t *series, int index, QWidget *parent = 0);
+    SeriesDisplay(const sequence_t &series, int index, QWidget *parent = 0);
     /**
      * @~russian
      * @brief Деструктор класса.
@@ -286,7 +324,7 @@ public:
      * @param index Number of entries about the genre in the genre list.
      * @param parent Parent window pointer.
      */
-    GenresDisplay(genre_t *genres, int index, QWidget *parent = 0);
+    GenresDisplay(const genre_t &genres, int index, QWidget *parent = 0);
 
     /**
      * @~russian
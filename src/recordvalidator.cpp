@@ -0,0 +1,145 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации проверки записей.
+ *
+ * @~english
+ * @brief Source file for record validation.
+ */
+
+#include "recordvalidator.h"
+#include "person.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VALIDATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+static inline bool isCyrillic(ushort ch)
+{
+    return (ch & 0xFF00) == 0x0400;
+}
+
+static inline bool isLatin(ushort ch)
+{
+    ushort lower = ch | 0x20;
+    return (lower >= 'a') && (lower <= 'z');
+}
+
+/*
+ * Quick check whether the text contains both alphabets at all, most titles contain only one of them.
+ */
+static bool hasBothAlphabets(const ushort *text, int size)
+{
+    bool cyrillic = false;
+    bool latin = false;
+    int i = 0;
+
+#ifdef VALIDATOR_SSE2
+    const __m128i highMask = _mm_set1_epi16(static_cast<short>(0xFF00));
+    const __m128i cyrillicBlock = _mm_set1_epi16(0x0400);
+    const __m128i caseBit = _mm_set1_epi16(0x20);
+    const __m128i beforeA = _mm_set1_epi16('a' - 1);
+    const __m128i afterZ = _mm_set1_epi16('z' + 1);
+    __m128i cyrillicAny = _mm_setzero_si128();
+    __m128i latinAny = _mm_setzero_si128();
+
+    for (; i + 8 <= size; i += 8)
+    {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + i));
+        __m128i lower = _mm_or_si128(chars, caseBit);
+
+        // Characters above 0x7FFF are negative in the signed comparison, so they are not counted as Latin
+        cyrillicAny = _mm_or_si128(cyrillicAny, _mm_cmpeq_epi16(_mm_and_si128(chars, highMask), cyrillicBlock));
+        latinAny = _mm_or_si128(latinAny, _mm_and_si128(_mm_cmpgt_epi16(lower, beforeA), _mm_cmplt_epi16(lower, afterZ)));
+    }
+
+    cyrillic = (_mm_movemask_epi8(cyrillicAny) != 0);
+    latin = (_mm_movemask_epi8(latinAny) != 0);
+#endif
+
+    for (; i < size; ++i)
+    {
+        cyrillic = cyrillic || isCyrillic(text[i]);
+        latin = latin || isLatin(text[i]);
+    }
+
+    return cyrillic && latin;
+}
+
+bool RecordValidator::hasMixedWords(const QString &text)
+{
+    const ushort *chars = text.utf16();
+    int size = text.size();
+
+    if (!hasBothAlphabets(chars, size))
+        return false;
+
+    bool cyrillic = false;
+    bool latin = false;
+
+    for (int i = 0; i < size; ++i)
+    {
+        if (isCyrillic(chars[i]))
+            cyrillic = true;
+        else
+            if (isLatin(chars[i]))
+                latin = true;
+            else
+                if (!QChar(chars[i]).isLetterOrNumber())
+                {
+                    // End of the word
+                    cyrillic = false;
+                    latin = false;
+                }
+
+        if (cyrillic && latin)
+            return true;
+    }
+
+    return false;
+}
+
+Status RecordValidator::classify(const FileRecord &record)
+{
+    // At least one author is required by the format
+    if (record.getAuthorCount() == 0)
+        return stIncorrectAuthorField;
+
+    QString text = record.getBookTitle();
+
+    for (int i = 0; i < record.getAuthorCount(); ++i)
+    {
+        const Person &author = record.getAuthor(i);
+
+        if (!author.isCorrect())
+            return stIncorrectAuthorField;
+
+        text += ' ';
+        text += author.getFullNameLFM();
+    }
+
+    if (hasMixedWords(text))
+        return stMixedCyrLat;
+
+    return stNormalRecord;
+}
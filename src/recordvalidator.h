@@ -0,0 +1,91 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef RECORDVALIDATOR_H
+#define RECORDVALIDATOR_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль проверки записей.
+ *
+ * @~english
+ * @brief Module of record validation.
+ */
+
+#include "filerecord.h"
+
+#include <QString>
+
+/**
+ * @~russian
+ * @brief Определение статуса записи при чтении.
+ *
+ * Проверка выполняется для каждой прочитанной книги, поэтому поиск смешения алфавитов сделан в два прохода:
+ * быстрый проход блоками по 8 символов (SSE2 на x86-64) только определяет, есть ли в строке и кириллица,
+ * и латиница, и лишь в этом случае строка проверяется по словам.
+ *
+ * @~english
+ * @brief Determining the record status on reading.
+ *
+ * Validation is performed for every read book, so the search for mixed alphabets is done in two passes:
+ * a fast pass by blocks of 8 characters (SSE2 on x86-64) only determines whether the string contains both
+ * Cyrillic and Latin letters, and only in this case the string is checked word by word.
+ */
+class RecordValidator
+{
+public:
+    /**
+     * @~russian
+     * @brief Определение статуса записи.
+     *
+     * Некорректное поле «Автор» (см. Person::isCorrect()) или отсутствие авторов важнее смешения алфавитов.
+     * @param record Запись.
+     * @return Статус записи.
+     *
+     * @~english
+     * @brief Determining the status of the record.
+     *
+     * Incorrect «Author» field (see Person::isCorrect()) or missing authors take precedence over mixed alphabets.
+     * @param record Record.
+     * @return Status of the record.
+     */
+    static Status classify(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Поиск слов, в которых смешаны кириллица и латиница.
+     *
+     * Например, латинские «a», «e», «o», «c», набранные внутри русского слова.
+     * @param text Проверяемая строка.
+     * @return @c true - если хотя бы в одном слове есть буквы обоих алфавитов;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Searching for words with mixed Cyrillic and Latin letters.
+     *
+     * For example, Latin «a», «e», «o», «c» typed inside a Russian word.
+     * @param text String being checked.
+     * @return @c true - if at least one word contains letters of both alphabets;@n
+     * @c false - if not.
+     */
+    static bool hasMixedWords(const QString &text);
+};
+
+#endif // RECORDVALIDATOR_H
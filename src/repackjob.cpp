@@ -0,0 +1,504 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации задания упаковки книг в общие архивы.
+ *
+ * @~english
+ * @brief Source file for the job packing books into shared archives.
+ */
+
+#include "repackjob.h"
+#include "csv.h"
+#include "authorindex.h"
+#include "paralleldeflate.h"
+#include "crc32.h"
+#include "consts.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QDate>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+const qint64 parallelDeflateSize = 4 * 1024 * 1024; // Larger books are compressed by blocks in several threads
+
+/*
+ * Field of an .inp line, the separators of fields and lines are not allowed inside.
+ */
+static QString inpField(QString text)
+{
+    return text.replace(QChar(0x04), ' ').replace('\r', ' ').replace('\n', ' ');
+}
+
+/*
+ * Part of a list field of an .inp line, the separators of parts and items are not allowed inside as well.
+ */
+static QString inpListPart(const QString &text)
+{
+    return inpField(text).replace(',', ' ').replace(':', ' ');
+}
+
+RepackJob::RepackJob(const QVector<FileRecord> &records, const QString &targetDir, QObject *parent) :
+    Job(parent)
+{
+    this->records = records;
+    this->targetDir = targetDir;
+    threads = 0;
+    level = 9;
+    packSize = 1024 * 1024 * 1024;
+    inpx = true;
+    nextEntry = 0;
+    maxPending = 0;
+    archive = new mz_zip_archive;
+    memset(archive, 0, sizeof(*archive));
+    packOpen = false;
+    centralSize = 0;
+    broken = false;
+    packNumber = 0;
+    written = 0;
+
+    qint64 bytes = 0;
+    QVector<FileRecord>::const_iterator it;
+
+    for (it = this->records.constBegin(); it != this->records.constEnd(); ++it)
+    {
+        bytes += (*it).getSize();
+    }
+
+    setTotal(this->records.count(), bytes);
+}
+
+RepackJob::~RepackJob()
+{
+    delete archive;
+}
+
+QString RepackJob::getTitle() const
+{
+    return tr("Repacking books into archives");
+}
+
+void RepackJob::setThreads(int threads)
+{
+    this->threads = threads;
+}
+
+void RepackJob::setPacking(int level, int packSize, bool inpx)
+{
+    this->level = level;
+    this->packSize = qMin(static_cast<qint64>(packSize) * 1024 * 1024, static_cast<qint64>(maxPackBytes));
+    this->inpx = inpx;
+}
+
+void RepackJob::run()
+{
+    sortRecords();
+
+    // Each worker may prepare a few books ahead of the writer
+    maxPending = 4 * ((threads > 0) ? threads : QThread::idealThreadCount());
+    runParallel(order.count(), threads);
+
+    // Archives and catalogs of a cancelled job stay consistent with each other
+    if (packOpen)
+        closePack();
+
+    if (!packs.isEmpty())
+        saveCatalogs();
+
+    if (isCancelled())
+        emit EventMessage(tr("%1: cancelled").arg(getTitle()));
+    else
+        emit EventMessage(tr("%1 books packed into %2 archives in %3, %4 not packed")
+                          .arg(written).arg(packs.count()).arg(QDir::toNativeSeparators(targetDir)).arg(failed.load()));
+}
+
+void RepackJob::sortRecords()
+{
+    AuthorIndex authors;
+    authors.build(records);
+
+    QVector<QString> keys(records.count());
+    const QChar separator(0x01);
+    order.resize(records.count());
+
+    for (int i = 0; i < records.count(); ++i)
+    {
+        const FileRecord &record = records.at(i);
+        const sequence_t &sequences = record.getSequenceList();
+
+        // Books without an author go last, the padded number keeps a series in its order
+        QString author = (record.getAuthorCount() > 0) ?
+                         authors.canonical(record.getAuthor(0)).getFullNameLFM().toLower() : QString(QChar(0xFFFF));
+        QString series = sequences.isEmpty() ? QString() : sequences.first().first.toLower();
+        int number = sequences.isEmpty() ? 0 : sequences.first().second;
+
+        keys[i] = author + separator + series + separator + QString("%1").arg(number, 10, 10, QChar('0')) + separator
+                  + record.getBookTitle().toLower() + separator + record.getFileName();
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&keys](int a, int b)
+    {
+        return keys.at(a) < keys.at(b);
+    });
+}
+
+void RepackJob::processParallel(int index)
+{
+    {
+        // Preparation runs ahead of writing by a few books only, so memory does not grow with a slow disk
+        QMutexLocker locker(&mtxWrite);
+
+        while ((index - nextEntry >= maxPending) && (!isCancelled()))
+            cndWrite.wait(&mtxWrite, 100);
+    }
+
+    if (isCancelled())
+        return;
+
+    PackEntry entry = prepareEntry(records.at(order.at(index)));
+
+    QMutexLocker locker(&mtxWrite);
+    ready.insert(index, entry);
+
+    // The thread that finished the next book in order writes it and the ready books after it
+    while (ready.contains(nextEntry))
+    {
+        writeEntry(nextEntry, ready.take(nextEntry));
+        ++nextEntry;
+    }
+
+    cndWrite.wakeAll();
+}
+
+RepackJob::PackEntry RepackJob::prepareEntry(const FileRecord &record) const
+{
+    PackEntry entry;
+    entry.crc = MZ_CRC32_INIT;
+    entry.size = 0;
+
+    QByteArray data;
+
+    if (record.isArchive())
+    {
+        mz_zip_archive source;
+        memset(&source, 0, sizeof(source));
+
+        if (!mz_zip_reader_init_file(&source, QFile::encodeName(record.getFileName()).constData(), 0))
+        {
+            entry.error = tr("Cannot open archive %1").arg(record.getFileName());
+            return entry;
+        }
+
+        mz_zip_archive_file_stat stat;
+        bool copied = false;
+        bool succeeded = (mz_zip_reader_get_num_files(&source) == 1) && mz_zip_reader_file_stat(&source, 0, &stat);
+
+        if (succeeded)
+        {
+            // Without the UTF-8 flag the name is in the legacy code page, as UnzipJob decodes it
+            QString name = (stat.m_bit_flag & 0x0800) ? QString::fromUtf8(stat.m_filename) :
+                           QString::fromLocal8Bit(stat.m_filename);
+            entry.name = QFileInfo(name).fileName();
+            entry.size = stat.m_uncomp_size;
+
+            if (stat.m_method == MZ_DEFLATED)
+            {
+                // The deflate stream is copied as is, the checksum is taken from the central directory
+                entry.data.resize(static_cast<int>(stat.m_comp_size));
+                entry.crc = stat.m_crc32;
+                copied = true;
+                succeeded = mz_zip_reader_extract_to_mem(&source, 0, entry.data.data(), entry.data.size(),
+                            MZ_ZIP_FLAG_COMPRESSED_DATA);
+            }
+            else
+            {
+                data.resize(static_cast<int>(stat.m_uncomp_size));
+                succeeded = mz_zip_reader_extract_to_mem(&source, 0, data.data(), data.size(), 0);
+            }
+        }
+
+        mz_zip_reader_end(&source);
+
+        if (!succeeded)
+        {
+            entry.error = tr("Error reading the archive %1").arg(record.getFileName());
+            return entry;
+        }
+
+        if (copied)
+            return entry;
+    }
+    else
+    {
+        QFile file(record.getFileName());
+        bool succeeded = file.open(QFile::ReadOnly);
+
+        if (succeeded)
+        {
+            data = file.readAll();
+            succeeded = (data.size() == file.size());
+        }
+
+        if (!succeeded)
+        {
+            entry.error = tr("Cannot read file %1").arg(record.getFileName());
+            return entry;
+        }
+
+        entry.name = QFileInfo(record.getFileName()).fileName();
+        entry.size = data.size();
+    }
+
+    if (data.size() >= parallelDeflateSize)
+    {
+        ParallelDeflate deflate(level);
+
+        if (deflate.compressBuffer(data))
+        {
+            entry.data = deflate.getResult();
+            entry.crc = deflate.getCrc32();
+            return entry;
+        }
+    }
+    else
+    {
+        size_t length = 0;
+        void *output = tdefl_compress_mem_to_heap(data.constData(), data.size(), &length,
+                       tdefl_create_comp_flags_from_zip_params(level, -15, MZ_DEFAULT_STRATEGY));
+
+        if (output)
+        {
+            entry.data = QByteArray(static_cast<const char *>(output), static_cast<int>(length));
+            entry.crc = Crc32::update(MZ_CRC32_INIT, reinterpret_cast<const uchar *>(data.constData()), data.size());
+            mz_free(output);
+            return entry;
+        }
+    }
+
+    entry.error = tr("Cannot compress file %1").arg(record.getFileName());
+    return entry;
+}
+
+void RepackJob::writeEntry(int index, const PackEntry &entry)
+{
+    const FileRecord &record = records.at(order.at(index));
+    addProgress(1, record.getSize());
+
+    if (!entry.error.isEmpty())
+    {
+        failed.ref();
+        emit ErrorMessage(entry.error);
+        return;
+    }
+
+    if (broken)
+    {
+        failed.ref();
+        return;
+    }
+
+    QString name = entry.name;
+    int dot = entry.name.lastIndexOf('.');
+
+    // Books with equal names from different folders get a number before the extension
+    for (int number = 2; packNames.contains(name); ++number)
+    {
+        name = (dot < 0) ? entry.name + '_' + QString::number(number) :
+               entry.name.left(dot) + '_' + QString::number(number) + entry.name.mid(dot);
+    }
+
+    QByteArray encodedName = name.toUtf8();
+
+    if (packOpen)
+    {
+        // Both headers and the directory record are counted, so the archive never exceeds the limit
+        qint64 size = archive->m_archive_size + centralSize;
+        qint64 growth = entry.data.size() + 2 * encodedName.size() + MZ_ZIP_LOCAL_DIR_HEADER_SIZE +
+                        MZ_ZIP_CENTRAL_DIR_HEADER_SIZE;
+
+        if ((size + growth > packSize) || (packNames.size() >= maxPackEntries))
+            closePack();
+    }
+
+    if ((!packOpen) && (!openPack()))
+    {
+        broken = true;
+        failed.ref();
+        emit ErrorMessage(tr("Cannot create archive %1").arg(packName));
+        return;
+    }
+
+    // Names are stored in UTF-8 with the flag, otherwise unpackers decode them in the OEM code page
+    if (!mz_zip_writer_add_mem_ex(archive, encodedName.constData(), entry.data.constData(), entry.data.size(),
+                                  "", 0, level | MZ_ZIP_FLAG_COMPRESSED_DATA | MZ_ZIP_FLAG_UTF8_FILENAME, entry.size,
+                                  entry.crc))
+    {
+        failed.ref();
+        emit ErrorMessage(tr("Cannot add file %1 to archive %2").arg(record.getFileName(), packName));
+        return;
+    }
+
+    packNames.insert(name);
+    centralSize += MZ_ZIP_CENTRAL_DIR_HEADER_SIZE + encodedName.size();
+    ++written;
+
+    mapping.append(Csv::field(record.getFileName())).append(',').append(Csv::field(QFileInfo(packName).fileName()));
+    mapping.append(',').append(Csv::field(name)).append(',').append(QByteArray::number(entry.size)).append('\n');
+
+    if (inpx)
+        inp.append(inpLine(record, name, entry.size, written));
+}
+
+bool RepackJob::openPack()
+{
+    // Numbering continues after the archives already in the folder
+    do
+    {
+        packName = QDir(targetDir).filePath(QString("fb2-%1.zip").arg(++packNumber, 6, 10, QChar('0')));
+    }
+    while (QFile::exists(packName));
+
+    memset(archive, 0, sizeof(*archive));
+    packNames.clear();
+    centralSize = 0;
+    inp.clear();
+
+    packOpen = mz_zip_writer_init_file(archive, QFile::encodeName(packName).constData(), 0);
+    return packOpen;
+}
+
+void RepackJob::closePack()
+{
+    bool succeeded = mz_zip_writer_finalize_archive(archive);
+    mz_zip_writer_end(archive);
+    packOpen = false;
+
+    if (packNames.isEmpty())
+    {
+        QFile::remove(packName);
+        return;
+    }
+
+    if (!succeeded)
+    {
+        emit ErrorMessage(tr("Cannot finish archive %1").arg(packName));
+        return;
+    }
+
+    packs.append(packName);
+    inpFiles.insert(QFileInfo(packName).completeBaseName() + ".inp", inp);
+    emit EventMessage(tr("Archive %1 written: %2 books").arg(packName).arg(packNames.size()));
+}
+
+void RepackJob::saveCatalogs()
+{
+    // Catalogs are named after the range of archives written by this run
+    QString base = QDir(targetDir).filePath(QFileInfo(packs.first()).completeBaseName() + '-' +
+                                            QFileInfo(packs.last()).completeBaseName().mid(4));
+
+    QSaveFile file(base + ".csv");
+
+    if ((!file.open(QIODevice::WriteOnly)) || (file.write("file,pack,entry,size\n") < 0) ||
+            (file.write(mapping) < 0) || (!file.commit()))
+        emit ErrorMessage(tr("Cannot write the mapping %1").arg(file.fileName()));
+
+    if (!inpx)
+        return;
+
+    // The catalog lists the files of each archive in the .inp file of the same name
+    QString inpxName = base + ".inpx";
+    QByteArray collection = QFileInfo(targetDir).fileName().toUtf8() + "\r\n" + QFileInfo(base).fileName().toUtf8() +
+                            "\r\n65536\r\n" + tr("Books repacked by %1").arg(NAMES::nameApplication).toUtf8() + "\r\n";
+    QByteArray version = QDate::currentDate().toString("yyyyMMdd").toLatin1() + "\r\n";
+    QByteArray structure = "AUTHOR;GENRE;TITLE;SERIES;SERNO;FILE;SIZE;LIBID;DEL;EXT;DATE\r\n";
+
+    mz_zip_archive catalog;
+    memset(&catalog, 0, sizeof(catalog));
+    bool succeeded = mz_zip_writer_init_file(&catalog, QFile::encodeName(inpxName).constData(), 0);
+
+    if (succeeded)
+    {
+        succeeded = mz_zip_writer_add_mem(&catalog, "collection.info", collection.constData(), collection.size(), level) &&
+                    mz_zip_writer_add_mem(&catalog, "version.info", version.constData(), version.size(), level) &&
+                    mz_zip_writer_add_mem(&catalog, "structure.info", structure.constData(), structure.size(), level);
+
+        QMap<QString, QByteArray>::const_iterator it;
+
+        for (it = inpFiles.constBegin(); (it != inpFiles.constEnd()) && succeeded; ++it)
+        {
+            succeeded = mz_zip_writer_add_mem(&catalog, it.key().toUtf8().constData(), it.value().constData(),
+                                              it.value().size(), level);
+        }
+
+        succeeded = succeeded && mz_zip_writer_finalize_archive(&catalog);
+        mz_zip_writer_end(&catalog);
+    }
+
+    if (!succeeded)
+    {
+        QFile::remove(inpxName);
+        emit ErrorMessage(tr("Cannot write the catalog %1").arg(inpxName));
+    }
+}
+
+QByteArray RepackJob::inpLine(const FileRecord &record, const QString &name, qint64 size, int id)
+{
+    QString authors;
+    QString genres;
+
+    for (int i = 0; i < record.getAuthorCount(); ++i)
+    {
+        const Person &author = record.getAuthor(i);
+        authors += inpListPart(author.getLastName()) + ',' + inpListPart(author.getFirstName()) + ',' +
+                   inpListPart(author.getMiddleName()) + ':';
+    }
+
+    genre_t::const_iterator genre;
+
+    for (genre = record.getGenresList().constBegin(); genre != record.getGenresList().constEnd(); ++genre)
+    {
+        genres += inpListPart((*genre).first) + ':';
+    }
+
+    const sequence_t &sequences = record.getSequenceList();
+    int dot = name.lastIndexOf('.');
+    QStringList fields;
+
+    fields << authors << genres << inpField(record.getBookTitle())
+           << (sequences.isEmpty() ? QString() : inpField(sequences.first().first))
+           << ((sequences.isEmpty() || (sequences.first().second <= 0)) ? QString() : QString::number(sequences.first().second))
+           << inpField((dot < 0) ? name : name.left(dot)) << QString::number(size) << QString::number(id) << "0"
+           << ((dot < 0) ? QString() : inpField(name.mid(dot + 1))) << QDate::currentDate().toString("yyyy-MM-dd");
+
+    return fields.join(QChar(0x04)).toUtf8() + "\r\n";
+}
@@ -0,0 +1,295 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef REPACKJOB_H
+#define REPACKJOB_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль задания упаковки книг в общие архивы.
+ *
+ * @~english
+ * @brief Module of the job packing books into shared archives.
+ */
+
+#include "job.h"
+#include "filerecord.h"
+
+#include <QVector>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QByteArray>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+// Forward class declarations
+struct mz_zip_archive_tag;
+
+/**
+ * @~russian
+ * @brief Задание упаковки книг в общие архивы.
+ *
+ * Книги упорядочиваются по каноническому имени первого автора, серии, номеру в серии и названию и записываются
+ * в архивы @c fb2-NNNNNN.zip целевой папки. Новый архив начинается, когда следующая книга превысила бы
+ * заданный размер или ограничения zip без zip64 (65535 файлов, 4 ГБ). Исходные файлы не удаляются.@n
+ * Книги готовятся параллельно: сжатые данные архивов .fb2.zip копируются без повторного сжатия, остальные книги
+ * сжимаются в рабочих потоках. Записывает готовую книгу поток, у которого она следующая по порядку, поэтому
+ * состав архивов не зависит от количества потоков, а число книг в памяти ограничено.@n
+ * Рядом с архивами сохраняется таблица соответствия CSV «файл - архив - имя в архиве» и, если включено,
+ * каталог INPX с файлами .inp для каждого архива.
+ *
+ * @~english
+ * @brief Job of packing books into shared archives.
+ *
+ * Books are ordered by the canonical name of the first author, series, number in the series and title and are
+ * written into @c fb2-NNNNNN.zip archives of the target folder. A new archive is started when the next book would
+ * exceed the given size or the limits of zip without zip64 (65535 files, 4 GB). Source files are not removed.@n
+ * Books are prepared in parallel: the compressed data of .fb2.zip archives is copied without recompression, the
+ * other books are compressed in worker threads. A ready book is written by the thread for which it is the next
+ * in order, so the contents of archives do not depend on the number of threads, and the number of books in
+ * memory is bounded.@n
+ * A CSV mapping "file - archive - name in archive" is saved next to the archives and, if enabled, an INPX
+ * catalog with an .inp file for each archive.
+ */
+class RepackJob : public Job
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param records Упаковываемые записи.
+     * @param targetDir Папка архивов.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param records Packed records.
+     * @param targetDir Folder of archives.
+     * @param parent Parent object.
+     */
+    RepackJob(const QVector<FileRecord> &records, const QString &targetDir, QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор.
+     *
+     * @~english
+     * @brief Destructor.
+     */
+    ~RepackJob();
+
+    /**
+     * @~russian
+     * @brief Получение названия задания.
+     * @return Название задания.
+     *
+     * @~english
+     * @brief Getting the job title.
+     * @return Job title.
+     */
+    QString getTitle() const;
+
+    /**
+     * @~russian
+     * @brief Установка количества потоков обработки.
+     * @param threads Количество потоков, 0 - по количеству процессоров.
+     *
+     * @~english
+     * @brief Setting the number of processing threads.
+     * @param threads Number of threads, 0 - by number of processors.
+     */
+    void setThreads(int threads);
+
+    /**
+     * @~russian
+     * @brief Установка параметров упаковки.
+     * @param level Уровень сжатия от 1 (быстрое) до 9 (наилучшее).
+     * @param packSize Наибольший размер архива в мегабайтах.
+     * @param inpx Сохранять каталог INPX.
+     *
+     * @~english
+     * @brief Setting packing options.
+     * @param level Compression level from 1 (fast) to 9 (best).
+     * @param packSize Largest archive size in megabytes.
+     * @param inpx Save INPX catalog.
+     */
+    void setPacking(int level, int packSize, bool inpx);
+
+    /**
+     * @~russian
+     * @brief Выполнение задания.
+     *
+     * @~english
+     * @brief Running the job.
+     */
+    void run();
+
+protected:
+    /**
+     * @~russian
+     * @brief Подготовка и запись одной книги в рабочем потоке.
+     * @param index Номер книги по порядку упаковки.
+     *
+     * @~english
+     * @brief Preparing and writing a single book in a worker thread.
+     * @param index Book number in packing order.
+     */
+    void processParallel(int index);
+
+private:
+    /**
+     * @~russian
+     * @brief Книга, подготовленная к записи в архив.
+     *
+     * @~english
+     * @brief Book prepared for writing to the archive.
+     */
+    struct PackEntry
+    {
+        QString name; ///< @~russian Имя файла книги. @~english Book file name.
+        QByteArray data; ///< @~russian Поток deflate. @~english Deflate stream.
+        quint32 crc; ///< @~russian Контрольная сумма книги. @~english Book checksum.
+        qint64 size; ///< @~russian Размер книги. @~english Book size.
+        QString error; ///< @~russian Описание ошибки, пустое - книга готова. @~english Error description, empty - the book is ready.
+    };
+
+    static const int maxPackEntries = 0xFFFF; ///< @~russian Файлов в zip без zip64. @~english Files in zip without zip64.
+    static const qint64 maxPackBytes = Q_INT64_C(0xFFFFFFFF) - 0x1000000; ///< @~russian Размер zip без zip64 с запасом на каталог. @~english Zip size without zip64 with reserve for the directory.
+
+    QVector<FileRecord> records; ///< @~russian Упаковываемые записи. @~english Packed records.
+    QVector<int> order; ///< @~russian Номера записей по порядку упаковки. @~english Record numbers in packing order.
+    QString targetDir; ///< @~russian Папка архивов. @~english Folder of archives.
+    int threads; ///< @~russian Количество потоков обработки. @~english Number of processing threads.
+    int level; ///< @~russian Уровень сжатия. @~english Compression level.
+    qint64 packSize; ///< @~russian Наибольший размер архива в байтах. @~english Largest archive size in bytes.
+    bool inpx; ///< @~russian Сохранять каталог INPX. @~english Save INPX catalog.
+
+    QMutex mtxWrite; ///< @~russian Защита записи архива. @~english Protection of archive writing.
+    QWaitCondition cndWrite; ///< @~russian Ожидание записи предыдущих книг. @~english Waiting for previous books to be written.
+    QMap<int, PackEntry> ready; ///< @~russian Подготовленные книги, ожидающие очереди. @~english Prepared books waiting for their turn.
+    int nextEntry; ///< @~russian Номер следующей записываемой книги. @~english Number of the next book to write.
+    int maxPending; ///< @~russian Наибольшее опережение подготовки. @~english Largest lead of preparation.
+
+    mz_zip_archive_tag *archive; ///< @~russian Текущий архив. @~english Current archive.
+    bool packOpen; ///< @~russian Текущий архив открыт. @~english The current archive is open.
+    bool broken; ///< @~russian Запись архивов невозможна. @~english Writing archives is impossible.
+    int packNumber; ///< @~russian Номер текущего архива. @~english Number of the current archive.
+    QString packName; ///< @~russian Имя файла текущего архива. @~english File name of the current archive.
+    QSet<QString> packNames; ///< @~russian Имена книг текущего архива. @~english Book names of the current archive.
+    qint64 centralSize; ///< @~russian Размер центрального каталога текущего архива. @~english Central directory size of the current archive.
+    QStringList packs; ///< @~russian Записанные архивы. @~english Written archives.
+    QByteArray mapping; ///< @~russian Таблица соответствия CSV. @~english CSV mapping.
+    QByteArray inp; ///< @~russian Строки .inp текущего архива. @~english .inp lines of the current archive.
+    QMap<QString, QByteArray> inpFiles; ///< @~russian Файлы .inp записанных архивов. @~english .inp files of written archives.
+    int written; ///< @~russian Записано книг. @~english Books written.
+    QAtomicInt failed; ///< @~russian Незаписанных книг. @~english Books not written.
+
+    /**
+     * @~russian
+     * @brief Упорядочивание книг по автору, серии и названию.
+     *
+     * @~english
+     * @brief Ordering books by author, series and title.
+     */
+    void sortRecords();
+
+    /**
+     * @~russian
+     * @brief Чтение книги и подготовка потока deflate.
+     * @param record Запись о файле.
+     * @return Подготовленная книга.
+     *
+     * @~english
+     * @brief Reading the book and preparing the deflate stream.
+     * @param record File record.
+     * @return Prepared book.
+     */
+    PackEntry prepareEntry(const FileRecord &record) const;
+
+    /**
+     * @~russian
+     * @brief Запись подготовленной книги в текущий архив.
+     * @param index Номер книги по порядку упаковки.
+     * @param entry Подготовленная книга.
+     *
+     * @~english
+     * @brief Writing the prepared book to the current archive.
+     * @param index Book number in packing order.
+     * @param entry Prepared book.
+     */
+    void writeEntry(int index, const PackEntry &entry);
+
+    /**
+     * @~russian
+     * @brief Создание следующего архива.
+     * @return @c true - если архив создан;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Creating the next archive.
+     * @return @c true - if the archive is created;@n
+     * @c false - if not.
+     */
+    bool openPack();
+
+    /**
+     * @~russian
+     * @brief Завершение текущего архива.
+     *
+     * @~english
+     * @brief Finishing the current archive.
+     */
+    void closePack();
+
+    /**
+     * @~russian
+     * @brief Сохранение таблицы соответствия и каталога INPX.
+     *
+     * @~english
+     * @brief Saving the mapping and INPX catalog.
+     */
+    void saveCatalogs();
+
+    /**
+     * @~russian
+     * @brief Формирование строки .inp.
+     * @param record Запись о файле.
+     * @param name Имя книги в архиве.
+     * @param size Размер книги.
+     * @param id Номер книги в каталоге.
+     * @return Строка в UTF-8.
+     *
+     * @~english
+     * @brief Building an .inp line.
+     * @param record File record.
+     * @param name Book name in the archive.
+     * @param size Book size.
+     * @param id Book number in the catalog.
+     * @return Line in UTF-8.
+     */
+    static QByteArray inpLine(const FileRecord &record, const QString &name, qint64 size, int id);
+};
+
+#endif // REPACKJOB_H
@@ -0,0 +1,170 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации арены памяти для разбора файлов.
+ *
+ * @~english
+ * @brief Source file for memory arena of file parsing.
+ */
+
+#include "scanarena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Size of the allocation header, keeps the returned memory aligned to 16 bytes
+const size_t headerSize = 16;
+
+// Blocks kept between files, the rest are released after an unusually large file
+const int keptBlocks = 4;
+
+static inline size_t alignedSize(size_t size)
+{
+    return (size + 15) & ~static_cast<size_t>(15);
+}
+
+static inline size_t &storedSize(char *address)
+{
+    return *reinterpret_cast<size_t *>(address - headerSize);
+}
+
+ScanArena::ScanArena(size_t blockSize)
+{
+    this->blockSize = alignedSize(blockSize);
+    current = -1;
+    offset = 0;
+    last = 0;
+}
+
+ScanArena::~ScanArena()
+{
+    reset();
+
+    QVector<char *>::iterator it;
+
+    for (it = blocks.begin(); it != blocks.end(); ++it)
+        ::free(*it);
+}
+
+void *ScanArena::allocate(size_t size)
+{
+    size_t needed = headerSize + alignedSize(size);
+
+    if (needed > blockSize)
+    {
+        char *area = static_cast<char *>(::malloc(needed));
+
+        if (!area)
+            return 0;
+
+        large.append(area);
+        storedSize(area + headerSize) = size;
+        return area + headerSize;
+    }
+
+    if ((current < 0) || (offset + needed > blockSize))
+    {
+        if (current + 1 == blocks.count())
+        {
+            char *block = static_cast<char *>(::malloc(blockSize));
+
+            if (!block)
+                return 0;
+
+            blocks.append(block);
+        }
+
+        ++current;
+        offset = 0;
+    }
+
+    last = blocks.at(current) + offset + headerSize;
+    offset += needed;
+    storedSize(last) = size;
+    return last;
+}
+
+void *ScanArena::reallocate(void *address, size_t size)
+{
+    if (!address)
+        return allocate(size);
+
+    char *area = static_cast<char *>(address);
+    size_t oldSize = storedSize(area);
+
+    // The last area of the current block grows in place, as miniz does with its directory arrays
+    if ((area == last) && (current >= 0))
+    {
+        size_t start = area - blocks.at(current);
+
+        if (start + alignedSize(size) <= blockSize)
+        {
+            offset = start + alignedSize(size);
+            storedSize(area) = size;
+            return area;
+        }
+    }
+
+    void *result = allocate(size);
+
+    if (result)
+        memcpy(result, area, oldSize < size ? oldSize : size);
+
+    return result;
+}
+
+void ScanArena::reset()
+{
+    QVector<char *>::iterator it;
+
+    for (it = large.begin(); it != large.end(); ++it)
+        ::free(*it);
+
+    large.clear();
+
+    while (blocks.count() > keptBlocks)
+    {
+        ::free(blocks.last());
+        blocks.removeLast();
+    }
+
+    current = -1;
+    offset = 0;
+    last = 0;
+}
+
+void *ScanArena::allocFunc(void *opaque, size_t items, size_t size)
+{
+    return static_cast<ScanArena *>(opaque)->allocate(items * size);
+}
+
+void ScanArena::freeFunc(void *opaque, void *address)
+{
+    // Memory is returned all at once by reset()
+    Q_UNUSED(opaque)
+    Q_UNUSED(address)
+}
+
+void *ScanArena::reallocFunc(void *opaque, void *address, size_t items, size_t size)
+{
+    return static_cast<ScanArena *>(opaque)->reallocate(address, items * size);
+}
@@ -0,0 +1,182 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef SCANARENA_H
+#define SCANARENA_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль арены памяти для временных данных разбора файлов.
+ *
+ * @~english
+ * @brief Module of memory arena for temporary data of file parsing.
+ */
+
+#include <QVector>
+#include <stddef.h>
+
+/**
+ * @~russian
+ * @brief Монотонная арена памяти для временных данных разбора одного файла.
+ *
+ * Память выделяется последовательно из блоков фиксированного размера, освобождение отдельных участков
+ * ничего не делает, вся память возвращается сразу методом reset() между файлами. Блоки при этом
+ * сохраняются и используются для следующего файла, поэтому при сканировании большого количества книг
+ * буферы распаковки (окно inflate, буфер чтения, каталог архива) не обращаются к системному распределителю.@n
+ * Арена не потокобезопасна: каждый поток чтения владеет своей ареной.
+ *
+ * @~english
+ * @brief Monotonic memory arena for temporary data of parsing a single file.
+ *
+ * Memory is allocated sequentially from fixed size blocks, releasing of individual areas does nothing,
+ * all memory is returned at once by reset() between files. The blocks are kept and reused for the next file,
+ * so when scanning a large number of books the unpacking buffers (inflate window, read buffer, archive
+ * directory) do not go to the system allocator.@n
+ * The arena is not thread-safe: each reading thread owns its own arena.
+ */
+class ScanArena
+{
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param blockSize Размер блока памяти, запросы больше блока выделяются отдельно.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param blockSize Size of memory block, requests larger than the block are allocated separately.
+     */
+    explicit ScanArena(size_t blockSize = 256 * 1024);
+
+    /**
+     * @~russian
+     * @brief Деструктор, освобождает все блоки.
+     *
+     * @~english
+     * @brief Destructor, releases all blocks.
+     */
+    ~ScanArena();
+
+    /**
+     * @~russian
+     * @brief Выделение памяти, выровненной на 16 байт.
+     * @param size Размер в байтах.
+     * @return Указатель на память или 0 при нехватке памяти.
+     *
+     * @~english
+     * @brief Allocating memory aligned to 16 bytes.
+     * @param size Size in bytes.
+     * @return Pointer to memory or 0 if out of memory.
+     */
+    void *allocate(size_t size);
+
+    /**
+     * @~russian
+     * @brief Изменение размера выделенной памяти.
+     *
+     * Последний выделенный участок расширяется на месте, если в блоке есть место, иначе содержимое копируется.
+     * @param address Ранее выделенная память или 0.
+     * @param size Новый размер в байтах.
+     * @return Указатель на память или 0 при нехватке памяти.
+     *
+     * @~english
+     * @brief Changing size of allocated memory.
+     *
+     * The last allocated area is grown in place if the block has room, otherwise the contents are copied.
+     * @param address Previously allocated memory or 0.
+     * @param size New size in bytes.
+     * @return Pointer to memory or 0 if out of memory.
+     */
+    void *reallocate(void *address, size_t size);
+
+    /**
+     * @~russian
+     * @brief Возврат всей выделенной памяти перед разбором следующего файла.
+     *
+     * Отдельно выделенные большие участки освобождаются, блоки сохраняются.
+     *
+     * @~english
+     * @brief Returning all allocated memory before parsing the next file.
+     *
+     * Separately allocated large areas are released, the blocks are kept.
+     */
+    void reset();
+
+    /**
+     * @~russian
+     * @brief Функция выделения памяти для miniz (mz_alloc_func).
+     * @param opaque Указатель на арену.
+     * @param items Количество элементов.
+     * @param size Размер элемента.
+     * @return Указатель на память.
+     *
+     * @~english
+     * @brief Memory allocation function for miniz (mz_alloc_func).
+     * @param opaque Pointer to the arena.
+     * @param items Number of items.
+     * @param size Item size.
+     * @return Pointer to memory.
+     */
+    static void *allocFunc(void *opaque, size_t items, size_t size);
+
+    /**
+     * @~russian
+     * @brief Функция освобождения памяти для miniz (mz_free_func), ничего не делает.
+     * @param opaque Указатель на арену.
+     * @param address Освобождаемая память.
+     *
+     * @~english
+     * @brief Memory release function for miniz (mz_free_func), does nothing.
+     * @param opaque Pointer to the arena.
+     * @param address Released memory.
+     */
+    static void freeFunc(void *opaque, void *address);
+
+    /**
+     * @~russian
+     * @brief Функция изменения размера памяти для miniz (mz_realloc_func).
+     * @param opaque Указатель на арену.
+     * @param address Ранее выделенная память.
+     * @param items Количество элементов.
+     * @param size Размер элемента.
+     * @return Указатель на память.
+     *
+     * @~english
+     * @brief Memory resizing function for miniz (mz_realloc_func).
+     * @param opaque Pointer to the arena.
+     * @param address Previously allocated memory.
+     * @param items Number of items.
+     * @param size Item size.
+     * @return Pointer to memory.
+     */
+    static void *reallocFunc(void *opaque, void *address, size_t items, size_t size);
+
+private:
+    Q_DISABLE_COPY(ScanArena)
+
+    size_t blockSize; ///< @~russian Размер блока. @~english Block size.
+    QVector<char *> blocks; ///< @~russian Блоки памяти. @~english Memory blocks.
+    QVector<char *> large; ///< @~russian Отдельно выделенные участки. @~english Separately allocated areas.
+    int current; ///< @~russian Номер текущего блока, -1 - нет. @~english Number of current block, -1 - none.
+    size_t offset; ///< @~russian Занятая часть текущего блока. @~english Used part of current block.
+    char *last; ///< @~russian Последний выделенный участок. @~english Last allocated area.
+};
+
+#endif // SCANARENA_H
@@ -0,0 +1,229 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#include "scanreport.h"
+#include "csv.h"
+
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+void ScanReport::add(const Sample &sample)
+{
+    addTo(directories, QFileInfo(sample.fileName).absolutePath(), sample);
+    addTo(types, typeKey(sample.archive, sample.encoding), sample);
+}
+
+void ScanReport::clear()
+{
+    directories.clear();
+    types.clear();
+}
+
+bool ScanReport::isEmpty() const
+{
+    return types.isEmpty();
+}
+
+QVector<ScanReport::Entry> ScanReport::getEntries(Grouping grouping) const
+{
+    QMap<QString, Entry> subtrees;
+
+    if (grouping == grSubtree)
+        subtrees = getSubtrees();
+
+    const QMap<QString, Entry> &entries = (grouping == grDirectory) ? directories :
+                                          (grouping == grSubtree) ? subtrees : types;
+    QVector<Entry> result;
+    result.reserve(entries.size());
+    QMap<QString, Entry>::const_iterator it;
+
+    for (it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        result.append(it.value());
+    }
+
+    return result;
+}
+
+QByteArray ScanReport::toCsv(Grouping grouping) const
+{
+    QByteArray csv = (grouping == grDirectory) ? "directory" : (grouping == grSubtree) ? "subtree" : "type";
+    csv.append(",files,errors,size,bytes_read,bytes_inflated,parse_ns,total_ns\n");
+
+    QVector<Entry> entries = getEntries(grouping);
+    QVector<Entry>::const_iterator it;
+
+    for (it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        csv.append(Csv::field((*it).key));
+        csv.append(',').append(QByteArray::number((*it).files));
+        csv.append(',').append(QByteArray::number((*it).errors));
+        csv.append(',').append(QByteArray::number((*it).size));
+        csv.append(',').append(QByteArray::number((*it).bytesRead));
+        csv.append(',').append(QByteArray::number((*it).bytesInflated));
+        csv.append(',').append(QByteArray::number((*it).parseTime));
+        csv.append(',').append(QByteArray::number((*it).totalTime));
+        csv.append('\n');
+    }
+
+    return csv;
+}
+
+/*
+ * Report rows as JSON array, 64-bit values are stored as doubles, which is exact up to 2^53.
+ */
+static QJsonArray jsonEntries(const QVector<ScanReport::Entry> &entries, const QString &keyName)
+{
+    QJsonArray array;
+    QVector<ScanReport::Entry>::const_iterator it;
+
+    for (it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        QJsonObject row;
+        row.insert(keyName, (*it).key);
+        row.insert("files", static_cast<double>((*it).files));
+        row.insert("errors", static_cast<double>((*it).errors));
+        row.insert("size", static_cast<double>((*it).size));
+        row.insert("bytes_read", static_cast<double>((*it).bytesRead));
+        row.insert("bytes_inflated", static_cast<double>((*it).bytesInflated));
+        row.insert("parse_ns", static_cast<double>((*it).parseTime));
+        row.insert("total_ns", static_cast<double>((*it).totalTime));
+        array.append(row);
+    }
+
+    return array;
+}
+
+QByteArray ScanReport::toJson() const
+{
+    QJsonObject root;
+    root.insert("directories", jsonEntries(getEntries(grDirectory), "directory"));
+    root.insert("subtrees", jsonEntries(getEntries(grSubtree), "subtree"));
+    root.insert("types", jsonEntries(getEntries(grType), "type"));
+    return QJsonDocument(root).toJson();
+}
+
+QString ScanReport::typeKey(bool archive, const QString &encoding)
+{
+    QString type = archive ? "fb2.zip" : "fb2";
+    QString name = encoding.trimmed().toLower();
+    return type + ", " + (name.isEmpty() ? QString("?") : name);
+}
+
+void ScanReport::addTo(QMap<QString, Entry> &entries, const QString &key, const Sample &sample)
+{
+    QMap<QString, Entry>::iterator it = entries.find(key);
+
+    if (it == entries.end())
+    {
+        Entry entry = {key, 0, 0, 0, 0, 0, 0, 0};
+        it = entries.insert(key, entry);
+    }
+
+    Entry &entry = it.value();
+    entry.files++;
+    entry.errors += sample.error ? 1 : 0;
+    entry.size += sample.size;
+    entry.bytesRead += sample.bytesRead;
+    entry.bytesInflated += sample.bytesInflated;
+    entry.parseTime += sample.parseTime;
+    entry.totalTime += sample.totalTime;
+}
+
+/*
+ * Parent folder of the path, the path itself for the root.
+ */
+static QString parentPath(const QString &path)
+{
+    return QFileInfo(path).path();
+}
+
+/*
+ * Check whether the folder is the ancestor path or lies inside it.
+ */
+static bool isInside(const QString &path, const QString &ancestor)
+{
+    if (path == ancestor)
+        return true;
+
+    return path.startsWith(ancestor.endsWith('/') ? ancestor : ancestor + '/');
+}
+
+QMap<QString, ScanReport::Entry> ScanReport::getSubtrees() const
+{
+    QMap<QString, Entry> subtrees;
+
+    if (directories.isEmpty())
+        return subtrees;
+
+    // Common folder of all rows, subtrees above it would only repeat its totals
+    QString common = directories.constBegin().key();
+    QMap<QString, Entry>::const_iterator it;
+
+    for (it = directories.constBegin(); it != directories.constEnd(); ++it)
+    {
+        while (!isInside(it.key(), common))
+        {
+            QString parent = parentPath(common);
+
+            if (parent == common)
+                break;
+
+            common = parent;
+        }
+    }
+
+    for (it = directories.constBegin(); it != directories.constEnd(); ++it)
+    {
+        const Entry &source = it.value();
+        QString path = it.key();
+
+        while (true)
+        {
+            QMap<QString, Entry>::iterator subtree = subtrees.find(path);
+
+            if (subtree == subtrees.end())
+            {
+                Entry entry = {path, 0, 0, 0, 0, 0, 0, 0};
+                subtree = subtrees.insert(path, entry);
+            }
+
+            Entry &entry = subtree.value();
+            entry.files += source.files;
+            entry.errors += source.errors;
+            entry.size += source.size;
+            entry.bytesRead += source.bytesRead;
+            entry.bytesInflated += source.bytesInflated;
+            entry.parseTime += source.parseTime;
+            entry.totalTime += source.totalTime;
+
+            QString parent = parentPath(path);
+
+            if ((path == common) || (parent == path))
+                break;
+
+            path = parent;
+        }
+    }
+
+    return subtrees;
+}
@@ -0,0 +1,235 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef SCANREPORT_H
+#define SCANREPORT_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль отчета о производительности сканирования.
+ *
+ * @~english
+ * @brief Module of scan performance report.
+ */
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMap>
+
+/**
+ * @~russian
+ * @brief Отчет о сканировании по папкам и типам файлов.
+ *
+ * Замеры каждого файла суммируются в строку его папки и в строку его типа (архив или обычный файл
+ * и кодировка). Строки поддеревьев суммируют папку вместе со всеми вложенными папками, вплоть до общей
+ * папки всех просканированных файлов. По отчету видно, какие папки и поддеревья замедляют сканирование:
+ * большие иллюстрированные книги, медленные сетевые диски, поврежденные файлы.
+ *
+ * @~english
+ * @brief Scan report by folders and file types.
+ *
+ * Measurements of each file are summed to the row of its folder and to the row of its type (archive or plain file
+ * and encoding). Subtree rows sum a folder together with all nested folders, up to the common folder of all scanned
+ * files. The report shows which folders and subtrees slow the scan down: large illustrated books, slow network
+ * drives, broken files.
+ */
+class ScanReport
+{
+public:
+    /**
+     * @~russian
+     * @brief Способ группировки строк отчета.
+     *
+     * @~english
+     * @brief Grouping of report rows.
+     */
+    enum Grouping
+    {
+        grDirectory, ///< @~russian По папкам. @~english By folders.
+        grSubtree, ///< @~russian По поддеревьям папок. @~english By folder subtrees.
+        grType ///< @~russian По типам файлов. @~english By file types.
+    };
+
+    /**
+     * @~russian
+     * @brief Замеры одного файла.
+     *
+     * @~english
+     * @brief Measurements of one file.
+     */
+    struct Sample
+    {
+        QString fileName; ///< @~russian Имя файла. @~english File name.
+        bool archive; ///< @~russian Файл - архив. @~english File is archive.
+        QString encoding; ///< @~russian Кодировка книги. @~english Book encoding.
+        qint64 size; ///< @~russian Размер файла. @~english File size.
+        qint64 bytesRead; ///< @~russian Прочитано байт с диска. @~english Bytes read from disk.
+        qint64 bytesInflated; ///< @~russian Распаковано байт. @~english Bytes inflated.
+        qint64 parseTime; ///< @~russian Время разбора XML, нс. @~english XML parse time, ns.
+        qint64 totalTime; ///< @~russian Общее время обработки файла, нс. @~english Total file processing time, ns.
+        bool error; ///< @~russian Файл не прочитан или поврежден. @~english File is not read or broken.
+    };
+
+    /**
+     * @~russian
+     * @brief Строка отчета - сумма замеров группы файлов.
+     *
+     * @~english
+     * @brief Report row - sum of measurements of a group of files.
+     */
+    struct Entry
+    {
+        QString key; ///< @~russian Папка или тип файлов. @~english Folder or file type.
+        qint64 files; ///< @~russian Количество файлов. @~english Number of files.
+        qint64 errors; ///< @~russian Количество ошибок. @~english Number of errors.
+        qint64 size; ///< @~russian Размер файлов. @~english Size of files.
+        qint64 bytesRead; ///< @~russian Прочитано байт с диска. @~english Bytes read from disk.
+        qint64 bytesInflated; ///< @~russian Распаковано байт. @~english Bytes inflated.
+        qint64 parseTime; ///< @~russian Время разбора XML, нс. @~english XML parse time, ns.
+        qint64 totalTime; ///< @~russian Общее время обработки, нс. @~english Total processing time, ns.
+    };
+
+    /**
+     * @~russian
+     * @brief Добавление замеров файла в отчет.
+     * @param sample Замеры файла.
+     *
+     * @~english
+     * @brief Adding file measurements to the report.
+     * @param sample File measurements.
+     */
+    void add(const Sample &sample);
+
+    /**
+     * @~russian
+     * @brief Очистка отчета.
+     *
+     * @~english
+     * @brief Clearing the report.
+     */
+    void clear();
+
+    /**
+     * @~russian
+     * @brief Проверка, есть ли в отчете данные.
+     * @return @c true - если отчет пуст;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Checking whether the report has data.
+     * @return @c true - if the report is empty;@n
+     * @c false - if not.
+     */
+    bool isEmpty() const;
+
+    /**
+     * @~russian
+     * @brief Получение строк отчета.
+     * @param grouping Способ группировки.
+     * @return Строки отчета, упорядоченные по ключу.
+     *
+     * @~english
+     * @brief Getting report rows.
+     * @param grouping Grouping of rows.
+     * @return Report rows ordered by the key.
+     */
+    QVector<Entry> getEntries(Grouping grouping) const;
+
+    /**
+     * @~russian
+     * @brief Выгрузка отчета в формате CSV.
+     * @param grouping Способ группировки.
+     * @return Текст CSV в UTF-8.
+     *
+     * @~english
+     * @brief Exporting the report in CSV format.
+     * @param grouping Grouping of rows.
+     * @return CSV text in UTF-8.
+     */
+    QByteArray toCsv(Grouping grouping) const;
+
+    /**
+     * @~russian
+     * @brief Выгрузка отчета в формате JSON.
+     *
+     * Документ содержит все группировки: по папкам, по поддеревьям и по типам файлов.
+     * @return Документ JSON.
+     *
+     * @~english
+     * @brief Exporting the report in JSON format.
+     *
+     * The document contains all groupings: by folders, by subtrees and by file types.
+     * @return JSON document.
+     */
+    QByteArray toJson() const;
+
+    /**
+     * @~russian
+     * @brief Получение ключа типа файла.
+     * @param archive Файл - архив.
+     * @param encoding Кодировка книги.
+     * @return Ключ типа, например "fb2.zip, windows-1251".
+     *
+     * @~english
+     * @brief Getting the file type key.
+     * @param archive File is archive.
+     * @param encoding Book encoding.
+     * @return Type key, for example "fb2.zip, windows-1251".
+     */
+    static QString typeKey(bool archive, const QString &encoding);
+
+private:
+    QMap<QString, Entry> directories; ///< @~russian Строки по папкам. @~english Rows by folders.
+    QMap<QString, Entry> types; ///< @~russian Строки по типам файлов. @~english Rows by file types.
+
+    /**
+     * @~russian
+     * @brief Добавление замеров файла в строку отчета.
+     * @param entries Строки отчета.
+     * @param key Ключ строки.
+     * @param sample Замеры файла.
+     *
+     * @~english
+     * @brief Adding file measurements to the report row.
+     * @param entries Report rows.
+     * @param key Row key.
+     * @param sample File measurements.
+     */
+    static void addTo(QMap<QString, Entry> &entries, const QString &key, const Sample &sample);
+
+    /**
+     * @~russian
+     * @brief Суммирование строк папок в строки поддеревьев.
+     *
+     * Строка каждой папки добавляется к ней самой и ко всем родительским папкам до общей папки всех строк.
+     * @return Строки поддеревьев по ключу.
+     *
+     * @~english
+     * @brief Summing folder rows to subtree rows.
+     *
+     * The row of each folder is added to itself and to all parent folders up to the common folder of all rows.
+     * @return Subtree rows by the key.
+     */
+    QMap<QString, Entry> getSubtrees() const;
+};
+
+#endif // SCANREPORT_H
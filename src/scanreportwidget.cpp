@@ -0,0 +1,143 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для виджета отчета о сканировании.
+ *
+ * @~english
+ * @brief Source file for scan report widget.
+ */
+
+#include "scanreportwidget.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QComboBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QSaveFile>
+
+ScanReportWidget::ScanReportWidget(QWidget *parent) :
+    QWidget(parent)
+{
+    cmbGrouping = new QComboBox();
+    cmbGrouping->addItem(tr("By folder"), ScanReport::grDirectory);
+    cmbGrouping->addItem(tr("By subtree"), ScanReport::grSubtree);
+    cmbGrouping->addItem(tr("By file type"), ScanReport::grType);
+    connect(cmbGrouping, SIGNAL(currentIndexChanged(int)), this, SLOT(onFill()));
+
+    btnExport = new QPushButton(tr("Export..."));
+    connect(btnExport, SIGNAL(clicked()), this, SLOT(onExport()));
+
+    boxControls = new QHBoxLayout();
+    boxControls->addWidget(cmbGrouping);
+    boxControls->addStretch();
+    boxControls->addWidget(btnExport);
+
+    treeReport = new QTreeWidget();
+    treeReport->setHeaderLabels(QStringList() << tr("Folder") << tr("Files") << tr("Errors") << tr("Size, KB")
+                                << tr("Read, KB") << tr("Inflated, KB") << tr("Parse, ms") << tr("Total, ms"));
+    treeReport->setRootIsDecorated(false);
+    treeReport->setUniformRowHeights(true);
+    treeReport->setSortingEnabled(true);
+    treeReport->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    treeReport->header()->setStretchLastSection(false);
+
+    boxMain = new QVBoxLayout();
+    boxMain->setContentsMargins(0, 0, 0, 0);
+    boxMain->addLayout(boxControls);
+    boxMain->addWidget(treeReport);
+    this->setLayout(boxMain);
+}
+
+ScanReportWidget::~ScanReportWidget()
+{
+    delete treeReport;
+    delete btnExport;
+    delete cmbGrouping;
+    delete boxControls;
+    delete boxMain;
+}
+
+void ScanReportWidget::setReport(const ScanReport &report)
+{
+    this->report = report;
+    onFill();
+}
+
+void ScanReportWidget::onFill()
+{
+    ScanReport::Grouping grouping = static_cast<ScanReport::Grouping>(cmbGrouping->currentData().toInt());
+    QVector<ScanReport::Entry> entries = report.getEntries(grouping);
+    QList<QTreeWidgetItem *> items;
+    QVector<ScanReport::Entry>::const_iterator it;
+
+    treeReport->headerItem()->setText(0, (grouping == ScanReport::grType) ? tr("File type") : tr("Folder"));
+
+    // Numbers are stored as values, so the columns are sorted numerically
+    for (it = entries.constBegin(); it != entries.constEnd(); ++it)
+    {
+        QTreeWidgetItem *item = new QTreeWidgetItem();
+        item->setText(0, (*it).key);
+        item->setData(1, Qt::DisplayRole, (*it).files);
+        item->setData(2, Qt::DisplayRole, (*it).errors);
+        item->setData(3, Qt::DisplayRole, (*it).size / 1024);
+        item->setData(4, Qt::DisplayRole, (*it).bytesRead / 1024);
+        item->setData(5, Qt::DisplayRole, (*it).bytesInflated / 1024);
+        item->setData(6, Qt::DisplayRole, qRound64((*it).parseTime / 100000.0) / 10.0);
+        item->setData(7, Qt::DisplayRole, qRound64((*it).totalTime / 100000.0) / 10.0);
+
+        for (int column = 1; column < item->columnCount(); ++column)
+            item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+
+        if ((*it).errors > 0)
+            item->setForeground(2, Qt::red);
+
+        items.append(item);
+    }
+
+    treeReport->clear();
+    treeReport->addTopLevelItems(items);
+}
+
+void ScanReportWidget::onExport()
+{
+    QString selected;
+    QString filename = QFileDialog::getSaveFileName(this, tr("Export scan report"), QString(),
+                       tr("CSV (*.csv);;JSON (*.json)"), &selected);
+
+    if (filename.isEmpty())
+        return;
+
+    bool json = filename.endsWith(".json", Qt::CaseInsensitive) ||
+                ((!filename.endsWith(".csv", Qt::CaseInsensitive)) && (selected.contains("json")));
+    ScanReport::Grouping grouping = static_cast<ScanReport::Grouping>(cmbGrouping->currentData().toInt());
+    QByteArray data = json ? report.toJson() : report.toCsv(grouping);
+    QSaveFile file(filename);
+
+    if ((file.open(QIODevice::WriteOnly)) && (file.write(data) == data.size()) && (file.commit()))
+        emit EventMessage(tr("Scan report saved to %1").arg(filename));
+    else
+        emit ErrorMessage(tr("Cannot save scan report to %1").arg(filename));
+}
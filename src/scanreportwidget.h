@@ -0,0 +1,141 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+
+#ifndef SCANREPORTWIDGET_H
+#define SCANREPORTWIDGET_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль виджета отчета о сканировании.
+ *
+ * @~english
+ * @brief Module of scan report widget.
+ */
+
+#include "scanreport.h"
+
+#include <QWidget>
+
+// Forward class declarations
+class QVBoxLayout;
+class QHBoxLayout;
+class QComboBox;
+class QPushButton;
+class QTreeWidget;
+
+/**
+ * @~russian
+ * @brief Виджет отчета о сканировании.
+ *
+ * Показывает отчет таблицей, которую можно сортировать по любому столбцу, и сохраняет его в CSV или JSON.
+ *
+ * @~english
+ * @brief Scan report widget.
+ *
+ * Shows the report as a table sortable by any column, and saves it to CSV or JSON.
+ */
+class ScanReportWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор виджета.
+     * @param parent Родительский виджет.
+     *
+     * @~english
+     * @brief Constructor of the widget.
+     * @param parent Parent widget.
+     */
+    explicit ScanReportWidget(QWidget *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор виджета.
+     *
+     * @~english
+     * @brief Destructor of the widget.
+     */
+    virtual ~ScanReportWidget();
+
+    /**
+     * @~russian
+     * @brief Установка отображаемого отчета.
+     * @param report Отчет о сканировании.
+     *
+     * @~english
+     * @brief Setting the displayed report.
+     * @param report Scan report.
+     */
+    void setReport(const ScanReport &report);
+
+signals:
+    /**
+     * @~russian
+     * @brief Сообщение о событии.
+     * @param msg Текст сообщения.
+     *
+     * @~english
+     * @brief Event message.
+     * @param msg Message text.
+     */
+    void EventMessage(const QString &msg);
+
+    /**
+     * @~russian
+     * @brief Сообщение об ошибке.
+     * @param msg Текст сообщения.
+     *
+     * @~english
+     * @brief Error message.
+     * @param msg Message text.
+     */
+    void ErrorMessage(const QString &msg);
+
+private slots:
+    /**
+     * @~russian
+     * @brief Заполнение таблицы по выбранной группировке.
+     *
+     * @~english
+     * @brief Filling the table by the chosen grouping.
+     */
+    void onFill();
+
+    /**
+     * @~russian
+     * @brief Сохранение отчета в файл CSV или JSON.
+     *
+     * @~english
+     * @brief Saving the report to CSV or JSON file.
+     */
+    void onExport();
+
+private:
+    QVBoxLayout *boxMain; ///< @~russian Компоновка виджета. @~english Widget layout.
+    QHBoxLayout *boxControls; ///< @~russian Компоновка элементов управления. @~english Layout of controls.
+    QComboBox *cmbGrouping; ///< @~russian Выбор группировки. @~english Grouping selector.
+    QPushButton *btnExport; ///< @~russian Кнопка сохранения. @~english Export button.
+    QTreeWidget *treeReport; ///< @~russian Таблица отчета. @~english Report table.
+    ScanReport report; ///< @~russian Отображаемый отчет. @~english Displayed report.
+};
+
+#endif // SCANREPORTWIDGET_H
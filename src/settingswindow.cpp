@@ -31,6 +31,11 @@
 #include <QMessageBox>
 #include <QSettings>
 #include <QTabWidget>
+#include <QFormLayout>
+#include <QSpinBox>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QThread>
 
 SettingsWindow::SettingsWindow(QWidget *parent)
     : QDialog(parent)
@@ -46,9 +51,71 @@ SettingsWindow::SettingsWindow(QWidget *parent)
     hlpExternalEditors = new SettingsHelper();
     hlpExternalEditors->setHelpString(tr("%1 - name of book file substituted to command line"));
 
+    spnThreads = new QSpinBox();
+    spnThreads->setRange(0, 64);
+    spnThreads->setSpecialValueText(tr("Auto (%1)").arg(QThread::idealThreadCount()));
+
+    // Item data is the miniz compression level
+    cbCompressionLevel = new QComboBox();
+    cbCompressionLevel->addItem(tr("Fast"), 1);
+    cbCompressionLevel->addItem(tr("Default"), 6);
+    cbCompressionLevel->addItem(tr("Best"), 9);
+
+    spnMaxCompressionRatio = new QSpinBox();
+    spnMaxCompressionRatio->setRange(0, 100);
+    spnMaxCompressionRatio->setSuffix("%");
+    spnMaxCompressionRatio->setSpecialValueText(tr("Always keep"));
+    spnMaxCompressionRatio->setToolTip(tr("The file is left uncompressed if the archive is larger than "
+                                          "this percentage of the file size, 0 - the archive is always kept"));
+
+    spnImageQuality = new QSpinBox();
+    spnImageQuality->setRange(1, 100);
+    spnImageQuality->setSuffix("%");
+    spnImageQuality->setToolTip(tr("JPEG quality of images saved by the image optimization"));
+
+    spnMaxImageSize = new QSpinBox();
+    spnMaxImageSize->setRange(0, 10000);
+    spnMaxImageSize->setSingleStep(100);
+    spnMaxImageSize->setSuffix(tr(" px"));
+    spnMaxImageSize->setSpecialValueText(tr("No limit"));
+    spnMaxImageSize->setToolTip(tr("Larger images are scaled down by the image optimization"));
+
+    boxProcessing = new QFormLayout();
+    boxProcessing->addRow(tr("Processing threads"), spnThreads);
+    boxProcessing->addRow(tr("Compression level"), cbCompressionLevel);
+    chkCanonicalAuthors = new QCheckBox(tr("Use one spelling of the author name in templates"));
+    chkCanonicalAuthors->setToolTip(tr("Different spellings of the same author are replaced with the most common one, "
+                                       "so books of the author are placed in one folder"));
+
+    boxProcessing->addRow(tr("Maximum archive size"), spnMaxCompressionRatio);
+    boxProcessing->addRow(tr("Image quality"), spnImageQuality);
+    boxProcessing->addRow(tr("Maximum image size"), spnMaxImageSize);
+    boxProcessing->addRow(chkCanonicalAuthors);
+
+    chkAnalyzeBodies = new QCheckBox(tr("Count words and pages after reading files"));
+    chkAnalyzeBodies->setToolTip(tr("The text of each book is read once, the results are kept in the cache "
+                                    "until the file is changed"));
+    boxProcessing->addRow(chkAnalyzeBodies);
+
+    // Zip without zip64 is limited to 4 GB
+    spnPackSize = new QSpinBox();
+    spnPackSize->setRange(16, 4000);
+    spnPackSize->setSingleStep(64);
+    spnPackSize->setSuffix(tr(" MB"));
+    spnPackSize->setToolTip(tr("Repacking starts a new archive when the next book would exceed this size"));
+    boxProcessing->addRow(tr("Shared archive size"), spnPackSize);
+
+    chkWriteInpx = new QCheckBox(tr("Save INPX catalog of shared archives"));
+    chkWriteInpx->setToolTip(tr("The catalog lists the books of every archive for library programs"));
+    boxProcessing->addRow(chkWriteInpx);
+
+    wgtProcessing = new QWidget();
+    wgtProcessing->setLayout(boxProcessing);
+
     tbMain = new QTabWidget();
     tbMain->addTab(hlpRenameTemplates, tr("Rename templates"));
     tbMain->addTab(hlpExternalEditors, tr("External Editors"));
+    tbMain->addTab(wgtProcessing, tr("Processing"));
 
     boxButtons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
     connect(boxButtons, SIGNAL(accepted()), this, SLOT(accept()));
@@ -86,10 +153,34 @@ SettingsWindow::SettingsWindow(QWidget *parent)
 
     hlpExternalEditors->setSettingsList(lstExtEditors);
     settings.endArray();
+
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    spnThreads->setValue(settings.value(NAMES::nameThreads, 0).toInt());
+    int level = cbCompressionLevel->findData(settings.value(NAMES::nameCompressionLevel, 9).toInt());
+    cbCompressionLevel->setCurrentIndex(level != -1 ? level : cbCompressionLevel->count() - 1);
+    spnMaxCompressionRatio->setValue(settings.value(NAMES::nameMaxCompressionRatio, 0).toInt());
+    spnImageQuality->setValue(settings.value(NAMES::nameImageQuality, 80).toInt());
+    spnMaxImageSize->setValue(settings.value(NAMES::nameMaxImageSize, 1600).toInt());
+    chkCanonicalAuthors->setChecked(settings.value(NAMES::nameCanonicalAuthors, false).toBool());
+    chkAnalyzeBodies->setChecked(settings.value(NAMES::nameAnalyzeBodies, false).toBool());
+    spnPackSize->setValue(settings.value(NAMES::namePackSize, 1024).toInt());
+    chkWriteInpx->setChecked(settings.value(NAMES::nameWriteInpx, true).toBool());
+    settings.endGroup();
 }
 
 SettingsWindow::~SettingsWindow()
 {
+    delete chkWriteInpx;
+    delete spnPackSize;
+    delete chkAnalyzeBodies;
+    delete chkCanonicalAuthors;
+    delete spnMaxImageSize;
+    delete spnImageQuality;
+    delete spnMaxCompressionRatio;
+    delete cbCompressionLevel;
+    delete spnThreads;
+    delete boxProcessing;
+    delete wgtProcessing;
     delete hlpExternalEditors;
     delete hlpRenameTemplates;
     delete tbMain;
@@ -140,5 +231,17 @@ void SettingsWindow::accept()
 
     settings.endArray();
 
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    settings.setValue(NAMES::nameThreads, spnThreads->value());
+    settings.setValue(NAMES::nameCompressionLevel, cbCompressionLevel->currentData().toInt());
+    settings.setValue(NAMES::nameMaxCompressionRatio, spnMaxCompressionRatio->value());
+    settings.setValue(NAMES::nameImageQuality, spnImageQuality->value());
+    settings.setValue(NAMES::nameMaxImageSize, spnMaxImageSize->value());
+    settings.setValue(NAMES::nameCanonicalAuthors, chkCanonicalAuthors->isChecked());
+    settings.setValue(NAMES::nameAnalyzeBodies, chkAnalyzeBodies->isChecked());
+    settings.setValue(NAMES::namePackSize, spnPackSize->value());
+    settings.setValue(NAMES::nameWriteInpx, chkWriteInpx->isChecked());
+    settings.endGroup();
+
     QDialog::accept();
 }
@@ -39,6 +39,10 @@ class QDialogButtonBox;
 class QPushButton;
 class QListWidget;
 class QTabWidget;
+class QFormLayout;
+class QSpinBox;
+class QComboBox;
+class QCheckBox;
 
 /**
  * @~russian
@@ -152,6 +156,105 @@ private:
      */
     SettingsHelper *hlpExternalEditors;
 
+    /**
+     * @~russian
+     * @brief Страница параметров обработки файлов.
+     *
+     * @~english
+     * @brief Page of file processing settings.
+     */
+    QWidget *wgtProcessing;
+
+    /**
+     * @~russian
+     * @brief Менеджер размещения параметров обработки файлов.
+     *
+     * @~english
+     * @brief Layout manager for file processing settings.
+     */
+    QFormLayout *boxProcessing;
+
+    /**
+     * @~russian
+     * @brief Количество потоков обработки.
+     *
+     * @~english
+     * @brief Number of processing threads.
+     */
+    QSpinBox *spnThreads;
+
+    /**
+     * @~russian
+     * @brief Уровень сжатия.
+     *
+     * @~english
+     * @brief Compression level.
+     */
+    QComboBox *cbCompressionLevel;
+
+    /**
+     * @~russian
+     * @brief Максимальное отношение размера архива к размеру файла.
+     *
+     * @~english
+     * @brief Maximum ratio of archive size to file size.
+     */
+    QSpinBox *spnMaxCompressionRatio;
+
+    /**
+     * @~russian
+     * @brief Качество JPEG при пережатии изображений.
+     *
+     * @~english
+     * @brief JPEG quality of image recompression.
+     */
+    QSpinBox *spnImageQuality;
+
+    /**
+     * @~russian
+     * @brief Наибольший размер изображения.
+     *
+     * @~english
+     * @brief Largest image size.
+     */
+    QSpinBox *spnMaxImageSize;
+
+    /**
+     * @~russian
+     * @brief Подстановка канонических имен авторов в шаблоны.
+     *
+     * @~english
+     * @brief Substitution of canonical author names in templates.
+     */
+    QCheckBox *chkCanonicalAuthors;
+
+    /**
+     * @~russian
+     * @brief Анализ текста книг после чтения.
+     *
+     * @~english
+     * @brief Analysis of book text after reading.
+     */
+    QCheckBox *chkAnalyzeBodies;
+
+    /**
+     * @~russian
+     * @brief Наибольший размер общего архива.
+     *
+     * @~english
+     * @brief Largest size of a shared archive.
+     */
+    QSpinBox *spnPackSize;
+
+    /**
+     * @~russian
+     * @brief Сохранение каталога INPX общих архивов.
+     *
+     * @~english
+     * @brief Saving INPX catalog of shared archives.
+     */
+    QCheckBox *chkWriteInpx;
+
 private slots:
 
 };
@@ -0,0 +1,200 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации поиска книг с почти одинаковым текстом.
+ *
+ * @~english
+ * @brief Source file for searching books with nearly identical text.
+ */
+
+#include "similarityindex.h"
+
+#include <algorithm>
+
+SimilarityIndex::SimilarityIndex(double threshold) :
+    threshold(threshold)
+{
+}
+
+void SimilarityIndex::clear()
+{
+    rows.clear();
+    fingerprints.clear();
+    parents.clear();
+    groups.clear();
+}
+
+int SimilarityIndex::findRoot(int id)
+{
+    int root = id;
+
+    while (parents.at(root) != root)
+        root = parents.at(root);
+
+    while (parents.at(id) != root)
+    {
+        int next = parents.at(id);
+        parents[id] = root;
+        id = next;
+    }
+
+    return root;
+}
+
+void SimilarityIndex::compare(int a, int b)
+{
+    int rootA = findRoot(a);
+    int rootB = findRoot(b);
+
+    // Books already in one group are not compared again
+    if (rootA == rootB)
+        return;
+
+    if (similarity(fingerprints.at(a), fingerprints.at(b)) >= threshold)
+        parents[qMax(rootA, rootB)] = qMin(rootA, rootB);
+}
+
+void SimilarityIndex::build(const QVector<FileRecord> &records)
+{
+    clear();
+
+    for (int row = 0; row < records.size(); ++row)
+    {
+        const QVector<quint32> &fingerprint = records.at(row).getBodyStatistics().fingerprint;
+
+        if (fingerprint.size() == BodyStatistics::fingerprintSize)
+        {
+            rows.append(row);
+            fingerprints.append(fingerprint);
+        }
+    }
+
+    parents.resize(rows.size());
+
+    for (int i = 0; i < parents.size(); ++i)
+    {
+        parents[i] = i;
+    }
+
+    QVector<BucketEntry> buckets(rows.size());
+
+    for (int band = 0; band < BodyStatistics::fingerprintSize / bandRows; ++band)
+    {
+        for (int i = 0; i < rows.size(); ++i)
+        {
+            const quint32 *values = fingerprints.at(i).constData() + band * bandRows;
+            quint64 key = Q_UINT64_C(14695981039346656037);
+
+            for (int j = 0; j < bandRows; ++j)
+            {
+                key = (key ^ values[j]) * Q_UINT64_C(1099511628211);
+            }
+
+            buckets[i].key = key;
+            buckets[i].book = i;
+        }
+
+        std::sort(buckets.begin(), buckets.end());
+
+        int first = 0;
+
+        while (first < buckets.size())
+        {
+            int last = first + 1;
+
+            while ((last < buckets.size()) && (buckets.at(last).key == buckets.at(first).key))
+                ++last;
+
+            if (last - first <= maxBucketBooks)
+            {
+                for (int i = first; i < last - 1; ++i)
+                {
+                    for (int j = i + 1; j < last; ++j)
+                        compare(buckets.at(i).book, buckets.at(j).book);
+                }
+            }
+            else
+            {
+                // A huge bucket is a band of common boilerplate, its books are compared with the first one only
+                for (int i = first + 1; i < last; ++i)
+                    compare(buckets.at(first).book, buckets.at(i).book);
+            }
+
+            first = last;
+        }
+    }
+
+    // Numbering of groups, single books are dropped
+    QVector<int> groupIds(rows.size(), -1);
+    QVector<QVector<int> > sets;
+
+    for (int i = 0; i < rows.size(); ++i)
+    {
+        int root = findRoot(i);
+
+        if (groupIds.at(root) == -1)
+        {
+            groupIds[root] = sets.size();
+            sets.append(QVector<int>());
+        }
+
+        sets[groupIds.at(root)].append(rows.at(i));
+    }
+
+    QVector<QVector<int> >::const_iterator it;
+
+    for (it = sets.constBegin(); it != sets.constEnd(); ++it)
+    {
+        if ((*it).size() > 1)
+            groups.append(*it);
+    }
+}
+
+int SimilarityIndex::getBookCount() const
+{
+    return rows.size();
+}
+
+int SimilarityIndex::getGroupCount() const
+{
+    return groups.size();
+}
+
+const QVector<int> &SimilarityIndex::getGroup(int group) const
+{
+    return groups.at(group);
+}
+
+double SimilarityIndex::similarity(const QVector<quint32> &first, const QVector<quint32> &second)
+{
+    if ((first.isEmpty()) || (first.size() != second.size()))
+        return 0;
+
+    int equal = 0;
+
+    for (int i = 0; i < first.size(); ++i)
+    {
+        equal += (first.at(i) == second.at(i)) ? 1 : 0;
+    }
+
+    return static_cast<double>(equal) / first.size();
+}
@@ -0,0 +1,202 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef SIMILARITYINDEX_H
+#define SIMILARITYINDEX_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль поиска книг с почти одинаковым текстом.
+ *
+ * @~english
+ * @brief Module of searching books with nearly identical text.
+ */
+
+#include "filerecord.h"
+
+#include <QVector>
+
+/**
+ * @~russian
+ * @brief Указатель похожих книг по сигнатурам MinHash текста.
+ *
+ * Попарное сравнение всей библиотеки заменено LSH: сигнатура делится на полосы по @c bandRows значений,
+ * книги с одинаковой полосой попадают в одну корзину. Для каждой полосы строится массив пар «хэш полосы,
+ * запись», упорядочивается, и сравниваются только книги одной корзины. Кандидаты проверяются по доле
+ * совпадающих значений сигнатуры (оценка коэффициента Жаккара), похожие книги объединяются системой
+ * непересекающихся множеств.@n
+ * При 8 полосах по 4 значения пара со сходством 0,75 находится с вероятностью около 0,95, со сходством 0,3 -
+ * около 0,06, поэтому время построения почти линейно по количеству книг.
+ *
+ * @~english
+ * @brief Index of similar books by MinHash signatures of the text.
+ *
+ * Pairwise comparison of the entire library is replaced with LSH: the signature is split into bands of
+ * @c bandRows values, books with an equal band fall into the same bucket. For every band an array of
+ * "band hash, record" pairs is built and sorted, and only books of the same bucket are compared. Candidates are
+ * verified by the share of equal signature values (the Jaccard similarity estimate), similar books are joined
+ * by a disjoint-set forest.@n
+ * With 8 bands of 4 values a pair with similarity 0.75 is found with probability about 0.95, a pair with
+ * similarity 0.3 - about 0.06, so the build time is almost linear in the number of books.
+ */
+class SimilarityIndex
+{
+public:
+    /**
+     * @~russian
+     * @brief Конструктор.
+     * @param threshold Наименьшее сходство похожих книг от 0 до 1.
+     *
+     * @~english
+     * @brief Constructor.
+     * @param threshold Least similarity of similar books from 0 to 1.
+     */
+    explicit SimilarityIndex(double threshold = 0.75);
+
+    /**
+     * @~russian
+     * @brief Построение указателя по сигнатурам записей.
+     *
+     * Записи без сигнатуры пропускаются.
+     * @param records Записи.
+     *
+     * @~english
+     * @brief Building the index from signatures of the records.
+     *
+     * Records without a signature are skipped.
+     * @param records Records.
+     */
+    void build(const QVector<FileRecord> &records);
+
+    /**
+     * @~russian
+     * @brief Очистка указателя.
+     *
+     * @~english
+     * @brief Clearing the index.
+     */
+    void clear();
+
+    /**
+     * @~russian
+     * @brief Получение количества книг с сигнатурой.
+     * @return Количество книг в указателе.
+     *
+     * @~english
+     * @brief Getting the number of books with a signature.
+     * @return Number of books in the index.
+     */
+    int getBookCount() const;
+
+    /**
+     * @~russian
+     * @brief Получение количества групп похожих книг.
+     * @return Количество групп из двух и более книг.
+     *
+     * @~english
+     * @brief Getting the number of groups of similar books.
+     * @return Number of groups of two or more books.
+     */
+    int getGroupCount() const;
+
+    /**
+     * @~russian
+     * @brief Получение группы похожих книг.
+     * @param group Номер группы.
+     * @return Номера записей группы по возрастанию.
+     *
+     * @~english
+     * @brief Getting the group of similar books.
+     * @param group Group number.
+     * @return Numbers of records of the group in ascending order.
+     */
+    const QVector<int> &getGroup(int group) const;
+
+    /**
+     * @~russian
+     * @brief Оценка сходства текстов по сигнатурам.
+     * @param first Первая сигнатура.
+     * @param second Вторая сигнатура.
+     * @return Доля совпадающих значений от 0 до 1.
+     *
+     * @~english
+     * @brief Estimating the similarity of texts by signatures.
+     * @param first First signature.
+     * @param second Second signature.
+     * @return Share of equal values from 0 to 1.
+     */
+    static double similarity(const QVector<quint32> &first, const QVector<quint32> &second);
+
+private:
+    static const int bandRows = 4; ///< @~russian Значений сигнатуры в полосе. @~english Signature values in a band.
+    static const int maxBucketBooks = 64; ///< @~russian Наибольшее число книг в корзине для сравнения всех пар. @~english Largest number of books in a bucket to compare all pairs.
+
+    /**
+     * @~russian
+     * @brief Книга в корзине полосы.
+     *
+     * @~english
+     * @brief Book in a band bucket.
+     */
+    struct BucketEntry
+    {
+        quint64 key; ///< @~russian Хэш полосы. @~english Band hash.
+        int book; ///< @~russian Номер книги в указателе. @~english Book number in the index.
+
+        bool operator<(const BucketEntry &other) const
+        {
+            return (key < other.key) || ((key == other.key) && (book < other.book));
+        }
+    };
+
+    double threshold; ///< @~russian Наименьшее сходство. @~english Least similarity.
+    QVector<int> rows; ///< @~russian Номера записей книг. @~english Record numbers of books.
+    QVector<QVector<quint32> > fingerprints; ///< @~russian Сигнатуры книг. @~english Signatures of books.
+    QVector<int> parents; ///< @~russian Родители в лесу множеств. @~english Parents in the disjoint-set forest.
+    QVector<QVector<int> > groups; ///< @~russian Группы похожих книг. @~english Groups of similar books.
+
+    /**
+     * @~russian
+     * @brief Сравнение книг и объединение похожих.
+     * @param a Номер первой книги.
+     * @param b Номер второй книги.
+     *
+     * @~english
+     * @brief Comparing books and joining similar ones.
+     * @param a Number of the first book.
+     * @param b Number of the second book.
+     */
+    void compare(int a, int b);
+
+    /**
+     * @~russian
+     * @brief Поиск корня множества книги со сжатием пути.
+     * @param id Номер книги.
+     * @return Номер корневой книги.
+     *
+     * @~english
+     * @brief Finding the set root of the book with path compression.
+     * @param id Book number.
+     * @return Number of the root book.
+     */
+    int findRoot(int id);
+};
+
+#endif // SIMILARITYINDEX_H
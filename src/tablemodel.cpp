@@ -27,7 +27,22 @@
  */
 
 #include "tablemodel.h"
+#include "unzipjob.h"
+#include "consts.h"
+#include "genreregistry.h"
+#include "profiler.h"
+#include "covercache.h"
+#include "bodyjob.h"
+#include "similarityindex.h"
+#include "repackjob.h"
 #include <QDir>
+#include <QSettings>
+#include <QColor>
+#include <QIcon>
+#include <QPixmap>
+#include <QUrl>
+
+#include <algorithm>
 
 const char lbracket =
     '{'; // Left and right brackets for optional parameters. Should be moved to a more appropriate place.
@@ -36,6 +51,8 @@ const char rbracket = '}';
 TableModel::TableModel(QObject *parent): QAbstractTableModel(parent)
 {
     cntSelectedRecords = 0;
+    covers = new CoverCache(this);
+    connect(covers, SIGNAL(ThumbnailReady(QString)), this, SLOT(onThumbnailReady(QString)));
     connect(this, SIGNAL(MoveTo(QString, QString)), this, SLOT(onMoveTo(QString, QString)));
     connect(this, SIGNAL(CopyTo(QString, QString)), this, SLOT(onCopyTo(QString, QString)));
     connect(this, SIGNAL(InplaceRename(QString, QString)), this, SLOT(onInplaceRename(QString, QString)));
@@ -68,20 +85,23 @@ int TableModel::columnCount(const QModelIndex &parent) const
 
 QVariant TableModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid())
+    if ((!index.isValid()) || (index.row() >= Data.count()))
         return QVariant();
 
+    // Reference into the model storage, so displaying a cell does not touch the reference counter
+    const FileRecord &record = Data.at(index.row());
+
     switch (role)
     {
     case Qt::DisplayRole:
         switch (index.column())
         {
         case colBookTitle:
-            return Data.value(index.row()).getBookTitle();
+            return record.getBookTitle();
             break;
 
         case colBookAuthor:
-            return Data.value(index.row()).getAuthorList().join(";\n");
+            return record.getAuthorList().join(";\n");
             break;
 
         case colSeries:
@@ -93,11 +113,11 @@ QVariant TableModel::data(const QModelIndex &index, int role) const
             break;
 
         case colEncoding:
-            return Data.value(index.row()).getEncoding();
+            return record.getEncoding();
             break;
 
         case colIsArchive:
-            if (Data.value(index.row()).isArchive())
+            if (record.isArchive())
             {
                 return tr("yes");
             }
@@ -110,7 +130,17 @@ QVariant TableModel::data(const QModelIndex &index, int role) const
 
 
         case colFileSize:
-            return Data.value(index.row()).getSize();
+            return record.getSize();
+            break;
+
+        case colLength:
+            if (record.getBodyStatistics().isValid())
+                return record.getBodyStatistics().getPages();
+
+            break;
+
+        case colStatus:
+            return getStatusName(record.getStatus());
             break;
 
         default:
@@ -119,6 +149,55 @@ QVariant TableModel::data(const QModelIndex &index, int role) const
 
         break;
 
+    case Qt::ToolTipRole:
+        if (index.column() == colGenres)
+        {
+            QStringList codes;
+            const genre_t &genres = record.getGenresList();
+            genre_t::const_iterator it;
+
+            for (it = genres.constBegin(); it != genres.constEnd(); ++it)
+                codes.append((*it).first);
+
+            return codes.join(", ");
+        }
+
+        if ((index.column() == colLength) && record.getBodyStatistics().isValid())
+        {
+            const BodyStatistics &statistics = record.getBodyStatistics();
+            return tr("Words: %1, characters: %2").arg(statistics.words).arg(statistics.characters);
+        }
+
+        if (index.column() == colCover)
+        {
+            QString path = covers->getThumbnailPath(record);
+
+            if (!path.isEmpty())
+                return QString("<img src=\"%1\">").arg(QUrl::fromLocalFile(path).toString());
+        }
+
+        break;
+
+    case Qt::DecorationRole:
+        if (index.column() == colCover)
+        {
+            QImage thumbnail = covers->getThumbnail(record);
+
+            if (!thumbnail.isNull())
+                return QIcon(QPixmap::fromImage(thumbnail));
+        }
+
+        break;
+
+    case Qt::ForegroundRole:
+        if ((index.column() == colGenres) && record.hasUnknownGenre())
+            return QColor(Qt::red);
+
+        if ((index.column() == colStatus) && (record.getStatus() != stNormalRecord))
+            return QColor(Qt::red);
+
+        break;
+
     case Qt::CheckStateRole:
         if (index.column() != colCheckColumn)
         {
@@ -171,6 +250,18 @@ QVariant TableModel::headerData(int section, Qt::Orientation orientation, int ro
                 return tr("File size");
                 break;
 
+            case colLength:
+                return tr("Pages");
+                break;
+
+            case colStatus:
+                return tr("Status");
+                break;
+
+            case colCover:
+                return tr("Cover");
+                break;
+
             default:
                 break;
             }
@@ -229,82 +320,249 @@ void TableModel::onBeginReading()
 void TableModel::onEndReading()
 {
     endResetModel();
+
+    QSettings settings(NAMES::nameDeveloper, NAMES::nameApplication);
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    bool analyze = settings.value(NAMES::nameAnalyzeBodies, false).toBool();
+    settings.endGroup();
+
+    // Books read before are taken from the cache, so the pass after each reading is cheap
+    if (analyze)
+        startBodyJob(Data);
 }
 
 void TableModel::onAppendRecord(const FileRecord &record)
 {
+    Profiler::Scope scope(Profiler::phModelInsert);
+
+    // Called between beginResetModel() and endResetModel(), so no row signals are needed
+    QHash<QString, int>::const_iterator row = Rows.constFind(record.getFileName());
+
+    if ((!record.getFileName().isEmpty()) && (row != Rows.constEnd()))
+    {
+        bool selected = Data[row.value()].isSelected();
+        Data[row.value()] = record;
+        Data[row.value()].setSelected(selected);
+        emit EventMessage(tr("File \"%1\" updated").arg(record.getFileName()));
+        return;
+    }
+
+    Rows.insert(record.getFileName(), Data.count());
     Data.append(record);
     emit EventMessage(tr("File \"%1\" added").arg(record.getFileName()));
-    // TODO Replace QVector to QMap for avoiding record duplication
 }
 
 void TableModel::onReplaceRecord(const QModelIndex &index, const FileRecord &record)
 {
+    if ((!index.isValid()) || (index.row() >= Data.count()))
+        return;
 
+    // Selection could be changed by the user while the record was processed
+    bool selected = Data[index.row()].isSelected();
+    Rows.remove(Data.at(index.row()).getFileName());
+    Data[index.row()] = record;
+    Data[index.row()].setSelected(selected);
+    Rows.insert(record.getFileName(), index.row());
+
+    emit dataChanged(this->index(index.row(), 0), this->index(index.row(), colCounterField - 1));
 }
 
-void TableModel::onUnzipSelected()
+void TableModel::onUpdateRecord(const FileRecord &record)
 {
-    QVector<FileRecord>::iterator it;
-    QString result;
+    QHash<QString, int>::const_iterator row = Rows.constFind(record.getFileName());
 
-    for (it = Data.begin(); it != Data.end(); ++it)
+    if (row != Rows.constEnd())
     {
-        if ((*it).isSelected())
+        onReplaceRecord(index(row.value(), 0), record);
+        emit EventMessage(tr("File \"%1\" updated").arg(record.getFileName()));
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), Data.count(), Data.count());
+    Rows.insert(record.getFileName(), Data.count());
+    Data.append(record);
+    endInsertRows();
+
+    emit EventMessage(tr("File \"%1\" added").arg(record.getFileName()));
+    emit SetSelected(cntSelectedRecords);
+}
+
+void TableModel::onReplaceFile(const QString &fileName, const FileRecord &record)
+{
+    QHash<QString, int>::const_iterator row = Rows.constFind(fileName);
+
+    if (row == Rows.constEnd())
+    {
+        onUpdateRecord(record);
+        return;
+    }
+
+    // The folder watcher could already add a record for the new file
+    QHash<QString, int>::const_iterator duplicate = Rows.constFind(record.getFileName());
+
+    if ((duplicate != Rows.constEnd()) && (duplicate.value() != row.value()))
+    {
+        onRemoveFiles(QStringList() << record.getFileName());
+        row = Rows.constFind(fileName);
+    }
+
+    onReplaceRecord(index(row.value(), 0), record);
+}
+
+void TableModel::onRemoveFiles(const QStringList &files)
+{
+    QVector<int> rows;
+    QStringList::const_iterator it;
+
+    for (it = files.constBegin(); it != files.constEnd(); ++it)
+    {
+        QHash<QString, int>::const_iterator row = Rows.constFind(*it);
+
+        if (row != Rows.constEnd())
         {
-            if (!(*it).isArchive())
-            {
-                emit EventMessage(tr("File %1 already uncompressed").arg((*it).getFileName()));
-            }
-            else
-            {
-                result = (*it).unzipFile();
-                emit EventMessage(result);
-            }
+            rows.append(row.value());
         }
     }
+
+    if (rows.isEmpty())
+        return;
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    // Runs of adjacent rows are removed at once, from the end, so row numbers of remaining records stay valid
+    int last = rows.count() - 1;
+
+    while (last >= 0)
+    {
+        int first = last;
+
+        while ((first > 0) && (rows.at(first - 1) == rows.at(first) - 1))
+            --first;
+
+        beginRemoveRows(QModelIndex(), rows.at(first), rows.at(last));
+
+        for (int i = last; i >= first; --i)
+        {
+            const FileRecord &record = Data.at(rows.at(i));
+
+            if (record.isSelected())
+                cntSelectedRecords--;
+
+            emit EventMessage(tr("File \"%1\" removed").arg(record.getFileName()));
+            Rows.remove(record.getFileName());
+        }
+
+        Data.remove(rows.at(first), last - first + 1);
+        endRemoveRows();
+        last = first - 1;
+    }
+
+    // Only records behind the first removed row have moved
+    for (int i = rows.first(); i < Data.count(); ++i)
+    {
+        Rows.insert(Data.at(i).getFileName(), i);
+    }
+
+    emit SetSelected(cntSelectedRecords);
+}
+
+void TableModel::onUnzipSelected()
+{
+    startBatchJob(boUnzip, getSelectedItems());
 }
 
 void TableModel::onUnzipCurrent()
 {
     QModelIndex ind = sender()->property("index").toModelIndex();
 
-    if (Data.value(ind.row()).isArchive())
-        emit EventMessage(Data[ind.row()].unzipFile());
-    else
-        emit EventMessage(tr("File %1 already uncompressed").arg(Data.value(ind.row()).getFileName()));
+    BatchItem item;
+    item.record = Data.value(ind.row());
+    startBatchJob(boUnzip, QVector<BatchItem>() << item);
 }
 
 void TableModel::onZipSelected()
 {
-    QVector<FileRecord>::iterator it;
-    QString result;
+    startBatchJob(boZip, getSelectedItems());
+}
 
-    for (it = Data.begin(); it != Data.end(); ++it)
+void TableModel::onZipCurrent()
+{
+    QModelIndex ind = sender()->property("index").toModelIndex();
+
+    BatchItem item;
+    item.record = Data.value(ind.row());
+    startBatchJob(boZip, QVector<BatchItem>() << item);
+}
+
+void TableModel::onEditSelected(const QVector<MetadataTransform> &transforms)
+{
+    if (transforms.isEmpty())
+        return;
+
+    startBatchJob(boEditMetadata, getSelectedItems(), transforms);
+}
+
+void TableModel::onConvertSelectedToUtf8()
+{
+    startBatchJob(boConvertUtf8, getSelectedItems());
+}
+
+void TableModel::onOptimizeSelectedImages()
+{
+    startBatchJob(boOptimizeImages, getSelectedItems());
+}
+
+void TableModel::onAnalyzeSelected()
+{
+    QVector<FileRecord> records;
+    QVector<FileRecord>::const_iterator it;
+
+    for (it = Data.constBegin(); it != Data.constEnd(); ++it)
     {
         if ((*it).isSelected())
-        {
-            if ((*it).isArchive())
-            {
-                emit EventMessage(tr("File %1 already compressed").arg((*it).getFileName()));
-            }
-            else
-            {
-                result = (*it).zipFile();
-                emit EventMessage(result);
-            }
-        }
+            records.append(*it);
     }
+
+    startBodyJob(records);
 }
 
-void TableModel::onZipCurrent()
+void TableModel::onRepackSelected(const QString &targetDir)
 {
-    QModelIndex ind = sender()->property("index").toModelIndex();
+    QVector<FileRecord> records;
+    QVector<FileRecord>::const_iterator it;
 
-    if (!Data.value(ind.row()).isArchive())
-        emit EventMessage(Data[ind.row()].zipFile());
-    else
-        emit EventMessage(tr("File %1 already compressed").arg(Data.value(ind.row()).getFileName()));
+    for (it = Data.constBegin(); it != Data.constEnd(); ++it)
+    {
+        if ((*it).isSelected())
+            records.append(*it);
+    }
+
+    if (records.isEmpty())
+        return;
+
+    RepackJob *job = new RepackJob(records, targetDir);
+
+    QSettings settings(NAMES::nameDeveloper, NAMES::nameApplication);
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    job->setThreads(settings.value(NAMES::nameThreads, 0).toInt());
+    job->setPacking(settings.value(NAMES::nameCompressionLevel, 9).toInt(),
+                    settings.value(NAMES::namePackSize, 1024).toInt(),
+                    settings.value(NAMES::nameWriteInpx, true).toBool());
+    settings.endGroup();
+
+    emit StartJob(job);
+}
+
+void TableModel::onBodyAnalyzed(const QString &fileName, const BodyStatistics &statistics)
+{
+    QHash<QString, int>::const_iterator row = Rows.constFind(fileName);
+
+    if (row == Rows.constEnd())
+        return;
+
+    Data[row.value()].setBodyStatistics(statistics);
+    emit dataChanged(index(row.value(), colLength), index(row.value(), colLength));
 }
 
 void TableModel::onSelectAll()
@@ -352,84 +610,216 @@ void TableModel::onInvertSelection()
     emit SetSelected(cntSelectedRecords);
 }
 
-void TableModel::onMoveTo(QString basedir, QString pattern)
+void TableModel::onSelectGenreCategory(int category)
 {
     QVector<FileRecord>::iterator it;
+    cntSelectedRecords = 0;
 
     for (it = Data.begin(); it != Data.end(); ++it)
     {
-        if ((*it).isSelected())
+        const QVector<quint16> &ids = (*it).getGenreIds();
+        bool matched = false;
+
+        if (category < 0)
+            matched = (*it).hasUnknownGenre();
+        else
         {
-            QString newPath = fromTemplateToPath(pattern, (*it));
-            emit EventMessage((*it).moveFile(basedir + QDir::separator() + newPath));
+            QVector<quint16>::const_iterator id;
+
+            for (id = ids.constBegin(); (id != ids.constEnd()) && (!matched); ++id)
+                matched = (GenreRegistry::getCategory(*id) == category);
         }
+
+        (*it).setSelected(matched);
+
+        if (matched)
+            cntSelectedRecords++;
     }
+
+    emit SetSelected(cntSelectedRecords);
 }
 
-void TableModel::onCopyTo(QString basedir, QString pattern)
+void TableModel::onSelectStatus(int status)
 {
     QVector<FileRecord>::iterator it;
+    cntSelectedRecords = 0;
 
     for (it = Data.begin(); it != Data.end(); ++it)
     {
+        (*it).setSelected((*it).getStatus() == status);
+
         if ((*it).isSelected())
-        {
-            QString newPath = fromTemplateToPath(pattern, (*it));
-            emit EventMessage((*it).copyFile(basedir + QDir::separator() + newPath));
-        }
+            cntSelectedRecords++;
     }
+
+    emit SetSelected(cntSelectedRecords);
+}
+
+void TableModel::onSelectSimilar()
+{
+    SimilarityIndex index;
+    index.build(Data);
+
+    if (index.getBookCount() == 0)
+    {
+        emit EventMessage(tr("No books with counted words, use \"Count words and pages\" first"));
+        return;
+    }
+
+    // Without marked records all groups are marked, otherwise only the groups of marked records
+    bool restricted = (cntSelectedRecords > 0);
+    QVector<bool> marked(Data.size(), false);
+    int groups = 0;
+
+    for (int group = 0; group < index.getGroupCount(); ++group)
+    {
+        const QVector<int> &rows = index.getGroup(group);
+        QVector<int>::const_iterator it;
+        bool matched = !restricted;
+
+        for (it = rows.constBegin(); (it != rows.constEnd()) && (!matched); ++it)
+            matched = Data.at(*it).isSelected();
+
+        if (!matched)
+            continue;
+
+        for (it = rows.constBegin(); it != rows.constEnd(); ++it)
+            marked[*it] = true;
+
+        ++groups;
+    }
+
+    cntSelectedRecords = 0;
+
+    for (int row = 0; row < Data.size(); ++row)
+    {
+        Data[row].setSelected(marked.at(row));
+
+        if (marked.at(row))
+            cntSelectedRecords++;
+    }
+
+    emit SetSelected(cntSelectedRecords);
+    emit EventMessage(tr("Groups of similar books: %1, books: %2").arg(groups).arg(cntSelectedRecords));
+}
+
+void TableModel::onMoveTo(QString basedir, QString pattern)
+{
+    QVector<BatchItem> items = getSelectedItems();
+    QVector<BatchItem>::iterator it;
+    AuthorIndex authors = getTemplateAuthors();
+
+    for (it = items.begin(); it != items.end(); ++it)
+    {
+        QString newPath = fromTemplateToPath(pattern, (*it).record, authors);
+        (*it).target = basedir + QDir::separator() + newPath;
+    }
+
+    startBatchJob(boMove, items);
+}
+
+void TableModel::onCopyTo(QString basedir, QString pattern)
+{
+    QVector<BatchItem> items = getSelectedItems();
+    QVector<BatchItem>::iterator it;
+    AuthorIndex authors = getTemplateAuthors();
+
+    for (it = items.begin(); it != items.end(); ++it)
+    {
+        QString newPath = fromTemplateToPath(pattern, (*it).record, authors);
+        (*it).target = basedir + QDir::separator() + newPath;
+    }
+
+    startBatchJob(boCopy, items);
 }
 
 void TableModel::onInplaceRename(QString basedir, QString pattern)
 {
     Q_UNUSED(basedir)
 
-    QVector<FileRecord>::iterator it;
+    QVector<BatchItem> items = getSelectedItems();
+    QVector<BatchItem>::iterator it;
+    AuthorIndex authors = getTemplateAuthors();
 
-    for (it = Data.begin(); it != Data.end(); ++it)
+    for (it = items.begin(); it != items.end(); ++it)
     {
-        if ((*it).isSelected())
-        {
-            QString oldPath = QFileInfo((*it).getFileName()).absolutePath();
-            QString newPath = oldPath + QDir::separator() + fromTemplateToPath(pattern, (*it));
-            emit EventMessage((*it).renameFile(newPath));
-        }
+        QString oldPath = QFileInfo((*it).record.getFileName()).absolutePath();
+        (*it).target = oldPath + QDir::separator() + fromTemplateToPath(pattern, (*it).record, authors);
     }
+
+    startBatchJob(boRename, items);
 }
 
 void TableModel::onClearList()
 {
     emit onBeginReading();
     Data.clear();
+    Rows.clear();
     cntSelectedRecords = 0;
     emit SetSelected(cntSelectedRecords);
     emit onEndReading();
 }
 
+void TableModel::onThumbnailReady(const QString &fileName)
+{
+    QHash<QString, int>::const_iterator row = Rows.constFind(fileName);
+
+    if (row != Rows.constEnd())
+        emit dataChanged(index(row.value(), colCover), index(row.value(), colCover));
+}
+
 QString TableModel::getFormattedGenresList(int index) const
 {
     QStringList res;
-    genre_t tmp = Data.value(index).getGenresList();
-    genre_t::iterator it;
+    const genre_t &tmp = Data.at(index).getGenresList();
+    const QVector<quint16> &ids = Data.at(index).getGenreIds();
+    genre_t::const_iterator it;
+    QString name;
 
-    for (it = tmp.begin(); it != tmp.end(); ++it)
+    for (it = tmp.constBegin(); it != tmp.constEnd(); ++it)
     {
+        quint16 id = ids.value(it - tmp.constBegin(), GenreRegistry::unknownGenre);
+
+        if (id == GenreRegistry::unknownGenre)
+            name = tr("%1 (unknown)").arg((*it).first);
+        else
+            name = GenreRegistry::getName(id);
+
         if ((*it).second == 100)
-            res.append(QString("%1").arg((*it).first));
+            res.append(name);
         else
-            res.append(QString("%1 (%2\%)").arg((*it).first, QString::number((*it).second)));
+            res.append(QString("%1 (%2\%)").arg(name, QString::number((*it).second)));
     }
 
     return res.join(";\n");
 }
 
+QString TableModel::getStatusName(Status status)
+{
+    switch (status)
+    {
+    case stIncorrectAuthorField:
+        return tr("Incorrect author");
+        break;
+
+    case stMixedCyrLat:
+        return tr("Mixed Cyrillic and Latin");
+        break;
+
+    default:
+        break;
+    }
+
+    return tr("OK");
+}
+
 QString TableModel::getFormattedSeriesList(int index) const
 {
     QStringList res;
-    sequence_t tmp = Data.value(index).getSequenceList();
-    sequence_t::iterator it;
+    const sequence_t &tmp = Data.at(index).getSequenceList();
+    sequence_t::const_iterator it;
 
-    for (it = tmp.begin(); it != tmp.end(); ++it)
+    for (it = tmp.constBegin(); it != tmp.constEnd(); ++it)
     {
         res.append(QString("%1 - %2").arg((*it).first, QString::number((*it).second)));
     }
@@ -439,14 +829,14 @@ QString TableModel::getFormattedSeriesList(int index) const
 
 Qt::CheckState TableModel::getState(const QModelIndex &index) const
 {
-    Qt::CheckState cs = Data.value(index.row()).isSelected() ? Qt::Checked : Qt::Unchecked;
+    Qt::CheckState cs = Data.at(index.row()).isSelected() ? Qt::Checked : Qt::Unchecked;
     return cs;
 }
 
-QString TableModel::fromTemplateToPath(const QString &pattern, const FileRecord &record)
+QString TableModel::fromTemplateToPath(const QString &pattern, const FileRecord &record, const AuthorIndex &authors)
 {
     QString result = pattern;
-    Person author = record.getAuthor(0);
+    Person author = authors.canonical(record.getAuthor(0));
 
     // TODO Add event processing when the specified nickname instead of a name and surname
 
@@ -539,3 +929,100 @@ QString TableModel::fromPathRemoveOptional(QString &path, const QString &param,
 
     return path;
 }
+
+QVector<FileRecord> TableModel::getSelectedRecords() const
+{
+    QVector<FileRecord> records;
+    records.reserve(cntSelectedRecords);
+    QVector<FileRecord>::const_iterator it;
+
+    for (it = Data.constBegin(); it != Data.constEnd(); ++it)
+    {
+        if ((*it).isSelected())
+            records.append(*it);
+    }
+
+    return records;
+}
+
+AuthorIndex TableModel::buildAuthorIndex() const
+{
+    AuthorIndex authors;
+    authors.build(Data);
+    return authors;
+}
+
+AuthorIndex TableModel::getTemplateAuthors() const
+{
+    QSettings settings(NAMES::nameDeveloper, NAMES::nameApplication);
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    bool canonical = settings.value(NAMES::nameCanonicalAuthors, false).toBool();
+    settings.endGroup();
+
+    // One author may be spelled differently in different books, all of them go to the same folder
+    if (canonical)
+        return buildAuthorIndex();
+
+    return AuthorIndex();
+}
+
+QVector<BatchItem> TableModel::getSelectedItems()
+{
+    QVector<BatchItem> items;
+    items.reserve(cntSelectedRecords);
+
+    for (int i = 0; i < Data.count(); ++i)
+    {
+        if (Data[i].isSelected())
+        {
+            BatchItem item;
+            item.record = Data.at(i);
+            items.append(item);
+        }
+    }
+
+    return items;
+}
+
+void TableModel::startBatchJob(BatchOperation operation, const QVector<BatchItem> &items,
+                               const QVector<MetadataTransform> &transforms)
+{
+    if (items.isEmpty())
+        return;
+
+    BatchJob *job;
+
+    if (operation == boUnzip)
+        job = new UnzipJob(items);
+    else
+        job = new BatchJob(operation, items);
+
+    QSettings settings(NAMES::nameDeveloper, NAMES::nameApplication);
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    job->setThreads(settings.value(NAMES::nameThreads, 0).toInt());
+    job->setCompression(settings.value(NAMES::nameCompressionLevel, 9).toInt(),
+                        settings.value(NAMES::nameMaxCompressionRatio, 0).toInt());
+    job->setImageOptions(settings.value(NAMES::nameImageQuality, 80).toInt(),
+                         settings.value(NAMES::nameMaxImageSize, 1600).toInt());
+    settings.endGroup();
+    job->setTransforms(transforms);
+
+    connect(job, SIGNAL(ReplaceFile(QString, FileRecord)), this, SLOT(onReplaceFile(QString, FileRecord)));
+    emit StartJob(job);
+}
+
+void TableModel::startBodyJob(const QVector<FileRecord> &records)
+{
+    if (records.isEmpty())
+        return;
+
+    BodyJob *job = new BodyJob(records);
+
+    QSettings settings(NAMES::nameDeveloper, NAMES::nameApplication);
+    settings.beginGroup(NAMES::nameProcessingGroup);
+    job->setThreads(settings.value(NAMES::nameThreads, 0).toInt());
+    settings.endGroup();
+
+    connect(job, SIGNAL(BodyAnalyzed(QString, BodyStatistics)), this, SLOT(onBodyAnalyzed(QString, BodyStatistics)));
+    emit StartJob(job);
+}
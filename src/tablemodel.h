@@ -31,8 +31,16 @@
 
 #include <QAbstractTableModel>
 #include <QVector>
+#include <QHash>
+#include <QStringList>
 
 #include "filerecord.h"
+#include "batchjob.h"
+#include "authorindex.h"
+#include "bodyjob.h"
+
+// Forward class declarations
+class CoverCache;
 
 /**
  * @~russian
@@ -51,6 +59,9 @@ enum Columns
     colEncoding, ///< @~russian Поле «Кодировка». @~english Encoding field.
     colIsArchive, ///< @~russian Поле «Сжатый файл». @~english Is File Compressed field.
     colFileSize, ///< @~russian Поле «Размер файла». @~english File size field.
+    colLength, ///< @~russian Поле «Объем» в страницах. @~english Length field in pages.
+    colStatus, ///< @~russian Поле «Статус». @~english Status field.
+    colCover, ///< @~russian Поле «Обложка». @~english Cover field.
     colCounterField ///< @~russian Псевдополе - маркер конца перечисления. @warning Не использовать его иным образом! @~english Pseudofield - end marker listing. @warning Do not use it otherwise!
 };
 
@@ -207,6 +218,41 @@ public:
      */
     int getSelectedRecordsCount();
 
+    /**
+     * @~russian
+     * @brief Получение отмеченных записей.
+     * @return Копии отмеченных записей, данные записей разделяются с моделью.
+     *
+     * @~english
+     * @brief Getting the marked records.
+     * @return Copies of the marked records, the record data is shared with the model.
+     */
+    QVector<FileRecord> getSelectedRecords() const;
+
+    /**
+     * @~russian
+     * @brief Построение указателя авторов всех записей.
+     * @return Указатель авторов.
+     *
+     * @~english
+     * @brief Building the author index of all records.
+     * @return Author index.
+     */
+    AuthorIndex buildAuthorIndex() const;
+
+    /**
+     * @~russian
+     * @brief Получение описания статуса записи.
+     * @param status Статус записи.
+     * @return Описание статуса.
+     *
+     * @~english
+     * @brief Getting the description of the record status.
+     * @param status Status of the record.
+     * @return Status description.
+     */
+    static QString getStatusName(Status status);
+
     /**
      * @~russian
      * @brief Получить общее количество записей в таблице.
@@ -218,6 +264,53 @@ public:
      */
     int getRecordsCount();
 
+    /**
+     * @~russian
+     * @brief Подстановка значений полей записи в строку нового имени переименовываемого файла.
+     *
+     * Поскольку для удобства пользовательского редактирования строка шаблона состоит из человекопонятных подстановок,
+     * для формирования итогового имени переименуемого файла требуется подставить значения полей записи в шаблон.
+     * @param pattern Строка шаблона.
+     * @param record Запись с данными.
+     * @param authors Указатель авторов, имя первого автора заменяется каноническим написанием.
+     * @return Итоговая строка имени файла.
+     *
+     * @~english
+     * @brief Substituting the values of record fields in the string of new filename.
+     *
+     * As for the convenience of the user edit the template line consists of clear human substitutions,
+     * to form the final name of the file being renamed is required to substitute the values of the fields in the template.
+     *
+     * @param pattern The template string.
+     * @param record Data record.
+     * @param authors Author index, the name of the first author is replaced with the canonical spelling.
+     * @return The result filename string.
+     */
+    static QString fromTemplateToPath(const QString &pattern, const FileRecord &record, const AuthorIndex &authors);
+
+    /**
+     * @~russian
+     * @brief Удаление опциональных параметров из строки имени файла.
+     *
+     * Параметры, взятые в квадратные скобки, являются необязательными и заполняются только при наличии.
+     * Весь текст в квадратных скобках вокруг параметра удаляется, если это не затрагивает другие параметры.
+     * @param path Строка имени файла.
+     * @param param Заменяемый опциональный параметр.
+     * @param subst Подставляемая строка - значение параметра.
+     * @return Строка имени файла с подставленным значением параметра.
+     *
+     * @~english
+     * @brief Removing the optional parameters of the file name string.
+     *
+     * The parameters in brackets are optional and should be completed only if there is.
+     * All of the text in square brackets around the parameter is removed, if it does not affect the other parameters.
+     * @param path Filename string.
+     * @param param Replacement optional parameter.
+     * @param subst Substituted string - value of the parameter.
+     * @return File name string with a substituted value of the parameter.
+     */
+    static QString fromPathRemoveOptional(QString &path, const QString &param, const QString &subst);
+
 signals:
 
     /**
@@ -292,6 +385,20 @@ signals:
      */
     void InplaceRename(QString basedir, QString pattern);
 
+    /**
+     * @~russian
+     * @brief Запуск фонового задания, созданного моделью.
+     *
+     * Обработчик сигнала должен подключить сигналы задания и запустить его.
+     * @param job Созданное задание.
+     *
+     * @~english
+     * @brief Starting the background job created by the model.
+     *
+     * The signal handler should connect signals of the job and start it.
+     * @param job Created job.
+     */
+    void StartJob(Job *job);
 
 public slots:
 
@@ -337,6 +444,51 @@ public slots:
      */
     void onReplaceRecord(const QModelIndex &index, const FileRecord &record);
 
+    /**
+     * @~russian
+     * @brief Обработчик события обновления записи файла.
+     *
+     * Если запись с таким именем файла уже есть в модели, то она заменяется, иначе запись добавляется
+     * в конец таблицы. Используется при наблюдении за папкой и не требует сброса модели.
+     * @param record Запись, содержащая новые данные.
+     *
+     * @~english
+     * @brief The event handler for updating a file record.
+     *
+     * If a record with the same file name is already in the model, it is replaced, otherwise the record
+     * is appended to the end of the table. Used when watching a folder and does not require model reset.
+     * @param record A record containing new data.
+     */
+    void onUpdateRecord(const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Обработчик события замены записи файла после операции над ним.
+     *
+     * Если запись исходного файла уже удалена из модели, то новая запись обрабатывается как обновление.
+     * @param fileName Имя файла до операции.
+     * @param record Запись, содержащая новые данные.
+     *
+     * @~english
+     * @brief The event handler for replacing a file record after operation on it.
+     *
+     * If the record of the original file is already removed from the model, the new record is processed as update.
+     * @param fileName File name before operation.
+     * @param record A record containing new data.
+     */
+    void onReplaceFile(const QString &fileName, const FileRecord &record);
+
+    /**
+     * @~russian
+     * @brief Обработчик события удаления файлов.
+     * @param files Список имен удаленных файлов.
+     *
+     * @~english
+     * @brief The event handler for deleting files.
+     * @param files List of deleted file names.
+     */
+    void onRemoveFiles(const QStringList &files);
+
     /**
      * @~russian
      * @brief Обработчик сигнала «Распаковать отмеченные файлы».
@@ -373,6 +525,88 @@ public slots:
      */
     void onZipCurrent();
 
+    /**
+     * @~russian
+     * @brief Пакетное изменение метаданных отмеченных файлов.
+     *
+     * Файлы переписываются параллельно, каждая измененная запись заменяется в модели по мере готовности.
+     * @param transforms Список преобразований, применяемых к каждой записи по порядку.
+     *
+     * @~english
+     * @brief Batch editing of metadata of marked files.
+     *
+     * Files are rewritten in parallel, each changed record is replaced in the model as soon as it is ready.
+     * @param transforms List of transformations applied to every record in order.
+     */
+    void onEditSelected(const QVector<MetadataTransform> &transforms);
+
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Перекодировать в UTF-8» меню «Инструменты».
+     *
+     * Отмеченные файлы в другой кодировке перекодируются потоком, файлы в UTF-8 пропускаются.
+     *
+     * @~english
+     * @brief Convert To UTF-8 action handler of Tools menu.
+     *
+     * Marked files in other encodings are recoded by streaming, files in UTF-8 are skipped.
+     */
+    void onConvertSelectedToUtf8();
+
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Оптимизировать изображения» меню «Инструменты».
+     *
+     * Изображения отмеченных файлов пережимаются с качеством и наибольшим размером из настроек.
+     *
+     * @~english
+     * @brief Optimize Images action handler of Tools menu.
+     *
+     * Images of marked files are recompressed with the quality and the largest size from the settings.
+     */
+    void onOptimizeSelectedImages();
+
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Анализировать текст» меню «Инструменты».
+     *
+     * Для отмеченных файлов считаются слова, символы и страницы.
+     *
+     * @~english
+     * @brief Analyze Text action handler of Tools menu.
+     *
+     * Words, characters and pages are counted for marked files.
+     */
+    void onAnalyzeSelected();
+
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Упаковать в общие архивы» меню «Инструменты».
+     *
+     * Отмеченные книги записываются в общие архивы, исходные файлы и список не изменяются.
+     * @param targetDir Папка архивов.
+     *
+     * @~english
+     * @brief Repack Into Shared Archives action handler of Tools menu.
+     *
+     * Marked books are written into shared archives, source files and the list are not changed.
+     * @param targetDir Folder of archives.
+     */
+    void onRepackSelected(const QString &targetDir);
+
+    /**
+     * @~russian
+     * @brief Обработчик события готовности статистики текста книги.
+     * @param fileName Имя файла книги.
+     * @param statistics Статистика текста.
+     *
+     * @~english
+     * @brief The event handler of the book text statistics readiness.
+     * @param fileName Book file name.
+     * @param statistics Text statistics.
+     */
+    void onBodyAnalyzed(const QString &fileName, const BodyStatistics &statistics);
+
     /**
      * @~russian
      * @brief Обработчик сигнала «Отметить все файлы» меню «Выбор».
@@ -400,6 +634,43 @@ public slots:
      */
     void onInvertSelection();
 
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Отметить по жанру» меню «Выбор».
+     * @param category Номер категории справочника жанров, -1 - файлы с нестандартными жанрами.
+     *
+     * @~english
+     * @brief Select By Genre action handler.
+     * @param category Category number of the genre registry, -1 - files with non-standard genres.
+     */
+    void onSelectGenreCategory(int category);
+
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Отметить по статусу» меню «Выбор».
+     * @param status Статус отмечаемых записей.
+     *
+     * @~english
+     * @brief Select By Status action handler.
+     * @param status Status of the records being marked.
+     */
+    void onSelectStatus(int status);
+
+    /**
+     * @~russian
+     * @brief Обработчик сигнала «Отметить похожие книги» меню «Выбор».
+     *
+     * Если отмеченных записей нет, отмечаются все книги, у которых есть копии с почти одинаковым текстом,
+     * иначе - отмеченные книги и их копии. Сходство определяется по сигнатурам, построенным при подсчете слов.
+     *
+     * @~english
+     * @brief Select Similar Books action handler.
+     *
+     * If there are no marked records, all books having copies with nearly identical text are marked, otherwise
+     * the marked books and their copies. The similarity is determined by signatures built when counting words.
+     */
+    void onSelectSimilar();
+
     /**
      * @~russian
      * @brief Обработчик сигнала «Переместить и переименовать по шаблону».
@@ -448,6 +719,17 @@ public slots:
      */
     void onClearList();
 
+    /**
+     * @~russian
+     * @brief Обработчик события готовности миниатюры обложки.
+     * @param fileName Имя файла книги.
+     *
+     * @~english
+     * @brief The event handler of the cover thumbnail readiness.
+     * @param fileName Book file name.
+     */
+    void onThumbnailReady(const QString &fileName);
+
 private:
     /**
      * @~russian
@@ -458,6 +740,24 @@ private:
      */
     QVector<FileRecord> Data;
 
+    /**
+     * @~russian
+     * @brief Индекс записей по имени файла: имя файла -> номер строки в хранилище данных модели.
+     *
+     * @~english
+     * @brief Index of records by file name: file name -> row in the data storage.
+     */
+    QHash<QString, int> Rows;
+
+    /**
+     * @~russian
+     * @brief Кеш миниатюр обложек.
+     *
+     * @~english
+     * @brief Cache of cover thumbnails.
+     */
+    CoverCache *covers;
+
     /**
      * @~russian
      * @brief Получение и форматирование списка жанров записи.
@@ -508,48 +808,52 @@ private:
 
     /**
      * @~russian
-     * @brief Подстановка значений полей записи в строку нового имени переименовываемого файла.
-     *
-     * Поскольку для удобства пользовательского редактирования строка шаблона состоит из человекопонятных подстановок,
-     * для формирования итогового имени переименуемого файла требуется подставить значения полей записи в шаблон.
-     * @param pattern Строка шаблона.
-     * @param record Запись с данными.
-     * @return Итоговая строка имени файла.
+     * @brief Получение указателя авторов для подстановки в шаблоны.
+     * @return Указатель по всем записям или пустой указатель, если замена канонических имен выключена.
      *
      * @~english
-     * @brief Substituting the values of record fields in the string of new filename.
-     *
-     * As for the convenience of the user edit the template line consists of clear human substitutions,
-     * to form the final name of the file being renamed is required to substitute the values of the fields in the template.
-     *
-     * @param pattern The template string.
-     * @param record Data record.
-     * @return The result filename string.
+     * @brief Getting the author index for template substitution.
+     * @return Index of all records or empty index if substitution of canonical names is disabled.
      */
-    QString fromTemplateToPath(const QString &pattern, const FileRecord &record);
+    AuthorIndex getTemplateAuthors() const;
 
     /**
      * @~russian
-     * @brief Удаление опциональных параметров из строки имени файла.
+     * @brief Получение списка помеченных записей для пакетной операции.
+     * @return Список помеченных записей.
      *
-     * Параметры, взятые в квадратные скобки, являются необязательными и заполняются только при наличии.
-     * Весь текст в квадратных скобках вокруг параметра удаляется, если это не затрагивает другие параметры.
-     * @param path Строка имени файла.
-     * @param param Заменяемый опциональный параметр.
-     * @param subst Подставляемая строка - значение параметра.
-     * @return Строка имени файла с подставленным значением параметра.
+     * @~english
+     * @brief Getting the list of marked records for batch operation.
+     * @return List of marked records.
+     */
+    QVector<BatchItem> getSelectedItems();
+
+    /**
+     * @~russian
+     * @brief Создание задания пакетной операции и отсылка сигнала о его запуске.
+     * @param operation Выполняемая операция.
+     * @param items Список обрабатываемых записей.
+     * @param transforms Преобразования метаданных для операции boEditMetadata.
      *
      * @~english
-     * @brief Removing the optional parameters of the file name string.
+     * @brief Creating a batch operation job and sending a signal to start it.
+     * @param operation Performed operation.
+     * @param items List of processed records.
+     * @param transforms Metadata transformations for boEditMetadata operation.
+     */
+    void startBatchJob(BatchOperation operation, const QVector<BatchItem> &items,
+                       const QVector<MetadataTransform> &transforms = QVector<MetadataTransform>());
+
+    /**
+     * @~russian
+     * @brief Создание задания анализа текста и отсылка сигнала о его запуске.
+     * @param records Анализируемые записи.
      *
-     * The parameters in brackets are optional and should be completed only if there is.
-     * All of the text in square brackets around the parameter is removed, if it does not affect the other parameters.
-     * @param path Filename string.
-     * @param param Replacement optional parameter.
-     * @param subst Substituted string - value of the parameter.
-     * @return File name string with a substituted value of the parameter.
+     * @~english
+     * @brief Creating a text analysis job and sending a signal to start it.
+     * @param records Analyzed records.
      */
-    QString fromPathRemoveOptional(QString &path, const QString &param, const QString &subst);
+    void startBodyJob(const QVector<FileRecord> &records);
 
 };
 
@@ -32,6 +32,7 @@
 #include <QString>
 #include <QVector>
 #include <QPair>
+#include <QHash>
 
 /**
  * @~russian
@@ -80,4 +81,90 @@ typedef QVector<QPair<QString, int> > sequence_t;
  */
 typedef QVector<QPair<QString, QString> > setting_t;
 
+/**
+ * @~russian
+ * @brief Псевдоним типа для состояния файла.
+ *
+ * Первый параметр - размер файла.@n
+ * Второй параметр - время изменения файла в миллисекундах.
+ *
+ * @~english
+ * @brief Type definition for file state.
+ *
+ * First parameter - file size.@n
+ * Second parameter - file modification time in milliseconds.
+ */
+typedef QPair<qint64, qint64> filestate_t;
+
+/**
+ * @~russian
+ * @brief Псевдоним типа для снимка содержимого папок: папка -> (файл -> состояние).
+ *
+ * @~english
+ * @brief Type definition for snapshot of folders contents: folder -> (file -> state).
+ */
+typedef QHash<QString, QHash<QString, filestate_t> > snapshot_t;
+
+/**
+ * @~russian
+ * @brief Статистика текста книги.
+ *
+ * Символы считаются с пробелами, несколько пробельных символов подряд и разметка между словами считаются одним
+ * пробелом. Страница - 1800 символов, как машинописная страница.
+ *
+ * @~english
+ * @brief Statistics of the book text.
+ *
+ * Characters are counted with spaces, several whitespace characters in a row and markup between words are
+ * counted as one space. A page is 1800 characters, as a typewritten page.
+ */
+struct BodyStatistics
+{
+    qint64 words; ///< @~russian Количество слов, -1 - текст не анализировался. @~english Number of words, -1 - the text was not analyzed.
+    qint64 characters; ///< @~russian Количество символов. @~english Number of characters.
+    QVector<quint32> fingerprint; ///< @~russian Сигнатура MinHash текста, пустая - текст слишком короткий. @~english MinHash signature of the text, empty - the text is too short.
+
+    /**
+     * @~russian
+     * @brief Конструктор статистики неанализированного текста.
+     *
+     * @~english
+     * @brief Constructor of statistics of the not analyzed text.
+     */
+    BodyStatistics() : words(-1), characters(0) {}
+
+    /**
+     * @~russian
+     * @brief Проверка, анализировался ли текст.
+     * @return @c true - если статистика известна;@n
+     * @c false - если нет.
+     *
+     * @~english
+     * @brief Checking whether the text was analyzed.
+     * @return @c true - if the statistics is known;@n
+     * @c false - if not.
+     */
+    bool isValid() const
+    {
+        return words >= 0;
+    }
+
+    /**
+     * @~russian
+     * @brief Получение количества страниц.
+     * @return Количество страниц, округленное вверх.
+     *
+     * @~english
+     * @brief Getting the number of pages.
+     * @return Number of pages rounded up.
+     */
+    qint64 getPages() const
+    {
+        return (characters + charactersPerPage - 1) / charactersPerPage;
+    }
+
+    static const int charactersPerPage = 1800; ///< @~russian Символов на странице. @~english Characters per page.
+    static const int fingerprintSize = 32; ///< @~russian Количество значений сигнатуры. @~english Number of signature values.
+};
+
 #endif // TYPES_H
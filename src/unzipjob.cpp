@@ -0,0 +1,307 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+/*
+ * @file
+ * @~russian
+ * @brief Файл реализации для параллельной распаковки архивов.
+ *
+ * @~english
+ * @brief Source file for parallel unpacking of archives.
+ */
+
+#include "unzipjob.h"
+#include "profiler.h"
+
+#ifndef MINIZ_HEADER_FILE_ONLY
+#define MINIZ_HEADER_FILE_ONLY
+#endif
+#include "3rdparty/miniz.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QMutexLocker>
+
+#if defined Q_OS_UNIX
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+const int commitBatchSize = 32; // Files per disk synchronization. Also limits the number of open temporary files
+const int maxPooledBuffer = 64 * 1024 * 1024; // Larger buffers are freed instead of returning to the pool
+const int maxRenameAttempts = 16; // Free names tried when the target is created by someone else at the same time
+
+UnzipJob::UnzipJob(const QVector<BatchItem> &items, QObject *parent) :
+    BatchJob(boUnzip, items, parent)
+{
+}
+
+UnzipJob::~UnzipJob()
+{
+    while (!buffers.isEmpty())
+    {
+        delete buffers.pop();
+    }
+}
+
+void UnzipJob::run()
+{
+    // Workers access items concurrently, so the vector must not be shared with the caller
+    items.detach();
+    runParallel(items.count(), threads);
+
+    // The tail of the last batch is committed even after cancellation: these files are already unpacked
+    QVector<StagedFile> batch;
+    {
+        QMutexLocker locker(&mtxShared);
+        batch = staged;
+        staged.clear();
+    }
+    commit(batch);
+
+    if (isCancelled())
+        emit EventMessage(tr("%1: cancelled").arg(getTitle()));
+}
+
+void UnzipJob::processParallel(int index)
+{
+    BatchItem &item = items[index];
+    qint64 size = item.record.getSize();
+    QString fileName = item.record.getFileName();
+
+    if (!item.record.isArchive())
+    {
+        emit EventMessage(tr("File %1 already uncompressed").arg(fileName));
+        addProgress(1, size);
+        return;
+    }
+
+    QByteArray *buffer = acquireBuffer();
+    QString entryName;
+    QString error = extract(fileName, *buffer, entryName);
+
+    if (!error.isEmpty())
+    {
+        releaseBuffer(buffer);
+        emit ErrorMessage(error);
+        addProgress(1, size);
+        return;
+    }
+
+    StagedFile file;
+    file.index = index;
+    file.size = buffer->size();
+    file.target = QDir::toNativeSeparators(QFileInfo(fileName).canonicalPath() + "/" + entryName);
+    file.temp = new QFile(file.target + QString(".%1.part").arg(index));
+
+    if ((!file.temp->open(QFile::WriteOnly | QFile::Truncate)) ||
+            (file.temp->write(*buffer) != buffer->size()) || (!file.temp->flush()))
+    {
+        emit ErrorMessage(tr("Error writing the file %1").arg(file.temp->fileName()));
+        file.temp->close();
+        file.temp->remove();
+        delete file.temp;
+        releaseBuffer(buffer);
+        addProgress(1, size);
+        return;
+    }
+
+    releaseBuffer(buffer);
+
+    QVector<StagedFile> batch;
+    {
+        QMutexLocker locker(&mtxShared);
+        staged.append(file);
+
+        if (staged.count() >= commitBatchSize)
+        {
+            batch = staged;
+            staged.clear();
+        }
+    }
+
+    // The worker which completed the batch commits it, the others continue unpacking
+    commit(batch);
+    addProgress(1, size);
+}
+
+QByteArray *UnzipJob::acquireBuffer()
+{
+    QMutexLocker locker(&mtxShared);
+
+    if (buffers.isEmpty())
+        return new QByteArray();
+
+    return buffers.pop();
+}
+
+void UnzipJob::releaseBuffer(QByteArray *buffer)
+{
+    if (buffer->capacity() > maxPooledBuffer)
+    {
+        delete buffer;
+        return;
+    }
+
+    QMutexLocker locker(&mtxShared);
+    buffers.push(buffer);
+}
+
+QString UnzipJob::extract(const QString &fileName, QByteArray &buffer, QString &entryName)
+{
+    Profiler::Scope scope(Profiler::phUnzip);
+    mz_zip_archive archive;
+    memset(&archive, 0, sizeof(archive));
+
+    if (!mz_zip_reader_init_file(&archive, QFile::encodeName(fileName).constData(), 0))
+    {
+        return tr("Cannot open archive %1").arg(fileName);
+    }
+
+    if (mz_zip_reader_get_num_files(&archive) != 1)
+    {
+        mz_zip_reader_end(&archive);
+        return tr("The archive %1 more than one file, or no files in the archive").arg(fileName);
+    }
+
+    mz_zip_archive_file_stat file_stat;
+
+    if (!mz_zip_reader_file_stat(&archive, 0, &file_stat))
+    {
+        mz_zip_reader_end(&archive);
+        return tr("Error reading the archive %1").arg(fileName);
+    }
+
+    // Only the name is taken from the archive, so the file cannot be placed outside the archive folder
+    entryName = QFileInfo(QString::fromLocal8Bit(file_stat.m_filename)).fileName();
+
+    if (entryName.isEmpty())
+    {
+        mz_zip_reader_end(&archive);
+        return tr("Error reading the archive %1").arg(fileName);
+    }
+
+    // resize() keeps the capacity, so a pooled buffer is reallocated only for a larger book
+    buffer.resize(static_cast<int>(file_stat.m_uncomp_size));
+
+    if (!mz_zip_reader_extract_to_mem(&archive, 0, buffer.data(), buffer.size(), 0))
+    {
+        mz_zip_reader_end(&archive);
+        return tr("Error extracting file %2 from archive %1").arg(fileName, entryName);
+    }
+
+    mz_zip_reader_end(&archive);
+    return QString();
+}
+
+void UnzipJob::commit(QVector<StagedFile> batch)
+{
+    if (batch.isEmpty())
+        return;
+
+    QVector<StagedFile>::iterator it;
+
+#if defined Q_OS_UNIX
+
+    // Data of all files of the batch must reach the disk before any rename
+    for (it = batch.begin(); it != batch.end(); ++it)
+    {
+        ::fsync((*it).temp->handle());
+    }
+
+#endif
+
+    QSet<QString> dirs;
+
+    for (it = batch.begin(); it != batch.end(); ++it)
+    {
+        QString tempName = (*it).temp->fileName();
+
+        (*it).temp->close();
+        delete (*it).temp;
+        (*it).temp = 0;
+
+        // QFile::rename() never replaces an existing file, so a free name is taken if the target appears meanwhile
+        QString target;
+        bool renamed;
+
+        {
+            Profiler::Scope scope(Profiler::phRename);
+            target = FileRecord::getNewName((*it).target);
+            renamed = QFile::rename(tempName, target);
+
+            for (int attempt = 1; (!renamed) && (attempt < maxRenameAttempts) && (QFile::exists(target)); ++attempt)
+            {
+                target = FileRecord::getNewName(target);
+                renamed = QFile::rename(tempName, target);
+            }
+        }
+
+        if (!renamed)
+        {
+            QFile::remove(tempName);
+            emit ErrorMessage(tr("Error extracting file %2 from archive %1").arg(items.at((*it).index).record.getFileName(),
+                              target));
+            (*it).target.clear();
+            continue;
+        }
+
+        (*it).target = target;
+        dirs.insert(QFileInfo(target).absolutePath());
+    }
+
+#if defined Q_OS_UNIX
+    // Renames are persistent only after the folder itself is synchronized
+    QSet<QString>::const_iterator dir;
+
+    for (dir = dirs.constBegin(); dir != dirs.constEnd(); ++dir)
+    {
+        int fd = ::open(QFile::encodeName(*dir).constData(), O_RDONLY);
+
+        if (fd != -1)
+        {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+#endif
+
+    // Source archives are removed only when the unpacked books are durable
+    for (it = batch.begin(); it != batch.end(); ++it)
+    {
+        if ((*it).target.isEmpty())
+            continue;
+
+        BatchItem &item = items[(*it).index];
+        QString oldFileName = item.record.getFileName();
+        qint64 oldSize = item.record.getSize();
+
+        item.record.setFileName((*it).target);
+        item.record.setSize((*it).size);
+        item.record.setIsArchive(false);
+        QFile::remove(oldFileName);
+
+        emit EventMessage(tr("Archive %1 succesfully unzipped (%2 -> %3)").arg(oldFileName, QString::number(oldSize),
+                          QString::number((*it).size)));
+        emit ReplaceFile(oldFileName, item.record);
+    }
+}
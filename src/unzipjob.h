@@ -0,0 +1,201 @@
+/***********************************************************************
+ *
+ * Copyright (C) 2015,2016 Sergej Martynov <veter@veter.name>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ ***********************************************************************/
+
+#ifndef UNZIPJOB_H
+#define UNZIPJOB_H
+
+/**
+ * @file
+ * @~russian
+ * @brief Модуль параллельной распаковки архивов.
+ *
+ * @~english
+ * @brief Module of parallel unpacking of archives.
+ */
+
+#include "batchjob.h"
+
+#include <QMutex>
+#include <QStack>
+#include <QByteArray>
+
+// Forward class declarations
+class QFile;
+
+/**
+ * @~russian
+ * @brief Задание параллельной распаковки выбранных архивов.
+ *
+ * Потоки пула распаковывают архивы в память (буферы берутся из общего пула и используются повторно)
+ * и записывают результат во временные файлы рядом с архивами. Временные файлы фиксируются пачками:
+ * синхронизация файлов с диском, переименование в итоговые имена без замены существующих файлов,
+ * синхронизация папок и только затем удаление исходных архивов. Прерванная распаковка не оставляет
+ * ни испорченных, ни потерянных книг.
+ *
+ * @~english
+ * @brief Job of parallel unpacking of selected archives.
+ *
+ * Pool threads inflate archives into memory (buffers are taken from a shared pool and reused)
+ * and write the result into temporary files next to the archives. Temporary files are committed
+ * in batches: synchronization of files with disk, rename to the final names without replacing existing files,
+ * synchronization of folders and only then removal of the source archives. Interrupted unpacking leaves
+ * neither corrupted nor lost books.
+ */
+class UnzipJob : public BatchJob
+{
+    Q_OBJECT
+public:
+    /**
+     * @~russian
+     * @brief Конструктор задания.
+     * @param items Список распаковываемых записей.
+     * @param parent Родительский объект.
+     *
+     * @~english
+     * @brief Constructor of the job.
+     * @param items List of unpacked records.
+     * @param parent Parent object.
+     */
+    explicit UnzipJob(const QVector<BatchItem> &items, QObject *parent = 0);
+
+    /**
+     * @~russian
+     * @brief Деструктор задания.
+     *
+     * @~english
+     * @brief Destructor of the job.
+     */
+    virtual ~UnzipJob();
+
+    /**
+     * @~russian
+     * @brief Тело потока вычисления.
+     *
+     * @~english
+     * @brief Body of the thread.
+     */
+    void run();
+
+protected:
+    /**
+     * @~russian
+     * @brief Распаковка одного архива во временный файл в потоке пула.
+     * @param index Номер записи.
+     *
+     * @~english
+     * @brief Unpacking of one archive into a temporary file in the pool thread.
+     * @param index Record number.
+     */
+    void processParallel(int index);
+
+private:
+    /**
+     * @~russian
+     * @brief Распакованный, но еще не зафиксированный файл.
+     *
+     * @~english
+     * @brief Unpacked but not yet committed file.
+     */
+    struct StagedFile
+    {
+        int index; ///< @~russian Номер записи. @~english Record number.
+        QFile *temp; ///< @~russian Открытый временный файл. @~english Open temporary file.
+        QString target; ///< @~russian Итоговое имя файла. @~english Final file name.
+        qint64 size; ///< @~russian Размер распакованного файла. @~english Size of the unpacked file.
+    };
+
+    /**
+     * @~russian
+     * @brief Мьютекс пула буферов и списка распакованных файлов.
+     *
+     * @~english
+     * @brief Mutex of the buffer pool and the list of staged files.
+     */
+    QMutex mtxShared;
+
+    /**
+     * @~russian
+     * @brief Пул буферов распаковки.
+     *
+     * @~english
+     * @brief Pool of inflate buffers.
+     */
+    QStack<QByteArray *> buffers;
+
+    /**
+     * @~russian
+     * @brief Распакованные, но еще не зафиксированные файлы.
+     *
+     * @~english
+     * @brief Unpacked but not yet committed files.
+     */
+    QVector<StagedFile> staged;
+
+    /**
+     * @~russian
+     * @brief Получение буфера из пула.
+     * @return Буфер распаковки.
+     *
+     * @~english
+     * @brief Getting a buffer from the pool.
+     * @return Inflate buffer.
+     */
+    QByteArray *acquireBuffer();
+
+    /**
+     * @~russian
+     * @brief Возврат буфера в пул.
+     * @param buffer Буфер распаковки.
+     *
+     * @~english
+     * @brief Returning a buffer to the pool.
+     * @param buffer Inflate buffer.
+     */
+    void releaseBuffer(QByteArray *buffer);
+
+    /**
+     * @~russian
+     * @brief Распаковка архива в буфер.
+     * @param fileName Имя архива.
+     * @param buffer Буфер, в который распаковывается файл.
+     * @param entryName Имя файла внутри архива.
+     * @return Пустая строка в случае успеха, иначе сообщение об ошибке.
+     *
+     * @~english
+     * @brief Unpacking the archive into the buffer.
+     * @param fileName Archive name.
+     * @param buffer Buffer to which the file is unpacked.
+     * @param entryName Name of the file inside the archive.
+     * @return Empty string on success, error message otherwise.
+     */
+    QString extract(const QString &fileName, QByteArray &buffer, QString &entryName);
+
+    /**
+     * @~russian
+     * @brief Фиксация пачки распакованных файлов.
+     * @param batch Пачка файлов.
+     *
+     * @~english
+     * @brief Commit of a batch of unpacked files.
+     * @param batch Batch of files.
+     */
+    void commit(QVector<StagedFile> batch);
+};
+
+#endif // UNZIPJOB_H